@@ -49,6 +49,17 @@ public:
     pages[mem >> PAGE_SHIFT] = page;
   }
   //
+  // Copy the complete page table out, or install a complete
+  // page table at once.
+  void GetPageTable(class Page *table[256]) const
+  {
+    memcpy(table,pages,sizeof(pages));
+  }
+  void SetPageTable(class Page *const table[256])
+  {
+    memcpy(pages,table,sizeof(pages));
+  }
+  //
   // Read and write from an address
   UBYTE ReadByte(ADR mem)
   {
@@ -18,7 +18,6 @@
 #include "cpu.hpp"
 #include "exceptions.hpp"
 #include "alsasound.hpp"
-#include "audiobuffer.hpp"
 #include "unistd.hpp"
 #include "new.hpp"
 #include <assert.h>
@@ -35,9 +34,9 @@
 AlsaSound::AlsaSound(class Machine *mach)
   : Sound(mach), CardName(new char[8]),
     SoundStream(NULL), HWParms(NULL), SWParms(NULL), AsyncHandler(NULL),
-    MayRunPokey(false), AbleIRQ(false),
+    Underrun(false), AbleIRQ(false),
     FragSize(8), NumFrags(12), 
-    BufferedSamples(0), ForceStereo(false), UpdateBuffer(false), Polling(false), 
+    ForceStereo(false), UpdateBuffer(false), Polling(false), 
     UpdateSamples(0)
 {
   strcpy(CardName,"default"); //hw:0,0");
@@ -69,7 +68,8 @@ AlsaSound::~AlsaSound(void)
 ///
 
 /// AlsaSound::SuspendAudio
-// Suspend audio playing since we need access to the buffer.
+// Suspend the async handler since we need to access the
+// consumer side of the buffer.
 void AlsaSound::SuspendAudio(void)
 {
   // Stop processing of the signal handler
@@ -79,38 +79,26 @@ void AlsaSound::SuspendAudio(void)
 ///
 
 /// AlsaSound::ResumeAudio
-// Resume playing, grant buffer access again.
+// Resume playing, push samples into the device and
+// enable the async handler again.
 void AlsaSound::ResumeAudio(void)
 {
   if (SoundStream) {    
     // Push a couple of samples into the buffer.
     // Check whether we have an underrun here. If so, switch back to preparation state
     if (snd_pcm_state(SoundStream) == SND_PCM_STATE_XRUN) {
-      // Outch, underrun.
+      // Outch, underrun. The latency control will pick up the
+      // low fill level.
       snd_pcm_prepare(SoundStream);
-      //printf("ResumeAudio based ");
-      AdjustUnderrun();
     }
     // Due to the start threshold handling, this should run the PCM automatically.
     AbleIRQ     = false;
-    MayRunPokey = true;
     AlsaCallBack();
-    MayRunPokey = false;
     AbleIRQ     = true;
   }
 }
 ///
 
-/// AlsaSound::GenerateSamples
-// Generate the given number (not in bytes, but in number) of audio samples
-// and place them into the tail of the ready buffer list.
-void AlsaSound::GenerateSamples(ULONG numsamples)
-{	
-  // Let the sound class do the work and update the sample count.
-  BufferedSamples += Sound::GenerateSamples(numsamples,FragSamples);
-}
-///
-
 /// AlsaSound::ColdStart
 // Run a coldstart. Also initializes the dsp device if we haven't done so
 // before. Or at least, it tries to.
@@ -138,13 +126,14 @@ void AlsaSound::WarmStart(void)
 {
   ConsoleSpeakerStat = false;  
   //
-  // Dispose the old audio buffer nodes now.
+  // Dispose the old samples now. The async handler must not
+  // run meanwhile.
+  SuspendAudio();
   CleanBuffer();
+  Underrun           = false;
   //
   // Reset generation frequency
-  EffectiveFreq      = SamplingFreq;
-  DifferentialAdjust = 0;
-  BufferedSamples    = 0;
+  ResetRateControl(TargetSamples);
 }
 ///
 
@@ -365,9 +354,7 @@ bool AlsaSound::InitializeDsp(void)
     ThrowAlsa(err,"AlsaSound::InitializeDsp","unable to write back the software parameters");
   }
   //
-  // Setup the effective buffering frequency.
-  EffectiveFreq      = SamplingFreq;
-  DifferentialAdjust = 0;
+  // Setup the buffering.
   CycleCarry         = 0;
   UpdateBuffer       = false;
   Polling            = false;
@@ -376,6 +363,12 @@ bool AlsaSound::InitializeDsp(void)
   FragSamples        = fragsize;
   BufferSize         = FragSamples * NumFrags;
   //
+  // Allocate the ring buffer the async handler takes the samples from.
+  AllocateBuffer(BufferSize << 2);
+  //
+  // Keep one ALSA buffer size of samples in the ring buffer.
+  ResetRateControl(BufferSize);
+  //
   // Start the async handler now.
   if ((err = snd_async_add_pcm_handler(&AsyncHandler,SoundStream,&AlsaSound::AlsaCallBackStub,this)) < 0) {
     Polling = true; 
@@ -419,90 +412,59 @@ void AlsaSound::AlsaCallBack(void)
     // Get the number of available frames in the output buffer.
     avail = snd_pcm_avail_update(SoundStream);
     while(avail >= (1L << FragSize)) {
+      const UBYTE *samples;
+      ULONG cpy;
+      int err;
       // Round down to integers of the fragment size.
       avail &= -(1L << FragSize);
-      // Get the next buffer we want to play back.
-      if (PlayingBuffer == NULL) {
-	struct AudioBufferBase *next = ReadyBuffers.First();
-	// No playing buffer. Pull a new one from the list of ready buffers.
-	if (next && next->FreeSamples() == 0) {
-	  next->Remove();
-	  PlayingBuffer = next;
-	}
-      }
-      if (PlayingBuffer == NULL) {
-	// Ok, check whether we may launch pokey directly here. This might
-	// be valid if the main thread is waiting in the VBI anyhow.	   
+      // Get the next samples we want to play back.
+      samples = Ring.NextSamples(cpy);
+      if (cpy == 0) {
+	// Unfortunately, we cannot directly call pokey
+	// here since we don't know the state of it and whether something
+	// else is currently playing with it. Let the emulation thread
+	// refill the buffer.
 	//printf("AlsaCallBack based ");
-	AdjustUnderrun();
-	if (MayRunPokey) {
-	  //printf("Alsa buffer run out of data, must generate more now\n");
-	  GenerateSamples(avail);
-	  continue;
-	} else {
-	  // Unfortunately, we cannot directly call pokey
-	  // here since we don't know the state of it and whether something
-	  // else is currently playing with it.
-	  return;
-	}
+	Underrun = true;
+	return;
+      }
+      // We do have samples now. Ok, copy as many as required into the output buffer.
+      if (cpy > ULONG(avail))
+	cpy = avail;
+      //
+      // Write the indicated number of bytes into the stream if we can.
+      err = snd_pcm_writei(SoundStream,samples,cpy);
+      // If we have an error, ignore this frame and continue.
+      if (err < 0) {      
+	//printf("underrun %d\n",err);
+	return;
       }
-      if (PlayingBuffer) {
-	int cpy,err;
-	// We do have a buffer now. Ok, copy as many bytes as required into the output buffer.
-	cpy = PlayingBuffer->ReadySamples();
-	if (cpy > avail)
-	  cpy = avail;
-	//
-	// Write the indicated number of bytes into the stream if we can.
-	err = snd_pcm_writei(SoundStream,PlayingBuffer->ReadPtr,cpy);
-	// If we have an error, ignore this frame and continue.
-	if (err < 0) {      
-	  //printf("underrun %d\n",err);
-	  return;
-	}
 #if 0
-	{
-	  static ULONG samplecnt = 0;
-	  static time_t starttime = 0;
-	  static time_t nowtime = 0;
-	  struct timeval tv;
+      {
+	static ULONG samplecnt = 0;
+	static time_t starttime = 0;
+	static time_t nowtime = 0;
+	struct timeval tv;
 
-	  if (starttime == 0) {
-	    gettimeofday(&tv,NULL);
-	    starttime = tv.tv_sec;
-	  }
+	if (starttime == 0) {
 	  gettimeofday(&tv,NULL);
-	  nowtime = tv.tv_sec;
-
-	  if (nowtime> starttime) {
-	    printf("%g\n",samplecnt / (double)((nowtime - starttime)));
-	  }
-	  samplecnt += err;
+	  starttime = tv.tv_sec;
 	}
-#endif
-	//printf("%d.%d.%d\n",avail,cpy,err);
-	// Otherwise, it returns the number of frames (does it?)
-	avail                  -= err;
-	BufferedSamples        -= err;
-	// Adjust the playing buffer pointers now.
-	PlayingBuffer->ReadPtr += err << PlayingBuffer->SampleShift;
-	//
-	// Check whether we have a playing buffer that is empty. If so, put it
-	// back if we can.
-	if (PlayingBuffer->IsEmpty()) {	  
-	  // We're done with it. Dispose it.
-	  FreeBuffers.AddTail(PlayingBuffer);
-	  PlayingBuffer = NULL;
+	gettimeofday(&tv,NULL);
+	nowtime = tv.tv_sec;
+
+	if (nowtime> starttime) {
+	  printf("%g\n",samplecnt / (double)((nowtime - starttime)));
 	}
+	samplecnt += err;
       }
+#endif
+      //printf("%d.%d.%d\n",avail,cpy,err);
+      // Otherwise, it returns the number of frames (does it?)
+      avail                  -= err;
+      // Remove the played samples from the buffer.
+      Ring.ConsumeSamples(err);
     }
-    /*
-    if (BufferedSamples < FragSamples) {
-      // Better enlarge the frequency to avoid the trouble...
-      printf("AlsaCallBack tail based ");
-      AdjustUnderrun();
-    }
-    */
   }
 }
 ///
@@ -524,7 +486,7 @@ void AlsaSound::HBI(void)
     // Compute the number of samples we need to generate this time.
     // Note that the pokey base frequency is the HBI frequency. The number of clocks
     // per HBI is 114.
-    remaining      = EffectiveFreq + DifferentialAdjust; // the number of sampling cycles left this time.
+    remaining      = EffectiveFreq; // the number of sampling cycles left this time.
     // number of samples to generate this time.
     samples        = (remaining * cycles + CycleCarry) / (PokeyFreq * 114);         
     // keep the number of samples we did not take due to round-off   
@@ -533,8 +495,8 @@ void AlsaSound::HBI(void)
     UpdateSamples += samples;
     //
     if (UpdateSamples > 0) {
-      // Compute this number of samples, and put it into the buffer.
-      SuspendAudio();
+      // Compute this number of samples, and put it into the buffer. The
+      // async handler only consumes from the ring, so it may keep running.
       GenerateSamples(UpdateSamples);
       ResumeAudio();
       UpdateSamples     = 0;
@@ -554,26 +516,22 @@ void AlsaSound::UpdateSound(class Timer *delay)
     // Signal that we must update the sound now since the pokey parameters changed.
     UpdateBuffer = true;
     if (delay) {    
-      // Here we are in the VBI state. Check now at the end of the VBI
-      // how many bytes are left.
-      SuspendAudio();
-      DifferentialAdjust = 0;
-      // Check how many bytes we got buffered. If too many, cut the frequency down.
-      if (BufferedSamples > (BufferSize + FragSamples)) {
-	AdjustOverrun();
-      }
+      ULONG ready;
+      // Here we are in the VBI state. Push what we have into the device.
       ResumeAudio();
       //
-      MayRunPokey       = true; // as no one is working with it, go ahead!
       delay->WaitForEvent();    
-      MayRunPokey       = false;
       //
-      SuspendAudio();
-      if (BufferedSamples < (FragSamples << 2)) {
-	// Better enlarge the frequency to avoid the trouble...
+      // Adjust the rate at which samples are generated to the number
+      // of samples left in the buffer.
+      ControlRate();
+      ready = Ring.ReadySamples();
+      if (Underrun || ready < (FragSamples << 2)) {
+	Underrun = false;
+	// Refill the buffer immediately to avoid a near buffer stall.
 	//printf("UpdateSound based ");
-	GenerateSamples((FragSamples << 2) - BufferedSamples);
-	AdjustUnderrun();
+	if (ready < (FragSamples << 2))
+	  GenerateSamples((FragSamples << 2) - ready);
       }
       ResumeAudio();
     } else {
@@ -587,54 +545,6 @@ void AlsaSound::UpdateSound(class Timer *delay)
 }
 ///
 
-/// AlsaSound::AdjustOverrun
-// Signal a buffer overrun
-void AlsaSound::AdjustOverrun(void)
-{
-  LONG newfreq;
-  // The buffer is running too full. This means we are
-  // generating samples too fast. Reduce the sampling frequency.
-  // We must do this very carefully as overruns accumulate data
-  newfreq = (EffectiveFreq * 4095) >> 12;
-  if (newfreq >= EffectiveFreq)
-    newfreq--;
-  EffectiveFreq      = newfreq;
-  DifferentialAdjust = -(LONG(BufferedSamples - BufferSize) * newfreq) >> 13;
-  if (-DifferentialAdjust >= (newfreq >> 1))
-    DifferentialAdjust = -(newfreq >> 1);
-  // Drop buffer bytes we should have generated so far.
-  UpdateSamples = 0;
-#if 0
-  printf("Overrun!  BufBytes = %u Freq now=%d, DA= %d, Target = %d\n",
-	 BufferedSamples,EffectiveFreq + DifferentialAdjust,DifferentialAdjust,BufferSize);
-#endif
-}
-///
-
-/// AlsaSound::AdjustUnderrun
-// Signal a buffer underrun
-void AlsaSound::AdjustUnderrun(void)
-{
-  LONG newfreq;
-  // The buffer is running empty. We are generating
-  // too few samples. Enlarge the effective frequency to keep track.
-  newfreq = (EffectiveFreq << 12) / 4095;
-  if (newfreq <= EffectiveFreq)
-    newfreq++;
-  if (newfreq <= (SamplingFreq << 1))
-    EffectiveFreq    = newfreq;
-  //
-  DifferentialAdjust = 0;
-  // We underrrun, or are near to underrun. We'd better update the
-  // the buffer and flush all buffered bytes to prevent the worst.
-  UpdateBuffer = true;
-#if 0
-  printf("Underrun! BufBytes = %u Freq now=%d, DA = %d, Target = %d\n",
-	 BufferedSamples,EffectiveFreq + DifferentialAdjust,DifferentialAdjust,BufferSize);
-#endif
-}
-///
-
 /// AlsaSound::DisplayStatus
 // Display the status of the sound over the monitor
 void AlsaSound::DisplayStatus(class Monitor *mon)
@@ -660,7 +570,7 @@ void AlsaSound::DisplayStatus(class Monitor *mon)
 		   SamplingFreq,
 		   FragSize,
 		   NumFrags,
-		   BufferedSamples,
+		   LONG(Ring.ReadySamples()),
 		   EffectiveFreq,
 		   Stereo?("on"):("off"),
 		   Interleaved?("on"):("off"),
@@ -700,7 +610,6 @@ void AlsaSound::ParseArgs(class ArgParser *args)
     snd_pcm_close(SoundStream);
     SoundStream = NULL;
     CleanBuffer();
-    BufferedSamples = 0;
   }
   if (enable) {
     EnableSound = true;
@@ -47,21 +47,14 @@ class AlsaSound : public Sound {
   // new samples
   snd_async_handler_t *AsyncHandler;
   //
-  // The following bool is set if Pokey is currently not
-  // in use and we may run it to get more samples.
-  bool                 MayRunPokey;
+  // The following bool is set by the async handler if it
+  // ran out of samples.
+  volatile bool        Underrun;
   //
   // The following bool is set in case the async handler
   // can be run savely.
   volatile bool        AbleIRQ;
   //
-  // Effective output frequency. We reduce or increase this
-  // depending on whether the buffer over- or underruns.
-  LONG                 EffectiveFreq;
-  //
-  // Differential adjustment (D-part of the control loop)
-  LONG                 DifferentialAdjust;
-  //
   // frequency carry-over from last computation loop
   LONG                 CycleCarry;
   // 
@@ -73,8 +66,6 @@ class AlsaSound : public Sound {
   // buffering and so on.
   LONG                 NumFrags;
   //
-  // Total number of samples in the output buffer
-  ULONG                BufferedSamples;
   ULONG                BufferSize;      // total size of the buffer in samples
   ULONG                FragSamples;     // samples in a fragment
   //
@@ -93,10 +84,6 @@ class AlsaSound : public Sound {
   // delayed the generation to reduce the overhead.
   ULONG                UpdateSamples;
   //
-  // Generate the given number (not in bytes, but in number) of audio samples
-  // and place them into the tail of the ready buffer list.
-  void GenerateSamples(ULONG numsamples);
-  //
   // ALSA callback that gets invoked whenever enough room is in the
   // buffer. This is just the stub function that loads the "this" pointer.
   static void AlsaCallBackStub(snd_async_handler_t *ahandler);
@@ -104,21 +91,17 @@ class AlsaSound : public Sound {
   // The real callback
   void AlsaCallBack(void);
   //
-  // Signal a buffer overrun
-  void AdjustOverrun(void);
-  //
-  // Signal a buffer underrun
-  void AdjustUnderrun(void);
-  //
   // Private setup of the dsp: Initialize and
   // configure the dsp for the user specified
   // parameters. Returns false in case the dsp cannot be setup.
   bool InitializeDsp(void);
   //
-  // Suspend audio playing since we need access to the buffer.
+  // Suspend the async handler since we need to access the
+  // consumer side of the buffer.
   void SuspendAudio(void);
   //
-  // Resume playing, grant buffer access again.
+  // Resume playing, push samples into the device and
+  // enable the async handler again.
   void ResumeAudio(void);
 public:
   // Constructor and destructor
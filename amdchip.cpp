@@ -20,7 +20,7 @@
 // Constructor
 AmdChip::AmdChip(class Machine *mach,ChipType ct,const char *name,int unit,class CartFlash *cf)
   : Chip(mach,name), Saveable(mach,name,unit), cmdState(CmdRead), type(ct), 
-    Modified(false), Enabled(true), Unit(unit), Parent(cf), Rom(NULL)
+    Modified(false), Dirty(NULL), AnyDirty(false), Enabled(true), Unit(unit), Parent(cf), Rom(NULL)
 {
   int i;
   //
@@ -44,11 +44,13 @@ AmdChip::AmdChip(class Machine *mach,ChipType ct,const char *name,int unit,class
   //
   // Allocate the pages for the chip
   if (TotalPages > 0) {
-    Rom = new class FlashPage*[TotalPages];
+    Rom   = new class FlashPage*[TotalPages];
+    Dirty = new bool[TotalPages];
     //
     // Erase all the pages we hold.
     for(i = 0;i < TotalPages;i++) {
-      Rom[i] = NULL;
+      Rom[i]   = NULL;
+      Dirty[i] = false;
     }
   }
 }
@@ -82,6 +84,7 @@ AmdChip::~AmdChip(void)
     }
     delete Rom;
   }
+  delete[] Dirty;
 }
 ///
 
@@ -130,8 +133,11 @@ void AmdChip::ChipErase(UWORD sector)
     }
   }
 
-  for (i=page_start; i<page_end; i++) 
+  for (i=page_start; i<page_end; i++) {
     Rom[i]->Blank();
+    Dirty[i] = true;
+  }
+  AnyDirty = true;
 }
 ///
 
@@ -183,6 +189,8 @@ bool AmdChip::RomAreaWrite(ADR mem,UBYTE val)
       //printf("Post-Programmed Mem : %04X=%02X (%02X)\n", mem, fp->ReadByte(mem), b);
       cmdState = CmdRead;
       Modified = true;
+      Dirty[(ActiveBank<<5)+((mem-0xA000)>>PAGE_SHIFT)] = true;
+      AnyDirty = true;
       break;
     case CmdErase1:
       if (m == 0x5555 && val == 0xAA)
@@ -281,8 +289,67 @@ void AmdChip::WriteToFile(FILE *fp)
     if (!Rom[i]->WriteToFile(fp))
       ThrowIo("AmdChip::WriteToFile","failed to write the AMD FlashROM image to file");
   }
-  // No saving required anymore.
+  // No saving required anymore, and the journal
+  // is no longer needed either.
   Modified = false;
+  AnyDirty = false;
+  for (i=0; i<TotalPages; i++)
+    Dirty[i] = false;
+}
+///
+
+/// AmdChip::WriteJournal
+// Append all pages modified since the last call to the journal.
+// Runs of erased pages are kept as a single record.
+void AmdChip::WriteJournal(class FlashJournal *journal)
+{
+  int i = 0,first;
+
+  if (AnyDirty) {
+    while(i < TotalPages) {
+      if (Dirty[i]) {
+	if (Rom[i]->isBlank()) {
+	  first = i;
+	  while(i < TotalPages && Dirty[i] && Rom[i]->isBlank()) {
+	    Dirty[i] = false;
+	    i++;
+	  }
+	  journal->WriteErase(Unit,first,i - first);
+	  continue;
+	}
+	journal->WritePage(Unit,i,Rom[i]->Memory());
+	Dirty[i] = false;
+      }
+      i++;
+    }
+    AnyDirty = false;
+  }
+}
+///
+
+/// AmdChip::RestorePages
+// Restore pages from a journal record. Returns false if the
+// record does not fit into this chip.
+bool AmdChip::RestorePages(const struct FlashJournal::Record &rec)
+{
+  int i;
+
+  if (ULONG(rec.Page) + rec.Count > ULONG(TotalPages))
+    return false;
+  //
+  // The restored pages are not in the image, hence the chip is
+  // modified, and they must go into the next journal.
+  for (i=rec.Page; i<rec.Page+rec.Count; i++) {
+    if (rec.Erase) {
+      Rom[i]->Blank();
+    } else {
+      memcpy(Rom[i]->Memory(),rec.Data,256);
+    }
+    Dirty[i] = true;
+  }
+  Modified = true;
+  AnyDirty = true;
+  return true;
 }
 ///
 
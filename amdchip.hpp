@@ -14,6 +14,7 @@
 #include "chip.hpp"
 #include "memcontroller.hpp"
 #include "saveable.hpp"
+#include "flashjournal.hpp"
 ///
 
 /// Forwards
@@ -69,6 +70,11 @@ private:
   // been written to and requires saving back.
   bool               Modified;
   //
+  // Pages modified since they were last written to the journal,
+  // and an indicator whether there is any.
+  bool              *Dirty;
+  bool               AnyDirty;
+  //
   // The following is true in case the user desires to activate
   // the mapping. Otherwise, no data is read.
   bool               Enabled;
@@ -125,6 +131,13 @@ public:
     return Modified;
   }
   //
+  // Return a boolean indicator whether there are pages the
+  // journal does not know about yet.
+  bool IsDirty(void) const
+  {
+    return AnyDirty;
+  }
+  //
   // Perform a write into the Flash ROM area, possibly modifying the content.
   // This never expects a WSYNC. Default is not to perform any operation.
   // Return code indicates whether this write was useful for this cart.
@@ -139,6 +152,13 @@ public:
   void ReadFromFile(FILE *fp);
   void WriteToFile(FILE *fp);
   //
+  // Append all pages modified since the last call to the journal.
+  void WriteJournal(class FlashJournal *journal);
+  //
+  // Restore pages from a journal record. Returns false if the
+  // record does not fit into this chip.
+  bool RestorePages(const struct FlashJournal::Record &rec);
+  //
   // Map the chip into the 6502 address space
   bool MapChip(class MMU *mmu,UBYTE activebank);
   //
@@ -471,6 +471,12 @@ public:
     return YPos;
   }
   //
+  // Return the number of lines of a frame, PAL or NTSC.
+  LONG FrameLines(void) const
+  {
+    return TotalLines;
+  }
+  //
   // Return the required modulo = width and height of a suitable display
   // buffer for any kind of interface function.
   void DisplayDimensions(UWORD &width,UWORD &height)
@@ -15,6 +15,7 @@
 #include "monitor.hpp"
 #include "argparser.hpp"
 #include "antic.hpp"
+#include "sound.hpp"
 #include "sighandler.hpp"
 #include "errorrequester.hpp"
 #include "choicerequester.hpp"
@@ -95,6 +96,7 @@ void Atari::EmulationLoop(void)
   //
   LONG usecs;
   LONG missedframes;
+  class Sound *sound;
   bool redo = false;
   //
   // Compute the refresh rate as the VBI delay in micro seconds
@@ -171,7 +173,13 @@ void Atari::EmulationLoop(void)
 	  //
 	  // Now check whether we run out of time for this refresh
 	  //
-	  if (!VBITimer->EventIsOver() || missedframes >= MaxMiss) {
+	  sound = machine->Sound();
+	  if (sound && sound->isOffline()) {
+	    // The sound output is rendered offline, hence there is
+	    // no time base to follow. Refresh the display only if
+	    // the sound driver wants it.
+	    machine->VBI(VBITimer,sound->isVideoSkipped());
+	  } else if (!VBITimer->EventIsOver() || missedframes >= MaxMiss) {
 	    // Ok, we either still have time to, or we need to 
 	    // generate the display. This also drives all other
 	    // frequent activity.
@@ -2,7 +2,7 @@
  **
  ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
  **
- ** $Id: audiobuffer.cpp,v 1.7 2015/05/21 18:52:35 thor Exp $
+ ** $Id: audiobuffer.cpp,v 1.8 2020/04/19 16:21:07 thor Exp $
  **
  ** In this module: Audio buffer abstraction class provided to collect pokey
  ** output.
@@ -11,49 +11,208 @@
 /// Includes
 #include "types.hpp"
 #include "new.hpp"
+#include "string.hpp"
 #include "audiobuffer.hpp"
 ///
 
-/// AudioBufferBase::AudioBufferBase
-AudioBufferBase::AudioBufferBase(void)
-  : Buffer(NULL), BufferEnd(NULL), ReadPtr(NULL), WritePtr(NULL), Size(0)
+/// AudioBuffer::AudioBuffer
+AudioBuffer::AudioBuffer(void)
+  : Buffer(NULL), Mask(0), Head(0), Tail(0), SampleShift(0), Writer(NULL)
+{
+  memset(Silence,0,sizeof(Silence));
+}
+///
+
+/// AudioBuffer::~AudioBuffer
+// Dispose an audio buffer
+AudioBuffer::~AudioBuffer(void)
 {
+  delete[] Buffer;
 }
 ///
 
-/// AudioBufferBase::Realloc
-// Re-allocate a buffer for the given number of samples
-void AudioBufferBase::Realloc(ULONG size)
+/// AudioBuffer::Allocate
+// Allocate the buffer for at least the given number of samples in
+// the given sample format. This also empties the buffer.
+void AudioBuffer::Allocate(ULONG samples,bool signedsamples,bool stereo,bool sixteenbit,
+			   bool littleendian,bool interleaved)
 {
-  // First compute how many bytes we need.
-  size <<= SampleShift;
+  ULONG size;
+  UBYTE zero = 0;
+  //
+  // Compute the bitshift for the number of bytes per sample.
+  SampleShift = 0;
+  if (stereo)      SampleShift++;
+  if (sixteenbit)  SampleShift++;
+  if (interleaved) SampleShift++;
+  Writer      = WriterOf(signedsamples,stereo,sixteenbit,littleendian,interleaved);
+  Writer(Silence,&zero,&zero,1);
   //
-  // Then check whether we have to enlarge the buffer.
-  if (size > Size) {
+  // Round the size up to a power of two.
+  size = 1UL << SampleShift;
+  while((size >> SampleShift) < samples)
+    size <<= 1;
+  //
+  if (Buffer == NULL || Mask + 1 != size) {
     delete[] Buffer;
-    Buffer    = NULL;
-    Buffer    = new UBYTE[size];
-    Size      = size;
-    BufferEnd = Buffer + size;
+    Buffer = NULL;
+    Buffer = new UBYTE[size];
+    Mask   = size - 1;
   }
-  // Re-seat read and write pointers.
-  ReadPtr = WritePtr = Buffer;
+  Reset();
 }
 ///
 
-/// AudioBufferBase::~AudioBufferBase
-// Dispose an audio buffer
-AudioBufferBase::~AudioBufferBase(void)
+/// AudioBuffer::PutSamples
+// Producer side: Convert samples of the left and right pokey into
+// the buffer. Returns the number of samples that fit into the buffer.
+ULONG AudioBuffer::PutSamples(const UBYTE *left,const UBYTE *right,ULONG count)
 {
-  delete[] Buffer;
+  ULONG head = Head;
+  ULONG free = FreeSamples();
+  ULONG done = 0;
+  //
+  if (count > free)
+    count = free;
+  //
+  // This runs at most twice: Once up to the end of the buffer, once
+  // from its start. As the sample size is a power of two, a sample is
+  // never split at the end of the buffer.
+  while(count) {
+    ULONG offset = head & Mask;
+    ULONG todo   = (Mask + 1 - offset) >> SampleShift;
+    if (todo > count)
+      todo = count;
+    Writer(Buffer + offset,left + done,right + done,todo);
+    head  += todo << SampleShift;
+    done  += todo;
+    count -= todo;
+  }
+  //
+  // Make the samples visible to the consumer.
+  StoreCounter(Head,head);
+  //
+  return done;
+}
+///
+
+/// AudioBuffer::NextSamples
+// Consumer side: Return a pointer to the samples available for
+// playing that are contiguous in memory, and their number.
+const UBYTE *AudioBuffer::NextSamples(ULONG &count) const
+{
+  ULONG ready  = ReadySamples();
+  ULONG offset = Tail & Mask;
+  //
+  count = (Mask + 1 - offset) >> SampleShift;
+  if (count > ready)
+    count = ready;
+  //
+  return Buffer + offset;
+}
+///
+
+/// AudioBuffer::ReadSamples
+// Consumer side: Copy up to the given number of samples into the
+// target and remove them. Returns the number of samples copied.
+ULONG AudioBuffer::ReadSamples(UBYTE *to,ULONG count)
+{
+  ULONG done = 0;
+  //
+  while(count) {
+    ULONG avail;
+    const UBYTE *from = NextSamples(avail);
+    if (avail == 0)
+      break;
+    if (avail > count)
+      avail = count;
+    memcpy(to,from,avail << SampleShift);
+    ConsumeSamples(avail);
+    to    += avail << SampleShift;
+    done  += avail;
+    count -= avail;
+  }
+  //
+  return done;
+}
+///
+
+/// AudioBuffer::FillSilence
+// Fill the target with the given number of samples of silence.
+void AudioBuffer::FillSilence(UBYTE *to,ULONG count) const
+{
+  ULONG bytes = 1UL << SampleShift;
+  //
+  while(count) {
+    memcpy(to,Silence,bytes);
+    to += bytes;
+    count--;
+  }
+}
+///
+
+/// AudioBuffer::PutSample
+// Place a single sample into the output. Possibly sign-extend it, enlarge it to
+// 16 bit or duplicate it for stereo output.
+template<bool signedsamples,bool stereo,bool sixteenbit,bool littleendian>
+inline void AudioBuffer::PutSample(UBYTE *&to,UBYTE out)
+{
+  // Note that all the following are template parameters whose value is known at
+  // compile time. Hence, evaluation of these is rather fast since it's all
+  // optimized away.
+  //
+  // First level-shift for unsigned output.
+  if (signedsamples == false)
+    out += 128;
+  //
+  // If we have to generate sixteen bit samples, do now.
+  // We never generate negative values here, this makes things a bit
+  // simpler.
+  if (sixteenbit) {
+    if (littleendian) {
+      *to++ = 0;     // lo-byte
+      *to++ = out;   // hi-byte
+    } else {
+      *to++ = out;   // hi-byte
+      *to++ = 0;     // lo-byte
+    }
+    if (stereo) {
+      if (littleendian) {
+	*to++ = 0;   // lo-byte
+	*to++ = out; // hi-byte
+      } else {
+	*to++ = out; // hi-byte
+	*to++ = 0;   // lo-byte
+      }
+    }
+  } else {
+    *to++ = out;
+    if (stereo) {
+      *to++ = out;
+    }
+  }
+}
+///
+
+/// AudioBuffer::WriteSamples
+// Convert pokey samples into the output format. For interleaved output,
+// the sample of the second pokey follows that of the first.
+template<bool signedsamples,bool stereo,bool sixteenbit,bool littleendian,bool interleaved>
+void AudioBuffer::WriteSamples(UBYTE *to,const UBYTE *left,const UBYTE *right,ULONG count)
+{
+  while(count) {
+    PutSample<signedsamples,stereo,sixteenbit,littleendian>(to,*left++);
+    if (interleaved)
+      PutSample<signedsamples,stereo,sixteenbit,littleendian>(to,*right++);
+    count--;
+  }
 }
 ///
 
-/// AudioBufferBase::NewBuffer
-// Construct a new audio buffer with the given parameters; hence, we provide the
-// factory for the generic type.
-struct AudioBufferBase *AudioBufferBase::NewBuffer(bool signedsamples,bool stereo,bool sixteenbit,
-						   bool littleendian,bool interleaved)
+/// AudioBuffer::WriterOf
+// Select the writer for the given sample format.
+AudioBuffer::SampleWriter AudioBuffer::WriterOf(bool signedsamples,bool stereo,bool sixteenbit,
+						bool littleendian,bool interleaved)
 {
   // This is unfortunately a bit lengthy since there are so many parameters, but
   // I can't help it.
@@ -62,29 +221,29 @@ struct AudioBufferBase *AudioBufferBase::NewBuffer(bool signedsamples,bool stere
       if (sixteenbit) {
 	if (littleendian) {
 	  if (interleaved) {
-	    return new AudioBuffer<true,true,true,true,true>;
+	    return &WriteSamples<true,true,true,true,true>;
 	  } else { // interleaved == false
-	    return new AudioBuffer<true,true,true,true,false>;
+	    return &WriteSamples<true,true,true,true,false>;
 	  }
 	} else { // littleendian == false
 	  if (interleaved) {
-	    return new AudioBuffer<true,true,true,false,true>;
+	    return &WriteSamples<true,true,true,false,true>;
 	  } else { // interleaved == false
-	    return new AudioBuffer<true,true,true,false,false>;
+	    return &WriteSamples<true,true,true,false,false>;
 	  }
 	}
       } else { // sixteenbit == false
 	if (littleendian) {
 	  if (interleaved) {
-	    return new AudioBuffer<true,true,false,true,true>;
+	    return &WriteSamples<true,true,false,true,true>;
 	  } else { // interleaved == false
-	    return new AudioBuffer<true,true,false,true,false>;
+	    return &WriteSamples<true,true,false,true,false>;
 	  }
 	} else { // littleendian == false
 	  if (interleaved) {
-	    return new AudioBuffer<true,true,false,false,true>;
+	    return &WriteSamples<true,true,false,false,true>;
 	  } else { // interleaved == false
-	    return new AudioBuffer<true,true,false,false,false>;
+	    return &WriteSamples<true,true,false,false,false>;
 	  }
 	}
       }
@@ -92,29 +251,29 @@ struct AudioBufferBase *AudioBufferBase::NewBuffer(bool signedsamples,bool stere
       if (sixteenbit) {
 	if (littleendian) {
 	  if (interleaved) {
-	    return new AudioBuffer<true,false,true,true,true>;
+	    return &WriteSamples<true,false,true,true,true>;
 	  } else { // interleaved == false
-	    return new AudioBuffer<true,false,true,true,false>;
+	    return &WriteSamples<true,false,true,true,false>;
 	  }
 	} else { // littleendian == false
 	  if (interleaved) {
-	    return new AudioBuffer<true,false,true,false,true>;
+	    return &WriteSamples<true,false,true,false,true>;
 	  } else { // interleaved == false
-	    return new AudioBuffer<true,false,true,false,false>;
+	    return &WriteSamples<true,false,true,false,false>;
 	  }
 	}
       } else { // sixteenbit == false
 	if (littleendian) {
 	  if (interleaved) {
-	    return new AudioBuffer<true,false,false,true,true>;
+	    return &WriteSamples<true,false,false,true,true>;
 	  } else { // interleaved == false
-	    return new AudioBuffer<true,false,false,true,false>;
+	    return &WriteSamples<true,false,false,true,false>;
 	  }
 	} else { // littleendian == false
 	  if (interleaved) {
-	    return new AudioBuffer<true,false,false,false,true>;
+	    return &WriteSamples<true,false,false,false,true>;
 	  } else { // interleaved == false
-	    return new AudioBuffer<true,false,false,false,false>;
+	    return &WriteSamples<true,false,false,false,false>;
 	  }
 	}
       }
@@ -124,29 +283,29 @@ struct AudioBufferBase *AudioBufferBase::NewBuffer(bool signedsamples,bool stere
       if (sixteenbit) {
 	if (littleendian) {
 	  if (interleaved) {
-	    return new AudioBuffer<false,true,true,true,true>;
+	    return &WriteSamples<false,true,true,true,true>;
 	  } else { // interleaved == false
-	    return new AudioBuffer<false,true,true,true,false>;
+	    return &WriteSamples<false,true,true,true,false>;
 	  }
 	} else { // littleendian == false
 	  if (interleaved) {
-	    return new AudioBuffer<false,true,true,false,true>;
+	    return &WriteSamples<false,true,true,false,true>;
 	  } else { // interleaved == false
-	    return new AudioBuffer<false,true,true,false,false>;
+	    return &WriteSamples<false,true,true,false,false>;
 	  }
 	}
       } else { // sixteenbit == false
 	if (littleendian) {
 	  if (interleaved) {
-	    return new AudioBuffer<false,true,false,true,true>;
+	    return &WriteSamples<false,true,false,true,true>;
 	  } else { // interleaved == false
-	    return new AudioBuffer<false,true,false,true,false>;
+	    return &WriteSamples<false,true,false,true,false>;
 	  }
 	} else { // littleendian == false
 	  if (interleaved) {
-	    return new AudioBuffer<false,true,false,false,true>;
+	    return &WriteSamples<false,true,false,false,true>;
 	  } else { // interleaved == false
-	    return new AudioBuffer<false,true,false,false,false>;
+	    return &WriteSamples<false,true,false,false,false>;
 	  }
 	}
       }
@@ -154,29 +313,29 @@ struct AudioBufferBase *AudioBufferBase::NewBuffer(bool signedsamples,bool stere
       if (sixteenbit) {
 	if (littleendian) {
 	  if (interleaved) {
-	    return new AudioBuffer<false,false,true,true,true>;
+	    return &WriteSamples<false,false,true,true,true>;
 	  } else { // interleaved == false
-	    return new AudioBuffer<false,false,true,true,false>;
+	    return &WriteSamples<false,false,true,true,false>;
 	  }
 	} else { // littleendian == false
 	  if (interleaved) {
-	    return new AudioBuffer<false,false,true,false,true>;
+	    return &WriteSamples<false,false,true,false,true>;
 	  } else { // interleaved == false
-	    return new AudioBuffer<false,false,true,false,false>;
+	    return &WriteSamples<false,false,true,false,false>;
 	  }
 	}
       } else { // sixteenbit == false
 	if (littleendian) {
 	  if (interleaved) {
-	    return new AudioBuffer<false,false,false,true,true>;
+	    return &WriteSamples<false,false,false,true,true>;
 	  } else { // interleaved == false
-	    return new AudioBuffer<false,false,false,true,false>;
+	    return &WriteSamples<false,false,false,true,false>;
 	  }
 	} else { // littleendian == false
 	  if (interleaved) {
-	    return new AudioBuffer<false,false,false,false,true>;
+	    return &WriteSamples<false,false,false,false,true>;
 	  } else { // interleaved == false
-	    return new AudioBuffer<false,false,false,false,false>;
+	    return &WriteSamples<false,false,false,false,false>;
 	  }
 	}
       }
@@ -185,250 +344,3 @@ struct AudioBufferBase *AudioBufferBase::NewBuffer(bool signedsamples,bool stere
 }
 ///
 
-/// AudioBufferBase::CopyBuffer
-// Convert the passed in audio buffer into the format of this buffer. 
-// Allocate the new buffer if required.
-void AudioBufferBase::CopyBuffer(struct AudioBufferBase *base)
-{
-  ULONG samples,free,cnt;
-  UBYTE *src,*dst;
-  int offset;
-  //
-  samples = base->ReadySamples();
-  free    = FreeSamples();
-  // Copy at most as many positions as we have free entries!
-  if (samples > free)
-    samples = free;
-  //
-  // Now copy the stuff over, but first keep source and target.
-  src = base->ReadPtr;
-  dst = WritePtr;
-  cnt = samples;
-  while(cnt) {
-    PutSample(base->GetSample());
-    cnt--;
-  }
-  //
-  // Check whether the target is interleaved. If so, we need to copy the
-  // second buffer as well.
-  if ((offset = ChannelOffset())) {
-    // Ok, re-seat the read and write source and copy the second part
-    // of the data as well.
-    base->ReadPtr = src + base->ChannelOffset();
-    WritePtr      = dst + offset;
-    cnt           = samples;
-    while(cnt) {
-      PutSample(base->GetSample());
-      cnt--;
-    }
-    base->ReadPtr -= base->ChannelOffset();
-    WritePtr      -= offset;
-  }
-}
-///
-
-/// AudioBuffer::AudioBuffer
-template<bool signedsamples,bool stereo,bool sixteenbit,bool littleendian,bool interleaved>
-AudioBuffer<signedsamples,stereo,sixteenbit,littleendian,interleaved>::AudioBuffer(void)
-{ 
-  SampleShift = 0;
-  //
-  // Double the buffer size for stereo, sixteenbit and interleaving.
-  if (stereo)      SampleShift++;
-  if (sixteenbit)  SampleShift++;
-  if (interleaved) SampleShift++;
-}
-///
-
-/// AudioBuffer::PutSample
-// Place a simple sample into the audio buffer. Possibly sign-extend it, enlarge it to
-// 16 bit or interleave it.
-template<bool signedsamples,bool stereo,bool sixteenbit,bool littleendian,bool interleaved>
-void AudioBuffer<signedsamples,stereo,sixteenbit,littleendian,interleaved>::PutSample(UBYTE out)
-{
-  // Note that all the following are template parameters whose value is known at
-  // compile time. Hence, evaluation of these is rather fast since it's all
-  // optimized away (hopefully!)
-  //
-  // First level-shift for unsigned output.
-  if (signedsamples == false)
-    out += 128;
-  //
-  // If we have to generate sixteen bit samples, do now.
-  // We never generate negative values here, this makes things a bit
-  // simpler.
-  if (sixteenbit) {
-    if (littleendian) {
-      *WritePtr++ = 0;     // lo-byte
-      *WritePtr++ = out;   // hi-byte
-    } else {
-      *WritePtr++ = out;   // hi-byte
-      *WritePtr++ = 0;     // lo-byte
-    }
-    if (stereo) {
-      if (littleendian) {
-	*WritePtr++ = 0;   // lo-byte
-	*WritePtr++ = out; // hi-byte
-      } else {
-	*WritePtr++ = out; // hi-byte
-	*WritePtr++ = 0;   // lo-byte
-      }
-    }
-  } else {
-    *WritePtr++ = out;
-    if (stereo) {
-      *WritePtr++ = out;
-    }
-  }
-  // Check whether we are generating interleaved stereo-sound. If so,
-  // skip the second sample of the pair.
-  if (interleaved) {
-    if (sixteenbit) {
-      WritePtr += 2;
-      if (stereo) {
-	WritePtr += 2;
-      }
-    } else {
-      WritePtr++;
-      if (stereo) {
-	WritePtr++;
-      }
-    }
-  }
-}
-///
-
-/// AudioBuffer::GetSample
-// Return a single sample from the buffer,
-// advance the read pointer accordingly. This is
-// used to convert sample formats.
-template<bool signedsamples,bool stereo,bool sixteenbit,bool littleendian,bool interleaved>
-UBYTE AudioBuffer<signedsamples,stereo,sixteenbit,littleendian,interleaved>::GetSample(void)
-{
-  UBYTE data;
-  //
-  // Extract the proper data from the samples in the buffer.
-  if (sixteenbit) {
-    if (littleendian) {
-      ReadPtr++;
-      data = *ReadPtr++;   // little-endian: Get second hi-byte
-    } else {
-      data = *ReadPtr++;   // otherwise, the hi-byte is here.
-      ReadPtr++;
-    }
-    if (stereo) {
-      // Advance over the second identical sample
-      ReadPtr += 2;
-    }
-  } else {
-    data = *ReadPtr++;
-    if (stereo) {
-      // Advance over the second sample
-      ReadPtr++;
-    }
-  }
-  // Check whether we are generating interleaved stereo-sound. If so,
-  // skip the second sample of the pair.
-  if (interleaved) {
-    if (sixteenbit) {
-      ReadPtr += 2;
-      if (stereo) {
-	ReadPtr += 2;
-      }
-    } else {
-      ReadPtr++;
-      if (stereo) {
-	ReadPtr++;
-      }
-    }
-  }
-  //
-  // Convert to unsigned if asked so.
-  if (signedsamples == false)
-    data -= 128;
-  //
-  return data;
-}
-///
-
-/// AudioBuffer::ChannelOffset
-// Return the offset from here to the next buffer entry
-// of the other (2nd) channel for interleaved data.
-template<bool signedsamples,bool stereo,bool sixteenbit,bool littleendian,bool interleaved>
-int AudioBuffer<signedsamples,stereo,sixteenbit,littleendian,interleaved>::ChannelOffset(void)
-{
-  if (interleaved) {
-    int offset = 1;
-    if (stereo)     offset++;
-    if (sixteenbit) offset++;
-    return offset;
-  } else {
-    return 0;
-  }
-}
-///
-
-/// AudioBuffer::AddOffset
-// Add an offset to all entries in the buffer, starting at the start of
-// the buffer, up to the WritePtr. This is required to add a console
-// offset, possibly, afterwards.
-template<bool signedsamples,bool stereo,bool sixteenbit,bool littleendian,bool interleaved>
-void AudioBuffer<signedsamples,stereo,sixteenbit,littleendian,interleaved>::AddOffset(UBYTE offset)
-{
-  UBYTE *dta = Buffer;
-
-  while(dta < WritePtr) {
-    if (sixteenbit) {
-      if (littleendian) {
-	dta++;
-	*dta++ += offset; // only to the high-byte
-      } else {
-	*dta++ += offset; // only to the high-byte
-	dta++;
-      }
-    } else {
-      *dta++ += offset;
-    }
-    // Whether we are stereo or not does not matter. The same modifications
-    // are applied to both buffers.
-  }
-}
-///
-
-/// AudioBuffer::CheckForMuting
-// Check whether all entries between the first entry and the WritePtr
-// whether the given value equals the passed in value. If not,
-// then it returns true.
-template<bool signedsamples,bool stereo,bool sixteenbit,bool littleendian,bool interleaved>
-bool AudioBuffer<signedsamples,stereo,sixteenbit,littleendian,interleaved>::CheckForMuting(UBYTE value)
-{
-  UBYTE *dta = Buffer;
-
-  // Check whether we must convert the sample back to unsigned.
-  if (signedsamples == false)
-    value += 128;
-  //
-  // Now test in the buffer for a value that is
-  // not the muting value.
-  while(dta < WritePtr) {
-    if (sixteenbit) {
-      if (littleendian) {
-	dta++; // ignore the lo-byte
-	if (*dta++ != value)
-	  return true;
-      } else {
-	if (*dta++ != value)
-	  return true;
-	dta++;
-      }
-    } else {
-      if (*dta++ != value)
-	return true;
-    }
-    // stereo or interleaved does not matter, we handle them similarly and
-    // check both channels.
-  }
-  
-  return false;
-}
-///
@@ -2,7 +2,7 @@
  **
  ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
  **
- ** $Id: audiobuffer.hpp,v 1.8 2015/05/21 18:52:35 thor Exp $
+ ** $Id: audiobuffer.hpp,v 1.9 2020/04/19 16:21:07 thor Exp $
  **
  ** In this module: Audio buffer abstraction class provided to collect pokey
  ** output.
@@ -14,150 +14,145 @@
 /// Includes
 #include "types.h"
 #include "types.hpp"
-#include "list.hpp"
 #include "exceptions.hpp"
 ///
 
-/// Struct AudioBufferBase
-// Definition of an audio buffer. This contains the sample data for one block
-// we submit to the audio/dsp device.
-struct AudioBufferBase : public Node<struct AudioBufferBase> {
-  //
-  AudioBufferBase(void);
-  virtual ~AudioBufferBase(void);
-  //
-  // The buffer we administrate. Its lifetime is controlled by
-  // this structure.
-  UBYTE   *Buffer;
-  // Pointer to the end of the buffer. For easy overrun-checks.
-  UBYTE   *BufferEnd;
-  //
-  // Read-pointer: That's were we read data from.
-  UBYTE   *ReadPtr;
-  //
-  // Write-pointer: That's where audio data is filled in.
-  UBYTE   *WritePtr;
-  //
-  // Size of this buffer in bytes (not samples). This defines how large
-  // the buffer is we allocated.
-  ULONG    Size;
-  //
-  // Compute the bitshift to compute the number bytes per sample, 
-  // required for buffer allocation and similar operations.
-  UBYTE    SampleShift;
-  //
-  // This is the call-in required for pokey to place a 
-  // single sample into the buffer.
-  virtual void PutSample(UBYTE sample) = 0;
-  //
-  // Return a single sample from the buffer,
-  // advance the read pointer accordingly. This is
-  // used to convert sample formats.
-  virtual UBYTE GetSample(void) = 0;
-  //
-  // Return the offset from here to the next buffer entry
-  // of the other (2nd) channel for interleaved data.
-  virtual int ChannelOffset(void) = 0;
-  //
-  // Re-allocate a buffer for the given number of samples
-  void Realloc(ULONG size);
-  //
-  // Construct a new audio buffer with the given parameters; hence, we provide the
-  // factory for the generic type.
-  static struct AudioBufferBase *NewBuffer(bool signedsamples,bool stereo,bool sixteenbit,
-					   bool littleendian,bool interleaved);
-  //
-  // Return the number of available bytes for playing.
-  ULONG ReadyBytes(void) const
+/// Class AudioBuffer
+// The audio buffer is a ring buffer of a power-of-two size that keeps
+// the samples in the format of the audio output device. It is filled
+// by exactly one producer, the emulation thread running pokey, and
+// drained by exactly one consumer, which might be an audio callback
+// or signal handler of the output device. Neither side ever locks:
+// The producer only updates the head, the consumer only the tail.
+class AudioBuffer {
+  //
+  // The buffer itself.
+  UBYTE          *Buffer;
+  //
+  // The size of the buffer in bytes minus one. As the size is a
+  // power of two, this masks out the buffer offset from the
+  // free-running head and tail counters.
+  ULONG           Mask;
+  //
+  // The number of bytes written into the buffer so far. This is
+  // only modified by the producer.
+  volatile ULONG  Head;
+  //
+  // The number of bytes consumed from the buffer so far. This is
+  // only modified by the consumer.
+  volatile ULONG  Tail;
+  //
+  // The bit shift to compute the number of bytes per sample.
+  UBYTE           SampleShift;
+  //
+  // A single sample of silence in the output format.
+  UBYTE           Silence[8];
+  //
+  // The writer that converts pokey samples into the output format.
+  // It takes the samples of the left and right pokey, and the number
+  // of samples to convert.
+  typedef void (*SampleWriter)(UBYTE *to,const UBYTE *left,const UBYTE *right,ULONG count);
+  SampleWriter    Writer;
+  //
+  // Place a single pokey sample into the output.
+  template<bool signedsamples,bool stereo,bool sixteenbit,bool littleendian>
+  static inline void PutSample(UBYTE *&to,UBYTE out);
+  //
+  // Convert pokey samples into the output format. This is templated by
+  // signed-ness, stereo, sixteenbit, big/little endian and interleaving
+  // such that all format decisions are made at compile time.
+  template<bool signedsamples,bool stereo,bool sixteenbit,bool littleendian,bool interleaved>
+  static void WriteSamples(UBYTE *to,const UBYTE *left,const UBYTE *right,ULONG count);
+  //
+  // Select the writer for the given sample format.
+  static SampleWriter WriterOf(bool signedsamples,bool stereo,bool sixteenbit,
+			       bool littleendian,bool interleaved);
+  //
+  // Read the head or tail counter such that all data written
+  // before the counter was updated is visible.
+  static ULONG LoadCounter(const volatile ULONG &counter)
   {
-#if CHECK_LEVEL > 0
-    if (WritePtr < ReadPtr) {
-      Throw(OutOfRange,"AudioBufferBase::ReadyBytes","an empty audio buffer has been detected in the queue");
-    }
+#if HAS_ATOMIC_BUILTINS
+    return __atomic_load_n(&counter,__ATOMIC_ACQUIRE);
+#else
+    return counter;
 #endif
-    return ULONG(WritePtr - ReadPtr);
   }
   //
-  // Return the number of free bytes that can be filled.
-  ULONG FreeBytes(void) const
+  // Update the head or tail counter after all data has been
+  // written or read.
+  static void StoreCounter(volatile ULONG &counter,ULONG value)
   {
-#if CHECK_LEVEL > 0
-    if (BufferEnd < WritePtr) {
-      Throw(OutOfRange,"AudioBufferBase::FreeBytes","an overrun audio buffer has been detected in the queue");
-    }
+#if HAS_ATOMIC_BUILTINS
+    __atomic_store_n(&counter,value,__ATOMIC_RELEASE);
+#else
+    counter = value;
 #endif
-    return ULONG(BufferEnd - WritePtr);
   }
   //
-  // Return the number of available samples for playing
-  ULONG ReadySamples(void) const
+public:
+  AudioBuffer(void);
+  ~AudioBuffer(void);
+  //
+  // Allocate the buffer for at least the given number of samples in
+  // the given sample format. This also empties the buffer, hence
+  // neither the producer nor the consumer may be active.
+  void Allocate(ULONG samples,bool signedsamples,bool stereo,bool sixteenbit,
+		bool littleendian,bool interleaved);
+  //
+  // Empty the buffer. Neither the producer nor the consumer may be
+  // active while this is called.
+  void Reset(void)
   {
-    return ReadyBytes() >> SampleShift;
+    Head = Tail = 0;
   }
   //
-  // Return the number of free samples
-  ULONG FreeSamples(void) const
+  // Return the bit shift that computes bytes from samples.
+  UBYTE SampleShiftOf(void) const
   {
-    return FreeBytes() >> SampleShift;
+    return SampleShift;
   }
   //
-  // Return whether this buffer is empty.
-  bool IsEmpty(void) const
+  // Return the total number of samples the buffer can hold.
+  ULONG SizeOf(void) const
   {
-    return (ReadPtr >= WritePtr)?(true):(false);
+    return (Buffer)?((Mask + 1) >> SampleShift):(0);
   }
   //
-  // Convert the passed in audio buffer into the format of this buffer. 
-  // Allocate the new buffer if required.
-  void CopyBuffer(struct AudioBufferBase *base);
-  //
-  // Add an offset to all entries in the buffer, starting at the start of
-  // the buffer, up to the ReadPtr. This is required to add a console
-  // offset, possibly, afterwards.
-  virtual void AddOffset(UBYTE offset) = 0;
-  //
-  // Check whether all entries between the first entry and the ReadPtr
-  // whether the given value equals the passed in value. If not,
-  // then it returns true.
-  virtual bool CheckForMuting(UBYTE value) = 0;
-};
-///
-
-/// Templated AudioBuffer
-// This buffer is templated by signed-ness, stereo, sixteenbit, big/little endian, and interleaving
-// The implementation depends on all these parameters (yuck!).
-// Luckely, C++ has generic programming or I'd had to write all this several times.
-template<bool signedsamples,bool stereo,bool sixteenbit,bool littleendian,bool interleaved> 
-struct AudioBuffer : public AudioBufferBase {
-  //   
-  // Constructor and destructor are trivial. All done by the base class.
-  AudioBuffer(void);
+  // Return the number of samples available for playing.
+  ULONG ReadySamples(void) const
+  {
+    return (LoadCounter(Head) - LoadCounter(Tail)) >> SampleShift;
+  }
   //
-  virtual ~AudioBuffer(void)
-  { }
+  // Return the number of samples that can still be filled in.
+  ULONG FreeSamples(void) const
+  {
+    return SizeOf() - ReadySamples();
+  }
   //
-  // This is the call-in required for pokey to place a 
-  // single sample into the buffer.
-  virtual void PutSample(UBYTE sample);  
+  // Producer side: Convert samples of the left and right pokey into
+  // the buffer. The right channel is only used for interleaved output.
+  // Returns the number of samples that fit into the buffer.
+  ULONG PutSamples(const UBYTE *left,const UBYTE *right,ULONG count);
   //
-  // Return a single sample from the buffer,
-  // advance the read pointer accordingly. This is
-  // used to convert sample formats.
-  virtual UBYTE GetSample(void);  
+  // Consumer side: Return a pointer to the samples available for
+  // playing that are contiguous in memory, and their number.
+  const UBYTE *NextSamples(ULONG &count) const;
   //
-  // Return the offset from here to the next buffer entry
-  // of the other (2nd) channel for interleaved data.
-  virtual int ChannelOffset(void);  
+  // Consumer side: Remove the given number of samples from the
+  // buffer after they have been played.
+  void ConsumeSamples(ULONG count)
+  {
+    StoreCounter(Tail,Tail + (count << SampleShift));
+  }
   //
-  // Add an offset to all entries in the buffer, starting at the start of
-  // the buffer, up to the ReadPtr. This is required to add a console
-  // offset, possibly, afterwards.
-  virtual void AddOffset(UBYTE offset);
+  // Consumer side: Copy up to the given number of samples into the
+  // target and remove them. Returns the number of samples copied.
+  ULONG ReadSamples(UBYTE *to,ULONG count);
   //
-  // Check whether all entries between the first entry and the ReadPtr
-  // whether the given value equals the passed in value. If not,
-  // then it returns true.
-  virtual bool CheckForMuting(UBYTE value);
+  // Fill the target with the given number of samples of silence.
+  void FillSilence(UBYTE *to,ULONG count) const;
 };
 ///
 
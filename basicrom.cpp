@@ -205,6 +205,9 @@ void BasicROM::LoadROM(void)
 {
   BasicType type = ROMType();
 
+  // Patches of the previous run went into the old image, hence
+  // always start from a fresh one.
+  ReleaseImage();
   switch(type) {
   case Basic_RevA:
     // Ok, try to load Basic RevA.
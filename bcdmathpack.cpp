@@ -0,0 +1,1042 @@
+/***********************************************************************************
+ **
+ ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
+ **
+ ** $Id: bcdmathpack.cpp,v 1.1 2020/04/26 12:41:17 thor Exp $
+ **
+ ** In this module: Native BCD implementation of the Os math pack
+ **********************************************************************************/
+
+/// Includes
+#include "bcdmathpack.hpp"
+#include "adrspace.hpp"
+#include "string.hpp"
+///
+
+/// BCDMathPack::BCDMathPack
+BCDMathPack::BCDMathPack(void)
+{
+  memset(Reg,0,sizeof(Reg));
+}
+///
+
+/// BCDMathPack::~BCDMathPack
+BCDMathPack::~BCDMathPack(void)
+{
+}
+///
+
+/// BCDMathPack::Load
+// Load the page zero work area into the image.
+void BCDMathPack::Load(class AdrSpace *adr)
+{
+  int i;
+
+  for(i = WorkStart;i < 256;i++) {
+    Reg[i] = adr->ReadByte(ADR(i));
+  }
+}
+///
+
+/// BCDMathPack::Store
+// Write the image back into page zero.
+void BCDMathPack::Store(class AdrSpace *adr) const
+{
+  int i;
+
+  for(i = WorkStart;i < 256;i++) {
+    adr->WriteByte(ADR(i),Reg[i]);
+  }
+}
+///
+
+/// BCDMathPack::ReadMemory
+// Read a byte of memory, or of the work area in the image.
+UBYTE BCDMathPack::ReadMemory(class AdrSpace *adr,ADR mem) const
+{
+  mem &= 0xffff;
+  if (mem >= WorkStart && mem < 0x100)
+    return Reg[mem];
+  return adr->ReadByte(mem);
+}
+///
+
+/// BCDMathPack::WriteMemory
+// Write a byte of memory, or of the work area in the image.
+void BCDMathPack::WriteMemory(class AdrSpace *adr,ADR mem,UBYTE val)
+{
+  mem &= 0xffff;
+  if (mem >= WorkStart && mem < 0x100) {
+    Reg[mem] = val;
+  } else {
+    adr->WriteByte(mem,val);
+  }
+}
+///
+
+/// BCDMathPack::AddDecimal
+// Add two bytes with carry in decimal mode, exactly as the CPU
+// emulation does.
+UBYTE BCDMathPack::AddDecimal(UBYTE a,UBYTE b,bool &carry)
+{
+  UWORD al = UWORD((a & 0x0f) + (b & 0x0f) + (carry?1:0));
+  UWORD ah = UWORD((a & 0xf0) + (b & 0xf0));
+  //
+  if (al > 9) {
+    al += 6;
+    ah += 0x10;
+  }
+  if (ah > 0x90)
+    ah += 0x60;
+  //
+  carry = (ah >= 0x100);
+  return UBYTE(ah | (al & 0x0f));
+}
+///
+
+/// BCDMathPack::SubDecimal
+// Subtract two bytes with borrow in decimal mode, exactly as the CPU
+// emulation does. The carry is set if no borrow occured.
+UBYTE BCDMathPack::SubDecimal(UBYTE a,UBYTE b,bool &carry)
+{
+  UWORD al = UWORD((a & 0x0f) - (b & 0x0f) - (carry?0:1));
+  UWORD ah = UWORD((a & 0xf0) - (b & 0xf0));
+  //
+  // The carry is that of the binary subtraction, which is the same
+  // as that of the decimal subtraction.
+  carry = (int(a) - int(b) - (carry?0:1)) >= 0;
+  if (al & 0x10) {
+    al -= 6;
+    ah -= 0x10;
+  }
+  if (ah & 0x100)
+    ah -= 0x60;
+  //
+  return UBYTE(ah | (al & 0x0f));
+}
+///
+
+/// BCDMathPack::ClearRegisters
+// Clear the given number of registers from the given page zero
+// address on.
+void BCDMathPack::ClearRegisters(UBYTE reg,UBYTE count)
+{
+  do {
+    Reg[reg++] = 0;
+  } while(--count);
+}
+///
+
+/// BCDMathPack::ShiftDigitLeft
+// Shift the five mantissa bytes from the given address on left by
+// a digit, return the digit shifted out.
+UBYTE BCDMathPack::ShiftDigitLeft(UBYTE reg)
+{
+  UBYTE out = Reg[reg] >> 4;
+  int i;
+  //
+  for(i = 0;i < 4;i++) {
+    Reg[reg + i] = UBYTE((Reg[reg + i] << 4) | (Reg[reg + i + 1] >> 4));
+  }
+  Reg[reg + 4] <<= 4;
+  //
+  return out;
+}
+///
+
+/// BCDMathPack::ShiftRightRounded
+// Shift the mantissa of FR0 right by a byte, rounding by the digits
+// shifted out and inserting the given byte on top. This increments
+// the exponent.
+void BCDMathPack::ShiftRightRounded(UBYTE top)
+{
+  bool carry = (Reg[FR0 + 5] >= 0x50);
+  int i;
+  //
+  for(i = 5;i > 1;i--) {
+    Reg[FR0 + i] = AddDecimal(Reg[FR0 + i - 1],0,carry);
+  }
+  Reg[FR0 + 1] = AddDecimal(top,0,carry);
+  Reg[FR0]++;
+}
+///
+
+/// BCDMathPack::TimesTen
+// Multiply FR0 by ten and shift back if a digit ran over.
+void BCDMathPack::TimesTen(void)
+{
+  UBYTE digit = ShiftDigitLeft(FR0 + 1);
+  //
+  if (digit)
+    ShiftRightRounded(digit);
+}
+///
+
+/// BCDMathPack::ShiftRegisterRight
+// Shift the twelve digit register from FR0 on right by a byte.
+void BCDMathPack::ShiftRegisterRight(void)
+{
+  int i;
+  //
+  for(i = 11;i > 0;i--) {
+    Reg[FR0 + i] = Reg[FR0 + i - 1];
+  }
+  Reg[FR0] = 0;
+}
+///
+
+/// BCDMathPack::NormalizeExtended
+// Normalize FR0 together with its extension, returns true on an
+// overflow. Numbers with a zero exponent are left alone, numbers
+// with a zero mantissa are cleared.
+bool BCDMathPack::NormalizeExtended(void)
+{
+  int shifts,i;
+  //
+  for(shifts = 0;shifts < 5;shifts++) {
+    if (UBYTE(Reg[FR0] << 1) == 0)
+      return false;
+    if (Reg[FR0 + 1])
+      return (Reg[FR0] & 0x7f) >= 0x72;
+    // Shift the mantissa and the extension up by a byte. Note that the
+    // last byte of the extension remains.
+    for(i = 1;i < 7;i++) {
+      Reg[FR0 + i] = Reg[FR0 + i + 1];
+    }
+    Reg[FR0]--;
+  }
+  //
+  // The mantissa is zero.
+  ZFR0();
+  return false;
+}
+///
+
+/// BCDMathPack::NormalizeRounded
+// Normalize FR0 and round it by its extension. Return true on an
+// overflow.
+bool BCDMathPack::NormalizeRounded(void)
+{
+  bool carry;
+  int i;
+  //
+  if (NormalizeExtended())
+    return true;
+  //
+  if (Reg[FRE] < 0x50)
+    return false;
+  //
+  carry = true;
+  for(i = 5;i > 0;i--) {
+    Reg[FR0 + i] = AddDecimal(Reg[FR0 + i],0,carry);
+  }
+  if (!carry)
+    return false;
+  //
+  // The mantissa ran over, shift back in the carry.
+  ShiftRightRounded(1);
+  return (Reg[FR0] & 0x7f) >= 0x72;
+}
+///
+
+/// BCDMathPack::NORMALIZE
+// Normalize FR0, the undocumented call-in at 0xdc00.
+bool BCDMathPack::NORMALIZE(void)
+{
+  Reg[FRE]     = 0;
+  Reg[FRE + 1] = 0;
+  return NormalizeExtended();
+}
+///
+
+/// BCDMathPack::ZFR0
+// Clear FR0.
+bool BCDMathPack::ZFR0(void)
+{
+  ClearRegisters(FR0,6);
+  return false;
+}
+///
+
+/// BCDMathPack::FSUB
+// FR0 - FR1 -> FR0
+bool BCDMathPack::FSUB(void)
+{
+  Reg[FR1] ^= 0x80;
+  return FADD();
+}
+///
+
+/// BCDMathPack::FADD
+// FR0 + FR1 -> FR0. The math pack aligns the smaller operand with
+// truncation, adds or subtracts the mantissas and normalizes without
+// rounding.
+bool BCDMathPack::FADD(void)
+{
+  UBYTE shift,to,from;
+  bool carry;
+  int i;
+  //
+  for(;;) {
+    Reg[EEXP] = Reg[FR1] & 0x7f;
+    shift     = UBYTE((Reg[FR0] & 0x7f) - Reg[EEXP]);
+    if ((shift & 0x80) == 0)
+      break;
+    // FR1 is the larger one, exchange the operands.
+    for(i = 0;i < 6;i++) {
+      UBYTE t       = Reg[FR0 + i];
+      Reg[FR0 + i]  = Reg[FR1 + i];
+      Reg[FR1 + i]  = t;
+    }
+  }
+  //
+  // If the operands are too far apart, the result is just FR0.
+  if (shift >= 5)
+    return NORMALIZE();
+  //
+  // Align FR1 to FR0.
+  carry     = (Reg[FR1] + shift) > 0xff;
+  Reg[FR1] += shift;
+  if (shift) {
+    from = UBYTE((shift ^ 0xff) + 6 + (carry?1:0));
+    to   = 5;
+    do {
+      Reg[UBYTE(FR1 + to)] = Reg[FR1 + from];
+      to--;
+    } while(--from);
+    do {
+      Reg[UBYTE(FR1 + to)] = 0;
+    } while(--to);
+  }
+  //
+  if ((Reg[FR0] ^ Reg[FR1]) & 0x80) {
+    // Signs differ, subtract the mantissas.
+    carry = true;
+    for(i = 5;i > 0;i--) {
+      Reg[FR0 + i] = SubDecimal(Reg[FR0 + i],Reg[FR1 + i],carry);
+    }
+    if (!carry) {
+      // The result is negative, complement and flip the sign.
+      carry = true;
+      for(i = 5;i > 0;i--) {
+	Reg[FR0 + i] = SubDecimal(0,Reg[FR0 + i],carry);
+      }
+      Reg[FR0] ^= 0x80;
+    }
+  } else {
+    carry = false;
+    for(i = 5;i > 0;i--) {
+      Reg[FR0 + i] = AddDecimal(Reg[FR0 + i],Reg[FR1 + i],carry);
+    }
+    if (carry)
+      ShiftRightRounded(1);
+  }
+  //
+  return NORMALIZE();
+}
+///
+
+/// BCDMathPack::PrepareSign
+// Compute the sign of a product or quotient, strip the sign of FR1
+// and return the exponent of FR0.
+UBYTE BCDMathPack::PrepareSign(void)
+{
+  Reg[NSIGN] = (Reg[FR0] ^ Reg[FR1]) & 0x80;
+  Reg[FR1]  &= 0x7f;
+  return Reg[FR0] & 0x7f;
+}
+///
+
+/// BCDMathPack::PrepareMultiply
+// Setup FMUL or FDIV for the given result exponent: Move FR0 into its
+// extension, FR1 into FR2, ten times FR1 into FR2, and clear FR0.
+void BCDMathPack::PrepareMultiply(UBYTE exponent)
+{
+  int i;
+  //
+  Reg[EEXP]   = exponent | Reg[NSIGN];
+  Reg[FR0]    = 0;
+  Reg[FR1]    = 0;
+  Reg[ZTEMP1] = 5;
+  for(i = 5;i >= 0;i--) {
+    Reg[FR2 + i] = Reg[FR1 + i];
+    Reg[FRE + i] = Reg[FR0 + i];
+  }
+  Reg[FR2] = ShiftDigitLeft(FR2 + 1);
+  ZFR0();
+}
+///
+
+/// BCDMathPack::AddMultiple
+// Add the six bytes at the given register the given number of
+// times to FR0.
+void BCDMathPack::AddMultiple(UBYTE reg,UBYTE count)
+{
+  bool carry;
+  int i;
+  //
+  while(count) {
+    carry = false;
+    for(i = 5;i >= 0;i--) {
+      Reg[FR0 + i] = AddDecimal(Reg[FR0 + i],Reg[reg + i],carry);
+    }
+    count--;
+  }
+}
+///
+
+/// BCDMathPack::FMUL
+// FR0 * FR1 -> FR0. The mantissas are multiplied digit by digit
+// into the twelve digit register from FR0 on, which is then rounded.
+bool BCDMathPack::FMUL(void)
+{
+  UBYTE a,exponent;
+  //
+  a        = UBYTE(PrepareSign() - 0x40);
+  exponent = UBYTE(a + Reg[FR1] + 1);
+  // Check for overflow of the signed exponent addition.
+  if ((~(a ^ Reg[FR1])) & (a ^ exponent) & 0x80)
+    return true;
+  if (exponent & 0x80)
+    return ZFR0();
+  //
+  PrepareMultiply(exponent);
+  do {
+    AddMultiple(FR1,Reg[FRE + 5] & 0x0f);
+    AddMultiple(FR2,Reg[FRE + 5] >> 4);
+    ShiftRegisterRight();
+  } while(--Reg[ZTEMP1]);
+  //
+  Reg[FR0] = Reg[EEXP];
+  return NormalizeRounded();
+}
+///
+
+/// BCDMathPack::DivideStep
+// Run the long division step of FDIV for the divisor at the
+// given register, counting up from the given value. Returns the
+// count.
+UBYTE BCDMathPack::DivideStep(UBYTE reg,UBYTE count)
+{
+  bool carry;
+  int i;
+  //
+  for(;;) {
+    carry = true;
+    for(i = 5;i >= 0;i--) {
+      Reg[FRE + i] = SubDecimal(Reg[FRE + i],Reg[reg + i],carry);
+    }
+    if (!carry || ++count == 0)
+      break;
+  }
+  // Undo the last subtraction.
+  for(i = 5;i >= 0;i--) {
+    Reg[FRE + i] = AddDecimal(Reg[FRE + i],Reg[reg + i],carry);
+  }
+  return count;
+}
+///
+
+/// BCDMathPack::FDIV
+// FR0 / FR1 -> FR0. The dividend is kept in the extension of FR0,
+// and the quotient is computed by repeated subtraction.
+bool BCDMathPack::FDIV(void)
+{
+  UBYTE a,exponent;
+  int i;
+  //
+  // Check for a division by zero.
+  if ((Reg[FR1] & 0x7f) == 0 &&
+      (Reg[FR1 + 1] | Reg[FR1 + 2] | Reg[FR1 + 3] | Reg[FR1 + 4] | Reg[FR1 + 5]) == 0)
+    return true;
+  //
+  a        = UBYTE(PrepareSign() - Reg[FR1]);
+  exponent = UBYTE(a + 0x40);
+  if ((~(a ^ 0x40)) & (a ^ exponent) & 0x80)
+    return true;
+  if (exponent & 0x80)
+    return ZFR0();
+  //
+  PrepareMultiply(exponent);
+  for(;;) {
+    a            = UBYTE(DivideStep(FR2,0) << 4);
+    Reg[FR0 + 5] = DivideStep(FR1,a);
+    if (--Reg[ZTEMP1] & 0x80)
+      break;
+    for(i = 0;i < 11;i++) {
+      Reg[FR0 + i] = Reg[FR0 + i + 1];
+    }
+    Reg[FR0 + 11] = Reg[FR1];
+  }
+  //
+  ShiftRegisterRight();
+  Reg[FR0] = Reg[EEXP];
+  return NormalizeRounded();
+}
+///
+
+/// BCDMathPack::IFP
+// Convert the unsigned integer in FR0 into a floating point number
+// by doubling in decimal.
+bool BCDMathPack::IFP(void)
+{
+  bool carry;
+  int bit,i;
+  //
+  Reg[ZTEMP1]     = Reg[FR0];
+  Reg[ZTEMP1 + 1] = Reg[FR0 + 1];
+  ZFR0();
+  Reg[FR0] = 0x42;
+  for(bit = 0;bit < 16;bit++) {
+    carry               = (Reg[ZTEMP1 + 1] & 0x80) != 0;
+    Reg[ZTEMP1 + 1]     = UBYTE((Reg[ZTEMP1 + 1] << 1) | (Reg[ZTEMP1] >> 7));
+    Reg[ZTEMP1]       <<= 1;
+    for(i = 3;i > 0;i--) {
+      Reg[FR0 + i] = AddDecimal(Reg[FR0 + i],Reg[FR0 + i],carry);
+    }
+  }
+  return NORMALIZE();
+}
+///
+
+/// BCDMathPack::TimesFour
+// Multiply the integer under construction by four, return true
+// on an overflow.
+bool BCDMathPack::TimesFour(UBYTE &low)
+{
+  int i;
+  //
+  for(i = 0;i < 2;i++) {
+    bool carry      = (Reg[ZTEMP1 + 1] & 0x80) != 0;
+    Reg[ZTEMP1 + 1] = UBYTE((Reg[ZTEMP1 + 1] << 1) | (low >> 7));
+    low           <<= 1;
+    if (carry)
+      return true;
+  }
+  return false;
+}
+///
+
+/// BCDMathPack::TimesFive
+// Multiply the integer under construction by five, return true
+// on an overflow.
+bool BCDMathPack::TimesFive(UBYTE &low)
+{
+  UBYTE high = Reg[ZTEMP1 + 1];
+  UWORD sum;
+  //
+  Reg[ZTEMP1] = low;
+  if (TimesFour(low))
+    return true;
+  sum             = UWORD(low + Reg[ZTEMP1]);
+  low             = UBYTE(sum);
+  sum             = UWORD(high + Reg[ZTEMP1 + 1] + (sum >> 8));
+  Reg[ZTEMP1 + 1] = UBYTE(sum);
+  return sum > 0xff;
+}
+///
+
+/// BCDMathPack::TimesHundred
+// Multiply the integer under construction by 100, return true on an
+// overflow.
+bool BCDMathPack::TimesHundred(UBYTE &low)
+{
+  return TimesFour(low) || TimesFive(low) || TimesFive(low);
+}
+///
+
+/// BCDMathPack::FPI
+// Convert FR0 into an unsigned integer, with rounding. Returns true if
+// the number is negative or too large.
+bool BCDMathPack::FPI(void)
+{
+  UBYTE exponent = Reg[FR0];
+  UBYTE low      = 0;
+  UBYTE x        = 0;
+  //
+  Reg[ZTEMP1]     = 0;
+  Reg[ZTEMP1 + 1] = 0;
+  if (exponent & 0x80) {
+    exponent &= 0x7f;
+    if (exponent)
+      return true;
+  }
+  if (exponent >= 0x43)
+    return true;
+  Reg[FR0] = 0;
+  if (exponent < 0x3f) {
+    // Less than 1/100, which rounds to zero.
+    Reg[FR0 + 1] = 0;
+    return false;
+  }
+  if (exponent > 0x3f) {
+    // Convert the integer part byte by byte.
+    Reg[EEXP] = exponent - 0x3f;
+    for(;;) {
+      UBYTE digits = Reg[FR0 + 1 + x];
+      UBYTE lo     = digits & 0x0f;
+      UBYTE hi     = digits >> 4;
+      UWORD sum;
+      //
+      Reg[FR0] = UBYTE((hi << 3) + lo);
+      sum      = UWORD(hi * 10 + lo + Reg[ZTEMP1]);
+      low      = UBYTE(sum);
+      if (sum > 0xff) {
+	if (++Reg[ZTEMP1 + 1] == 0)
+	  return true;
+      }
+      if (++x >= Reg[EEXP])
+	break;
+      Reg[FR0 + 5] = x;
+      if (TimesHundred(low))
+	return true;
+      Reg[ZTEMP1] = low;
+    }
+  }
+  //
+  // Round by the first fractional byte.
+  if (Reg[FR0 + 1 + x] >= 0x50) {
+    if (++low == 0) {
+      if (++Reg[ZTEMP1 + 1] == 0)
+	return true;
+    }
+  }
+  Reg[FR0]     = low;
+  Reg[FR0 + 1] = Reg[ZTEMP1 + 1];
+  return false;
+}
+///
+
+/// BCDMathPack::GetDigit
+// Read the character at INBUFF+y, advance y and return true if it is
+// a digit. The character or the digit value is returned in c.
+bool BCDMathPack::GetDigit(class AdrSpace *adr,UBYTE &y,UBYTE &c) const
+{
+  c = ReadMemory(adr,PointerOf(INBUFF) + y++);
+  if (c >= '0' && c <= '9') {
+    c -= '0';
+    return true;
+  }
+  return false;
+}
+///
+
+/// BCDMathPack::AFP
+// Convert the ASCII number at INBUFF+CIX into FR0. Returns true if no
+// number could be found.
+bool BCDMathPack::AFP(class AdrSpace *adr)
+{
+  ADR inbuff = PointerOf(INBUFF);
+  UBYTE y    = Reg[CIX];
+  bool count = false;
+  UBYTE c;
+  //
+  while(ReadMemory(adr,inbuff + y) == ' ') {
+    y++;
+  }
+  Reg[CIX] = y;
+  ClearRegisters(FRX,6);
+  Reg[DIGRT] = 0xff;
+  ClearRegisters(FR0,8);
+  //
+  for(;;) {
+    // Count the characters that are part of the number.
+    if (count)
+      Reg[FCHRFLG]--;
+    count = true;
+    if (GetDigit(adr,y,c)) {
+      if (Reg[FR0 + 1] < 0x10) {
+	// The mantissa is not yet full, shift in the digit.
+	ShiftDigitLeft(FR0 + 1);
+	Reg[FR0 + 5] |= c;
+	if (Reg[DIGRT] & 0x80)
+	  continue;
+	if (--Reg[EEXP])
+	  continue;
+	c = Reg[DIGRT];
+      }
+      // The mantissa is full. Keep the first digit that does
+      // not fit for rounding.
+      if (Reg[FRX] == 0) {
+	Reg[FRE] = UBYTE(c << 4);
+	Reg[FRX]++;
+      }
+      if ((Reg[DIGRT] & 0x80) == 0)
+	continue;
+      if (++Reg[EEXP])
+	continue;
+      // Exponent overflow.
+      Reg[CIX] = y - 1;
+      return true;
+    }
+    if (c == '.') {
+      if ((Reg[DIGRT] & 0x80) == 0)
+	break;
+      Reg[DIGRT]++;
+      count = false;
+      continue;
+    }
+    if (c == 'E') {
+      UBYTE exponent;
+      // An exponent requires a mantissa.
+      if (Reg[FCHRFLG] == 0) {
+	Reg[CIX] = y - 1;
+	return true;
+      }
+      // Remember where to continue if this is not an exponent.
+      Reg[FRX] = y;
+      if (!GetDigit(adr,y,c)) {
+	if (c == '-') {
+	  Reg[ESIGN] = c;
+	} else if (c != '+') {
+	  y = Reg[FRX];
+	  break;
+	}
+	if (!GetDigit(adr,y,c)) {
+	  y = Reg[FRX];
+	  break;
+	}
+      }
+      // At most two exponent digits.
+      Reg[ZTEMP1] = c;
+      exponent    = c;
+      if (GetDigit(adr,y,c)) {
+	Reg[ZTEMP1 + 1] = c;
+	exponent        = UBYTE(Reg[ZTEMP1] * 10 + c);
+	y++;
+      }
+      if (Reg[ESIGN]) {
+	exponent = UBYTE(~exponent);
+	Reg[EEXP]++;
+      }
+      Reg[EEXP] += exponent;
+      break;
+    }
+    // A sign is only allowed in front of the digits.
+    if (Reg[FCHRFLG])
+      break;
+    if (c == '+') {
+      count = false;
+      continue;
+    }
+    if (c == '-') {
+      Reg[NSIGN] = 0x80;
+      count      = false;
+      continue;
+    }
+    Reg[CIX] = y - 1;
+    return true;
+  }
+  //
+  // Compute the exponent to the base of 100, and adjust the
+  // mantissa for odd decimal exponents.
+  Reg[CIX] = y - 1;
+  Reg[FR0] = UBYTE(((Reg[EEXP] >> 1) | (Reg[EEXP] & 0x80)) + 0x44) | Reg[NSIGN];
+  if (Reg[EEXP] & 1)
+    TimesTen();
+  return NormalizeRounded();
+}
+///
+
+/// BCDMathPack::PutChar
+// Write the given character into the output buffer and advance y.
+void BCDMathPack::PutChar(class AdrSpace *adr,UBYTE &y,UBYTE c)
+{
+  WriteMemory(adr,PointerOf(INBUFF) + y,c);
+  y++;
+}
+///
+
+/// BCDMathPack::PrintMantissa
+// Print the mantissa of FR0 with the decimal dot after the given
+// number of bytes.
+void BCDMathPack::PrintMantissa(class AdrSpace *adr,UBYTE &y,UBYTE dot)
+{
+  int x;
+  //
+  Reg[DIGRT] = dot;
+  for(x = 0;;x++) {
+    if (Reg[DIGRT] == 0) {
+      if (x == 0)
+	PutChar(adr,y,'0');
+      PutChar(adr,y,'.');
+    }
+    if (x >= 5)
+      break;
+    Reg[DIGRT]--;
+    // Suppress the leading zero of the first byte, unless the dot
+    // comes right behind it.
+    if ((Reg[FR0 + 1 + x] >> 4) || x) {
+      PutChar(adr,y,(Reg[FR0 + 1 + x] >> 4) | '0');
+    } else if (Reg[DIGRT] & 0x80) {
+      PutChar(adr,y,'0');
+    }
+    PutChar(adr,y,(Reg[FR0 + 1 + x] & 0x0f) | '0');
+  }
+}
+///
+
+/// BCDMathPack::StripZeros
+// Remove trailing zeros and the decimal dot from the output, move
+// y to the last character and return it.
+UBYTE BCDMathPack::StripZeros(class AdrSpace *adr,UBYTE &y) const
+{
+  ADR buffer = PointerOf(INBUFF);
+  UBYTE c;
+  //
+  do {
+    c = ReadMemory(adr,buffer + --y);
+  } while(c == '0');
+  if (c == '.')
+    c = ReadMemory(adr,buffer + --y);
+  //
+  return c;
+}
+///
+
+/// BCDMathPack::FASC
+// Convert FR0 to ASCII into LBUFF and point INBUFF to it. The last
+// character has its high bit set.
+bool BCDMathPack::FASC(class AdrSpace *adr)
+{
+  UBYTE exponent = Reg[FR0] & 0x7f;
+  UBYTE y        = 0;
+  UBYTE last     = 0;
+  //
+  Reg[INBUFF]     = UBYTE(LBUFF);
+  Reg[INBUFF + 1] = UBYTE(LBUFF >> 8);
+  if (exponent) {
+    if (Reg[FR0] & 0x80)
+      PutChar(adr,y,'-');
+    if (exponent >= 0x3f && exponent < 0x45) {
+      // Print in fixed point notation.
+      PrintMantissa(adr,y,exponent - 0x3f);
+      last = StripZeros(adr,y);
+    } else if (exponent > 0x0e || (exponent == 0x0e && Reg[FR0 + 1] >= 0x10)) {
+      // Print in scientific notation with the dot after the first
+      // byte, then move it behind the first digit.
+      UBYTE first = (Reg[FR0] & 0x80)?(1):(0);
+      UBYTE x;
+      //
+      Reg[EEXP] = UBYTE(exponent << 1) ^ 0x80;
+      PrintMantissa(adr,y,1);
+      x = ReadMemory(adr,LBUFF + first + 1);
+      if (x != '.') {
+	WriteMemory(adr,LBUFF + first + 2,x);
+	WriteMemory(adr,LBUFF + first + 1,'.');
+	Reg[EEXP]++;
+      }
+      StripZeros(adr,y);
+      y++;
+      PutChar(adr,y,'E');
+      if (Reg[EEXP] & 0x80) {
+	Reg[EEXP] = UBYTE(-Reg[EEXP]);
+	PutChar(adr,y,'-');
+      } else {
+	PutChar(adr,y,'+');
+      }
+      last = Reg[EEXP];
+      for(x = 0;last >= 10;x++) {
+	last -= 10;
+      }
+      PutChar(adr,y,x | '0');
+    }
+  }
+  PutChar(adr,y,last | '0' | 0x80);
+  //
+  return false;
+}
+///
+
+/// BCDMathPack::LoadRegister
+// Load a floating point register from the given address.
+void BCDMathPack::LoadRegister(class AdrSpace *adr,UBYTE reg,ADR mem)
+{
+  int i;
+  //
+  Reg[FLPTR]     = UBYTE(mem);
+  Reg[FLPTR + 1] = UBYTE(mem >> 8);
+  for(i = 5;i >= 0;i--) {
+    Reg[reg + i] = ReadMemory(adr,mem + i);
+  }
+}
+///
+
+/// BCDMathPack::StoreRegister
+// Store a floating point register at the given address.
+void BCDMathPack::StoreRegister(class AdrSpace *adr,UBYTE reg,ADR mem)
+{
+  int i;
+  //
+  for(i = 5;i >= 0;i--) {
+    WriteMemory(adr,mem + i,Reg[reg + i]);
+  }
+}
+///
+
+/// BCDMathPack::FLD0R
+// Load FR0 from the given address.
+bool BCDMathPack::FLD0R(class AdrSpace *adr,ADR mem)
+{
+  LoadRegister(adr,FR0,mem);
+  return false;
+}
+///
+
+/// BCDMathPack::FLD0P
+// Load FR0 through FLPTR.
+bool BCDMathPack::FLD0P(class AdrSpace *adr)
+{
+  LoadRegister(adr,FR0,PointerOf(FLPTR));
+  return false;
+}
+///
+
+/// BCDMathPack::FLD1R
+// Load FR1 from the given address.
+bool BCDMathPack::FLD1R(class AdrSpace *adr,ADR mem)
+{
+  LoadRegister(adr,FR1,mem);
+  return false;
+}
+///
+
+/// BCDMathPack::FLD1P
+// Load FR1 through FLPTR.
+bool BCDMathPack::FLD1P(class AdrSpace *adr)
+{
+  LoadRegister(adr,FR1,PointerOf(FLPTR));
+  return false;
+}
+///
+
+/// BCDMathPack::FST0R
+// Store FR0 at the given address.
+bool BCDMathPack::FST0R(class AdrSpace *adr,ADR mem)
+{
+  Reg[FLPTR]     = UBYTE(mem);
+  Reg[FLPTR + 1] = UBYTE(mem >> 8);
+  StoreRegister(adr,FR0,mem);
+  return false;
+}
+///
+
+/// BCDMathPack::FST0P
+// Store FR0 through FLPTR.
+bool BCDMathPack::FST0P(class AdrSpace *adr)
+{
+  StoreRegister(adr,FR0,PointerOf(FLPTR));
+  return false;
+}
+///
+
+/// BCDMathPack::FMOVE
+// Copy FR0 to FR1.
+bool BCDMathPack::FMOVE(void)
+{
+  int i;
+  //
+  for(i = 0;i < 6;i++) {
+    Reg[FR1 + i] = Reg[FR0 + i];
+  }
+  return false;
+}
+///
+
+/// BCDMathPack::PLYEVL
+// Evaluate the polynomial of the given number of coefficients at the
+// given address at FR0 by the Horner scheme. The argument is kept in
+// PLYARG.
+bool BCDMathPack::PLYEVL(class AdrSpace *adr,ADR coefficients,UBYTE count)
+{
+  ADR next;
+  //
+  Reg[FPTR2]     = UBYTE(coefficients);
+  Reg[FPTR2 + 1] = UBYTE(coefficients >> 8);
+  Reg[ESIGN]     = count;
+  FST0R(adr,PLYARG);
+  FLD0R(adr,coefficients);
+  while(--Reg[ESIGN]) {
+    FLD1R(adr,PLYARG);
+    if (FMUL())
+      return true;
+    next           = PointerOf(FPTR2) + 6;
+    Reg[FPTR2]     = UBYTE(next);
+    Reg[FPTR2 + 1] = UBYTE(next >> 8);
+    FLD1R(adr,next & 0xffff);
+    if (FADD())
+      return true;
+  }
+  return false;
+}
+///
+
+/// BCDMathPack::Run
+// Run the given routine on the page zero of the address space,
+// including loading and storing the work area. The accumulator is
+// passed in, and the address in the X and Y registers. Returns the
+// carry flag of the ROM version.
+bool BCDMathPack::Run(class AdrSpace *adr,Routine routine,UBYTE a,ADR mem)
+{
+  bool carry;
+  //
+  Load(adr);
+  switch(routine) {
+  case Math_AFP:
+    carry = AFP(adr);
+    break;
+  case Math_FASC:
+    carry = FASC(adr);
+    break;
+  case Math_IFP:
+    carry = IFP();
+    break;
+  case Math_FPI:
+    carry = FPI();
+    break;
+  case Math_FSUB:
+    carry = FSUB();
+    break;
+  case Math_FADD:
+    carry = FADD();
+    break;
+  case Math_FMUL:
+    carry = FMUL();
+    break;
+  case Math_FDIV:
+    carry = FDIV();
+    break;
+  case Math_FLD0R:
+    carry = FLD0R(adr,mem);
+    break;
+  case Math_FLD0P:
+    carry = FLD0P(adr);
+    break;
+  case Math_FLD1R:
+    carry = FLD1R(adr,mem);
+    break;
+  case Math_FLD1P:
+    carry = FLD1P(adr);
+    break;
+  case Math_FST0R:
+    carry = FST0R(adr,mem);
+    break;
+  case Math_FST0P:
+    carry = FST0P(adr);
+    break;
+  case Math_FMOVE:
+    carry = FMOVE();
+    break;
+  case Math_PLYEVL:
+    carry = PLYEVL(adr,mem,a);
+    break;
+  case Math_Normalize:
+  default:
+    carry = NORMALIZE();
+    break;
+  }
+  Store(adr);
+  //
+  return carry;
+}
+///
@@ -0,0 +1,250 @@
+/***********************************************************************************
+ **
+ ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
+ **
+ ** $Id: bcdmathpack.hpp,v 1.1 2020/04/26 12:41:17 thor Exp $
+ **
+ ** In this module: Native BCD implementation of the Os math pack
+ **********************************************************************************/
+
+#ifndef BCDMATHPACK_HPP
+#define BCDMATHPACK_HPP
+
+/// Includes
+#include "types.h"
+#include "types.hpp"
+///
+
+/// Forwards
+class AdrSpace;
+///
+
+/// Class BCDMathPack
+// This class implements the floating point routines of the math pack
+// of the built-in Os natively, though in the very same decimal
+// arithmetic the 6502 code uses. Unlike the double precision
+// replacements of the MathPackPatch, the results are therefore
+// identical to that of the ROM to the last digit, including the
+// rounding and truncation, the error conditions, the formatting of
+// the output, and all the intermediate results the math pack leaves
+// in its page zero work area. Callers and ROM routines that peek into
+// these registers hence see the same values.
+//
+// The routines operate on a copy of the page zero work area that is
+// to be loaded before, and stored back after a routine has been run.
+// All routines return the carry flag of the ROM version, i.e. true
+// on an error.
+class BCDMathPack {
+  //
+  // Names of the page zero registers, following the Os equates.
+  enum {
+    FR0     = 0xd4, // the floating point accumulator
+    FRE     = 0xda, // its extension to twelve digits
+    FR1     = 0xe0, // the second operand
+    FR2     = 0xe6, // temporary register for FMUL and FDIV
+    FRX     = 0xec, // first extra digit flag of AFP
+    EEXP    = 0xed, // exponent under construction, result exponent
+    NSIGN   = 0xee, // sign of the number or of the result
+    ESIGN   = 0xef, // sign of the exponent, PLYEVL counter
+    FCHRFLG = 0xf0, // set if AFP has seen digits
+    DIGRT   = 0xf1, // digits right of the decimal dot
+    CIX     = 0xf2, // offset into the input buffer
+    INBUFF  = 0xf3, // the input or output buffer
+    ZTEMP1  = 0xf5, // temporaries
+    ZTEMP4  = 0xf7,
+    ZTEMP3  = 0xf9,
+    RADFLG  = 0xfb, // degree or radian flag
+    FLPTR   = 0xfc, // pointer to a floating point number
+    FPTR2   = 0xfe, // pointer to the polynomial coefficients
+    WorkStart = FR0 // the first register that belongs to the math pack
+  };
+  //
+  // The output buffer of FASC.
+  enum {
+    LBUFF   = 0x580,
+    PLYARG  = 0x5e0 // the argument of PLYEVL is kept here
+  };
+  //
+  // The page zero image, indexed by the page zero address. Only the
+  // work area from FR0 on is loaded and stored.
+  UBYTE Reg[256];
+  //
+  // Add or subtract two bytes in decimal mode exactly the way the
+  // NMOS 6502 does, including its results on non-decimal input. The
+  // carry is that of the 6502, i.e. it is set if no borrow occured
+  // on a subtraction.
+  static UBYTE AddDecimal(UBYTE a,UBYTE b,bool &carry);
+  static UBYTE SubDecimal(UBYTE a,UBYTE b,bool &carry);
+  //
+  // Read or write a byte of memory. Accesses to the work area go to
+  // the image, FR2 for example is a valid target of FST0R.
+  UBYTE ReadMemory(class AdrSpace *adr,ADR mem) const;
+  void WriteMemory(class AdrSpace *adr,ADR mem,UBYTE val);
+  //
+  // Return a pointer as found in the page zero image.
+  ADR PointerOf(UBYTE reg) const
+  {
+    return ADR(Reg[reg]) | (ADR(Reg[reg + 1]) << 8);
+  }
+  //
+  // Clear the given number of registers from the given page zero
+  // address on.
+  void ClearRegisters(UBYTE reg,UBYTE count);
+  //
+  // Shift the five mantissa bytes from the given address on left by
+  // a digit, return the digit shifted out.
+  UBYTE ShiftDigitLeft(UBYTE reg);
+  //
+  // Shift the mantissa of FR0 right by a byte, rounding by the digits
+  // shifted out and inserting the given byte on top. This increments
+  // the exponent.
+  void ShiftRightRounded(UBYTE top);
+  //
+  // Multiply FR0 by ten and shift back if a digit ran over.
+  void TimesTen(void);
+  //
+  // Shift the twelve digit register from FR0 on right by a byte.
+  void ShiftRegisterRight(void);
+  //
+  // Normalize FR0 together with its extension, returns true on an
+  // overflow.
+  bool NormalizeExtended(void);
+  //
+  // As above, but also round FR0 by its extension.
+  bool NormalizeRounded(void);
+  //
+  // Compute the sign of a product or quotient, strip the sign of FR1
+  // and return the exponent of FR0.
+  UBYTE PrepareSign(void);
+  //
+  // Setup FMUL or FDIV for the given result exponent: Move the
+  // operand of FR0 into its extension, FR1 into FR2 and ten times
+  // FR1 into FR2, clear FR0.
+  void PrepareMultiply(UBYTE exponent);
+  //
+  // Add the six bytes at the given register the given number of
+  // times to FR0.
+  void AddMultiple(UBYTE reg,UBYTE count);
+  //
+  // Run the long division step of FDIV for the divisor at the
+  // given register, counting up from the given value. Returns the
+  // count.
+  UBYTE DivideStep(UBYTE reg,UBYTE count);
+  //
+  // Multiply the integer under construction by FPI by 100. The low
+  // byte is passed in, the high byte is in ZTEMP1+1. Returns true
+  // on an overflow.
+  bool TimesHundred(UBYTE &low);
+  bool TimesFour(UBYTE &low);
+  bool TimesFive(UBYTE &low);
+  //
+  // Read the character at INBUFF+y, advance y and return true if
+  // it is a digit. The character or the digit value is returned in
+  // c.
+  bool GetDigit(class AdrSpace *adr,UBYTE &y,UBYTE &c) const;
+  //
+  // Write the given character into the output buffer and advance y.
+  void PutChar(class AdrSpace *adr,UBYTE &y,UBYTE c);
+  //
+  // Print the mantissa of FR0 with the decimal dot after the given
+  // number of bytes.
+  void PrintMantissa(class AdrSpace *adr,UBYTE &y,UBYTE dot);
+  //
+  // Remove trailing zeros and the decimal dot from the output, move
+  // y to the last character and return it.
+  UBYTE StripZeros(class AdrSpace *adr,UBYTE &y) const;
+  //
+  // Load a floating point register from the given address, or store
+  // it there.
+  void LoadRegister(class AdrSpace *adr,UBYTE reg,ADR mem);
+  void StoreRegister(class AdrSpace *adr,UBYTE reg,ADR mem);
+  //
+public:
+  // The routines that can be run by Run(), numbered as the escape
+  // codes of the MathPackPatch.
+  enum Routine {
+    Math_AFP       = 0,
+    Math_FASC      = 1,
+    Math_IFP       = 2,
+    Math_FPI       = 3,
+    Math_FSUB      = 6,
+    Math_FADD      = 7,
+    Math_FMUL      = 8,
+    Math_FDIV      = 9,
+    Math_FLD0R     = 10,
+    Math_FLD0P     = 11,
+    Math_FLD1R     = 12,
+    Math_FLD1P     = 13,
+    Math_FST0R     = 14,
+    Math_FST0P     = 15,
+    Math_FMOVE     = 16,
+    Math_PLYEVL    = 17,
+    Math_Normalize = 27
+  };
+  //
+  BCDMathPack(void);
+  ~BCDMathPack(void);
+  //
+  // Run the given routine on the page zero of the address space,
+  // including loading and storing the work area. The accumulator is
+  // passed in, and the address in the X and Y registers. Returns the
+  // carry flag of the ROM version.
+  bool Run(class AdrSpace *adr,Routine routine,UBYTE a,ADR mem);
+  //
+  // Load the page zero work area into the image.
+  void Load(class AdrSpace *adr);
+  //
+  // Write the image back into page zero.
+  void Store(class AdrSpace *adr) const;
+  //
+  // Convert the ASCII number at INBUFF+CIX into FR0.
+  bool AFP(class AdrSpace *adr);
+  //
+  // Convert FR0 to ASCII into LBUFF and point INBUFF to it.
+  bool FASC(class AdrSpace *adr);
+  //
+  // Convert the unsigned integer in FR0 into a floating point number.
+  bool IFP(void);
+  //
+  // Convert FR0 into an unsigned integer, with rounding.
+  bool FPI(void);
+  //
+  // Clear FR0.
+  bool ZFR0(void);
+  //
+  // FR0 - FR1 -> FR0
+  bool FSUB(void);
+  //
+  // FR0 + FR1 -> FR0
+  bool FADD(void);
+  //
+  // FR0 * FR1 -> FR0
+  bool FMUL(void);
+  //
+  // FR0 / FR1 -> FR0
+  bool FDIV(void);
+  //
+  // Evaluate the polynomial of the given number of coefficients at the
+  // given address at FR0.
+  bool PLYEVL(class AdrSpace *adr,ADR coefficients,UBYTE count);
+  //
+  // Normalize FR0, the undocumented call-in at 0xdc00.
+  bool NORMALIZE(void);
+  //
+  // Load FR0 or FR1 from the given address, or through FLPTR.
+  bool FLD0R(class AdrSpace *adr,ADR mem);
+  bool FLD0P(class AdrSpace *adr);
+  bool FLD1R(class AdrSpace *adr,ADR mem);
+  bool FLD1P(class AdrSpace *adr);
+  //
+  // Store FR0 at the given address, or through FLPTR.
+  bool FST0R(class AdrSpace *adr,ADR mem);
+  bool FST0P(class AdrSpace *adr);
+  //
+  // Copy FR0 to FR1.
+  bool FMOVE(void);
+};
+///
+
+///
+#endif
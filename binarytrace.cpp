@@ -0,0 +1,273 @@
+/***********************************************************************************
+ **
+ ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
+ **
+ ** $Id: binarytrace.cpp,v 1.1 2020/05/09 14:02:11 thor Exp $
+ **
+ ** In this module: Compact binary trace of the executed instructions
+ **********************************************************************************/
+
+/// Includes
+#include "binarytrace.hpp"
+#include "exceptions.hpp"
+#include "string.hpp"
+#include "new.hpp"
+#include <errno.h>
+///
+
+/// Statics
+const char BinaryTrace::Magic[8] = {'A','+','+','T','R','C','0','2'};
+///
+
+/// BinaryTrace::BinaryTrace
+BinaryTrace::BinaryTrace(void)
+  : File(NULL), Writing(false), FrameLines(0), Buffer(NULL), BufPtr(0), BufEnd(0)
+{
+  memset(&Last,0,sizeof(Last));
+}
+///
+
+/// BinaryTrace::~BinaryTrace
+BinaryTrace::~BinaryTrace(void)
+{
+  // Errors cannot be reported here anymore.
+  if (File) {
+    if (Writing && BufPtr > 0)
+      fwrite(Buffer,1,BufPtr,File);
+    fclose(File);
+  }
+  delete[] Buffer;
+}
+///
+
+/// BinaryTrace::Flush
+// Write the buffer out.
+void BinaryTrace::Flush(void)
+{
+  if (BufPtr > 0) {
+    if (fwrite(Buffer,1,BufPtr,File) != size_t(BufPtr)) {
+      BufPtr = 0;
+      ThrowIo("BinaryTrace::Flush","failed to write the trace file");
+    }
+    BufPtr = 0;
+  }
+}
+///
+
+/// BinaryTrace::GetByte
+// Read a byte from the buffer, refill it if required.
+bool BinaryTrace::GetByte(UBYTE &b)
+{
+  if (BufPtr >= BufEnd) {
+    BufEnd = LONG(fread(Buffer,1,BufferSize,File));
+    BufPtr = 0;
+    if (BufEnd <= 0) {
+      BufEnd = 0;
+      if (ferror(File))
+	ThrowIo("BinaryTrace::GetByte","failed to read the trace file");
+      return false;
+    }
+  }
+  b = Buffer[BufPtr++];
+  return true;
+}
+///
+
+/// BinaryTrace::PutNumber
+// Write a signed number in variable length coding: The sign goes
+// into the LSB, then seven bits per byte, and the MSB of each byte
+// is set if more bytes follow.
+void BinaryTrace::PutNumber(LONG n)
+{
+  ULONG v = (n < 0)?((ULONG(-(n + 1)) << 1) | 1):(ULONG(n) << 1);
+  //
+  while(v >= 0x80) {
+    PutByte(UBYTE((v & 0x7f) | 0x80));
+    v >>= 7;
+  }
+  PutByte(UBYTE(v));
+}
+///
+
+/// BinaryTrace::GetNumber
+// Read a number in variable length coding.
+bool BinaryTrace::GetNumber(LONG &n)
+{
+  ULONG v   = 0;
+  int shift = 0;
+  UBYTE b;
+  //
+  do {
+    if (!GetByte(b))
+      return false;
+    if (shift < 32)
+      v |= ULONG(b & 0x7f) << shift;
+    shift += 7;
+  } while(b & 0x80);
+  //
+  if (v & 1) {
+    n = -LONG(v >> 1) - 1;
+  } else {
+    n = LONG(v >> 1);
+  }
+  return true;
+}
+///
+
+/// BinaryTrace::OpenForWrite
+// Open a trace file for writing, given the number of lines
+// per frame of the machine. Throws on an error.
+void BinaryTrace::OpenForWrite(const char *name,LONG framelines)
+{
+  Close();
+  //
+  if (Buffer == NULL)
+    Buffer = new UBYTE[BufferSize];
+  File = fopen(name,"wb");
+  if (File == NULL)
+    ThrowIo("BinaryTrace::OpenForWrite","failed to open the trace file");
+  Writing = true;
+  BufPtr  = 0;
+  BufEnd  = 0;
+  memset(&Last,0,sizeof(Last));
+  //
+  memcpy(Buffer,Magic,sizeof(Magic));
+  BufPtr     = sizeof(Magic);
+  FrameLines = framelines;
+  PutNumber(FrameLines);
+}
+///
+
+/// BinaryTrace::OpenForRead
+// Open a trace for reading. Returns false if the file is not
+// a trace, throws on an error.
+bool BinaryTrace::OpenForRead(const char *name)
+{
+  char id[sizeof(Magic)];
+  //
+  Close();
+  //
+  if (Buffer == NULL)
+    Buffer = new UBYTE[BufferSize];
+  File = fopen(name,"rb");
+  if (File == NULL)
+    ThrowIo("BinaryTrace::OpenForRead","failed to open the trace file");
+  Writing = false;
+  BufPtr  = 0;
+  BufEnd  = 0;
+  memset(&Last,0,sizeof(Last));
+  //
+  if (fread(id,1,sizeof(id),File) != sizeof(id) || memcmp(id,Magic,sizeof(Magic)) ||
+      !GetNumber(FrameLines) || FrameLines <= 0) {
+    fclose(File);
+    File = NULL;
+    return false;
+  }
+  return true;
+}
+///
+
+/// BinaryTrace::Close
+// Close the trace file, flushing all data.
+void BinaryTrace::Close(void)
+{
+  if (File) {
+    FILE *file = File;
+    bool failed;
+    //
+    if (Writing) {
+      failed = BufPtr > 0 && fwrite(Buffer,1,BufPtr,File) != size_t(BufPtr);
+      BufPtr = 0;
+      File   = NULL;
+      if (fclose(file) != 0 || failed)
+	ThrowIo("BinaryTrace::Close","failed to write the trace file");
+    } else {
+      File   = NULL;
+      fclose(file);
+    }
+  }
+}
+///
+
+/// BinaryTrace::Write
+// Write an instruction to the trace.
+void BinaryTrace::Write(const struct Record &rec)
+{
+  UBYTE flags = rec.Size & SizeMask;
+  int i;
+  //
+  if (rec.PC != ((Last.PC + Last.Size) & 0xffff))
+    flags |= PCFlag;
+  if (rec.A != Last.A) flags |= AFlag;
+  if (rec.X != Last.X) flags |= XFlag;
+  if (rec.Y != Last.Y) flags |= YFlag;
+  if (rec.S != Last.S) flags |= SFlag;
+  if (rec.P != Last.P) flags |= PFlag;
+  //
+  PutByte(flags);
+  if (flags & PCFlag) {
+    PutByte(UBYTE(rec.PC));
+    PutByte(UBYTE(rec.PC >> 8));
+  }
+  for(i = 0;i < (rec.Size & SizeMask);i++) {
+    PutByte(rec.Bytes[i]);
+  }
+  if (flags & AFlag) PutByte(rec.A);
+  if (flags & XFlag) PutByte(rec.X);
+  if (flags & YFlag) PutByte(rec.Y);
+  if (flags & SFlag) PutByte(rec.S);
+  if (flags & PFlag) PutByte(rec.P);
+  //
+  // The beam position goes as difference to the previous one, which
+  // is usually a single byte each.
+  PutNumber(rec.YPos - Last.YPos);
+  PutNumber(rec.XPos - Last.XPos);
+  //
+  Last = rec;
+}
+///
+
+/// BinaryTrace::Read
+// Read an instruction from the trace, return false at
+// the end of the file.
+bool BinaryTrace::Read(struct Record &rec)
+{
+  UBYTE flags,lo,hi;
+  LONG dy,dx;
+  int i;
+  //
+  if (!GetByte(flags))
+    return false;
+  //
+  rec = Last;
+  if (flags & PCFlag) {
+    if (!GetByte(lo) || !GetByte(hi))
+      return false;
+    rec.PC = ADR(lo) | (ADR(hi) << 8);
+  } else {
+    rec.PC = (Last.PC + Last.Size) & 0xffff;
+  }
+  rec.Size = flags & SizeMask;
+  for(i = 0;i < rec.Size;i++) {
+    if (!GetByte(rec.Bytes[i]))
+      return false;
+  }
+  if ((flags & AFlag) && !GetByte(rec.A)) return false;
+  if ((flags & XFlag) && !GetByte(rec.X)) return false;
+  if ((flags & YFlag) && !GetByte(rec.Y)) return false;
+  if ((flags & SFlag) && !GetByte(rec.S)) return false;
+  if ((flags & PFlag) && !GetByte(rec.P)) return false;
+  if (!GetNumber(dy) || !GetNumber(dx))
+    return false;
+  rec.YPos   = Last.YPos + dy;
+  rec.XPos   = Last.XPos + dx;
+  rec.Cycles = dy * LineLength + dx;
+  //
+  // If the beam went back, a new frame started in between.
+  if (dy < 0)
+    rec.Cycles += FrameLines * LineLength;
+  //
+  Last = rec;
+  return true;
+}
+///
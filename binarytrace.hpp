@@ -0,0 +1,137 @@
+/***********************************************************************************
+ **
+ ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
+ **
+ ** $Id: binarytrace.hpp,v 1.1 2020/05/09 14:02:11 thor Exp $
+ **
+ ** In this module: Compact binary trace of the executed instructions
+ **********************************************************************************/
+
+#ifndef BINARYTRACE_HPP
+#define BINARYTRACE_HPP
+
+/// Includes
+#include "types.h"
+#include "types.hpp"
+#include "stdio.hpp"
+///
+
+/// Class BinaryTrace
+// This class writes or reads a trace of the CPU in a compact binary
+// format: Each instruction is kept as a flag byte, followed by the
+// PC if it is not the address behind the previous instruction, the
+// instruction bytes, the registers that changed, and the number of
+// cycles since the previous instruction as variable length number.
+// The beam position is reconstructed from the latter. The header
+// behind the magic ID holds the number of lines per frame such that
+// the cycle count is also correct when the beam wraps around at the
+// end of a frame. Disassembling the trace is postponed until it is
+// read back.
+class BinaryTrace {
+public:
+  //
+  // A single instruction of the trace.
+  struct Record {
+    ADR   PC;
+    UBYTE Bytes[3];  // the instruction, and its operands
+    UBYTE Size;      // number of valid bytes above
+    UBYTE A,X,Y,S,P; // registers before the instruction is executed
+    int   XPos,YPos; // the beam position
+    LONG  Cycles;    // cycles since the previous instruction.
+  };
+  //
+private:
+  //
+  // Flags in the first byte of a record.
+  enum {
+    SizeMask = 0x03, // the instruction size
+    PCFlag   = 0x04, // the PC follows
+    AFlag    = 0x08, // the registers follow
+    XFlag    = 0x10,
+    YFlag    = 0x20,
+    SFlag    = 0x40,
+    PFlag    = 0x80
+  };
+  //
+  // The number of cycles in a line. Used to convert the beam position
+  // into a linear position.
+  enum {
+    LineLength = 114
+  };
+  //
+  // The size of the file buffer.
+  enum {
+    BufferSize = 1 << 16
+  };
+  //
+  // The file we read from or write to.
+  FILE         *File;
+  //
+  // Set if the file is open for writing.
+  bool          Writing;
+  //
+  // The number of lines per frame of the traced machine.
+  LONG          FrameLines;
+  //
+  // The buffer of the file, and the fill level resp. the read
+  // position and the number of valid bytes.
+  UBYTE        *Buffer;
+  LONG          BufPtr,BufEnd;
+  //
+  // The previous record. Registers that did not change and the
+  // PC are taken from here.
+  struct Record Last;
+  //
+  // The magic ID at the start of the file.
+  static const char Magic[8];
+  //
+  // Write the buffer out.
+  void Flush(void);
+  //
+  // Write or read a byte.
+  void PutByte(UBYTE b)
+  {
+    if (BufPtr >= BufferSize)
+      Flush();
+    Buffer[BufPtr++] = b;
+  }
+  bool GetByte(UBYTE &b);
+  //
+  // Write or read a signed number in variable length coding.
+  void PutNumber(LONG n);
+  bool GetNumber(LONG &n);
+  //
+public:
+  BinaryTrace(void);
+  ~BinaryTrace(void);
+  //
+  // Open a trace file for writing, given the number of lines
+  // per frame of the machine. Throws on an error.
+  void OpenForWrite(const char *name,LONG framelines);
+  //
+  // Open a trace for reading. Returns false if the file is not
+  // a trace, throws on an error.
+  bool OpenForRead(const char *name);
+  //
+  // Close the trace file, flushing all data.
+  void Close(void);
+  //
+  // Check whether a trace file is open.
+  bool isOpen(void) const
+  {
+    return File != NULL;
+  }
+  //
+  // Write an instruction to the trace. The cycle count
+  // of the record is ignored and computed from the beam
+  // position.
+  void Write(const struct Record &rec);
+  //
+  // Read an instruction from the trace, return false at
+  // the end of the file.
+  bool Read(struct Record &rec);
+};
+///
+
+///
+#endif
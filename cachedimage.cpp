@@ -0,0 +1,325 @@
+/***********************************************************************************
+ **
+ ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
+ **
+ ** $Id: cachedimage.cpp,v 1.1 2020/04/05 12:31:17 thor Exp $
+ **
+ ** In this module: Sector cache on top of a disk image
+ **********************************************************************************/
+
+/// Includes
+#include "cachedimage.hpp"
+#include "machine.hpp"
+#include "monitor.hpp"
+#include "string.hpp"
+#include "new.hpp"
+///
+
+/// CachedImage::CachedImage
+CachedImage::CachedImage(class Machine *mach,class DiskImage *image,ULONG lines,ULONG secspertrack)
+  : DiskImage(mach), VBIAction(mach), Image(image), Index(NULL), SectorCnt(0),
+    MaxLines(lines), NumLines(0), SectorsPerTrack((secspertrack)?(secspertrack):(1)),
+    DirtyLines(0), SyncCounter(0),
+    Hits(0), Misses(0), ReadAheads(0), WriteBacks(0)
+{
+  SectorCnt = Image->SectorCount();
+  if (SectorCnt > 0xffff)
+    SectorCnt = 0xffff;
+  Index     = new struct CacheLine *[SectorCnt + 1];
+  memset(Index,0,sizeof(struct CacheLine *) * (SectorCnt + 1));
+}
+///
+
+/// CachedImage::~CachedImage
+CachedImage::~CachedImage(void)
+{
+  SyncImage();
+  FlushCache();
+  delete[] Index;
+  delete Image;
+}
+///
+
+/// CachedImage::FlushCache
+// Release all cache lines, dirty or not.
+void CachedImage::FlushCache(void)
+{
+  struct CacheLine *line;
+  //
+  while((line = Lines.RemHead())) {
+    Index[line->Sector] = NULL;
+    delete line;
+  }
+  NumLines   = 0;
+  DirtyLines = 0;
+}
+///
+
+/// CachedImage::WriteBack
+// Write a dirty line back into the image. Returns the SIO status.
+// If this fails, the line stays dirty and is tried again on the
+// next synchronization.
+UBYTE CachedImage::WriteBack(struct CacheLine *line)
+{
+  UBYTE result;
+  UWORD delay;
+  //
+  if (!line->Dirty)
+    return 'C';
+  //
+  result = Image->WriteSector(line->Sector,line->Data,delay);
+  if (result == 'C') {
+    line->Dirty  = false;
+    line->Failed = false;
+    DirtyLines--;
+    WriteBacks++;
+  } else if (!line->Failed) {
+    // Only warn once, and not on each retry.
+    line->Failed = true;
+    Machine->PutWarning("Failed to write sector %d back into the disk image.\n",line->Sector);
+  }
+  //
+  return result;
+}
+///
+
+/// CachedImage::AllocateLine
+// Get a cache line for the given sector, either by allocating
+// a new one or evicting the least recently used line. Returns
+// NULL if the line cannot be made available.
+struct CachedImage::CacheLine *CachedImage::AllocateLine(UWORD sector)
+{
+  struct CacheLine *line;
+  UWORD size = Image->SectorSize(sector);
+  //
+  if (NumLines < MaxLines) {
+    line = new struct CacheLine(size);
+    NumLines++;
+  } else {
+    // Evict the least recently used line.
+    line = Lines.Last();
+    if (line == NULL)
+      return NULL;
+    // A line that cannot be written back must not be lost.
+    if (WriteBack(line) != 'C')
+      return NULL;
+    Index[line->Sector] = NULL;
+    line->Remove();
+    if (line->Size != size) {
+      delete line;
+      NumLines--;
+      line = new struct CacheLine(size);
+      NumLines++;
+    }
+  }
+  line->Sector   = sector;
+  line->Dirty    = false;
+  line->Failed   = false;
+  line->HasDelay = false;
+  Lines.AddHead(line);
+  Index[sector] = line;
+  //
+  return line;
+}
+///
+
+/// CachedImage::FetchSector
+// Read a sector from the image into the cache, given the delay
+// the SIO expects by default. Returns the SIO status.
+UBYTE CachedImage::FetchSector(UWORD sector,UWORD delay)
+{
+  struct CacheLine *line = AllocateLine(sector);
+  UWORD defaultdelay     = delay;
+  UBYTE result;
+  //
+  if (line == NULL)
+    return 'E';
+  //
+  result = Image->ReadSector(sector,line->Data,delay);
+  if (result == 'C') {
+    line->HasDelay = (delay != defaultdelay);
+    line->Delay    = delay;
+  } else {
+    // Errors are not cached, the image has to
+    // report them again.
+    Index[sector] = NULL;
+    line->Remove();
+    delete line;
+    NumLines--;
+  }
+  return result;
+}
+///
+
+/// CachedImage::OpenImage
+// Open a disk image from a file given an image stream.
+void CachedImage::OpenImage(class ImageStream *image)
+{
+  SyncImage();
+  FlushCache();
+  delete[] Index;
+  Index     = NULL;
+  //
+  Image->OpenImage(image);
+  //
+  SectorCnt = Image->SectorCount();
+  if (SectorCnt > 0xffff)
+    SectorCnt = 0xffff;
+  Index     = new struct CacheLine *[SectorCnt + 1];
+  memset(Index,0,sizeof(struct CacheLine *) * (SectorCnt + 1));
+}
+///
+
+/// CachedImage::Reset
+// Reset to the initial stage.
+void CachedImage::Reset(void)
+{
+  SyncImage();
+  Image->Reset();
+}
+///
+
+/// CachedImage::ReadSector
+// Read a sector from the image into the supplied buffer. The buffer size
+// must fit the above SectorSize. Returns the SIO status indicator.
+UBYTE CachedImage::ReadSector(UWORD sector,UBYTE *buffer,UWORD &delay)
+{
+  struct CacheLine *line;
+  UBYTE result;
+  UWORD defaultdelay = delay;
+  ULONG next,last,ahead;
+  //
+  if (sector == 0 || sector > SectorCnt || MaxLines == 0)
+    return Image->ReadSector(sector,buffer,delay);
+  //
+  line = Index[sector];
+  if (line) {
+    Hits++;
+    line->Remove();
+    Lines.AddHead(line);
+    memcpy(buffer,line->Data,line->Size);
+    // Keep the timing the image reported when the sector
+    // was read, or the default timing of the SIO otherwise.
+    if (line->HasDelay)
+      delay = line->Delay;
+    return 'C';
+  }
+  //
+  Misses++;
+  result = Image->ReadSector(sector,buffer,delay);
+  if (result != 'C')
+    return result;
+  //
+  line = AllocateLine(sector);
+  if (line) {
+    memcpy(line->Data,buffer,line->Size);
+    line->HasDelay = (delay != defaultdelay);
+    line->Delay    = delay;
+  }
+  //
+  // Read ahead the remaining sectors of this track, but do
+  // not let them push more than half of the cache out.
+  last  = ((sector - 1) / SectorsPerTrack + 1) * SectorsPerTrack;
+  if (last > SectorCnt)
+    last = SectorCnt;
+  ahead = MaxLines >> 1;
+  for(next = ULONG(sector) + 1;next <= last && ahead;next++,ahead--) {
+    if (Index[next] == NULL) {
+      if (FetchSector(UWORD(next),defaultdelay) != 'C')
+	break;
+      ReadAheads++;
+    }
+  }
+  //
+  return result;
+}
+///
+
+/// CachedImage::WriteSector
+// Write a sector to the image from the supplied buffer. The buffer size
+// must fit the sector size above. Returns also the SIO status indicator.
+UBYTE CachedImage::WriteSector(UWORD sector,const UBYTE *buffer,UWORD &delay)
+{
+  struct CacheLine *line;
+  //
+  // Protected images report the error themselves.
+  if (sector == 0 || sector > SectorCnt || MaxLines == 0 || (Image->Status() & Protected))
+    return Image->WriteSector(sector,buffer,delay);
+  //
+  line = Index[sector];
+  if (line) {
+    line->Remove();
+    Lines.AddHead(line);
+  } else {
+    line = AllocateLine(sector);
+    if (line == NULL)
+      return Image->WriteSector(sector,buffer,delay);
+  }
+  //
+  memcpy(line->Data,buffer,line->Size);
+  if (!line->Dirty) {
+    line->Dirty = true;
+    DirtyLines++;
+  }
+  return 'C';
+}
+///
+
+/// CachedImage::ProtectImage
+// Protect an image on user request
+void CachedImage::ProtectImage(void)
+{
+  SyncImage();
+  Image->ProtectImage();
+}
+///
+
+/// CachedImage::SyncImage
+// Write all dirty sectors back into the image.
+void CachedImage::SyncImage(void)
+{
+  struct CacheLine *line;
+  //
+  for(line = Lines.First();line;line = line->NextOf()) {
+    WriteBack(line);
+  }
+}
+///
+
+/// CachedImage::VBI
+// Write dirty sectors back periodically such that they
+// do not get lost should the emulator crash.
+void CachedImage::VBI(class Timer *,bool,bool)
+{
+  if (DirtyLines) {
+    if (++SyncCounter >= SyncInterval) {
+      SyncCounter = 0;
+      SyncImage();
+    }
+  } else {
+    SyncCounter = 0;
+  }
+}
+///
+
+/// CachedImage::DisplayStatistics
+// Print the cache statistics over the monitor.
+void CachedImage::DisplayStatistics(class Monitor *mon)
+{
+  struct CacheLine *line;
+  ULONG dirty = 0;
+  //
+  for(line = Lines.First();line;line = line->NextOf()) {
+    if (line->Dirty)
+      dirty++;
+  }
+  //
+  mon->PrintStatus("\tCached sectors   : " LU " of " LU ", " LU " dirty\n"
+		   "\tCache hits       : " LU "\n"
+		   "\tCache misses     : " LU "\n"
+		   "\tRead ahead       : " LU "\n"
+		   "\tWrite backs      : " LU "\n",
+		   NumLines,MaxLines,dirty,
+		   Hits,Misses,ReadAheads,WriteBacks);
+}
+///
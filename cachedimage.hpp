@@ -0,0 +1,170 @@
+/***********************************************************************************
+ **
+ ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
+ **
+ ** $Id: cachedimage.hpp,v 1.1 2020/04/05 12:31:17 thor Exp $
+ **
+ ** In this module: Sector cache on top of a disk image
+ **********************************************************************************/
+
+#ifndef CACHEDIMAGE_HPP
+#define CACHEDIMAGE_HPP
+
+/// Includes
+#include "types.hpp"
+#include "list.hpp"
+#include "diskimage.hpp"
+#include "imagestream.hpp"
+#include "vbiaction.hpp"
+///
+
+/// Forwards
+class Machine;
+class Monitor;
+///
+
+/// Class CachedImage
+// This class keeps the most recently used sectors of another disk image
+// in memory. Reads that miss the cache also fetch the remaining sectors
+// of the same track, writes are kept in the cache and written back when
+// the sector is evicted, the image is closed, or at the latest after
+// SyncInterval vertical blanks. Thus, at most the writes of the last
+// second are lost should the emulator crash. This only works for
+// images whose sector contents does not depend on the timing or the
+// number of reads, i.e. not for ATX images.
+class CachedImage : public DiskImage, private VBIAction {
+  //
+  // The image whose sectors are cached. This is owned by this class.
+  class DiskImage   *Image;
+  //
+  // A cached sector.
+  struct CacheLine : public Node<struct CacheLine> {
+    // The sector number kept in here.
+    UWORD  Sector;
+    // Set if the sector has been written to, but not yet to the image.
+    bool   Dirty;
+    // Set if writing the sector back failed, and the user has
+    // been warned about it.
+    bool   Failed;
+    // Set if the image reported a delay for reading the sector, which
+    // is then kept in Delay.
+    bool   HasDelay;
+    UWORD  Delay;
+    // The size of the sector in bytes.
+    UWORD  Size;
+    // The sector contents.
+    UBYTE *Data;
+    //
+    CacheLine(UWORD size)
+      : Sector(0), Dirty(false), Failed(false), HasDelay(false), Delay(0), Size(size), Data(new UBYTE[size])
+    { }
+    ~CacheLine(void)
+    {
+      delete[] Data;
+    }
+  };
+  //
+  // All cache lines, the most recently used one first.
+  List<CacheLine>    Lines;
+  //
+  // Cache lines indexed by the sector number, or NULL if the
+  // sector is not cached.
+  struct CacheLine **Index;
+  //
+  // Number of sectors in the image, and thus the size of the index - 1.
+  ULONG              SectorCnt;
+  //
+  // Number of cache lines we may allocate, and number of allocated lines.
+  ULONG              MaxLines;
+  ULONG              NumLines;
+  //
+  // Number of sectors per track for the read-ahead.
+  ULONG              SectorsPerTrack;
+  //
+  // Number of vertical blanks after which dirty sectors are
+  // written back into the image.
+  enum {
+    SyncInterval = 50
+  };
+  //
+  // Number of dirty lines, and the number of vertical blanks
+  // since the first of them became dirty.
+  ULONG              DirtyLines;
+  ULONG              SyncCounter;
+  //
+  // Statistics.
+  ULONG              Hits;
+  ULONG              Misses;
+  ULONG              ReadAheads;
+  ULONG              WriteBacks;
+  //
+  // Release all cache lines and the index.
+  void FlushCache(void);
+  //
+  // Write a dirty line back into the image. Returns the SIO status.
+  // The line stays dirty if this fails.
+  UBYTE WriteBack(struct CacheLine *line);
+  //
+  // Get a cache line for the given sector, either by allocating
+  // a new one or evicting the least recently used line. Returns
+  // NULL if the line cannot be made available.
+  struct CacheLine *AllocateLine(UWORD sector);
+  //
+  // Read a sector from the image into the cache, given the delay
+  // the SIO expects by default. Returns the SIO status.
+  UBYTE FetchSector(UWORD sector,UWORD delay);
+  //
+  // Write dirty sectors back periodically.
+  virtual void VBI(class Timer *,bool quick,bool pause);
+  //
+public:
+  // Build a cache for the given image, which must be opened already, with
+  // the given number of sectors. This takes over the image.
+  CachedImage(class Machine *mach,class DiskImage *image,ULONG lines,ULONG secspertrack);
+  virtual ~CachedImage(void);
+  //
+  // Open a disk image from a file given an image stream.
+  virtual void OpenImage(class ImageStream *image);
+  //
+  // Reset to the initial stage.
+  virtual void Reset(void);
+  //
+  // Return the sector size given the sector offset passed in.
+  virtual UWORD SectorSize(UWORD sector)
+  {
+    return Image->SectorSize(sector);
+  }
+  //
+  // Return the number of sectors.
+  virtual ULONG SectorCount(void)
+  {
+    return Image->SectorCount();
+  }
+  //
+  // Return the disk status.
+  virtual UBYTE Status(void)
+  {
+    return Image->Status();
+  }
+  //
+  // Read a sector from the image into the supplied buffer. The buffer size
+  // must fit the above SectorSize. Returns the SIO status indicator.
+  virtual UBYTE ReadSector(UWORD sector,UBYTE *buffer,UWORD &delay);
+  //
+  // Write a sector to the image from the supplied buffer. The buffer size
+  // must fit the sector size above. Returns also the SIO status indicator.
+  virtual UBYTE WriteSector(UWORD sector,const UBYTE *buffer,UWORD &delay);
+  //
+  // Protect an image on user request
+  virtual void ProtectImage(void);
+  //
+  // Write all dirty sectors back into the image.
+  void SyncImage(void);
+  //
+  // Print the cache statistics over the monitor.
+  void DisplayStatistics(class Monitor *mon);
+};
+///
+
+///
+#endif
@@ -0,0 +1,300 @@
+/***********************************************************************************
+ **
+ ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
+ **
+ ** $Id: callprofiler.cpp,v 1.1 2020/04/12 14:02:51 thor Exp $
+ **
+ ** In this module: Hierarchical subroutine profiler for the 6502
+ **********************************************************************************/
+
+/// Includes
+#include "callprofiler.hpp"
+#include "monitor.hpp"
+#include "string.hpp"
+#include "new.hpp"
+///
+
+/// Defines
+// The pseudo-address of the root of the call tree. This is outside
+// of the 6502 address space and thus never the target of a JSR.
+#define ROOT_ENTRY 0x10000
+///
+
+/// CallProfiler::CallNode::~CallNode
+// Dispose a node of the call tree and all its callees.
+CallProfiler::CallNode::~CallNode(void)
+{
+  struct CallNode *child;
+
+  while((child = Child)) {
+    Child = child->Sibling;
+    delete child;
+  }
+}
+///
+
+/// CallProfiler::CallProfiler
+CallProfiler::CallProfiler(void)
+  : Root(NULL,ROOT_ENTRY,false), Depth(0), Current(&Root), NodeCount(1),
+    CallPending(false), PendingStackPointer(0),
+    InterruptPending(false), InterruptStackPointer(0)
+{
+  Root.Calls = 1;
+}
+///
+
+/// CallProfiler::~CallProfiler
+CallProfiler::~CallProfiler(void)
+{
+  // The root node disposes the complete tree.
+}
+///
+
+/// CallProfiler::Enter
+// Enter a subroutine, either by JSR or by an interrupt.
+void CallProfiler::Enter(ADR entry,UBYTE s,bool irq)
+{
+  struct CallNode *node,**prev;
+  //
+  // If the shadow stack is full, the stack pointer has wrapped around
+  // and we cannot follow the program anymore. Just keep accounting to
+  // the current subroutine then.
+  if (Depth >= MaxDepth)
+    return;
+  //
+  // Find the callee among the callees of the current node. Move it
+  // to the front such that loops calling the same subroutine find it
+  // quickly.
+  prev = &Current->Child;
+  while((node = *prev)) {
+    if (node->Entry == entry && node->Interrupt == irq) {
+      *prev         = node->Sibling;
+      break;
+    }
+    prev = &node->Sibling;
+  }
+  if (node == NULL) {
+    node = new struct CallNode(Current,entry,irq);
+    NodeCount++;
+  }
+  node->Sibling  = Current->Child;
+  Current->Child = node;
+  node->Calls++;
+  //
+  Stack[Depth].Node         = node;
+  Stack[Depth].StackPointer = s;
+  Depth++;
+  Current = node;
+}
+///
+
+/// CallProfiler::Summarize
+// Recursively compute the inclusive counts of a node.
+void CallProfiler::Summarize(struct CallNode *node)
+{
+  struct CallNode *child;
+  //
+  node->TotalCycles = node->SelfCycles;
+  node->TotalStolen = node->SelfStolen;
+  for(child = node->Child;child;child = child->Sibling) {
+    Summarize(child);
+    node->TotalCycles += child->TotalCycles;
+    node->TotalStolen += child->TotalStolen;
+  }
+}
+///
+
+/// CallProfiler::Collect
+// Recursively collect the per-subroutine results of the
+// given node into the function table.
+void CallProfiler::Collect(const struct CallNode *node,struct Function *functions,
+			   LONG *index,ULONG *active,LONG &count)
+{
+  const struct CallNode *child;
+  struct Function *f;
+  //
+  if (index[node->Entry] < 0) {
+    f                   = functions + count;
+    f->Entry            = node->Entry;
+    f->Interrupt        = node->Interrupt;
+    f->Calls            = 0;
+    f->SelfCycles       = 0;
+    f->SelfStolen       = 0;
+    f->TotalCycles      = 0;
+    f->TotalStolen      = 0;
+    index[node->Entry]  = count++;
+  }
+  f = functions + index[node->Entry];
+  f->Calls      += node->Calls;
+  f->SelfCycles += node->SelfCycles;
+  f->SelfStolen += node->SelfStolen;
+  //
+  // If the subroutine calls itself, the inclusive counts of the
+  // outermost call already include the inner calls.
+  if (active[node->Entry] == 0) {
+    f->TotalCycles += node->TotalCycles;
+    f->TotalStolen += node->TotalStolen;
+  }
+  active[node->Entry]++;
+  for(child = node->Child;child;child = child->Sibling) {
+    Collect(child,functions,index,active,count);
+  }
+  active[node->Entry]--;
+}
+///
+
+/// CallProfiler::CollectFunctions
+// Collect the per-subroutine results, sorted by decreasing
+// exclusive cycles. Returns the number of entries, the array
+// must be released by the caller with delete[].
+LONG CallProfiler::CollectFunctions(struct Function *&functions)
+{
+  LONG *index   = NULL;
+  ULONG *active = NULL;
+  LONG count    = 0;
+  LONG i,j;
+  //
+  Summarize();
+  functions = NULL;
+  try {
+    functions = new struct Function[NodeCount];
+    index     = new LONG[ROOT_ENTRY + 1];
+    active    = new ULONG[ROOT_ENTRY + 1];
+    for(i = 0;i <= ROOT_ENTRY;i++) {
+      index[i]  = -1;
+      active[i] = 0;
+    }
+    Collect(&Root,functions,index,active,count);
+  } catch(...) {
+    delete[] functions;
+    delete[] index;
+    delete[] active;
+    functions = NULL;
+    throw;
+  }
+  delete[] index;
+  delete[] active;
+  //
+  // Sort by decreasing exclusive cycles. This is an insertion sort,
+  // the number of subroutines of a 6502 program is small enough.
+  for(i = 1;i < count;i++) {
+    struct Function f = functions[i];
+    for(j = i;j > 0 && functions[j - 1].SelfCycles < f.SelfCycles;j--) {
+      functions[j] = functions[j - 1];
+    }
+    functions[j] = f;
+  }
+  //
+  return count;
+}
+///
+
+/// CallProfiler::NameOf
+// Print the name of a subroutine into the buffer.
+const char *CallProfiler::NameOf(class Monitor *mon,const struct CallNode *node,
+				 char *buffer,size_t size)
+{
+  const char *name;
+  //
+  if (node->Entry == ROOT_ENTRY) {
+    snprintf(buffer,size,"(toplevel)");
+  } else if ((name = mon->SymbolNameOf(node->Entry))) {
+    snprintf(buffer,size,"%s",name);
+  } else {
+    snprintf(buffer,size,"%s_%04x",(node->Interrupt)?("int"):("sub"),
+	     (unsigned int)(node->Entry));
+  }
+  return buffer;
+}
+///
+
+/// CallProfiler::WriteChain
+// Write the call chain leading to the given node in the
+// folded format, i.e. separated by semicolons.
+void CallProfiler::WriteChain(FILE *file,class Monitor *mon,const struct CallNode *node)
+{
+  char name[80];
+  //
+  if (node->Parent) {
+    WriteChain(file,mon,node->Parent);
+    fputc(';',file);
+  }
+  fputs(NameOf(mon,node,name,sizeof(name)),file);
+}
+///
+
+/// CallProfiler::WriteFoldedNode
+// Write the folded stacks of a node and all its callees.
+void CallProfiler::WriteFoldedNode(FILE *file,class Monitor *mon,const struct CallNode *node)
+{
+  const struct CallNode *child;
+  //
+  // The cycles the code ran, then the cycles lost to DMA
+  // as a pseudo-callee such that they show up separately.
+  if (node->SelfCycles > node->SelfStolen) {
+    WriteChain(file,mon,node);
+    fprintf(file," %.0f\n",double(node->SelfCycles - node->SelfStolen));
+  }
+  if (node->SelfStolen) {
+    WriteChain(file,mon,node);
+    fprintf(file,";(dma) %.0f\n",double(node->SelfStolen));
+  }
+  for(child = node->Child;child;child = child->Sibling) {
+    WriteFoldedNode(file,mon,child);
+  }
+}
+///
+
+/// CallProfiler::WriteFoldedStacks
+// Write the call tree as folded stacks for flame graphs.
+void CallProfiler::WriteFoldedStacks(FILE *file,class Monitor *mon)
+{
+  WriteFoldedNode(file,mon,&Root);
+}
+///
+
+/// CallProfiler::WriteCallgrindNode
+// Write the callgrind records of a node and all its callees.
+void CallProfiler::WriteCallgrindNode(FILE *file,class Monitor *mon,const struct CallNode *node)
+{
+  const struct CallNode *child;
+  char name[80];
+  ADR pos = (node->Entry == ROOT_ENTRY)?(0):(node->Entry);
+  //
+  // The callgrind tools sum up all records of the same function, so
+  // each node of the call tree can be written on its own.
+  fprintf(file,"fn=%s\n",NameOf(mon,node,name,sizeof(name)));
+  fprintf(file,"0x%04x %.0f %.0f\n",(unsigned int)pos,
+	  double(node->SelfCycles - node->SelfStolen),double(node->SelfStolen));
+  for(child = node->Child;child;child = child->Sibling) {
+    fprintf(file,"cfn=%s\n",NameOf(mon,child,name,sizeof(name)));
+    fprintf(file,"calls=%lu 0x%04x\n",(unsigned long)(child->Calls),(unsigned int)(child->Entry));
+    fprintf(file,"0x%04x %.0f %.0f\n",(unsigned int)pos,
+	    double(child->TotalCycles - child->TotalStolen),double(child->TotalStolen));
+  }
+  fputc('\n',file);
+  //
+  for(child = node->Child;child;child = child->Sibling) {
+    WriteCallgrindNode(file,mon,child);
+  }
+}
+///
+
+/// CallProfiler::WriteCallgrind
+// Write the call tree in the callgrind format.
+void CallProfiler::WriteCallgrind(FILE *file,class Monitor *mon)
+{
+  Summarize();
+  fprintf(file,
+	  "# callgrind format\n"
+	  "version: 1\n"
+	  "creator: Atari++\n"
+	  "positions: instr\n"
+	  "events: Cycles DMA\n"
+	  "event: Cycles : CPU cycles executed\n"
+	  "event: DMA : Cycles lost to DMA\n"
+	  "summary: %.0f %.0f\n\n",
+	  double(Root.TotalCycles - Root.TotalStolen),double(Root.TotalStolen));
+  WriteCallgrindNode(file,mon,&Root);
+}
+///
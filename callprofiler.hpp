@@ -0,0 +1,224 @@
+/***********************************************************************************
+ **
+ ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
+ **
+ ** $Id: callprofiler.hpp,v 1.1 2020/04/12 14:02:51 thor Exp $
+ **
+ ** In this module: Hierarchical subroutine profiler for the 6502
+ **********************************************************************************/
+
+#ifndef CALLPROFILER_HPP
+#define CALLPROFILER_HPP
+
+/// Includes
+#include "types.hpp"
+#include "stdio.hpp"
+///
+
+/// Forwards
+class Monitor;
+///
+
+/// Class CallProfiler
+// This class builds a call tree of the emulated program by following
+// JSR instructions and interrupts. Each node of the tree collects the
+// cycles spent in one subroutine when called along one specific call
+// chain. A subroutine is left as soon as the stack pointer climbs
+// above the position it had before the call, which covers RTS, RTI
+// and all stack manipulation tricks that return early. Cycles the CPU
+// lost to DMA are kept apart from the cycles the code ran.
+class CallProfiler {
+public:
+  //
+  // A node of the call tree.
+  struct CallNode {
+    // The caller, or NULL for the root of the tree.
+    struct CallNode *Parent;
+    // The first subroutine called from here.
+    struct CallNode *Child;
+    // The next subroutine called from the same caller.
+    struct CallNode *Sibling;
+    // The entry address of the subroutine.
+    ADR              Entry;
+    // Set if this subroutine was entered by an interrupt rather
+    // than by a JSR.
+    bool             Interrupt;
+    // Number of times this node was entered.
+    ULONG            Calls;
+    // All cycles spent in this subroutine, not counting its callees.
+    UQUAD            SelfCycles;
+    // The part of the above the CPU lost to DMA.
+    UQUAD            SelfStolen;
+    // Inclusive counts, including all callees. These are only
+    // valid after Summarize() has been run.
+    UQUAD            TotalCycles;
+    UQUAD            TotalStolen;
+    //
+    CallNode(struct CallNode *parent,ADR entry,bool irq)
+      : Parent(parent), Child(NULL), Sibling(NULL), Entry(entry), Interrupt(irq),
+	Calls(0), SelfCycles(0), SelfStolen(0), TotalCycles(0), TotalStolen(0)
+    { }
+    //
+    ~CallNode(void);
+  };
+  //
+  // Per-subroutine results, summed over all call chains
+  // the subroutine was reached by.
+  struct Function {
+    // The entry address of the subroutine.
+    ADR              Entry;
+    // Set if this is an interrupt handler.
+    bool             Interrupt;
+    // Number of calls.
+    ULONG            Calls;
+    // Exclusive counts.
+    UQUAD            SelfCycles;
+    UQUAD            SelfStolen;
+    // Inclusive counts. Recursive calls are only counted once.
+    UQUAD            TotalCycles;
+    UQUAD            TotalStolen;
+  };
+  //
+private:
+  //
+  // Maximum depth of the call stack we follow. The 6502 stack
+  // cannot hold more return addresses than this.
+  enum {
+    MaxDepth = 256
+  };
+  //
+  // An entry of the shadow call stack.
+  struct Frame {
+    // The node of the call tree the CPU is currently in.
+    struct CallNode *Node;
+    // The stack pointer before the call. The subroutine is left
+    // as soon as the stack pointer reaches this value again.
+    UBYTE            StackPointer;
+  };
+  //
+  // The root of the call tree, collects all cycles outside of
+  // any subroutine called since the profiler was started.
+  struct CallNode    Root;
+  //
+  // The shadow call stack, and its depth.
+  struct Frame       Stack[MaxDepth];
+  int                Depth;
+  //
+  // The node the CPU currently runs in.
+  struct CallNode   *Current;
+  //
+  // Number of nodes in the call tree, including the root.
+  LONG               NodeCount;
+  //
+  // A JSR that has been decoded but whose cycles have not
+  // yet been accounted for. The subroutine is entered at the
+  // next instruction fetch, which avoids reading the operand
+  // of the JSR a second time.
+  bool               CallPending;
+  UBYTE              PendingStackPointer;
+  //
+  // An interrupt that has been started, but whose handler has
+  // not yet been reached. The handler is entered at the next
+  // instruction fetch, which avoids reading the vector.
+  bool               InterruptPending;
+  UBYTE              InterruptStackPointer;
+  //
+  // Enter a subroutine, either by JSR or by an interrupt.
+  void Enter(ADR entry,UBYTE s,bool irq);
+  //
+  // Recursively compute the inclusive counts of a node.
+  static void Summarize(struct CallNode *node);
+  //
+  // Recursively collect the per-subroutine results of the
+  // given node into the function table.
+  static void Collect(const struct CallNode *node,struct Function *functions,
+		      LONG *index,ULONG *active,LONG &count);
+  //
+  // Write the call chain leading to the given node in the
+  // folded format, i.e. separated by semicolons.
+  static void WriteChain(FILE *file,class Monitor *mon,const struct CallNode *node);
+  //
+  // Print the name of a subroutine into the buffer.
+  static const char *NameOf(class Monitor *mon,const struct CallNode *node,
+			    char *buffer,size_t size);
+  //
+  // Write the callgrind records of a node and all its callees.
+  static void WriteCallgrindNode(FILE *file,class Monitor *mon,const struct CallNode *node);
+  //
+  // Write the folded stacks of a node and all its callees.
+  static void WriteFoldedNode(FILE *file,class Monitor *mon,const struct CallNode *node);
+  //
+public:
+  CallProfiler(void);
+  ~CallProfiler(void);
+  //
+  // Account the given number of cycles, of which "stolen" were
+  // lost to DMA, to the subroutine the CPU currently runs in, then
+  // leave all subroutines the stack pointer has returned from.
+  // This is called on each instruction fetch with the address
+  // of the instruction.
+  void Account(ULONG cycles,ULONG stolen,ADR pc,UBYTE s)
+  {
+    // The cycles of the interrupt sequence are already
+    // accounted to the handler.
+    if (InterruptPending) {
+      InterruptPending = false;
+      Enter(pc,InterruptStackPointer,true);
+    }
+    Current->SelfCycles += cycles;
+    Current->SelfStolen += stolen;
+    while(Depth > 0 && s >= Stack[Depth - 1].StackPointer) {
+      Depth--;
+      Current = (Depth > 0)?(Stack[Depth - 1].Node):(&Root);
+    }
+    if (CallPending) {
+      CallPending = false;
+      Enter(pc,PendingStackPointer,false);
+    }
+  }
+  //
+  // Signal that a JSR has been decoded, with the stack pointer
+  // before the return address is pushed. The target is the
+  // address of the next instruction fetch.
+  void Call(UBYTE s)
+  {
+    CallPending         = true;
+    PendingStackPointer = s;
+  }
+  //
+  // Signal the start of an interrupt sequence, with the stack
+  // pointer before the return address is pushed. The handler is
+  // entered at the next instruction fetch.
+  void Interrupt(UBYTE s)
+  {
+    InterruptPending      = true;
+    InterruptStackPointer = s;
+  }
+  //
+  // Compute the inclusive counts of the call tree.
+  void Summarize(void)
+  {
+    Summarize(&Root);
+  }
+  //
+  // Return the root of the call tree.
+  const struct CallNode *RootOf(void) const
+  {
+    return &Root;
+  }
+  //
+  // Collect the per-subroutine results, sorted by decreasing
+  // exclusive cycles. Returns the number of entries, the array
+  // must be released by the caller with delete[].
+  LONG CollectFunctions(struct Function *&functions);
+  //
+  // Write the call tree in the callgrind format.
+  void WriteCallgrind(FILE *file,class Monitor *mon);
+  //
+  // Write the call tree as folded stacks for flame graphs.
+  void WriteFoldedStacks(FILE *file,class Monitor *mon);
+};
+///
+
+///
+#endif
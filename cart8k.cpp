@@ -15,6 +15,7 @@
 #include "cartridge.hpp"
 #include "argparser.hpp"
 #include "exceptions.hpp"
+#include "romimage.hpp"
 #include "cart8k.hpp"
 ///
 
@@ -27,14 +28,29 @@ const UWORD Cart8K::CartSizes[] = {8,0};
 /// Cart8K::Cart8K
 // Construct the cart. There is nothing to do here.
 Cart8K::Cart8K(void)
+  : Image(NULL)
 {
 }
 ///
 
 /// Cart8K::~Cart8K
-// Dispose the cart. There is nothing to dispose
+// Dispose the cart and the mapped image, if any.
 Cart8K::~Cart8K(void)
 {
+  ReleaseImage();
+}
+///
+
+/// Cart8K::ReleaseImage
+// Release the mapped image, let the pages use their own storage.
+void Cart8K::ReleaseImage(void)
+{
+  int i;
+  //
+  for(i = 0;i < 32;i++)
+    Rom[i].SetImage(NULL);
+  delete Image;
+  Image = NULL;
 }
 ///
 
@@ -56,6 +72,19 @@ void Cart8K::ReadFromFile(FILE *fp)
   
   pages    = 32;
   page     = Rom;
+  //
+  // Try to map the image first such that it is shared with all
+  // other processes using the same ROM. Otherwise, read it.
+  ReleaseImage();
+  Image    = new class RomImage;
+  if (Image->Map(fp,ULONG(pages) << 8)) {
+    do {
+      page->SetImage(Image->PageOf(32 - pages));
+      page++;
+    } while(--pages);
+    return;
+  }
+  ReleaseImage();
   
   do {
     if (!page->ReadFromFile(fp))    
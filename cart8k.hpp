@@ -15,6 +15,10 @@
 #include "cartridge.hpp"
 ///
 
+/// Forwards
+class RomImage;
+///
+
 /// Class Cart8K
 // The Cart8K class implements a simple 8K cart without CartCtrl support
 // whatsoever.
@@ -25,6 +29,12 @@ protected:
   // The contents of the cart
   class RomPage Rom[32];
   //
+  // The mapped image file the above pages use, if any.
+  class RomImage *Image;
+  //
+  // Release the mapped image, let the pages use their own storage.
+  void ReleaseImage(void);
+  //
 public:
   Cart8K(void);
   virtual ~Cart8K(void);
@@ -131,10 +131,14 @@ bool CartATMax::ComplexWrite(class MMU *mmu,ADR mem,UBYTE)
     // Get the bank to map in, from the lower nibble.
     newbank = mem & (Banks - 1);
     // This will/might require rebuilding now
-    if (newdisabled != Disabled || newbank != ActiveBank) {
+    if (newdisabled != Disabled) {
       ActiveBank = newbank;
       Disabled   = newdisabled;
       mmu->BuildCartArea();
+    } else if (newbank != ActiveBank) {
+      ActiveBank = newbank;
+      if (!Disabled)
+	mmu->SwitchCartBank(this,0xa000,0xc000,Rom + (ActiveBank << 5));
     }
     //
     // Only react on the lower part of CartCtrl.
@@ -123,10 +123,14 @@ bool CartAtrax::ComplexWrite(class MMU *mmu,ADR mem,UBYTE val)
   // Get the bank to map in.
   newbank = val & 0x0f;
   // This will/might require rebuilding now
-  if (newdisabled != Disabled || newbank != ActiveBank) {
+  if (newdisabled != Disabled) {
     ActiveBank = newbank;
     Disabled   = newdisabled;
     mmu->BuildCartArea();
+  } else if (newbank != ActiveBank) {
+    ActiveBank = newbank;
+    if (!Disabled)
+      mmu->SwitchCartBank(this,0xa000,0xc000,Rom + (ActiveBank << 5));
   }
   //
   // This cart only reacts to writes into the byte 0xd500. Everything
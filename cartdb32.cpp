@@ -115,8 +115,9 @@ bool CartDB32::ComplexWrite(class MMU *mmu,ADR mem,UBYTE)
   //
   // This will/might require rebuilding now
   if (newbank != ActiveBank) {
+    // Only the window at 0x8000 changes.
     ActiveBank     = newbank;
-    mmu->BuildCartArea();
+    mmu->SwitchCartBank(this,0x8000,0xa000,Rom + (ActiveBank << 5));
   }
   //
   // This cart only reacts to writes into the byte 0xd500 to 0xd503. Everything
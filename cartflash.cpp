@@ -20,6 +20,7 @@
 #include "cartflash.hpp"
 #include "choicerequester.hpp"
 #include "filerequester.hpp"
+#include "flashjournal.hpp"
 #include "new.hpp"
 ///
 
@@ -32,9 +33,10 @@ const UWORD CartFlash::CartSizes[] = {128,512,1024,0xffff,0};
 /// CartFlash::CartFlash
 // Construct the cart. There is nothing to do here.
 CartFlash::CartFlash(class Machine *mach,UBYTE banks)
-  : Configurable(mach), TotalBanks(banks), Active(true), EnableOnReset(true),
+  : Configurable(mach), VBIAction(mach), TotalBanks(banks), Active(true), EnableOnReset(true),
     Rom1(NULL), Rom2(NULL), 
-    ActiveBank(0), Machine(mach), RequestSave(NULL), SavePath(NULL)
+    ActiveBank(0), Machine(mach), RequestSave(NULL), SavePath(NULL),
+    Journal(new class FlashJournal), UseJournal(false), JournalCounter(0)
   // A page is 256 bytes large, making 32*256 = 8192 bytes
 {
 }
@@ -100,9 +102,19 @@ void CartFlash::Initialize(void)
 ///
 
 /// CartFlash::~CartFlash
-// Dispose the cart. There is nothing to dispose
+// Dispose the cart. If the journal is in use, this is the time to
+// write the modifications back into the image.
 CartFlash::~CartFlash(void)
 {
+  if (UseJournal && CartPath && ((Rom1 && Rom1->IsModified()) || (Rom2 && Rom2->IsModified()))) {
+    try {
+      CompactJournal();
+    } catch(...) {
+      // Cannot report this anymore. The journal stays, and is
+      // replayed the next time the image is loaded.
+    }
+  }
+  delete Journal;
   delete Rom1;
   delete Rom2;
   delete RequestSave;
@@ -135,6 +147,75 @@ void CartFlash::ReadFromFile(FILE *fp)
     Rom1->ReadFromFile(fp);
   if (Rom2)
     Rom2->ReadFromFile(fp);
+  //
+  // Bring in the modifications that did not make it into the image.
+  if (UseJournal && CartPath)
+    ReplayJournal();
+}
+///
+
+/// CartFlash::ReplayJournal
+// Replay the journal on top of the image just loaded.
+void CartFlash::ReplayJournal(void)
+{
+  struct FlashJournal::Record rec;
+  //
+  if (Journal->OpenForRead(CartPath)) {
+    // An incomplete or damaged record ends the journal. Everything
+    // replayed goes into the next journal, which replaces this one.
+    while(Journal->Read(rec)) {
+      class AmdChip *chip = (rec.Unit == 0)?(Rom1):((rec.Unit == 1)?(Rom2):(NULL));
+      if (chip == NULL || !chip->RestorePages(rec))
+	break;
+    }
+    Journal->Close();
+  }
+}
+///
+
+/// CartFlash::FlushJournal
+// Append the modified pages to the journal and flush it.
+void CartFlash::FlushJournal(void)
+{
+  if ((Rom1 && Rom1->IsDirty()) || (Rom2 && Rom2->IsDirty())) {
+    try {
+      if (!Journal->isWriting())
+	Journal->OpenForWrite(CartPath);
+      if (Rom1)
+	Rom1->WriteJournal(Journal);
+      if (Rom2)
+	Rom2->WriteJournal(Journal);
+      Journal->Flush();
+    } catch(...) {
+      // Do not try again each VBI.
+      Journal->Close();
+      UseJournal = false;
+      throw;
+    }
+  }
+}
+///
+
+/// CartFlash::CompactJournal
+// Write the image back to where it came from, with the header it
+// was loaded with, and delete the journal then.
+void CartFlash::CompactJournal(void)
+{
+  Cartridge::SaveCart(NULL,WithHeader);
+  Journal->Remove(CartPath);
+}
+///
+
+/// CartFlash::VBI
+// Flush the journal periodically.
+void CartFlash::VBI(class Timer *,bool,bool)
+{
+  if (UseJournal && CartPath) {
+    if (++JournalCounter >= JournalInterval) {
+      JournalCounter = 0;
+      FlushJournal();
+    }
+  }
 }
 ///
 
@@ -222,6 +303,13 @@ void CartFlash::SaveCart(void)
   if (modified) {
     char request[256];
     //
+    // With the journal, the modifications are already persistent
+    // and only need to go into the image.
+    if (UseJournal && CartPath) {
+      CompactJournal();
+      return;
+    }
+    //
     // Check whether the user wants to save the changes back to disk.
     if (RequestSave == NULL)
       RequestSave = new class ChoiceRequester(Machine);
@@ -282,3 +370,17 @@ void CartFlash::ParseArgs(class ArgParser *args)
   args->DefineBool("EnableCartFlash","enable the flash cartrdige mapping",EnableOnReset);
 }
 ///
+
+/// CartFlash::SetJournal
+// Enable or disable the journal. This must be set before the
+// image is loaded to replay the journal.
+void CartFlash::SetJournal(bool use)
+{
+  UseJournal = use;
+  //
+  // Stop writing the journal if it is no longer desired. It stays
+  // around until the image is written.
+  if (!UseJournal)
+    Journal->Close();
+}
+///
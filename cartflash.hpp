@@ -15,6 +15,7 @@
 #include "cartridge.hpp"
 #include "memcontroller.hpp"
 #include "configurable.hpp"
+#include "vbiaction.hpp"
 ///
 
 /// Forwards
@@ -23,6 +24,8 @@ class Machine;
 class ArgParser;
 class ChoiceRequester;
 class FileRequester;
+class FlashJournal;
+class Timer;
 ///
 
 /// Class CartFlash
@@ -30,7 +33,7 @@ class FileRequester;
 // These carts come with various sizes that are mapped 
 // into the address range 0xa000 to 0xbfff and are controlled
 // by the CartCtrl area.
-class CartFlash : public Cartridge, public Configurable {
+class CartFlash : public Cartridge, public Configurable, private VBIAction {
   //
   // Number of banks in this cartridge
   UBYTE                  TotalBanks;
@@ -58,6 +61,32 @@ class CartFlash : public Cartridge, public Configurable {
   // Requests the path to save the file to.
   class FileRequester   *SavePath;
   //
+  // The journal of the modifications, and the flag whether it
+  // shall be used at all.
+  class FlashJournal    *Journal;
+  bool                   UseJournal;
+  //
+  // Number of VBIs since the journal has been flushed last.
+  int                    JournalCounter;
+  //
+  // Number of VBIs between two flushes of the journal.
+  enum {
+    JournalInterval = 25
+  };
+  //
+  // Replay the journal on top of the image just loaded.
+  void ReplayJournal(void);
+  //
+  // Append the modified pages to the journal and flush it.
+  void FlushJournal(void);
+  //
+  // Write the image back to where it came from and delete the
+  // journal then.
+  void CompactJournal(void);
+  //
+  // Flush the journal periodically.
+  virtual void VBI(class Timer *time,bool quick,bool pause);
+  //
 public:
   // The cartridge requires the number of banks for construction,
   // unlike other carts.
@@ -105,6 +134,10 @@ public:
   // Define the arguments for the Flash cartridge. This is uniquely a
   // configurable cartridge.
   virtual void ParseArgs(class ArgParser *args);
+  //
+  // Enable or disable the journal. This must be set before the
+  // image is loaded to replay the journal.
+  void SetJournal(bool use);
 };
 ///
 
@@ -123,11 +123,14 @@ bool CartMEGA::ComplexWrite(class MMU *mmu,ADR mem,UBYTE val)
   }
   //
   // This will/might require rebuilding now
-  if (newbank    != ActiveBank || 
-      newdisable != Disabled) {
+  if (newdisable != Disabled) {
     ActiveBank = newbank;
     Disabled   = newdisable;
     mmu->BuildCartArea();
+  } else if (newbank != ActiveBank) {
+    ActiveBank = newbank;
+    if (!Disabled)
+      mmu->SwitchCartBank(this,0x8000,0xc000,Rom + (ActiveBank << 6));
   }
   //
   // This cart only reacts to writes into the byte 0xd500. Everything
@@ -38,7 +38,7 @@
 
 /// Cartridge::Cartridge
 Cartridge::Cartridge(void)
-  : CartPath(NULL)
+  : CartPath(NULL), WithHeader(false)
 { }
 ///
 
@@ -343,6 +343,7 @@ void Cartridge::LoadFromFile(const char *path,bool skipheader)
   // cartridge back in case it was modified.
   CartPath = new char[strlen(path) + 1];
   strcpy(CartPath,path);
+  WithHeader = skipheader;
   //
   fp = fopen(path,"rb");
   if (fp) {
@@ -371,11 +372,13 @@ void Cartridge::LoadFromFile(const char *path,bool skipheader)
 // Save this cartridge to a given path name.
 // Currently only relevent to the CartFlash class. If the
 // path is NULL, the save path is identical to the path the
-// cart was loaded from.
+// cart was loaded from. The image is first written to a temporary
+// file that replaces the original only once it is complete.
 void Cartridge::SaveCart(const char *path, bool withheader)
 {
   FILE *fp;
   struct CartHeader hdr; 
+  char *tmpname;
 
   if (path == NULL)
     path = CartPath;
@@ -386,8 +389,12 @@ void Cartridge::SaveCart(const char *path, bool withheader)
     strcpy(CartPath,path);
   }
   //
+  tmpname = new char[strlen(path) + 2];
+  strcpy(tmpname,path);
+  strcat(tmpname,"~");
+  //
   // Try only to save in case the path is writable
-  fp = fopen(path,"wb");
+  fp = fopen(tmpname,"wb");
   if (fp) {
     try {
       if (withheader) {	
@@ -408,14 +415,34 @@ void Cartridge::SaveCart(const char *path, bool withheader)
 	}
       }
       WriteToFile(fp);
-      fclose(fp);
+      if (fclose(fp)) {
+	fp = NULL;
+	ThrowIo("Cartridge::SaveToFile","unable to write the cart image");
+      }
+      fp = NULL;
+#if HAVE_CHMOD
+      {
+	struct stat info;
+	// Keep the access rights of the original image, the
+	// temporary file is created with the default rights.
+	if (stat(path,&info) == 0 && chmod(tmpname,info.st_mode & 07777))
+	  ThrowIo("Cartridge::SaveToFile","unable to set the access rights of the cart image");
+      }
+#endif
+      if (rename(tmpname,path))
+	ThrowIo("Cartridge::SaveToFile","unable to replace the cart image");
     } catch(...) {
-      fclose(fp);
-      // Remove the incomplete cart.
-      unlink(path);
+      if (fp)
+	fclose(fp);
+      // Remove the incomplete cart, the original stays.
+      unlink(tmpname);
+      delete[] tmpname;
       throw;
     }
+    delete[] tmpname;
+    WithHeader = withheader;
   } else {
+    delete[] tmpname;
     ThrowIo("Cartridge::SaveToFile","unable to save the cart image");
   }
 }
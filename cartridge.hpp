@@ -37,6 +37,10 @@ protected:
   // Path name the cart was loaded from.
   char *CartPath;
   //
+  // Set if the image the cart was loaded from carries the
+  // atari800 CART type header.
+  bool  WithHeader;
+  //
   // Default constructor, does nothing.
   Cartridge(void);
   //
@@ -51,6 +51,7 @@ CartROM::CartROM(class Machine *mach)
   carttoload   = Cartridge::Cart_None;
   newcart      = NULL;
   insertrtime8 = false;
+  journalflash = false;
   swapcarts    = true;
   machtype     = machine->MachType();
 }
@@ -146,6 +147,8 @@ void CartROM::Initialize(void)
 	Throw(ObjectExists,"CartROM::Initialize","new cart exists already");
 #endif
       newcart    = BuildCart(carttoload,cartsize);
+      if (carttoload == Cartridge::Cart_Flash)
+	((class CartFlash *)newcart)->SetJournal(journalflash);
       try { 
 	// try to load the mentioned file from disk. This may fail, though.
 	LoadFromFile(cartpath,skipheader);
@@ -373,6 +376,7 @@ void CartROM::ParseArgs(class ArgParser *args)
   LONG type          = carttoload;
   bool withheader    = false;
   bool rtime         = insertrtime8;
+  bool journal       = journalflash;
   Machine_Type mtype = machine->MachType();
 
   args->DefineTitle("Cartridge");
@@ -444,6 +448,17 @@ void CartROM::ParseArgs(class ArgParser *args)
     swapcarts    = true;
     args->SignalBigChange(ArgParser::ColdStart);
   }
+  //
+  // The journal is set when the flash cart is inserted, hence
+  // re-insert it if this changes.
+  args->DefineBool("CartFlashJournal","keep a journal of flash cartridge modifications",journal);
+  if (journal != journalflash) {
+    journalflash = journal;
+    if (carttoload == Cartridge::Cart_Flash) {
+      swapcarts  = true;
+      args->SignalBigChange(ArgParser::ColdStart);
+    }
+  }
   args->CloseSubItem();
 }
 ///
@@ -72,6 +72,9 @@ class CartROM : public Chip, public MemController {
   // boolean that checks whether the RTime8 pass-thru cart should be
   // made available.
   bool                               insertrtime8;
+  // boolean whether modifications of flash cartridges are kept
+  // in a journal and written back into the image.
+  bool                               journalflash;
   //
   // Boolean whether the cart was changed and must be swapped
   // on the next reset.
@@ -117,10 +117,14 @@ bool CartWill::ComplexWrite(class MMU *mmu,ADR mem,UBYTE)
   }
   //
   // This will/might require rebuilding now
-  if (newbank != ActiveBank || newdisabled != Disabled) {
+  if (newdisabled != Disabled) {
     Disabled   = newdisabled;
     ActiveBank = newbank;
     mmu->BuildCartArea();
+  } else if (newbank != ActiveBank) {
+    ActiveBank = newbank;
+    if (!Disabled)
+      mmu->SwitchCartBank(this,0xa000,0xc000,Rom + (ActiveBank << 5));
   }
   // This cart accepts this write.
   return (mem == 0xd500);
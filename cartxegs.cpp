@@ -138,10 +138,15 @@ bool CartXEGS::ComplexWrite(class MMU *mmu,ADR mem,UBYTE val)
   newbank          = val & (TotalBanks - 1);
   //
   // This will/might require rebuilding now
-  if (newdisabled != Disabled || newbank != ActiveBank) {
+  if (newdisabled != Disabled) {
     ActiveBank     = newbank;
     Disabled       = newdisabled;
     mmu->BuildCartArea();
+  } else if (newbank != ActiveBank) {
+    // Only the window at 0x8000 changes.
+    ActiveBank     = newbank;
+    if (!Disabled)
+      mmu->SwitchCartBank(this,0x8000,0xa000,Rom + (ActiveBank << 5));
   }
   //
   // This cart only reacts to writes into the byte 0xd500. Everything
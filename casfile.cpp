@@ -16,7 +16,7 @@
 // Construct a cas file from a raw file. The file
 // must be administrated outside of this class.
 CASFile::CASFile(FILE *is) 
-  : src(is)
+  : src(is), baud(600)
 {
 }
 ///
@@ -67,6 +67,13 @@ UWORD CASFile::ReadChunk(UBYTE *buffer,LONG buffersize,UWORD &irg)
       
       return size;
     } else {
+      // Baud chunks keep the baud rate of the following
+      // records in the aux bytes.
+      if (chunk[0] == 'b' && chunk[1] == 'a' && chunk[2] == 'u' && chunk[3] == 'd') {
+	baud = chunk[6] | (chunk[7] << 8);
+	if (baud == 0)
+	  baud = 600;
+      }
       // Skip the data.
       while(size) {
 	if (fgetc(src) < 0) {
@@ -135,3 +142,89 @@ void CASFile::OpenForWriting(void)
   }
 }
 ///
+
+/// CASFile::WriteBaudRate
+// Write a chunk that sets the baud rate of the following records.
+void CASFile::WriteBaudRate(UWORD rate)
+{
+  UBYTE chunk[8];
+
+  chunk[0] = 'b';
+  chunk[1] = 'a';
+  chunk[2] = 'u';
+  chunk[3] = 'd';
+  chunk[4] = 0;
+  chunk[5] = 0;
+  chunk[6] = UBYTE(rate & 0xff);
+  chunk[7] = UBYTE(rate >> 8);
+
+  if (fwrite(chunk,1,sizeof(chunk),src) != sizeof(chunk)) {
+    ThrowIo("CASFile::WriteBaudRate","error when writing to CAS file");
+  }
+}
+///
+
+/// CASFile::WriteSourceHash
+// Write a chunk that records the hash and the size of the source
+// this image has been decoded from. Other readers skip this chunk.
+void CASFile::WriteSourceHash(UQUAD hash,ULONG size)
+{
+  UBYTE chunk[8 + 12];
+  int i;
+
+  chunk[0] = 'h';
+  chunk[1] = 'a';
+  chunk[2] = 's';
+  chunk[3] = 'h';
+  chunk[4] = 12;
+  chunk[5] = 0;
+  chunk[6] = 0;
+  chunk[7] = 0;
+  for(i = 0;i < 8;i++) {
+    chunk[8 + i]  = UBYTE(hash >> (i << 3));
+  }
+  for(i = 0;i < 4;i++) {
+    chunk[16 + i] = UBYTE(size >> (i << 3));
+  }
+
+  if (fwrite(chunk,1,sizeof(chunk),src) != sizeof(chunk)) {
+    ThrowIo("CASFile::WriteSourceHash","error when writing to CAS file");
+  }
+}
+///
+
+/// CASFile::HasSourceHash
+// Check whether the image has been decoded completely from a
+// source of the given hash and size. This rewinds the file.
+bool CASFile::HasSourceHash(UQUAD hash,ULONG size)
+{
+  UBYTE chunk[8];
+  UBYTE data[12];
+  bool found = false;
+  UWORD len;
+  int i;
+
+  rewind(src);
+  while(fread(chunk,1,8,src) == 8) {
+    len = chunk[4] | (chunk[5] << 8);
+    if (chunk[0] == 'h' && chunk[1] == 'a' && chunk[2] == 's' && chunk[3] == 'h' && len == 12) {
+      UQUAD h = 0;
+      ULONG s = 0;
+      if (fread(data,1,12,src) != 12)
+	break;
+      for(i = 7;i >= 0;i--) {
+	h = (h << 8) | data[i];
+      }
+      for(i = 11;i >= 8;i--) {
+	s = (s << 8) | data[i];
+      }
+      found = (h == hash && s == size);
+    } else if (fseek(src,len,SEEK_CUR) != 0) {
+      break;
+    }
+  }
+  rewind(src);
+
+  return found;
+}
+///
@@ -23,6 +23,9 @@ class CASFile : public TapeImage {
   // The image stream to read from.
   FILE               *src;
   //
+  // The baud rate of the records, as given by the last baud chunk.
+  UWORD               baud;
+  //
 public:
   // Construct a cas file from a raw file. The file
   // must be administrated outside of this class.
@@ -41,6 +44,24 @@ public:
   //
   // Create the header for a CAS file.
   virtual void OpenForWriting(void);
+  //
+  // Return the baud rate of the record read last.
+  virtual UWORD BaudRateOf(void) const
+  {
+    return baud;
+  }
+  //
+  // Write a chunk that sets the baud rate of the following records.
+  void WriteBaudRate(UWORD rate);
+  //
+  // Write a chunk that records the hash and the size of the source
+  // this image has been decoded from. Other readers skip this chunk.
+  // It is written last and hence also marks the image as complete.
+  void WriteSourceHash(UQUAD hash,ULONG size);
+  //
+  // Check whether the image has been decoded completely from a
+  // source of the given hash and size. This rewinds the file.
+  bool HasSourceHash(UQUAD hash,ULONG size);
 };
 ///
 
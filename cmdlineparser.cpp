@@ -22,9 +22,10 @@
 
 /// CmdLineParser::CmdLineParser
 CmdLineParser::CmdLineParser(void)
-  : args(NULL), Columns(0), ParseSource(NULL),
+  : args(NULL), last(&args), Columns(0), ParseSource(NULL),
     HelpBuffer(NULL), HelpBufferSize(0), Indent(-1), Remains(0)
 { 
+  memset(hash,0,sizeof(hash));
 }
 ///
 
@@ -232,17 +233,31 @@ void CmdLineParser::PrintHelp(const char *fmt,...)
 }
 ///
 
+/// CmdLineParser::HashOf
+// Compute the hash bucket of an argument name, ignoring the case.
+int CmdLineParser::HashOf(const char *name)
+{
+  ULONG h = 0;
+  //
+  while(*name) {
+    h = (h * 31) + tolower(UBYTE(*name));
+    name++;
+  }
+  return int((h ^ (h >> 8)) & (HashSize - 1));
+}
+///
+
 /// CmdLineParser::FindArgument
 const char *CmdLineParser::FindArgument(const char *name)
 {
-  struct Argument *arg = args;
+  struct Argument *arg = hash[HashOf(name)];
   // Find an argument by name
   while(arg) {
     if (!strcasecmp(arg->name,name)) {
       // Found me!
       return arg->value;
     }
-    arg = arg->next;
+    arg = arg->hashnext;
   }
   //
   // Return NULL if not found
@@ -250,6 +265,38 @@ const char *CmdLineParser::FindArgument(const char *name)
 }
 ///
 
+/// CmdLineParser::AddArgument
+// Find an argument by name, or create a new one without a value
+// if there is none yet. The value of an existing argument is
+// released as the source scanned last has the highest priority.
+struct CmdLineParser::Argument *CmdLineParser::AddArgument(const char *name)
+{
+  int bucket           = HashOf(name);
+  struct Argument *arg = hash[bucket];
+  //
+  while(arg) {
+    if (!strcasecmp(arg->name,name)) {
+      // Dispose the old value string as we have to replace it.
+      delete[] arg->value;
+      arg->value = NULL; // ensure exception savety.
+      return arg;
+    }
+    arg = arg->hashnext;
+  }
+  //
+  // We do not have an argument of this type yet, so allocate it and link it in.
+  arg           = new struct Argument;
+  *last         = arg;
+  last          = &(arg->next); // continue to link in here.
+  arg->hashnext = hash[bucket];
+  hash[bucket]  = arg;
+  arg->name     = new char[strlen(name) + 1];
+  strcpy(arg->name,name);
+  //
+  return arg;
+}
+///
+
 /// CmdLineParser::PrintError
 void CmdLineParser::PrintError(const char *fmt,...)
 {
@@ -271,13 +318,6 @@ void CmdLineParser::PrintError(const char *fmt,...)
 // This also filters for --help or -h or -help
 bool CmdLineParser::PreParseArgs(int argc,char **argv,const char *info)
 {
-  struct Argument **last;
-  //
-  // Find the argument we attach more arguments to.
-  last        = &args;
-  while (*last) {
-    last      = &((*last)->next);
-  }
   ParseSource = info; // Note where these arguments came from
   //
   // drop the command name
@@ -312,29 +352,9 @@ bool CmdLineParser::PreParseArgs(int argc,char **argv,const char *info)
     if (!strcasecmp(s,"help") || !(strcasecmp(s,"h"))) {
       givehelp = true;
     } else {
-      struct Argument *arg = args;
-      // Now scan whether we have this argument already.
-      while(arg) {
-	if (!strcasecmp(s,arg->name)) {
-	  // Yup. The one that is scanned last has the highest priority, hence replace this one.
-	  break;
-	}
-	arg = arg->next;
-      }
-      if (arg == NULL) {
-	// We do not have an argument of this type yet, so allocate it and link it in.
-	arg   = new struct Argument;
-	*last = arg;
-	last  = &(arg->next); // continue to link in here.
-	// Now allocate the name. We must have dropped a single minus, 
-	// hence len bytes are LONG enough.
-	arg->name = new char[len];
-	strcpy(arg->name,s);
-      } else {
-	// Now replace the value of this argument with the next argument.
-	delete[] arg->value;
-	arg->value = NULL; // ensure exception savety.
-      }
+      // Find the argument, or create it. The one that is scanned last
+      // has the highest priority, hence an existing value is replaced.
+      struct Argument *arg = AddArgument(s);
       // Attach the new value if there is one.
       if (argc) {
 	len = strlen(*argv);
@@ -366,16 +386,9 @@ bool CmdLineParser::PreParseArgs(int argc,char **argv,const char *info)
 // Run an argument parser from a configuration file
 bool CmdLineParser::PreParseArgs(FILE *file,const char *info)
 {
-  struct Argument **last;
   LONG lineno = 0;
   char line[512];
   //
-  // Find the argument where to link further arguments to.
-  last        = &args;
-  while (*last) {
-    last      = &((*last)->next);
-  }
-  //
   ParseSource = info;
   while(!feof(file)) {
     size_t len;
@@ -442,26 +455,7 @@ bool CmdLineParser::PreParseArgs(FILE *file,const char *info)
     //
     // Now check whether we have this argument already set in the database. If so,
     // we must replace it as the last scanned source has priority.
-    next  = args;
-    while(next) {
-      if (!strcasecmp(next->name,arg))
-	break;
-      next = next->next;
-    }
-    if (next == NULL) {
-      // We don't. Now get a new argument and link it in.
-      next  = new struct Argument;
-      *last = next;
-      last  = &(next->next); // next has to be attached here.
-      //
-      // Build the name string.
-      next->name = new char[len + 1];
-      strcpy(next->name,arg);
-    } else {
-      // Dispose the old value string as we have to replace it.
-      delete[] next->value;
-      next->value = NULL;
-    }
+    next  = AddArgument(arg);
     // Now check again for the argument value
     len = strlen(value);
     if (len >= 256) {
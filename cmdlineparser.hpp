@@ -16,13 +16,16 @@
 
 /// class CmdLineParser
 class CmdLineParser : public ArgParser {
-  // A singly linked list of arguments
+  // A singly linked list of arguments. Each argument is also linked
+  // into a hash chain keyed by its case-insensitive name, such that
+  // the definitions do not need to scan the complete list.
   struct Argument {
     struct Argument *next;
+    struct Argument *hashnext;
     char *name,*value;
     //
     Argument(void)
-      : next(NULL), name(NULL), value(NULL)
+      : next(NULL), hashnext(NULL), name(NULL), value(NULL)
     { };
     //
     ~Argument(void)
@@ -32,6 +35,24 @@ class CmdLineParser : public ArgParser {
     }
   }          *args;
   //
+  // The end of the above list, where new arguments are attached.
+  struct Argument **last;
+  //
+  // The number of hash buckets. Must be a power of two.
+  enum {
+    HashSize = 256
+  };
+  //
+  // The hash chains of the arguments.
+  struct Argument *hash[HashSize];
+  //
+  // Compute the hash bucket of an argument name, ignoring the case.
+  static int HashOf(const char *name);
+  //
+  // Find an argument by name, or create a new one without a value
+  // if there is none yet.
+  struct Argument *AddArgument(const char *name);
+  //
   // Length of a line for helper output. This is zero until we get the size.
   LONG        Columns;
   //
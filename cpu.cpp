@@ -13,6 +13,7 @@
 #include "mmu.hpp"
 #include "argparser.hpp"
 #include "cpu.hpp"
+#include "callprofiler.hpp"
 #include "antic.hpp"
 #include "monitor.hpp"
 #include "snapshot.hpp"
@@ -67,9 +68,8 @@
 /// CPU::CPU
 CPU::CPU(class Machine *mach)
   : Chip(mach,"CPU"), Saveable(mach,"CPU"), HBIAction(mach),
-    ProfilingCounters(NULL), CumulativeCounters(NULL), Instructions(NULL)
+    ProfilingCounters(NULL), CumulativeCounters(NULL), CallGraph(NULL), Instructions(NULL)
 {
-  int i;
   //
   EnableBreak            = false;
   EnableTracing          = false;
@@ -92,6 +92,8 @@ CPU::CPU(class Machine *mach)
   IRQMask                = 0;
   CycleCounter           = 0;
   ProfileCounter         = 0;
+  ProfileCharged         = 0;
+  ProfileStolen          = 0;
   NMI                    = false;
   HaltStart              = ClocksPerLine;
   IRQPending             = false;
@@ -100,13 +102,11 @@ CPU::CPU(class Machine *mach)
   EffectiveAddress       = 0;
   ISync                  = false;
   HitWatchPoint          = -1;
+  HitWatchType           = 0;
   //
   // Clear all break points
-  for(i=0;i<NumBreakPoints;i++) {
-    BreakPoints[i].Enabled = false;
-    BreakPoints[i].Free    = true;
-    BreakPoints[i].BreakPC = 0x000;
-  }
+  memset(BreakMap,0,sizeof(BreakMap));
+  BreakCount             = 0;
   //
   // Allocate all cycles. This simplifies overflow handling
   // in the GTIA scanline creator; namely, we won't need any.
@@ -159,6 +159,7 @@ CPU::~CPU(void)
 {
   delete[] ProfilingCounters;
   delete[] CumulativeCounters;
+  delete CallGraph;
 
   ClearInstructions();
 }
@@ -1087,35 +1088,26 @@ UWORD CPU::DecodeInstruction(void)
   //
   // Check for pending breaks.
   if (EnableBreak) {
-    int i;	
     // Re-insert the instruction decoder into the pipeline here unless something
     // else happens. This ensures that the monitor can at least
     // launch off the CPU again once we left here due to a breakpoint
     NextStep       = ExecutionSteps[-2];
     ExecutionSteps--;
     //
-#ifdef HAS_MEMBER_INIT
-    for(i=0;i<NumBreakPoints;i++) {
-      if (BreakPoints[i].Enabled && BreakPoints[i].BreakPC == GlobalPC) {  
-	InterruptS = 0x00; // Keep tracing
-	monitor->CapturedBreakPoint(i,GlobalPC);
-      }
+    // The monitor checks the condition of the break point, if any.
+    if (BreakCount && IfBreakPoint(GlobalPC) &&
+	monitor->TestBreakPoint(GlobalPC,DebugAdrSpace::ExecuteAccess)) {
+      InterruptS = 0x00; // Keep tracing
+      monitor->CapturedBreakPoint(GlobalPC);
     }
-#else
-    for(i=0;i<NumBreakPoints;i++) {
-      if (BreakPoints[i].Enabled && BreakPoints[i].BreakPC == GlobalPC) {
-	InterruptS = 0x00; // Keep tracing
-	monitor->CapturedBreakPoint(i,GlobalPC);
-      }
-    }
-#endif
     // Check for watchpoints. The instruction is completed before the watchpoint is
     // entered.
     if (EnableWatch) {
       int watch = HitWatchPoint;
       if (watch >= 0) {
 	HitWatchPoint = -1;
-	monitor->CapturedWatchPoint(watch,PreviousPC);
+	if (monitor->TestBreakPoint(watch,HitWatchType))
+	  monitor->CapturedWatchPoint(watch,PreviousPC);
       }
       PreviousPC = GlobalPC;
     }
@@ -1138,6 +1130,14 @@ UWORD CPU::DecodeInstruction(void)
       }
     }  
   }
+  //
+  // Run the call profiler: Account the cycles since the last
+  // instruction fetch, and follow returns from subroutines.
+  if (CallGraph) {
+    CallGraph->Account(ProfileCounter - ProfileCharged,ProfileStolen,GlobalPC,GlobalS);
+    ProfileCharged = ProfileCounter;
+    ProfileStolen  = 0;
+  }
   // Interrupt processing follows.
   // Check for pending NMIs. If so, service them by providing the pipeline of the NMI
   // processor. 
@@ -1146,6 +1146,8 @@ UWORD CPU::DecodeInstruction(void)
     NextStep       = aeu[1];
     ExecutionSteps = aeu + 2;
     InterruptS     = GlobalS;
+    if (CallGraph)
+      CallGraph->Interrupt(GlobalS);
     return (*aeu)->Execute(0);          // start the NMI processing here.
   }
   // Check for pending interrupts. If so, fetch it now.
@@ -1157,6 +1159,8 @@ UWORD CPU::DecodeInstruction(void)
     NextStep       = aeu[1];
     ExecutionSteps = aeu + 2;
     InterruptS     = GlobalS;
+    if (CallGraph)
+      CallGraph->Interrupt(GlobalS);
     return (*aeu)->Execute(0);          // start the IRQ processing here.
   }
   if (IRQMask && ((GlobalP & I_Mask) == 0)) {
@@ -1192,6 +1196,7 @@ UWORD CPU::DecodeInstruction(void)
     }
   }
   ProfileCounter = 0;
+  ProfileCharged = 0;
   //
   // Fetch the next Opcode: This counts as one execution step.
   opcode     = Ram->ReadByte(GlobalPC);
@@ -1201,6 +1206,11 @@ UWORD CPU::DecodeInstruction(void)
 #endif
   GlobalPC++;
   //
+  // Let the call profiler know about subroutine calls. It takes
+  // the target from the next instruction fetch.
+  if (CallGraph && opcode == 0x20)
+    CallGraph->Call(GlobalS);
+  //
   // Fetch the execution sequence for this opcode
   // and install it.
   aeu            = Instructions[opcode]->Sequence;
@@ -4205,6 +4215,8 @@ void CPU::WarmStart(void)
   GlobalS        = 0xff;  // reset stack pointer to top of stack
   CycleCounter   = 0;
   ProfileCounter = 0;
+  ProfileCharged = 0;
+  ProfileStolen  = 0;
   // Fetch the reset vector and run from there.
   ExecutionSteps = Instructions[0x100]->Sequence;
   NextStep       = *ExecutionSteps++;
@@ -4218,81 +4230,29 @@ void CPU::WarmStart(void)
 ///
 
 /// CPU::SetBreakPoint
-// Install/set a new break point at an indicated position,
-// return the id or -1 if no break point is available.
-int CPU::SetBreakPoint(ADR where)
+// Install a break point at the given address.
+void CPU::SetBreakPoint(ADR where)
 {
-  int i;
-
-  for(i=0;i<NumBreakPoints;i++) {
-    if (BreakPoints[i].Free) {  
-      EnableBreak            = true;
-      BreakPoints[i].Free    = false;
-      BreakPoints[i].Enabled = true;
-      BreakPoints[i].BreakPC = UWORD(where);
-      return i;
-    }
+  UBYTE &bits = BreakMap[(where >> 3) & 0x1fff];
+  UBYTE  mask = UBYTE(1 << (where & 7));
+  
+  if ((bits & mask) == 0) {
+    bits |= mask;
+    BreakCount++;
   }
-  return -1;
+  EnableBreak = true;
 }
 ///
 
-/// CPU::ClearBreakPoint
-// Release the breakpoint register #i
-void CPU::ClearBreakPoint(int i)
+/// CPU::ClearBreakPoints
+// Remove all break points.
+void CPU::ClearBreakPoints(void)
 {
-  BreakPoints[i].Free    = true;
-  BreakPoints[i].Enabled = false;
-  BreakPoints[i].BreakPC = 0x0000;  
+  memset(BreakMap,0,sizeof(BreakMap));
+  BreakCount = 0;
   
-  for(i=0;i<NumBreakPoints;i++) {
-    if (!BreakPoints[i].Free) {  
-      EnableBreak            = true;
-      return;
-    }
-  }
-
   // Disable this feature otherwise as it costs time
-  EnableBreak = EnableStacking || EnableTracing || EnableUntil || EnableWatch;
-}
-///
-
-/// CPU::EnableBreakPoint
-// Enable the breakpoint register #i
-void CPU::EnableBreakPoint(int i)
-{
-  if (!BreakPoints[i].Free) {
-    BreakPoints[i].Enabled = true;
-  }
-}
-///
-
-/// CPU::DisableBreakPoint
-// Disable the breakpoint register #i
-void CPU::DisableBreakPoint(int i)
-{
-  if (!BreakPoints[i].Free) {
-    BreakPoints[i].Enabled = false;
-  }
-}
-///
-
-/// CPU::IfBreakPoint
-// Test whether a breakpoint has been set
-// at the specified address
-bool CPU::IfBreakPoint(ADR where)
-{
-  int i;
-
-  for(i=0;i<NumBreakPoints;i++) {
-    if (BreakPoints[i].Enabled          &&
-	BreakPoints[i].Free    == false &&
-	BreakPoints[i].BreakPC == UWORD(where)) {
-      return true;
-    }
-  }
-
-  return false;
+  EnableBreak = EnableStacking || EnableTracing || EnableUntil || EnableWatch || BreakCount;
 }
 ///
 
@@ -4324,7 +4284,7 @@ void CPU::DisableWatchPoints(void)
     ExecutionSteps = Instructions[0xea]->Sequence;
     NextStep       = *ExecutionSteps++;
   }
-  EnableBreak = EnableStacking || EnableTracing || EnableUntil || EnableWatch;
+  EnableBreak = EnableStacking || EnableTracing || EnableUntil || EnableWatch || BreakCount;
 }
 ///
 
@@ -4559,6 +4519,13 @@ void CPU::StartProfiling(void)
 
   memset(ProfilingCounters ,0,(1L << 16) * sizeof(ULONG));
   memset(CumulativeCounters,0,(1L << 16) * sizeof(ULONG));
+  //
+  // Restart the call tree from scratch.
+  delete CallGraph;
+  CallGraph      = NULL;
+  CallGraph      = new class CallProfiler;
+  ProfileCharged = ProfileCounter;
+  ProfileStolen  = 0;
 }
 ///
 
@@ -4569,8 +4536,11 @@ void CPU::StopProfiling(void)
   delete[] ProfilingCounters;
   delete[] CumulativeCounters;
   
+  delete CallGraph;
+  
   ProfilingCounters  = NULL;
   CumulativeCounters = NULL;
+  CallGraph          = NULL;
 }
 ///
 
@@ -4671,12 +4641,8 @@ void CPU::DisplayStatus(class Monitor *mon)
 		   NMI?("yes"):("no "),
 		   IRQPending?("yes"):("no "));
 
-  for(i=0;i<NumBreakPoints;i++) {
-    if (!BreakPoints[i].Free) {
-      mon->PrintStatus("\tBreakpoint #%d at %04x (%s)\n",
-		       i,BreakPoints[i].BreakPC,
-		       (BreakPoints[i].Enabled)?("enabled"):("disabled"));
-    }
+  if (BreakCount) {
+    mon->PrintStatus("\tBreakpoints at " LU " addresses\n",BreakCount);
   }
 }
 ///
@@ -25,6 +25,7 @@
 /// Forward declarations
 class Monitor;
 class Patch;
+class CallProfiler;
 ///
 
 /// Class CPU
@@ -44,10 +45,8 @@ public:
   UWORD PreviousPC; // for watch point management: The PC of the instruction that caused the hit
   //
 #ifdef HAS_MEMBER_INIT
-  static const int NumBreakPoints = 8;
   static const int ClocksPerLine  = 114;
 #else
-#define            NumBreakPoints   8
 #define            ClocksPerLine    114
 #endif
   //
@@ -58,12 +57,13 @@ public:
   bool   EnableUntil;
   bool   TraceInterrupts;
   bool   EnableWatch;
-  int    HitWatchPoint; // the watch point number we run into.
-  struct BreakPoint {
-    bool Enabled;  // If this break point is activated
-    bool Free;     // if this slot is still available
-    UWORD BreakPC;
-  } BreakPoints[NumBreakPoints];
+  int    HitWatchPoint; // the address of the watch point we run into.
+  UBYTE  HitWatchType;  // the type of the access, see DebugAdrSpace.
+  //
+  // The break points, one bit per address, and the number
+  // of addresses with a break point.
+  UBYTE  BreakMap[0x10000 >> 3];
+  ULONG  BreakCount;
   //
 public:
   // Position of the CPU flags within the P register
@@ -179,6 +179,17 @@ public:
   // Profile counter, counts steps for the profiler.
   ULONG  ProfileCounter;
   //
+  // The part of the profile counter already accounted for by
+  // the call profiler.
+  ULONG  ProfileCharged;
+  //
+  // Counts the cycles lost to DMA for the call profiler.
+  ULONG  ProfileStolen;
+  //
+  // If non-NULL, this builds the call tree of the running program
+  // with inclusive and exclusive cycle counts per subroutine.
+  class CallProfiler *CallGraph;
+  //
   // CPU preferences
   LONG   WSyncPosition; // horizontal position of the WSync release slot. Defaults to 104.
   //
@@ -1553,7 +1564,8 @@ public:
     //
     // Check whether there is a CPU slot available (and not stolen by DMA)
     // or blocked by WSync wait
-    if ((*CurCycle & current->StopMask()) == 0) {
+    UBYTE stop = *CurCycle & current->StopMask();
+    if (stop == 0) {
       // Get already the step following this step such that the AEU may insert a step
       // between this and the next. This might be required to implement some data
       // dependent delay slots.
@@ -1568,8 +1580,11 @@ public:
     // Advance the rest of the hardware by a single cycle
     if (CurCycle <= LastCycle) {
       CycleCounter++;
-      // Bump the profile counter
+      // Bump the profile counter, and count cycles stolen by DMA
+      // for the call profiler.
       ProfileCounter++;
+      if (CallGraph)
+	ProfileStolen += stop & 0x01;
       machine->Step();
     }
   }
@@ -1630,23 +1645,28 @@ public:
     NMI = true; // that's all!
   }
   //
-  // Generate a watch point interrupt.
-  void GenerateWatchPoint(UBYTE idx)
+  // Generate a watch point interrupt for the given address and
+  // access type.
+  void GenerateWatchPoint(ADR mem,UBYTE type)
   {
-    HitWatchPoint = idx;
+    HitWatchPoint = mem;
+    HitWatchType  = type;
   }
   //
   // Miscellaneous breakpoint stuff.
   //
-  // Install/set a new break point at an indicated position,
-  // return the id or -1 if no break point is available.
-  int SetBreakPoint(ADR where);
-  void ClearBreakPoint(int bpk);
-  void EnableBreakPoint(int bpk);
-  void DisableBreakPoint(int bpk);
+  // Install a break point at an indicated position. The monitor
+  // keeps the details and checks conditions, the CPU only knows
+  // whether an address breaks.
+  void SetBreakPoint(ADR where);
+  // Remove all break points.
+  void ClearBreakPoints(void);
   // Test whether a breakpoint has been set
   // at the specified address
-  bool IfBreakPoint(ADR where);
+  bool IfBreakPoint(ADR where) const
+  {
+    return (BreakMap[(where >> 3) & 0x1fff] & (1 << (where & 7))) != 0;
+  }
   //
   // Enable or disable watch points.
   void EnableWatchPoints(void);
@@ -1691,6 +1711,13 @@ public:
   {
     return CumulativeCounters;
   }
+  //
+  // Return the call profiler that collects the call tree, or NULL
+  // in case profiling is disabled.
+  class CallProfiler *CallProfilerOf(void) const
+  {
+    return CallGraph;
+  }
 };
 ///
 
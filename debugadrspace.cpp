@@ -17,8 +17,8 @@
 
 /// DebugAdrSpace::CaptureWatch
 // Hit a watch point, now enter the monitor.
-void DebugAdrSpace::CaptureWatch(UBYTE idx,ADR)
+void DebugAdrSpace::CaptureWatch(ADR mem,UBYTE type)
 {
-  Machine->CPU()->GenerateWatchPoint(idx);
+  Machine->CPU()->GenerateWatchPoint(mem,type);
 }
 ///
@@ -32,6 +32,17 @@
 // this is the matter of the MMU class. This class includes
 // additional debug functionality to capture memory accesses.
 class DebugAdrSpace {
+public:
+  //
+  // The types of accesses a watch point can trigger on. Execution
+  // is checked by the CPU, though it is listed here for completeness.
+  enum AccessType {
+    ReadAccess    = 1,
+    WriteAccess   = 2,
+    ExecuteAccess = 4
+  };
+  //
+private:
   //
   // The address space we work on.
   class AdrSpace *Mem;
@@ -39,44 +50,29 @@ class DebugAdrSpace {
   // The monitor we break into.
   class Machine  *Machine;
   //
-  // The break points enabled here.
-  ADR             BreakPoint[16];
-  //
-  // Test whether a read-hit is enough.
-  bool            HitOnRead[16];
+  // The access types watched, one entry per address. The monitor
+  // keeps the details of the watch points and checks conditions,
+  // all we need here is to know whether an address is watched.
+  UBYTE           WatchMap[0x10000];
   //
-  // Number of break points enabled.
-  UBYTE           Count;
+  // Number of addresses watched.
+  ULONG           Count;
   //
   // Capture the indicated watch point.
-  void CaptureWatch(UBYTE idx,ADR mem);
+  void CaptureWatch(ADR mem,UBYTE type);
   //
   // Check whether an address is breaked on.
   void TestAddress(ADR mem)
   { 
-    if (Count) {
-      UBYTE i = Count;
-      while(i) {
-	--i;
-	if (BreakPoint[i] == mem) {
-	  CaptureWatch(i,mem);
-	}
-      }
-    }
+    if (WatchMap[mem & 0xffff] & WriteAccess)
+      CaptureWatch(mem,WriteAccess);
   }
   //
   // Check whether an address is breaked on.
   void TestReadAddress(ADR mem)
   { 
-    if (Count) {
-      UBYTE i = Count;
-      while(i) {
-	--i;
-	if (BreakPoint[i] == mem && HitOnRead[i]) {
-	  CaptureWatch(i,mem);
-	}
-      }
-    }
+    if (WatchMap[mem & 0xffff] & ReadAccess)
+      CaptureWatch(mem,ReadAccess);
   }
   //
   //
@@ -86,47 +82,24 @@ public:
   DebugAdrSpace(class Machine *mach,class AdrSpace *parent)
     : Mem(parent), Machine(mach), Count(0)
   {
-  }
-  // Install a breakpoint at the given address, return the break
-  // point number, or -1 in case no free break point is found.
-  BYTE SetWatchPoint(ADR mem,bool hitonread)
-  {
-    //
-    if (Count < 16) {
-      BreakPoint[Count] = mem;
-      HitOnRead[Count]  = hitonread;
-      return Count++;
-    } else {
-      return -1;
-    }
+    memset(WatchMap,0,sizeof(WatchMap));
   }
   //
-  // Remove the given break point by index.
-  void RemoveWatchPointByIndex(UBYTE idx)
+  // Watch the given address for the given access types.
+  void SetWatchPoint(ADR mem,UBYTE types)
   {
-    if (idx < Count) {
-      UBYTE i = idx;
-      while(i + 1 < Count) {
-	BreakPoint[i] = BreakPoint[i+1];
-	i++;
-      }
-      Count--;
-    }
+    UBYTE &entry = WatchMap[mem & 0xffff];
+    //
+    if (entry == 0 && types)
+      Count++;
+    entry |= types;
   }
   //
-  // Remove the given break point by address.
-  void RemoveWatchPoint(ADR mem)
+  // Remove all watch points.
+  void ClearWatchPoints(void)
   {
-    if (Count) {
-      UBYTE i = Count;
-      while(i) {
-	--i;
-	if (BreakPoint[i] == mem) {
-	  RemoveWatchPointByIndex(i);
-	  break;
-	}
-      }
-    }
+    memset(WatchMap,0,sizeof(WatchMap));
+    Count = 0;
   }
   //
   // Are any watch points enabled.
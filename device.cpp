@@ -179,6 +179,7 @@ void Device::Get(class CPU *cpu,class AdrSpace *adr)
 
   if (channel < 8 && (cpu->X() & 0x0f) == 0) {
     // Let the real handler do the job for us.
+    GetBulk(cpu,adr,channel);
     result = Get(channel,data);
     //
     // Install the result and return
@@ -200,6 +201,8 @@ void Device::Put(class CPU *cpu,class AdrSpace *adr)
     // Let the real handler do the job for us.
     data   = cpu->A();
     result = Put(channel,data);
+    if (result == 0x01)
+      result = PutBulk(cpu,adr,channel);
     //
     // Install the result and return
     SetResult(cpu,adr,result);
@@ -209,6 +212,102 @@ void Device::Put(class CPU *cpu,class AdrSpace *adr)
 }
 ///
 
+/// Device::GetBulk
+// If called from within a CIO get characters command, read all but
+// the last byte of the buffer directly into memory, and advance the
+// buffer pointer and the size in the zero page IOCB accordingly.
+// The last byte, or the byte at which the transfer stopped, then
+// goes through the regular Get which also delivers the EOF or error
+// condition, exactly as if the data had been read byte by byte.
+void Device::GetBulk(class CPU *cpu,class AdrSpace *adr,UBYTE channel)
+{
+  UBYTE block[4096];
+  ADR   mem;
+  UWORD len,size,i;
+  //
+  // Check whether CIO is running a get characters command on
+  // this channel, and whether break has not been pressed.
+  if (adr->ReadByte(0x22) != 0x07 || adr->ReadByte(0x2e) != cpu->X() ||
+      adr->ReadByte(0x11) == 0)
+    return;
+  //
+  mem = ADR(adr->ReadWord(0x24));   // buffer pointer
+  len = UWORD(adr->ReadWord(0x28)); // remaining bytes, including this one
+  while(len > 1) {
+    size = len - 1;
+    if (size > sizeof(block))
+      size = sizeof(block);
+    if (GetBlock(channel,block,size) != 0x01)
+      size = 0;
+    for(i = 0;i < size;i++) {
+      adr->WriteByte((mem + i) & 0xffff,block[i]);
+    }
+    mem  = (mem + size) & 0xffff;
+    len -= size;
+    if (size < sizeof(block))
+      break;
+  }
+  //
+  adr->WriteByte(0x24,UBYTE(mem & 0xff));
+  adr->WriteByte(0x25,UBYTE(mem >> 8));
+  adr->WriteByte(0x28,UBYTE(len & 0xff));
+  adr->WriteByte(0x29,UBYTE(len >> 8));
+}
+///
+
+/// Device::PutBulk
+// If called from within a CIO put characters command, write the
+// remaining bytes behind the one just written by Put, and advance
+// the buffer pointer and the size in the zero page IOCB such that
+// CIO finishes the command by its own increment. Returns the result
+// code of the transfer.
+UBYTE Device::PutBulk(class CPU *cpu,class AdrSpace *adr,UBYTE channel)
+{
+  UBYTE block[4096];
+  UBYTE result = 0x01;
+  ADR   mem;
+  UWORD len,size,i;
+  //
+  // Check whether CIO is running a put characters command on this
+  // channel, and whether the byte is taken from the buffer.
+  if (adr->ReadByte(0x22) != 0x0b || adr->ReadByte(0x2e) != cpu->X() ||
+      adr->ReadByte(0x11) == 0)
+    return result;
+  mem = ADR(adr->ReadWord(0x24));   // the byte just written
+  len = UWORD(adr->ReadWord(0x28)); // remaining bytes, including this one
+  if (len <= 1 || adr->ReadByte(mem) != cpu->A())
+    return result;
+  //
+  while(len > 1) {
+    size = len - 1;
+    if (size > sizeof(block))
+      size = sizeof(block);
+    for(i = 0;i < size;i++) {
+      block[i] = adr->ReadByte((mem + 1 + i) & 0xffff);
+    }
+    result = PutBlock(channel,block,size);
+    mem    = (mem + size) & 0xffff;
+    len   -= size;
+    if (result != 0x01) {
+      // CIO leaves the pointer and the size at the failing byte.
+      mem = (mem + 1) & 0xffff;
+      len--;
+      break;
+    } else if (size == 0) {
+      // Not supported by the device, go byte by byte.
+      break;
+    }
+  }
+  //
+  adr->WriteByte(0x24,UBYTE(mem & 0xff));
+  adr->WriteByte(0x25,UBYTE(mem >> 8));
+  adr->WriteByte(0x28,UBYTE(len & 0xff));
+  adr->WriteByte(0x29,UBYTE(len >> 8));
+  //
+  return result;
+}
+///
+
 /// Device::Status
 void Device::Status(class CPU *cpu,class AdrSpace *adr)
 {
@@ -61,6 +61,13 @@ private:
   void Put(class CPU *cpu,class AdrSpace *adr);
   void Status(class CPU *cpu,class AdrSpace *adr);
   void Special(class CPU *cpu,class AdrSpace *adr);  
+  //
+  // Transfer all but the last byte of a CIO get or put characters
+  // command in one go if the device supports it. CIO keeps the
+  // buffer pointer and the remaining size in the zero page IOCB and
+  // hence finishes the last byte as usual.
+  void GetBulk(class CPU *cpu,class AdrSpace *adr,UBYTE channel);
+  UBYTE PutBulk(class CPU *cpu,class AdrSpace *adr,UBYTE channel);
   // This method is called on a reset to close all open streams
   virtual void Reset(void) = 0;
   //
@@ -81,6 +88,21 @@ protected:
   virtual UBYTE Get(UBYTE channel,UBYTE &value) = 0;
   virtual UBYTE Put(UBYTE channel,UBYTE value) = 0;
   virtual UBYTE Status(UBYTE channel) = 0;
+  //
+  // Read or write a block of the given size. The size is
+  // to be updated to the number of bytes transfered. Devices that
+  // cannot transfer data in blocks need not to implement this, the
+  // data then goes byte by byte through Get and Put.
+  virtual UBYTE GetBlock(UBYTE,UBYTE *,UWORD &size)
+  {
+    size = 0;
+    return 0x01;
+  }
+  virtual UBYTE PutBlock(UBYTE,const UBYTE *,UWORD &size)
+  {
+    size = 0;
+    return 0x01;
+  }
   virtual UBYTE Special(UBYTE channel,UBYTE unit,class AdrSpace *adr,UBYTE cmd,
 			ADR mem,UWORD len,UBYTE aux[6]) = 0;
   //
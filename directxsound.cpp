@@ -19,7 +19,6 @@
 #include "cpu.hpp"
 #include "exceptions.hpp"
 #include "directxsound.hpp"
-#include "audiobuffer.hpp"
 #include "unistd.hpp"
 #include "new.hpp"
 #if HAVE_SDL2_SDL_H && HAVE_SDL_INITSUBSYSTEM
@@ -28,9 +27,9 @@
 /// DirectXSound::DirectXSound
 DirectXSound::DirectXSound(class Machine *mach)
   : Sound(mach), SDLClient(mach,0),
-    SoundStream(NULL), current(NULL),
+    SoundStream(NULL),
     FragSize(8), NumFrags(6),
-    BufferedSamples(0), UpdateBuffer(false), UpdateSamples(0)
+    UpdateBuffer(false), UpdateSamples(0)
 {
   SamplingFreq = 22050;
 }
@@ -39,29 +38,16 @@ DirectXSound::DirectXSound(class Machine *mach)
 /// DirectXSound::~DirectXSound
 DirectXSound::~DirectXSound(void) 
 {
-  if (current)
-    FreeBuffers.AddTail(current);
   if (SoundStream)
     delete SoundStream;
   //
-  // Audio buffers get disposed by the Sound
-}
-///
-
-/// DirectXSound::GenerateSamples
-// Generate the given number (not in bytes, but in number) of audio samples
-// and place them into the tail of the ready buffer list.
-void DirectXSound::GenerateSamples(ULONG numsamples)
-{	
-  // Let the parent class do the job
-  BufferedSamples += Sound::GenerateSamples(numsamples,FragSamples);
+  // The audio buffer gets disposed by the Sound
 }
 ///
 
 /// DirectXSound::FeedDevice
-// Feed data into the dsp device by taking buffered bytes from the queue
-// and removing the sample buffers, putting them back into the free list.
-// This returns false on a buffer underrun
+// Feed data into the dsp device by taking buffered samples from the
+// ring buffer. This returns false on a buffer underrun
 bool DirectXSound::FeedDevice(class Timer *delay)
 {
   void *buffer;
@@ -79,43 +65,23 @@ bool DirectXSound::FeedDevice(class Timer *delay)
     buffer = SoundStream->NextBuffer(size,0);
   }
   if (buffer) {
-    UBYTE *out = (UBYTE *)buffer;
+    UBYTE *out    = (UBYTE *)buffer;
+    UBYTE shift   = Ring.SampleShiftOf();
+    ULONG samples = ULONG(size) >> shift;
     ULONG copy;
-    ULONG bytes = ULONG(size);
-    // The device is ready to take more samples. Hence, pull them from the ready queue
-    while(bytes) {
-      // Check whether we still have an active input buffer. If so, use this one,
-      // otherwise fetch a new buffer.
-      if (current == NULL) {
-	current = ReadyBuffers.RemHead();
-      }
-      if (current == NULL) {
-	// Generate one fragment of data.
+    // The device is ready to take more samples. Hence, pull them from the ring buffer.
+    while(samples) {
+      copy = Ring.ReadSamples(out,samples);
+      if (copy == 0) {
+	// Generate one fragment of data. Everything runs in the
+	// emulation thread here, so pokey can be run directly.
 	GenerateSamples(FragSamples);
 	result = false;
 	continue;
       }
-      copy = current->ReadyBytes();
-      if (copy == 0L) {
-	FreeBuffers.AddTail(current);
-	current = NULL;
-	continue;
-      }
-      if (copy > bytes)
-	copy = bytes;
-      //
-      // Copy the data of this buffer over now.
-      memcpy(out,current->ReadPtr,copy);
-      BufferedSamples  -= copy >> current->SampleShift;
       // And advance the buffer position.
-      out              += copy;
-      current->ReadPtr += copy;
-      bytes            -= copy;
-      if (current->ReadPtr >= current->BufferEnd) {
-	// This buffer is used up, release it and fetch the next one.
-	FreeBuffers.AddTail(current);
-	current = NULL;
-      }
+      out     += copy << shift;
+      samples -= copy;
     }
     SoundStream->ReleaseBuffer(buffer,size);
   } else if (SoundStream->IsActive() == false) {
@@ -148,9 +114,7 @@ void DirectXSound::WarmStart(void)
   //
   // Dispose the old buffers now.
   CleanBuffer();
-  EffectiveFreq		 = SamplingFreq;
-  DifferentialAdjust = 0;
-  BufferedSamples    = 0;
+  ResetRateControl(TargetSamples);
 }
 ///
 
@@ -249,8 +213,11 @@ bool DirectXSound::InitializeDsp(void)
       // Also adjust the number of fragments.
       NumFrags = SoundStream->NumBuffersOf();
       //
-      // Setup the effective buffering frequency.
-      EffectiveFreq   = SamplingFreq;
+      // Allocate the ring buffer for twice the samples the device buffers.
+      AllocateBuffer(ULONG(NumFrags) * FragSamples * 2);
+      //
+      // Setup the latency control: Keep the buffer half filled.
+      ResetRateControl((ULONG(NumFrags) * FragSamples) >> 1);
       CycleCarry      = 0;
       UpdateBuffer    = false;
       UpdateSamples   = 0;
@@ -279,7 +246,7 @@ void DirectXSound::HBI(void)
     // Compute the number of samples we need to generate this time.
     // Note that the pokey base frequency is the HBI frequency. The number of clocks
     // per HBI is 114.
-    remaining      = EffectiveFreq + DifferentialAdjust; // the number of sampling cycles left this time.
+    remaining      = EffectiveFreq; // the number of sampling cycles left this time.
     // number of samples to generate this time.
     samples        = (remaining * cycles + CycleCarry) / (PokeyFreq * 114);         
     // keep the number of samples we did not take due to round-off   
@@ -334,29 +301,27 @@ void DirectXSound::UpdateSound(class Timer *delay)
     // Signal that we must now re-generate some samples as the audio
     // setting changed.
     UpdateBuffer       = true;
-    DifferentialAdjust = 0;
     // Ok, re-feed the device. In case of underrun, generate some samples manually.
     do {
 	  if (!FeedDevice(delay)) {
-		GenerateSamples((FragSamples << 1) - BufferedSamples);
-		AdjustUnderrun();
+		if (Ring.ReadySamples() < (FragSamples << 1))
+		  GenerateSamples((FragSamples << 1) - Ring.ReadySamples());
+		UpdateBuffer = true;
 	  }
       // If there is nothing to delay, bail out.
       if (delay == NULL) break;
       // Otherwise, delay until the delay time is over.
     } while(!delay->EventIsOver());
     //
-    // Now check for the number of bytes in the buffer. This should not
-    // grow endless. If it is too large, signal an overrun and adjust the
-    // frequency accordingly.
-    if (BufferedSamples > ULONG(NumFrags-2) * FragSamples) {
-      AdjustOverrun();
-    }
-    //
-    // If there is only one fragment in the buffer, signal underrun as well
-    if (delay && BufferedSamples < (FragSamples << 1)) {
-      GenerateSamples((FragSamples << 1) - BufferedSamples);
-      AdjustUnderrun();
+    // Now adjust the rate at which samples are generated to the
+    // number of samples in the buffer.
+    if (delay) {
+      ControlRate();
+      // If there is only one fragment in the buffer, refill it immediately.
+      if (Ring.ReadySamples() < (FragSamples << 1)) {
+	GenerateSamples((FragSamples << 1) - Ring.ReadySamples());
+	UpdateBuffer = true;
+      }
     }
   } else {
     // Sound has been disabled. Just do the wait if we have to wait.
@@ -367,46 +332,6 @@ void DirectXSound::UpdateSound(class Timer *delay)
 }
 ///
 
-/// DirectXSound::AdjustOverrun
-// Signal a buffer overrun
-void DirectXSound::AdjustOverrun(void)
-{
-  LONG newfreq;
-  // The buffer is running too full. This means we are
-  // generating samples too fast. Reduce the sampling frequency.
-  // We must do this very carefully as overruns accumulate data
-  newfreq = (EffectiveFreq * 16383) >> 14;
-  if (newfreq >= EffectiveFreq && newfreq > 0)
-    newfreq--;
-  EffectiveFreq = newfreq; 
-  DifferentialAdjust = -(LONG(BufferedSamples - FragSamples * NumFrags) * newfreq) >> 12;
-  if (-DifferentialAdjust >= (newfreq >> 1))
-    DifferentialAdjust = -(newfreq >> 1);
-  //
-  // Drop buffer bytes we should have generated so far.
-  UpdateSamples = 0;
-  //printf("Overrun! Freq now=%ld\n",EffectiveFreq);
-}
-///
-
-/// DirectXSound::AdjustUnderrun
-// Signal a buffer underrun
-void DirectXSound::AdjustUnderrun(void)
-{
-  LONG newfreq;
-  // The buffer is running empty. We are generating
-  // too few samples. Enlarge the effective frequency to keep track.
-  newfreq = (EffectiveFreq << 12) / 4094;
-  if (newfreq <= EffectiveFreq)
-    newfreq++;
-  EffectiveFreq = newfreq;
-  // We underrrun, or are near to underrun. We'd better update the
-  // the buffer and flush all buffered bytes to prevent the worst.
-  UpdateBuffer = true;
-  //printf("Underrun! Freq now=%ld\n",EffectiveFreq);
-}
-///
-
 /// DirectXSound::DisplayStatus
 // Display the status of the sound over the monitor
 void DirectXSound::DisplayStatus(class Monitor *mon)
@@ -430,7 +355,7 @@ void DirectXSound::DisplayStatus(class Monitor *mon)
 		   SamplingFreq,
 		   FragSize,
 		   NumFrags,
-		   BufferedSamples,
+		   LONG(Ring.ReadySamples()),
 		   EffectiveFreq,
 		   Stereo?("on"):("off"),
 		   Interleaved?("on"):("off"),
@@ -36,18 +36,8 @@ class DirectXSound : public Sound, public SDLClient {
   // this time the link to the directX interface.
   class DXSound   *SoundStream;
   //
-  // The currently active audio buffer
-  struct AudioBufferBase *current;
-  //
   // Sound configuration
   //
-  // Effective output frequency. We reduce or increase this
-  // depending on whether the buffer over- or underruns.
-  LONG             EffectiveFreq; 
-  //
-  // Differential adjustment (D-part of the control loop)
-  LONG             DifferentialAdjust;
-  //
   // frequency carry-over from last computation loop
   LONG             CycleCarry;
   // 
@@ -62,9 +52,6 @@ class DirectXSound : public Sound, public SDLClient {
   // buffering and so on.
   LONG             NumFrags;
   //
-  // Total number of bytes in the output buffer
-  ULONG            BufferedSamples;
-  //
   // This bool gets set if we must update the audio buffer
   // because either te device requires more data, or the audio
   // settings got altered.
@@ -73,21 +60,10 @@ class DirectXSound : public Sound, public SDLClient {
   // delayed the generation to reduce the overhead.
   ULONG            UpdateSamples;
   //
-  // Generate the given number (not in bytes, but in number) of audio samples
-  // and place them into the tail of the ready buffer list.
-  void GenerateSamples(ULONG numsamples);
-  //
-  // Feed data into the direct X machine by taking buffered bytes from the queue
-  // and removing the sample buffers, putting them back into the free list.
-  // This returns false on a buffer underrun
+  // Feed data into the direct X machine by taking buffered samples from
+  // the ring buffer. This returns false on a buffer underrun
   bool FeedDevice(class Timer *delay);
   //
-  // Signal a buffer overrun
-  void AdjustOverrun(void);
-  //
-  // Signal a buffer underrun
-  void AdjustUnderrun(void);
-  //
   // Private setup of the dsp: Initialize and
   // configure the dsp for the user specified
   // parameters. Returns false in case the dsp cannot be setup.
@@ -17,6 +17,7 @@
 #include "imagestream.hpp"
 #include "filestream.hpp"
 #include "zstream.hpp"
+#include "mmapstream.hpp"
 #include "diskimage.hpp"
 #include "xfdimage.hpp"
 #include "atrimage.hpp"
@@ -25,6 +26,7 @@
 #include "streamimage.hpp"
 #include "dcmimage.hpp"
 #include "casstream.hpp"
+#include "cachedimage.hpp"
 #include "stdio.hpp"
 #include "new.hpp"
 #include <errno.h>
@@ -93,9 +95,12 @@ DiskDrive::DiskDrive(class Machine *mach,const char *name,int id)
   ImageType        = Unknown;
   ImageStream      = NULL;
   Disk             = NULL;
+  Cache            = NULL;
   ImageName        = NULL;
   ImageToLoad      = NULL;
   SpeedControl     = SIO::Baud19200 - 7; // speedy default speed: that of a 1050 (in pokey timers, must add 7)
+  UltraSpeed       = false;
+  CacheSize        = 0;
   //
   // Install drive default settings: 128 byte sectors, 720 of them.
   SectorSize       = 128;
@@ -113,8 +118,10 @@ DiskDrive::DiskDrive(class Machine *mach,const char *name,int id)
 /// DiskDrive::~DiskDrive
 DiskDrive::~DiskDrive(void)
 {
-  delete ImageStream;
+  // The disk may write back into the stream, hence
+  // must go first.
   delete Disk;
+  delete ImageStream;
   delete[] ImageName;
   delete[] ImageToLoad;
 }
@@ -400,7 +407,32 @@ UBYTE DiskDrive::CreateNewImage(UWORD sectorsize,ULONG sectorcount)
   //
   // Create a new image stream and format it here.
   try {
+    UBYTE buffer[2];
+    bool compressed = false;
+    //
+    // Check whether the image is gzip'd. If so, it must be
+    // formatted through the ZLib stream such that the result
+    // is compressed again.
     ImageStream = new class FileStream;
+    try {
+      ImageStream->OpenImage(ImageToLoad);
+      if (ImageStream->Read(0,buffer,2) && buffer[0] == 0x1f && buffer[1] == 0x8b)
+	compressed = true;
+    } catch(const AtariException &) {
+      // The image does not exist (anymore). Create an ATR then.
+    }
+    delete ImageStream;
+    ImageStream = NULL;
+    //
+    if (compressed) {
+#if HAVE_ZLIB_H && HAVE_GZOPEN
+      ImageStream = new class ZStream;
+#else
+      return 'E';
+#endif
+    } else {
+      ImageStream = new class FileStream;
+    }
     if (ImageStream->FormatImage(ImageToLoad) == false) {
       EjectDisk();
       return 'E';
@@ -492,6 +524,18 @@ void DiskDrive::LoadImage(const char *filename)
       ImageStream->OpenImage(filename);
       OpenDiskFromStream();
     } else {
+#if USE_MMAPSTREAM
+      // This is an uncompressed image. Try to map it into memory for
+      // faster access, and keep the stdio stream if this fails.
+      class ImageStream *mapped = new class MMapStream;
+      try {
+	mapped->OpenImage(filename);
+	delete ImageStream;
+	ImageStream = mapped;
+      } catch(const AtariException &) {
+	delete mapped;
+      }
+#endif
       // Now build the stream from it.
       OpenDiskFromStream();
     }
@@ -612,6 +656,13 @@ void DiskDrive::OpenDiskFromStream(void)
 	DiskStatus = Single;
       }
     }
+    //
+    // Install the sector cache on top of the disk if requested. This
+    // only works for images whose sectors do not change on reading.
+    if (CacheSize > 0 && (ImageType == ATR || ImageType == XFD || ImageType == DCM)) {
+      Cache = new class CachedImage(machine,Disk,CacheSize,SectorsPerTrack);
+      Disk  = Cache;
+    }
   } else {    
     if (errno == 0)
       Throw(InvalidParameter,"DiskDrive::OpenDiskFromStream","invalid disk image");
@@ -1048,6 +1099,25 @@ UBYTE DiskDrive::ReadBuffer(const UBYTE *commandframe,UBYTE *buffer,int &,UWORD
 }
 ///
 
+/// DiskDrive::AcceleratesTransfer
+// Check whether the data frame of the indicated read command may be
+// delivered in a burst, bypassing the serial timing. This is only done
+// for plain sector reads, and not for ATX images whose timing is part
+// of the copy protection.
+bool DiskDrive::AcceleratesTransfer(const UBYTE *commandframe)
+{
+  if (UltraSpeed && Disk && ImageType != ATX) {
+    switch(commandframe[1]) {
+    case 0x52: // Read
+    case 0x72:
+    case 0xd2: // doubler fast read
+      return true;
+    }
+  }
+  return false;
+}
+///
+
 /// DiskDrive::ReadStatus
 // Execute a status-only command that does not read or write any data except
 // the data that came over AUX1 and AUX2
@@ -1115,6 +1185,14 @@ void DiskDrive::EjectDisk(void)
     ProtectionStatus = UnLoaded;
     delete Disk;
     Disk             = NULL;
+    Cache            = NULL;
+    //
+    // The disk wrote back into the stream, now the stream
+    // has to write back into the file.
+    if (ImageStream && !ImageStream->Close()) {
+      machine->PutWarning("Failed to write the modified disk image back into %s.\n",
+			  (ImageName)?(ImageName):("the image file"));
+    }
     delete ImageStream;
     ImageStream      = NULL;
     delete[] ImageName;
@@ -1173,12 +1251,13 @@ void DiskDrive::ParseArgs(class ArgParser *args)
     };
   char enableoption[32],imageoption[32],protectoption[32],drivemenu[32];
   char typeoption[32];
-  char speedoption[32];
+  char speedoption[32],ultraoption[32],cacheoption[32];
   bool protect   = (ProtectionStatus == ReadOnly);
   bool onoff     = (ProtectionStatus != Off);
   LONG drivetype = DriveModel;
   LONG speed     = SpeedControl;
   LONG newspeed  = -1;
+  LONG cachesize = CacheSize;
   const char *warning = NULL;
 
   // generate the appropriate options now
@@ -1187,6 +1266,8 @@ void DiskDrive::ParseArgs(class ArgParser *args)
   sprintf(protectoption,"Protect.%d",DriveId+1);
   sprintf(drivemenu,"Drive.%d",DriveId+1);
   sprintf(typeoption,"DriveModel.%d",DriveId+1);
+  sprintf(ultraoption,"UltraSpeed.%d",DriveId+1);
+  sprintf(cacheoption,"SectorCache.%d",DriveId+1);
 
   if (DriveId == 0) {
     args->DefineTitle("DiskDrive");
@@ -1197,6 +1278,8 @@ void DiskDrive::ParseArgs(class ArgParser *args)
   args->DefineBool(enableoption,"power the drive on",onoff);
   args->DefineBool(protectoption,"write protect the image file",protect); 
   args->DefineSelection(typeoption,"disk drive type and features",drivetypevector,drivetype);
+  args->DefineBool(ultraoption,"deliver sector reads without serial timing",UltraSpeed);
+  args->DefineLong(cacheoption,"number of sectors to cache, 0 to disable",0,4096,CacheSize);
   if (drivetype != LONG(DriveModel)) {
     //
     // Reset the speed to the default speed
@@ -1258,7 +1341,8 @@ void DiskDrive::ParseArgs(class ArgParser *args)
   if (ProtectionStatus != Off) {
     if (ImageName == NULL || ImageToLoad      == NULL || strcmp(ImageToLoad,ImageName) ||
 	(protect  ==true  && ProtectionStatus == ReadWrite) ||
-	(protect  ==false && ProtectionStatus == ReadOnly)) {
+	(protect  ==false && ProtectionStatus == ReadOnly)  ||
+	(cachesize != CacheSize && Disk)) {
       InsertDisk(protect);
     }
   }
@@ -1405,8 +1489,12 @@ void DiskDrive::DisplayStatus(class Monitor *mon)
 		     "\tImage file format: %s\n"
 		     "\tSectors          : " LU "\n"
 		     "\tSector size      : %d\n"
-		     "\tSectors per track: " LU "\n",
-		     drivetype,ImageName,disktype,imagetype,SectorCount,SectorSize,SectorsPerTrack);
+		     "\tSectors per track: " LU "\n"
+		     "\tUltra speed      : %s\n",
+		     drivetype,ImageName,disktype,imagetype,SectorCount,SectorSize,SectorsPerTrack,
+		     (UltraSpeed)?("on"):("off"));
+    if (Cache)
+      Cache->DisplayStatistics(mon);
   }
   mon->PrintStatus("\n");
 }
@@ -77,6 +77,7 @@ class DiskDrive : public SerialDevice {
   //
   class ImageStream     *ImageStream; // where to take the data from.
   class DiskImage       *Disk;        // the inserted disk itself.
+  class CachedImage     *Cache;       // the sector cache of the disk, if any.
   char                  *ImageName;   // path of the disk image.
   char                  *ImageToLoad; // image we have to insert.
   UWORD                  SectorSize;
@@ -92,6 +93,14 @@ class DiskDrive : public SerialDevice {
   //
   // For Speedy only: Display control byte and Speed Control Byte
   UBYTE                  SpeedControl;
+  //
+  // If set, sector reads are delivered in a burst without
+  // emulating the serial timing.
+  bool                   UltraSpeed;
+  //
+  // Number of sectors kept in the sector cache, or zero
+  // if the cache is disabled.
+  LONG                   CacheSize;
   //  
   // The last command issued. The command type defines how the
   // FDC control byte is read.
@@ -199,6 +208,10 @@ public:
   virtual UBYTE ReadStatus(const UBYTE *CommandFrame,UWORD &delay,
 			   UWORD &speed);
   //
+  // Check whether the data frame of the indicated read command may be
+  // delivered in a burst, bypassing the serial timing.
+  virtual bool AcceleratesTransfer(const UBYTE *CommandFrame);
+  //
   // Other methods imported by the SerialDevice class:
   //
   // ColdStart and WarmStart
@@ -0,0 +1,204 @@
+/***********************************************************************************
+ **
+ ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
+ **
+ ** $Id: flashjournal.cpp,v 1.1 2020/05/14 18:40:12 thor Exp $
+ **
+ ** In this module: Journal of the modifications of a flash cartridge
+ **********************************************************************************/
+
+/// Includes
+#include "flashjournal.hpp"
+#include "exceptions.hpp"
+#include "string.hpp"
+#include "unistd.hpp"
+#include "new.hpp"
+#include <errno.h>
+///
+
+/// Statics
+const char FlashJournal::Magic[8] = {'A','+','+','F','J','N','0','1'};
+///
+
+/// FlashJournal::FlashJournal
+FlashJournal::FlashJournal(void)
+  : File(NULL), Writing(false)
+{ }
+///
+
+/// FlashJournal::~FlashJournal
+FlashJournal::~FlashJournal(void)
+{
+  Close();
+}
+///
+
+/// FlashJournal::JournalName
+// Build the name of the journal from the name of the image. The
+// result must be disposed with delete[].
+char *FlashJournal::JournalName(const char *image)
+{
+  char *name = new char[strlen(image) + 5];
+  //
+  strcpy(name,image);
+  strcat(name,".jnl");
+  return name;
+}
+///
+
+/// FlashJournal::OpenJournal
+// Open the journal of the given image in the given mode.
+FILE *FlashJournal::OpenJournal(const char *image,const char *mode)
+{
+  char *name = JournalName(image);
+  FILE *fp   = fopen(name,mode);
+  //
+  delete[] name;
+  return fp;
+}
+///
+
+/// FlashJournal::OpenForRead
+// Open the journal of the given image for reading. Returns false if
+// there is none, or the file is not a journal.
+bool FlashJournal::OpenForRead(const char *image)
+{
+  char id[sizeof(Magic)];
+  //
+  Close();
+  //
+  File = OpenJournal(image,"rb");
+  if (File == NULL)
+    return false;
+  Writing = false;
+  //
+  if (fread(id,1,sizeof(id),File) != sizeof(id) || memcmp(id,Magic,sizeof(Magic))) {
+    Close();
+    return false;
+  }
+  return true;
+}
+///
+
+/// FlashJournal::Read
+// Read the next record from the journal. Returns false at the end
+// of the journal, or if the last record is incomplete.
+bool FlashJournal::Read(struct Record &rec)
+{
+  UBYTE head[4],count[2];
+  //
+  if (File == NULL || Writing)
+    return false;
+  //
+  if (fread(head,1,sizeof(head),File) != sizeof(head))
+    return false;
+  rec.Unit = head[1];
+  rec.Page = UWORD(head[2] | (head[3] << 8));
+  switch(head[0]) {
+  case PageTag:
+    rec.Erase = false;
+    rec.Count = 1;
+    if (fread(rec.Data,1,sizeof(rec.Data),File) != sizeof(rec.Data))
+      return false;
+    return true;
+  case EraseTag:
+    rec.Erase = true;
+    if (fread(count,1,sizeof(count),File) != sizeof(count))
+      return false;
+    rec.Count = UWORD(count[0] | (count[1] << 8));
+    return true;
+  }
+  //
+  // Anything else is garbage, as from a crash while writing.
+  return false;
+}
+///
+
+/// FlashJournal::OpenForWrite
+// Start a new journal for the given image, replacing the one that
+// might exist. Throws on an error.
+void FlashJournal::OpenForWrite(const char *image)
+{
+  Close();
+  //
+  File = OpenJournal(image,"wb");
+  if (File == NULL)
+    ThrowIo("FlashJournal::OpenForWrite","failed to create the flash cartridge journal");
+  Writing = true;
+  //
+  fwrite(Magic,1,sizeof(Magic),File);
+  Flush();
+}
+///
+
+/// FlashJournal::WritePage
+// Append a programmed page to the journal.
+void FlashJournal::WritePage(UBYTE unit,UWORD page,const UBYTE *data)
+{
+  UBYTE head[4];
+  //
+  head[0] = PageTag;
+  head[1] = unit;
+  head[2] = UBYTE(page);
+  head[3] = UBYTE(page >> 8);
+  fwrite(head,1,sizeof(head),File);
+  fwrite(data,1,256,File);
+}
+///
+
+/// FlashJournal::WriteErase
+// Append a run of erased pages to the journal.
+void FlashJournal::WriteErase(UBYTE unit,UWORD page,UWORD count)
+{
+  UBYTE head[6];
+  //
+  head[0] = EraseTag;
+  head[1] = unit;
+  head[2] = UBYTE(page);
+  head[3] = UBYTE(page >> 8);
+  head[4] = UBYTE(count);
+  head[5] = UBYTE(count >> 8);
+  fwrite(head,1,sizeof(head),File);
+}
+///
+
+/// FlashJournal::Flush
+// Hand all records written so far over to the operating system.
+// Throws on an error.
+void FlashJournal::Flush(void)
+{
+  if (File && Writing) {
+    if (fflush(File) != 0 || ferror(File)) {
+      Close();
+      ThrowIo("FlashJournal::Flush","failed to write the flash cartridge journal");
+    }
+  }
+}
+///
+
+/// FlashJournal::Close
+// Close the journal. Errors are ignored here, the journal is
+// only valid up to the last flush.
+void FlashJournal::Close(void)
+{
+  if (File) {
+    fclose(File);
+    File    = NULL;
+    Writing = false;
+  }
+}
+///
+
+/// FlashJournal::Remove
+// Close and delete the journal of the given image. This is done
+// as soon as the image itself has been written.
+void FlashJournal::Remove(const char *image)
+{
+  char *name;
+  //
+  Close();
+  name = JournalName(image);
+  unlink(name);
+  delete[] name;
+}
+///
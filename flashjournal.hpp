@@ -0,0 +1,107 @@
+/***********************************************************************************
+ **
+ ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
+ **
+ ** $Id: flashjournal.hpp,v 1.1 2020/05/14 18:40:12 thor Exp $
+ **
+ ** In this module: Journal of the modifications of a flash cartridge
+ **********************************************************************************/
+
+#ifndef FLASHJOURNAL_HPP
+#define FLASHJOURNAL_HPP
+
+/// Includes
+#include "types.h"
+#include "types.hpp"
+#include "stdio.hpp"
+///
+
+/// Class FlashJournal
+// This class keeps an append-only journal of the pages of a flash
+// cartridge that have been programmed or erased. It lives next to the
+// cartridge image, with ".jnl" appended to its name. Replaying it on
+// top of the image restores the modifications in case the emulator
+// did not get the chance to write the complete image back.
+// The journal consists of a magic ID, followed by records of a tag
+// byte, the chip unit and the page number as little endian word.
+// Programmed pages then carry their 256 bytes, erased runs of pages
+// the number of pages as little endian word.
+class FlashJournal {
+public:
+  //
+  // A single record of the journal.
+  struct Record {
+    UBYTE Unit;      // the chip the record belongs to
+    UWORD Page;      // the first page within the chip
+    UWORD Count;     // the number of pages
+    bool  Erase;     // set if the pages are erased, otherwise Data is valid
+    UBYTE Data[256]; // the contents of a programmed page
+  };
+  //
+private:
+  //
+  // Tags of the records.
+  enum {
+    PageTag  = 'P',
+    EraseTag = 'E'
+  };
+  //
+  // The journal file, if it is open.
+  FILE         *File;
+  //
+  // Set if the file is open for writing.
+  bool          Writing;
+  //
+  // The magic ID at the start of the file.
+  static const char Magic[8];
+  //
+  // Build the name of the journal from the name of the image. The
+  // result must be disposed with delete[].
+  static char *JournalName(const char *image);
+  //
+  // Open the journal of the given image in the given mode.
+  FILE *OpenJournal(const char *image,const char *mode);
+  //
+public:
+  FlashJournal(void);
+  ~FlashJournal(void);
+  //
+  // Open the journal of the given image for reading. Returns false if
+  // there is none, or the file is not a journal.
+  bool OpenForRead(const char *image);
+  //
+  // Read the next record from the journal. Returns false at the end
+  // of the journal, or if the last record is incomplete.
+  bool Read(struct Record &rec);
+  //
+  // Start a new journal for the given image, replacing the one that
+  // might exist. Throws on an error.
+  void OpenForWrite(const char *image);
+  //
+  // Check whether the journal is open for writing.
+  bool isWriting(void) const
+  {
+    return File && Writing;
+  }
+  //
+  // Append a programmed page resp. a run of erased pages to the journal.
+  // Errors are reported by the next Flush.
+  void WritePage(UBYTE unit,UWORD page,const UBYTE *data);
+  void WriteErase(UBYTE unit,UWORD page,UWORD count);
+  //
+  // Hand all records written so far over to the operating system.
+  // Throws on an error.
+  void Flush(void);
+  //
+  // Close the journal. Errors are ignored here, the journal is
+  // only valid up to the last flush.
+  void Close(void);
+  //
+  // Close and delete the journal of the given image. This is done
+  // as soon as the image itself has been written.
+  void Remove(const char *image);
+};
+///
+
+///
+#endif
@@ -91,6 +91,18 @@ public:
     memset(romimage,255,256);
   }
   //
+  // Check whether the page is erased completely.
+  bool isBlank(void) const
+  {
+    int i;
+    //
+    for(i = 0;i < 256;i++) {
+      if (romimage[i] != 255)
+	return false;
+    }
+    return true;
+  }
+  //
   // Patch a byte into a FlashROM.
   virtual void PatchByte(ADR mem,UBYTE val)
   {
@@ -925,6 +925,46 @@ UBYTE HDevice::Put(UBYTE channel,UBYTE value)
 }
 ///
 
+/// HDevice::GetBlock
+// Read a block of data from a plain file. Directories are read
+// byte by byte through Get. A short read leaves the EOF or error
+// condition to the following Get.
+UBYTE HDevice::GetBlock(UBYTE channel,UBYTE *buffer,UWORD &size)
+{
+  struct HandlerChannel *ch;
+  //
+  ch = Buffer[channel];
+  if (ch == NULL || (ch->openmode & 0x04) == 0 || (ch->openmode & 0x02) || ch->stream == NULL) {
+    size = 0;
+    return 0x01;
+  }
+  size = UWORD(fread(buffer,1,size,ch->stream));
+  //
+  return 0x01;
+}
+///
+
+/// HDevice::PutBlock
+// Write a block of data into a file, buffered.
+UBYTE HDevice::PutBlock(UBYTE channel,const UBYTE *buffer,UWORD &size)
+{
+  struct HandlerChannel *ch;
+  size_t written;
+  //
+  ch = Buffer[channel];
+  if (ch == NULL || (ch->openmode & 0x08) == 0 || ch->stream == NULL) {
+    size = 0;
+    return 0x01;
+  }
+  written = fwrite(buffer,1,size,ch->stream);
+  if (written < size) {
+    size = UWORD(written);
+    return (ch->lasterror = ch->AtariError(errno));
+  }
+  return (ch->lasterror = 0x01);
+}
+///
+
 /// HDevice::Status
 // Get the status of the HDevice
 // Write a byte into a file, buffered.
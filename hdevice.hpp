@@ -178,6 +178,9 @@ class HDevice : public Device {
   virtual UBYTE Status(UBYTE channel);
   virtual UBYTE Special(UBYTE channel,UBYTE unit,class AdrSpace *adr,UBYTE cmd,
 			ADR mem,UWORD len,UBYTE aux[6]);
+  // Block transfers for CIO get and put characters on plain files.
+  virtual UBYTE GetBlock(UBYTE channel,UBYTE *buffer,UWORD &size);
+  virtual UBYTE PutBlock(UBYTE channel,const UBYTE *buffer,UWORD &size);
   //
   virtual void Reset(void);
   //
@@ -0,0 +1,84 @@
+/***********************************************************************************
+ **
+ ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
+ **
+ ** $Id: hlepatch.cpp,v 1.1 2020/05/03 11:20:40 thor Exp $
+ **
+ ** In this module: High-level emulation of hot Os routines
+ **********************************************************************************/
+
+/// Includes
+#include "hlepatch.hpp"
+#include "romxlchecksum.hpp"
+#include "osrom.hpp"
+#include "adrspace.hpp"
+#include "machine.hpp"
+#include "cpu.hpp"
+///
+
+/// HLEPatch::HLEPatch
+HLEPatch::HLEPatch(class Machine *mach,class PatchProvider *p,UBYTE traps)
+  : Patch(mach,p,HLERoutines::Num_Routines), Traps(traps), Rom(NULL)
+{
+  UWORD lowsum,highsum;
+  //
+  // The registry is keyed by the XL checksums that are only
+  // meaningful for the XL type ROMs.
+  switch(mach->OsROM()->RomType()) {
+  case OsROM::Os_RomXL:
+  case OsROM::Os_Rom1200:
+  case OsROM::Os_Builtin:
+    RomXLChecksum::ComputeChecksums(mach,lowsum,highsum);
+    Rom = HLERoutines::FindRom(lowsum,highsum);
+    break;
+  default:
+    break;
+  }
+}
+///
+
+/// HLEPatch::InstallPatch
+// This entry is called whenever a new ROM is loaded. It is required
+// to install the patch into the image.
+void HLEPatch::InstallPatch(class AdrSpace *adr,UBYTE code)
+{
+  if (Rom == NULL)
+    return;
+  //
+  if ((Traps & MemoryClearTrap) && Rom->MemoryClear)
+    InsertESC(adr,Rom->MemoryClear,code + HLERoutines::MemoryClear);
+  if ((Traps & ScreenClearTrap) && Rom->ScreenClear)
+    InsertESC(adr,Rom->ScreenClear,code + HLERoutines::ScreenClear);
+  if (Traps & ScrollTrap) {
+    if (Rom->DeleteLine)
+      InsertESC(adr,Rom->DeleteLine,code + HLERoutines::DeleteLine);
+    if (Rom->InsertLine)
+      InsertESC(adr,Rom->InsertLine,code + HLERoutines::InsertLine);
+  }
+}
+///
+
+/// HLEPatch::RunPatch
+// This entry is called by the CPU emulator to run the patch at hand
+// whenever an ESC (HLT, JAM) code is detected. The ESC codes are
+// allocated in the order of the routines.
+void HLEPatch::RunPatch(class AdrSpace *adr,class CPU *cpu,UBYTE code)
+{
+  struct HLERoutines::Registers regs;
+  //
+  if (Rom == NULL || code >= HLERoutines::Num_Routines)
+    return;
+  //
+  regs.A = cpu->A();
+  regs.X = cpu->X();
+  regs.Y = cpu->Y();
+  regs.S = cpu->S();
+  regs.P = cpu->P();
+  HLERoutines::Run(Rom,HLERoutines::Routine(code),adr,regs);
+  cpu->A() = regs.A;
+  cpu->X() = regs.X;
+  cpu->Y() = regs.Y;
+  cpu->S() = regs.S;
+  cpu->P() = regs.P;
+}
+///
@@ -0,0 +1,80 @@
+/***********************************************************************************
+ **
+ ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
+ **
+ ** $Id: hlepatch.hpp,v 1.1 2020/05/03 11:20:40 thor Exp $
+ **
+ ** In this module: High-level emulation of hot Os routines
+ **********************************************************************************/
+
+#ifndef HLEPATCH_HPP
+#define HLEPATCH_HPP
+
+/// Includes
+#include "types.hpp"
+#include "patch.hpp"
+#include "hleroutines.hpp"
+///
+
+/// Forwards
+class CPU;
+class AdrSpace;
+class Machine;
+class PatchProvider;
+///
+
+/// Class HLEPatch
+// This patch replaces some time consuming loops of the Os by native
+// code: The memory test and clear on coldstart, clearing the screen
+// and scrolling the screen up or down by a line. Unlike the device
+// handler patches, these traps go into the middle of the Os code and
+// hence depend on the exact ROM. The native routines and the registry
+// of the ROMs they apply to are in HLERoutines, a ROM not found there
+// remains untouched.
+class HLEPatch : public Patch {
+public:
+  //
+  // The traps that can be enabled individually.
+  enum TrapMask {
+    MemoryClearTrap = 1, // Memory test and clear on coldstart
+    ScreenClearTrap = 2, // Clear the screen memory
+    ScrollTrap      = 4  // Insert or delete a line on a text screen
+  };
+  //
+private:
+  //
+  // The traps to install.
+  UBYTE                                      Traps;
+  //
+  // The entry points of the installed ROM, or NULL if the ROM is
+  // unknown.
+  const struct HLERoutines::RomEntryPoints  *Rom;
+  //
+  // Implementations of the Patch interface:
+  // This entry is called whenever a new ROM is loaded. It is required
+  // to install the patch into the image.
+  virtual void InstallPatch(class AdrSpace *adr,UBYTE code);
+  //
+  // This entry is called by the CPU emulator to run the patch at hand
+  // whenever an ESC (HLT, JAM) code is detected.
+  virtual void RunPatch(class AdrSpace *adr,class CPU *cpu,UBYTE code);
+  //
+public:
+  // The ROM must have been loaded already as the registry is
+  // searched here, before any other patch modifies the image.
+  HLEPatch(class Machine *mach,class PatchProvider *p,UBYTE traps);
+  virtual ~HLEPatch(void)
+  {
+  }
+  //
+  // Return the name of the ROM the entry points were found for,
+  // or NULL if the ROM is not known.
+  const char *RomName(void) const
+  {
+    return (Rom)?(Rom->Name):(NULL);
+  }
+};
+///
+
+///
+#endif
@@ -0,0 +1,304 @@
+/***********************************************************************************
+ **
+ ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
+ **
+ ** $Id: hleroutines.cpp,v 1.1 2020/05/16 10:12:31 thor Exp $
+ **
+ ** In this module: Native implementations of hot Os routines
+ **********************************************************************************/
+
+/// Includes
+#include "hleroutines.hpp"
+#include "adrspace.hpp"
+///
+
+/// Statics
+// The registry of the known ROMs, terminated by a zero entry.
+const struct HLERoutines::RomEntryPoints HLERoutines::Registry[] = {
+  {0xbd3d,0x1ab6,"built-in",
+   0xe51f,0xe53c,0xe56a,
+   0xf9f2,
+   0xf687,
+   0xf610,0xf631},
+  {0,0,NULL,0,0,0,0,0,0,0}
+};
+///
+
+/// HLERoutines::FindRom
+// Find the entry points of the ROM with the given checksums.
+// Returns NULL if the ROM is not known.
+const struct HLERoutines::RomEntryPoints *HLERoutines::FindRom(UWORD lowsum,UWORD highsum)
+{
+  const struct RomEntryPoints *entry;
+  //
+  for(entry = Registry;entry->Name;entry++) {
+    if (entry->LowSum == lowsum && entry->HighSum == highsum)
+      return entry;
+  }
+  return NULL;
+}
+///
+
+/// HLERoutines::EntryOf
+// Return the entry point of the given routine in the given ROM,
+// or zero if the ROM does not provide it.
+ADR HLERoutines::EntryOf(const struct RomEntryPoints *rom,Routine routine)
+{
+  switch(routine) {
+  case MemoryClear:
+    return rom->MemoryClear;
+  case ScreenClear:
+    return rom->ScreenClear;
+  case DeleteLine:
+    return rom->DeleteLine;
+  case InsertLine:
+    return rom->InsertLine;
+  default:
+    return 0;
+  }
+}
+///
+
+/// HLERoutines::JumpTo
+// Continue the 6502 code at the given address. This pushes the
+// continuation onto the stack where the RTS of the ESC code picks
+// it up.
+void HLERoutines::JumpTo(class AdrSpace *adr,struct Registers &regs,ADR dest)
+{
+  ADR where = dest - 1;
+  //
+  adr->WriteByte(0x100 + regs.S,UBYTE(where >> 8));
+  regs.S--;
+  adr->WriteByte(0x100 + regs.S,UBYTE(where & 0xff));
+  regs.S--;
+}
+///
+
+/// HLERoutines::SetZN
+// Set the Z and N flags from the given result.
+void HLERoutines::SetZN(struct Registers &regs,UBYTE result)
+{
+  regs.P &= ~(Z_Mask | N_Mask);
+  if (result == 0)
+    regs.P |= Z_Mask;
+  if (result & 0x80)
+    regs.P |= N_Mask;
+}
+///
+
+/// HLERoutines::SetCompare
+// Set the Z, N and C flags from a comparison.
+void HLERoutines::SetCompare(struct Registers &regs,UBYTE reg,UBYTE mem)
+{
+  SetZN(regs,UBYTE(reg - mem));
+  if (reg >= mem) {
+    regs.P |= C_Mask;
+  } else {
+    regs.P &= ~C_Mask;
+  }
+}
+///
+
+/// HLERoutines::RunMemoryClear
+// The memory test on coldstart: Write 0xff and then 0x00 into each
+// byte from 0x0008 up to the page in 0x06 and read it back. The
+// pointer is in 0x04 and 0x05 and has been cleared already.
+void HLERoutines::RunMemoryClear(const struct RomEntryPoints *rom,class AdrSpace *adr,struct Registers &regs)
+{
+  UBYTE y = 0x08;
+  UBYTE a = 0x00;
+  bool failed = false;
+  ADR mem;
+  //
+  do {
+    do {
+      mem = ADR(adr->ReadWord(0x04) + y) & 0xffff;
+      adr->WriteByte(mem,0xff);
+      if (adr->ReadByte(mem) != 0xff) {
+	a      = 0xff;
+	failed = true;
+	break;
+      }
+      adr->WriteByte(mem,0x00);
+      if (adr->ReadByte(mem) != 0x00) {
+	a      = 0x00;
+	failed = true;
+	break;
+      }
+    } while(++y);
+    if (failed) {
+      // The Os reports the error with the registers as
+      // left by the failing comparison.
+      regs.A = a;
+      regs.Y = y;
+      SetCompare(regs,a,adr->ReadByte(mem));
+      JumpTo(adr,regs,rom->MemoryClearFailed);
+      return;
+    }
+    a = UBYTE(adr->ReadByte(0x05) + 1);
+    adr->WriteByte(0x05,a);
+    a = adr->ReadByte(0x05);
+  } while(a < adr->ReadByte(0x06));
+  //
+  regs.A = a;
+  regs.Y = 0;
+  SetCompare(regs,a,adr->ReadByte(0x06));
+  JumpTo(adr,regs,rom->MemoryClearDone);
+}
+///
+
+/// HLERoutines::RunScreenClear
+// Clear the memory from SAVMSC up to RAMTOP, then home the cursor.
+void HLERoutines::RunScreenClear(class AdrSpace *adr,struct Registers &regs)
+{
+  UBYTE y = adr->ReadByte(SAVMSC);
+  UBYTE x = adr->ReadByte(SAVMSC + 1);
+  //
+  adr->WriteByte(ADRESS + 1,x);
+  adr->WriteByte(ADRESS,0x00);
+  do {
+    do {
+      adr->WriteByte(ADR(adr->ReadWord(ADRESS) + y) & 0xffff,0x00);
+    } while(++y);
+    x++;
+    adr->WriteByte(ADRESS + 1,x);
+  } while(x < adr->ReadByte(RAMTOP));
+  //
+  adr->WriteByte(ROWCRS,0x00);
+  adr->WriteByte(COLCRS,0x00);
+  adr->WriteByte(COLCRS + 1,0x00);
+  regs.A = 0x00;
+  regs.X = x;
+  regs.Y = y;
+  // The carry is that of the final comparison with RAMTOP.
+  regs.P |= C_Mask;
+  SetZN(regs,0x00);
+}
+///
+
+/// HLERoutines::RunDeleteLine
+// Move all lines below the line in X up by one, then clear the
+// bottom line. The line in X starts at ADRESS.
+void HLERoutines::RunDeleteLine(class AdrSpace *adr,struct Registers &regs)
+{
+  UBYTE x = regs.X;
+  UBYTE y;
+  ADR from,to;
+  //
+  for(;;) {
+    x++;
+    if (x >= adr->ReadByte(BOTSCR)) {
+      regs.P |= C_Mask;
+      break;
+    }
+    to   = adr->ReadWord(ADRESS);
+    from = to + 40;
+    adr->WriteByte(TOADR    ,UBYTE(from));
+    adr->WriteByte(TOADR + 1,UBYTE(from >> 8));
+    // The overflow flag is that of adding the carry to the high byte.
+    if ((to & 0xff00) == 0x7f00 && (from & 0xff00) == 0x8000) {
+      regs.P |= V_Mask;
+    } else {
+      regs.P &= ~V_Mask;
+    }
+    from &= 0xffff;
+    y = 40;
+    do {
+      y--;
+      adr->WriteByte(ADR(to + y) & 0xffff,adr->ReadByte(ADR(from + y) & 0xffff));
+    } while(y);
+    adr->WriteByte(ADRESS    ,UBYTE(from));
+    adr->WriteByte(ADRESS + 1,UBYTE(from >> 8));
+    if ((from >> 8) == 0) {
+      // The loop is closed by a BNE on the high byte, and falls into
+      // the clearing code with the carry of the addition.
+      if ((to >> 8) == 0xff) {
+	regs.P |= C_Mask;
+      } else {
+	regs.P &= ~C_Mask;
+      }
+      break;
+    }
+  }
+  //
+  // Clear the line at ADRESS.
+  to = adr->ReadWord(ADRESS);
+  y  = 40;
+  do {
+    y--;
+    adr->WriteByte(ADR(to + y) & 0xffff,0x00);
+  } while(y);
+  //
+  regs.A = 0x00;
+  regs.X = x;
+  regs.Y = 0xff;
+  SetZN(regs,0xff);
+}
+///
+
+/// HLERoutines::RunInsertLine
+// Move all lines from the line in X on down by one. ADRESS points to
+// the start of the bottom line.
+void HLERoutines::RunInsertLine(const struct RomEntryPoints *rom,class AdrSpace *adr,struct Registers &regs)
+{
+  UBYTE x = regs.X;
+  UBYTE y;
+  ADR from,to;
+  //
+  for(;;) {
+    x++;
+    if (x >= adr->ReadByte(BOTSCR))
+      break;
+    to   = adr->ReadWord(ADRESS);
+    from = to - 40;
+    adr->WriteByte(TOADR    ,UBYTE(to));
+    adr->WriteByte(TOADR + 1,UBYTE(to >> 8));
+    // The overflow flag is that of subtracting the borrow from the
+    // high byte.
+    if ((to & 0xff00) == 0x8000 && (from & 0xff00) == 0x7f00) {
+      regs.P |= V_Mask;
+    } else {
+      regs.P &= ~V_Mask;
+    }
+    from &= 0xffff;
+    adr->WriteByte(ADRESS    ,UBYTE(from));
+    adr->WriteByte(ADRESS + 1,UBYTE(from >> 8));
+    y = 40;
+    do {
+      y--;
+      regs.A = adr->ReadByte(ADR(from + y) & 0xffff);
+      adr->WriteByte(ADR(to + y) & 0xffff,regs.A);
+    } while(y);
+    regs.Y = 0xff;
+  }
+  //
+  regs.X = x;
+  SetCompare(regs,x,adr->ReadByte(BOTSCR));
+  JumpTo(adr,regs,rom->InsertLineDone);
+}
+///
+
+/// HLERoutines::Run
+// Run the given routine on the given ROM. This is entered in place
+// of the ROM code at its entry point, and is left by an RTS.
+void HLERoutines::Run(const struct RomEntryPoints *rom,Routine routine,
+		      class AdrSpace *adr,struct Registers &regs)
+{
+  switch(routine) {
+  case MemoryClear:
+    RunMemoryClear(rom,adr,regs);
+    break;
+  case ScreenClear:
+    RunScreenClear(adr,regs);
+    break;
+  case DeleteLine:
+    RunDeleteLine(adr,regs);
+    break;
+  case InsertLine:
+    RunInsertLine(rom,adr,regs);
+    break;
+  default:
+    break;
+  }
+}
+///
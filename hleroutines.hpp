@@ -0,0 +1,133 @@
+/***********************************************************************************
+ **
+ ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
+ **
+ ** $Id: hleroutines.hpp,v 1.1 2020/05/16 10:12:31 thor Exp $
+ **
+ ** In this module: Native implementations of hot Os routines
+ **********************************************************************************/
+
+#ifndef HLEROUTINES_HPP
+#define HLEROUTINES_HPP
+
+/// Includes
+#include "types.h"
+#include "types.hpp"
+///
+
+/// Forwards
+class AdrSpace;
+///
+
+/// Class HLERoutines
+// This class implements some time consuming loops of the Os natively:
+// The memory test and clear on coldstart, clearing the screen and
+// scrolling the screen up or down by a line. These routines go into
+// the middle of the Os code and hence depend on the exact ROM. Their
+// entry points are therefore kept in a registry that is keyed by the
+// XL checksums of the unpatched ROM.
+//
+// The routines leave the machine in exactly the state the ROM code
+// leaves it in, including the registers and flags, except for the
+// time they take. They operate on a copy of the CPU registers and do
+// not depend on the CPU emulation such that hletest can run them
+// against the ROM code for comparison.
+class HLERoutines {
+public:
+  //
+  // The routines implemented here.
+  enum Routine {
+    MemoryClear,
+    ScreenClear,
+    DeleteLine,
+    InsertLine,
+    Num_Routines
+  };
+  //
+  // The 6502 registers the routines operate on.
+  struct Registers {
+    UBYTE A,X,Y,S,P;
+  };
+  //
+  // Flags in the P register.
+  enum {
+    C_Mask = 0x01,
+    Z_Mask = 0x02,
+    V_Mask = 0x40,
+    N_Mask = 0x80
+  };
+  //
+  // The entry points for a specific ROM. An address of zero means
+  // that the ROM does not provide this routine.
+  struct RomEntryPoints {
+    // The two checksums of the ROM, as computed by the selftest. They
+    // are kept at 0xc000 and 0xfff8 of a genuine XL ROM.
+    UWORD        LowSum,HighSum;
+    // The name of the ROM, for the records.
+    const char  *Name;
+    // The memory test loop, the continuation behind it, and where the
+    // Os reports a memory error.
+    ADR          MemoryClear,MemoryClearDone,MemoryClearFailed;
+    // The subroutine that clears the screen memory from SAVMSC to
+    // RAMTOP.
+    ADR          ScreenClear;
+    // The subroutine that moves the screen up by a line from the
+    // cursor row on, and clears the bottom line.
+    ADR          DeleteLine;
+    // The loop that moves the screen down by a line, and the
+    // continuation behind it.
+    ADR          InsertLine,InsertLineDone;
+  };
+  //
+  // Os equates of the registers used by the routines.
+  enum {
+    SAVMSC = 0x58, // start of the screen memory
+    ROWCRS = 0x54, // cursor row
+    COLCRS = 0x55, // cursor column, two bytes
+    ADRESS = 0x64, // temporary pointer of the editor
+    TOADR  = 0x68, // second pointer of the editor
+    RAMTOP = 0x6a, // top of the available memory, in pages
+    BOTSCR = 0x2bf // number of text lines
+  };
+  //
+private:
+  //
+  // All ROMs we know the entry points of.
+  static const struct RomEntryPoints Registry[];
+  //
+  // Continue the 6502 code at the given address. This pushes the
+  // continuation onto the stack where the RTS of the ESC code picks
+  // it up.
+  static void JumpTo(class AdrSpace *adr,struct Registers &regs,ADR dest);
+  //
+  // Set the Z and N flags from the given result.
+  static void SetZN(struct Registers &regs,UBYTE result);
+  //
+  // Set the Z, N and C flags from a comparison.
+  static void SetCompare(struct Registers &regs,UBYTE reg,UBYTE mem);
+  //
+  // Implementations of the routines.
+  static void RunMemoryClear(const struct RomEntryPoints *rom,class AdrSpace *adr,struct Registers &regs);
+  static void RunScreenClear(class AdrSpace *adr,struct Registers &regs);
+  static void RunDeleteLine(class AdrSpace *adr,struct Registers &regs);
+  static void RunInsertLine(const struct RomEntryPoints *rom,class AdrSpace *adr,struct Registers &regs);
+  //
+public:
+  //
+  // Find the entry points of the ROM with the given checksums.
+  // Returns NULL if the ROM is not known.
+  static const struct RomEntryPoints *FindRom(UWORD lowsum,UWORD highsum);
+  //
+  // Return the entry point of the given routine in the given ROM,
+  // or zero if the ROM does not provide it.
+  static ADR EntryOf(const struct RomEntryPoints *rom,Routine routine);
+  //
+  // Run the given routine on the given ROM. This is entered in place
+  // of the ROM code at its entry point, and is left by an RTS.
+  static void Run(const struct RomEntryPoints *rom,Routine routine,
+		  class AdrSpace *adr,struct Registers &regs);
+};
+///
+
+///
+#endif
@@ -0,0 +1,874 @@
+/***********************************************************************************
+ **
+ ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
+ **
+ ** $Id: hletest.cpp,v 1.1 2020/05/16 10:12:31 thor Exp $
+ **
+ ** In this module: Differential test of the native Os routines against the ROM
+ **********************************************************************************/
+
+/// Includes
+#include "types.h"
+#include "types.hpp"
+#include "hleroutines.hpp"
+#include "bcdmathpack.hpp"
+#include "adrspace.hpp"
+#include "rampage.hpp"
+#include "osdist.hpp"
+#include "exceptions.hpp"
+#include "stdio.hpp"
+#include "string.hpp"
+///
+
+/// Description
+// This program runs the native routines of HLERoutines and the ROM code
+// they replace on the same machine state, and compares the memory, the
+// registers and the address the code continues at. The ROM code is run
+// by a minimal 6502 interpreter that only knows the documented opcodes,
+// which is all the routines require. The machine state is random
+// memory below the ROM, set up such that the preconditions of the
+// routines hold.
+//
+// For the built-in ROM, it also runs random operands through the math
+// pack of the ROM and its BCD implementation the MathPackPatch uses,
+// and compares the memory and the carry flag.
+//
+// It is built by "make hletest" and takes the ROM to test as optional
+// argument, a 16K XL ROM image, or uses the built-in ROM otherwise.
+// It returns zero if all tests pass.
+///
+
+/// Class RomRunner
+// A minimal 6502 that runs the ROM code on a flat memory image.
+class RomRunner {
+public:
+  UBYTE  Mem[0x10000];
+  UBYTE  A,X,Y,S,P;
+  UWORD  PC;
+  //
+  enum {
+    C_Mask = 0x01,
+    Z_Mask = 0x02,
+    I_Mask = 0x04,
+    D_Mask = 0x08,
+    B_Mask = 0x10,
+    V_Mask = 0x40,
+    N_Mask = 0x80
+  };
+  //
+private:
+  UBYTE Fetch(void)
+  {
+    return Mem[PC++];
+  }
+  //
+  UWORD FetchWord(void)
+  {
+    UWORD lo = Fetch();
+    return UWORD(lo | (Fetch() << 8));
+  }
+  //
+  UWORD ReadWord(UWORD adr) const
+  {
+    return UWORD(Mem[adr] | (Mem[UWORD(adr + 1)] << 8));
+  }
+  //
+  // Read a pointer from page zero, wrapping within the page.
+  UWORD ReadZPWord(UBYTE adr) const
+  {
+    return UWORD(Mem[adr] | (Mem[UBYTE(adr + 1)] << 8));
+  }
+  //
+  void Push(UBYTE b)
+  {
+    Mem[0x100 + S] = b;
+    S--;
+  }
+  //
+  UBYTE Pull(void)
+  {
+    S++;
+    return Mem[0x100 + S];
+  }
+  //
+  UBYTE SetZN(UBYTE v)
+  {
+    P &= ~(Z_Mask | N_Mask);
+    if (v == 0)
+      P |= Z_Mask;
+    P |= v & N_Mask;
+    return v;
+  }
+  //
+  void Compare(UBYTE reg,UBYTE v)
+  {
+    SetZN(UBYTE(reg - v));
+    if (reg >= v) {
+      P |= C_Mask;
+    } else {
+      P &= ~C_Mask;
+    }
+  }
+  //
+  // Add with carry. Decimal mode follows the NMOS 6502 of the CPU
+  // emulation: The Z flag is that of the binary sum, the other flags
+  // are those of the decimal adjusted sum.
+  void AddWithCarry(UBYTE v)
+  {
+    UBYTE c   = P & C_Mask;
+    UWORD sum = UWORD(A + v + c);
+    UWORD ah  = sum;
+    UWORD al;
+    //
+    P &= ~(C_Mask | V_Mask | Z_Mask | N_Mask);
+    if ((sum & 0xff) == 0)
+      P |= Z_Mask;
+    if (P & D_Mask) {
+      al = UWORD((A & 0x0f) + (v & 0x0f) + c);
+      ah = UWORD((A & 0xf0) + (v & 0xf0));
+      if (al > 9) {
+	al += 6;
+	ah += 0x10;
+      }
+      if (ah > 0x90)
+	ah += 0x60;
+      sum = UWORD(ah | (al & 0x0f));
+    }
+    if (~(A ^ v) & (A ^ ah) & 0x80)
+      P |= V_Mask;
+    if (ah & 0x80)
+      P |= N_Mask;
+    if (ah >= 0x100)
+      P |= C_Mask;
+    A = UBYTE(sum);
+  }
+  //
+  // Subtract with borrow. In decimal mode, all flags are those of the
+  // binary difference as on the NMOS 6502.
+  void SubtractWithCarry(UBYTE v)
+  {
+    UBYTE c    = P & C_Mask;
+    UWORD diff = UWORD(A - v - 1 + c);
+    UWORD al,ah;
+    //
+    P &= ~(C_Mask | V_Mask | Z_Mask | N_Mask);
+    if ((diff & 0xff) == 0)
+      P |= Z_Mask;
+    if ((A ^ v) & (A ^ diff) & 0x80)
+      P |= V_Mask;
+    if (diff & 0x80)
+      P |= N_Mask;
+    if (diff < 0x100)
+      P |= C_Mask;
+    if (P & D_Mask) {
+      al = UWORD((A & 0x0f) - (v & 0x0f) - 1 + c);
+      ah = UWORD((A & 0xf0) - (v & 0xf0));
+      if (al & 0x10) {
+	al -= 6;
+	ah -= 0x10;
+      }
+      if (ah & 0x100)
+	ah -= 0x60;
+      diff = UWORD(ah | (al & 0x0f));
+    }
+    A = UBYTE(diff);
+  }
+  //
+  void Branch(bool cond)
+  {
+    UBYTE off = Fetch();
+    if (cond)
+      PC = UWORD(PC + ((off & 0x80)?(int(off) - 0x100):(int(off))));
+  }
+  //
+  // Compute the effective address of the operand for the given
+  // addressing mode: 0 = (zp,X), 1 = zp, 3 = abs, 4 = (zp),Y,
+  // 5 = zp,X, 6 = abs,Y, 7 = abs,X, following the bbb bits of
+  // the opcode. If "yindex" is set, the X-indexed modes use Y.
+  UWORD Address(int mode,bool yindex = false)
+  {
+    UBYTE idx = (yindex)?(Y):(X);
+    switch(mode) {
+    case 0:
+      return ReadZPWord(UBYTE(Fetch() + X));
+    case 1:
+      return Fetch();
+    case 3:
+      return FetchWord();
+    case 4:
+      return UWORD(ReadZPWord(Fetch()) + Y);
+    case 5:
+      return UBYTE(Fetch() + idx);
+    case 6:
+      return UWORD(FetchWord() + Y);
+    case 7:
+      return UWORD(FetchWord() + idx);
+    }
+    return 0;
+  }
+  //
+  // Run a read-modify-write operation on the value.
+  UBYTE Modify(int op,UBYTE v)
+  {
+    UBYTE c;
+    //
+    switch(op) {
+    case 0: // ASL
+      P = UBYTE((P & ~C_Mask) | (v >> 7));
+      return SetZN(UBYTE(v << 1));
+    case 1: // ROL
+      c = P & C_Mask;
+      P = UBYTE((P & ~C_Mask) | (v >> 7));
+      return SetZN(UBYTE((v << 1) | c));
+    case 2: // LSR
+      P = UBYTE((P & ~C_Mask) | (v & 1));
+      return SetZN(UBYTE(v >> 1));
+    case 3: // ROR
+      c = P & C_Mask;
+      P = UBYTE((P & ~C_Mask) | (v & 1));
+      return SetZN(UBYTE((v >> 1) | (c << 7)));
+    case 6: // DEC
+      return SetZN(UBYTE(v - 1));
+    case 7: // INC
+      return SetZN(UBYTE(v + 1));
+    }
+    return v;
+  }
+  //
+public:
+  // Run a single instruction. Returns false on an opcode the
+  // interpreter does not know.
+  bool Step(void)
+  {
+    UBYTE op = Fetch();
+    int aaa  = op >> 5;
+    int bbb  = (op >> 2) & 7;
+    UWORD adr;
+    UBYTE v;
+    //
+    // Instructions that do not fit the regular encoding.
+    switch(op) {
+    case 0x00: // BRK
+      PC++;
+      Push(UBYTE(PC >> 8));
+      Push(UBYTE(PC));
+      Push(P | B_Mask | 0x20);
+      P |= I_Mask;
+      PC = ReadWord(0xfffe);
+      return true;
+    case 0x20: // JSR
+      adr = FetchWord();
+      PC--;
+      Push(UBYTE(PC >> 8));
+      Push(UBYTE(PC));
+      PC  = adr;
+      return true;
+    case 0x40: // RTI
+      P   = Pull();
+      PC  = Pull();
+      PC |= UWORD(Pull() << 8);
+      return true;
+    case 0x60: // RTS
+      PC  = Pull();
+      PC |= UWORD(Pull() << 8);
+      PC++;
+      return true;
+    case 0x4c: // JMP abs
+      PC = FetchWord();
+      return true;
+    case 0x6c: // JMP (abs), with the page wrap of the NMOS 6502
+      adr = FetchWord();
+      PC  = UWORD(Mem[adr] | (Mem[(adr & 0xff00) | ((adr + 1) & 0xff)] << 8));
+      return true;
+    case 0x08: Push(P | B_Mask | 0x20);          return true; // PHP
+    case 0x28: P = Pull();                       return true; // PLP
+    case 0x48: Push(A);                          return true; // PHA
+    case 0x68: A = SetZN(Pull());                return true; // PLA
+    case 0x88: Y = SetZN(UBYTE(Y - 1));          return true; // DEY
+    case 0xa8: Y = SetZN(A);                     return true; // TAY
+    case 0xc8: Y = SetZN(UBYTE(Y + 1));          return true; // INY
+    case 0xe8: X = SetZN(UBYTE(X + 1));          return true; // INX
+    case 0x18: P &= ~C_Mask;                     return true; // CLC
+    case 0x38: P |= C_Mask;                      return true; // SEC
+    case 0x58: P &= ~I_Mask;                     return true; // CLI
+    case 0x78: P |= I_Mask;                      return true; // SEI
+    case 0x98: A = SetZN(Y);                     return true; // TYA
+    case 0xb8: P &= ~V_Mask;                     return true; // CLV
+    case 0xd8: P &= ~D_Mask;                     return true; // CLD
+    case 0xf8: P |= D_Mask;                      return true; // SED
+    case 0x8a: A = SetZN(X);                     return true; // TXA
+    case 0x9a: S = X;                            return true; // TXS
+    case 0xaa: X = SetZN(A);                     return true; // TAX
+    case 0xba: X = SetZN(S);                     return true; // TSX
+    case 0xca: X = SetZN(UBYTE(X - 1));          return true; // DEX
+    case 0xea:                                   return true; // NOP
+    case 0x0a: A = Modify(0,A);                  return true; // ASL A
+    case 0x2a: A = Modify(1,A);                  return true; // ROL A
+    case 0x4a: A = Modify(2,A);                  return true; // LSR A
+    case 0x6a: A = Modify(3,A);                  return true; // ROR A
+    }
+    //
+    // Branches.
+    if ((op & 0x1f) == 0x10) {
+      static const UBYTE flags[4] = {N_Mask,V_Mask,C_Mask,Z_Mask};
+      Branch(((P & flags[aaa >> 1])?(1):(0)) == (aaa & 1));
+      return true;
+    }
+    //
+    switch(op & 3) {
+    case 1: // ORA AND EOR ADC STA LDA CMP SBC
+      if (bbb == 2) {
+	adr = PC++;
+      } else {
+	adr = Address(bbb);
+      }
+      if (aaa == 4) {
+	if (bbb == 2)
+	  return false;
+	Mem[adr] = A;
+	return true;
+      }
+      v = Mem[adr];
+      switch(aaa) {
+      case 0: A = SetZN(A | v);       break;
+      case 1: A = SetZN(A & v);       break;
+      case 2: A = SetZN(A ^ v);       break;
+      case 3: AddWithCarry(v);        break;
+      case 5: A = SetZN(v);           break;
+      case 6: Compare(A,v);           break;
+      case 7: SubtractWithCarry(v);   break;
+      }
+      return true;
+    case 2: // ASL ROL LSR ROR STX LDX DEC INC
+      if (bbb == 0 && aaa == 5) {
+	X = SetZN(Fetch());           // LDX #
+	return true;
+      }
+      if (bbb != 1 && bbb != 3 && bbb != 5 && bbb != 7)
+	return false;
+      adr = Address(bbb,aaa == 4 || aaa == 5);
+      switch(aaa) {
+      case 4:
+	if (bbb == 7)
+	  return false;
+	Mem[adr] = X;
+	break;
+      case 5:
+	X = SetZN(Mem[adr]);
+	break;
+      default:
+	Mem[adr] = Modify(aaa,Mem[adr]);
+	break;
+      }
+      return true;
+    case 0: // BIT STY LDY CPY CPX
+      if (bbb == 0) {
+	adr = PC++;
+	if (aaa < 5)
+	  return false;
+      } else if (bbb == 1 || bbb == 3 || ((bbb == 5 || bbb == 7) && (aaa == 4 || aaa == 5))) {
+	adr = Address(bbb);
+      } else {
+	return false;
+      }
+      v = Mem[adr];
+      switch(aaa) {
+      case 1: // BIT
+	P = UBYTE((P & ~(Z_Mask | V_Mask | N_Mask)) | (v & (V_Mask | N_Mask)));
+	if ((A & v) == 0)
+	  P |= Z_Mask;
+	break;
+      case 4:
+	if (bbb == 7)
+	  return false;
+	Mem[adr] = Y;
+	break;
+      case 5: Y = SetZN(v);    break;
+      case 6: Compare(Y,v);    break;
+      case 7: Compare(X,v);    break;
+      default:
+	return false;
+      }
+      return true;
+    }
+    return false;
+  }
+};
+///
+
+/// Statics
+// The state the tests run on. The ROM runner keeps the reference, the
+// address space the native routines work on.
+static class RomRunner  Runner;
+static class AdrSpace   Space;
+static class RamPage   *Pages[256];
+static const struct HLERoutines::RomEntryPoints *Rom;
+static UBYTE            RomImage[0x4000];
+static ULONG            Seed = 0x12345678;
+static int              Failures;
+static int              Tests;
+///
+
+/// Random
+// A simple pseudo-random generator such that the tests are
+// reproducible.
+static UBYTE Random(void)
+{
+  Seed = Seed * 1103515245UL + 12345UL;
+  return UBYTE(Seed >> 16);
+}
+///
+
+/// Setup
+// Fill the memory below the ROM with random data, install the ROM and
+// random registers. The stack pointer is set to a fixed value.
+static void Setup(void)
+{
+  int i;
+  //
+  for(i = 0;i < 0xc000;i++) {
+    Runner.Mem[i] = Random();
+  }
+  memcpy(Runner.Mem + 0xc000,RomImage,sizeof(RomImage));
+  Runner.A = Random();
+  Runner.X = Random();
+  Runner.Y = Random();
+  Runner.S = 0xf0;
+  // Decimal mode is off as the Os expects it, and interrupts are
+  // disabled.
+  Runner.P = UBYTE((Random() & ~RomRunner::D_Mask) | RomRunner::I_Mask | 0x20);
+}
+///
+
+/// PutWord
+// Write a word into the test memory.
+static void PutWord(ADR adr,UWORD w)
+{
+  Runner.Mem[adr]     = UBYTE(w);
+  Runner.Mem[adr + 1] = UBYTE(w >> 8);
+}
+///
+
+/// PrepareCall
+// Push the return address of the JSR that calls the routine under
+// test, and copy the state over to the native side.
+static void PrepareCall(ADR ret)
+{
+  int i;
+  //
+  // The routines are entered by a JSR or jump, the return address
+  // of the JSR is on the stack. Just push it.
+  Runner.Mem[0x100 + Runner.S] = UBYTE((ret - 1) >> 8);
+  Runner.S--;
+  Runner.Mem[0x100 + Runner.S] = UBYTE((ret - 1) & 0xff);
+  Runner.S--;
+  //
+  for(i = 0;i < 0x10000;i++) {
+    Space.WriteByte(i,Runner.Mem[i]);
+  }
+}
+///
+
+/// RunRom
+// Run the ROM code from the given entry point until it reaches the
+// return address or one of the continuations. Returns false if the
+// code cannot be run.
+static bool RunRom(const char *name,ADR entry,ADR ret,ADR cont,ADR cont2)
+{
+  ULONG steps = 0;
+  //
+  Runner.PC = UWORD(entry);
+  do {
+    if (!Runner.Step()) {
+      printf("%s: unsupported opcode $%02x at $%04x\n",name,Runner.Mem[UWORD(Runner.PC - 1)],Runner.PC - 1);
+      return false;
+    }
+    if (++steps > 50000000UL) {
+      printf("%s: the ROM code does not terminate\n",name);
+      return false;
+    }
+  } while(Runner.PC != ret && (cont == 0 || Runner.PC != cont) && (cont2 == 0 || Runner.PC != cont2));
+  //
+  return true;
+}
+///
+
+/// CompareMemory
+// Compare the memory of the native side with that of the ROM side,
+// and return the number of bytes that differ. The stack below the
+// stack pointer is scratch and may differ.
+static int CompareMemory(const char *name,int diffs)
+{
+  int i;
+  //
+  for(i = 0;i < 0x10000;i++) {
+    if (i > 0x100 && i <= 0x100 + Runner.S)
+      continue;
+    if (Space.ReadByte(i) != Runner.Mem[i]) {
+      if (diffs < 16)
+	printf("%s: memory at $%04x differs, native $%02x, ROM $%02x\n",name,i,Space.ReadByte(i),Runner.Mem[i]);
+      diffs++;
+    }
+  }
+  return diffs;
+}
+///
+
+/// RunTest
+// Run the given routine once natively and once in the ROM on the
+// current state, and compare the results. The routine is entered by a
+// JSR from the given return address, and the ROM code runs until it
+// reaches the return address or the given continuation.
+static void RunTest(const char *name,HLERoutines::Routine routine,ADR cont,ADR cont2 = 0)
+{
+  const ADR ret = 0x0600; // the caller, not executed
+  struct HLERoutines::Registers regs;
+  ADR entry = HLERoutines::EntryOf(Rom,routine);
+  ADR nativepc,rompc;
+  int diffs = 0;
+  //
+  if (entry == 0)
+    return;
+  Tests++;
+  //
+  PrepareCall(ret);
+  regs.A = Runner.A;
+  regs.X = Runner.X;
+  regs.Y = Runner.Y;
+  regs.S = Runner.S;
+  regs.P = Runner.P;
+  //
+  // Run the native code, followed by the RTS behind the ESC code.
+  HLERoutines::Run(Rom,routine,&Space,regs);
+  regs.S++;
+  nativepc  = Space.ReadByte(0x100 + regs.S);
+  regs.S++;
+  nativepc |= Space.ReadByte(0x100 + regs.S) << 8;
+  nativepc  = (nativepc + 1) & 0xffff;
+  //
+  // Run the ROM code.
+  if (!RunRom(name,entry,ret,cont,cont2)) {
+    Failures++;
+    return;
+  }
+  rompc = Runner.PC;
+  //
+  // Compare the results.
+  if (nativepc != rompc) {
+    printf("%s: native code continues at $%04x, the ROM at $%04x\n",name,nativepc,rompc);
+    diffs++;
+  }
+  if (regs.A != Runner.A || regs.X != Runner.X || regs.Y != Runner.Y || regs.S != Runner.S ||
+      regs.P != Runner.P) {
+    printf("%s: registers differ\n"
+	   "\tnative: A=%02x X=%02x Y=%02x S=%02x P=%02x\n"
+	   "\tROM   : A=%02x X=%02x Y=%02x S=%02x P=%02x\n",name,
+	   regs.A,regs.X,regs.Y,regs.S,regs.P,
+	   Runner.A,Runner.X,Runner.Y,Runner.S,Runner.P);
+    diffs++;
+  }
+  diffs = CompareMemory(name,diffs);
+  if (diffs)
+    Failures++;
+}
+///
+
+/// RunMathTest
+// Run the given math pack routine once by the BCD implementation and
+// once in the ROM from the given entry point on the current state,
+// and compare the memory and the carry flag. The other registers
+// are not defined on return.
+static void RunMathTest(const char *name,BCDMathPack::Routine routine,ADR entry)
+{
+  const ADR ret = 0x0600; // the caller, not executed
+  class BCDMathPack native;
+  bool carry;
+  int diffs = 0;
+  //
+  Tests++;
+  PrepareCall(ret);
+  carry = native.Run(&Space,routine,Runner.A,(ADR(Runner.Y) << 8) | Runner.X);
+  //
+  if (!RunRom(name,entry,ret,0,0)) {
+    Failures++;
+    return;
+  }
+  if (carry != ((Runner.P & RomRunner::C_Mask) != 0)) {
+    printf("%s: native carry %d, ROM carry %d\n",name,carry,Runner.P & RomRunner::C_Mask);
+    diffs++;
+  }
+  diffs = CompareMemory(name,diffs);
+  if (diffs)
+    Failures++;
+}
+///
+
+/// TestMemoryClear
+// The memory test on coldstart, up to the given page.
+static void TestMemoryClear(UBYTE top)
+{
+  Setup();
+  Runner.Mem[0x04] = 0x00;
+  Runner.Mem[0x05] = 0x00;
+  Runner.Mem[0x06] = top;
+  RunTest("memory clear",HLERoutines::MemoryClear,Rom->MemoryClearDone,Rom->MemoryClearFailed);
+}
+///
+
+/// TestScreenClear
+// Clear the screen from the given address up to the given top page.
+static void TestScreenClear(UWORD savmsc,UBYTE ramtop)
+{
+  Setup();
+  PutWord(HLERoutines::SAVMSC,savmsc);
+  Runner.Mem[HLERoutines::RAMTOP] = ramtop;
+  RunTest("screen clear",HLERoutines::ScreenClear,0);
+}
+///
+
+/// TestDeleteLine
+// Delete the given line of a screen at the given address with the
+// given number of lines.
+static void TestDeleteLine(UWORD savmsc,UBYTE lines,UBYTE row)
+{
+  Setup();
+  PutWord(HLERoutines::SAVMSC,savmsc);
+  PutWord(HLERoutines::ADRESS,UWORD(savmsc + 40 * row));
+  Runner.Mem[HLERoutines::BOTSCR] = lines;
+  Runner.X = row;
+  // The ROM enters with the carry of a comparison of the row
+  // against the number of lines.
+  Runner.P &= ~RomRunner::C_Mask;
+  RunTest("delete line",HLERoutines::DeleteLine,0);
+}
+///
+
+/// TestInsertLine
+// Insert a line at the given row into a screen that ends at the top
+// of the memory, with the given number of lines.
+static void TestInsertLine(UBYTE ramtop,UBYTE lines,UBYTE row)
+{
+  Setup();
+  Runner.Mem[HLERoutines::RAMTOP] = ramtop;
+  PutWord(HLERoutines::ADRESS,UWORD((ramtop << 8) - 40));
+  Runner.Mem[HLERoutines::BOTSCR] = lines;
+  Runner.Mem[HLERoutines::ROWCRS] = row;
+  Runner.X = row;
+  Runner.P &= ~RomRunner::C_Mask;
+  RunTest("insert line",HLERoutines::InsertLine,Rom->InsertLineDone);
+}
+///
+
+/// Math pack entry points
+// The math pack is entered at the same addresses in all Os versions.
+// The operands are in FR0 and FR1, the input of AFP at INBUFF+CIX.
+enum {
+  MathAFP    = 0xd800,
+  MathFASC   = 0xd8e6,
+  MathIFP    = 0xd9aa,
+  MathFPI    = 0xd9d2,
+  MathFSUB   = 0xda60,
+  MathFADD   = 0xda66,
+  MathFMUL   = 0xdadb,
+  MathFDIV   = 0xdb28,
+  MathPLYEVL = 0xdd40,
+  FR0        = 0xd4,
+  FR1        = 0xe0,
+  CIX        = 0xf2,
+  INBUFF     = 0xf3,
+  LBUFF      = 0x580,
+  Polynomial = 0x700, // where the coefficients of PLYEVL go
+  MathTests  = 1000   // the number of tests per routine
+};
+///
+
+/// RandomDigits
+// Two random BCD digits.
+static UBYTE RandomDigits(void)
+{
+  UBYTE high = UBYTE(Random() % 10);
+  //
+  return UBYTE((high << 4) | (Random() % 10));
+}
+///
+
+/// RandomNumber
+// Write a random floating point number to the given address. This is
+// zero if "zero" is set, a number with only two digits if "shortnum"
+// is set, and a number with all digits otherwise. The exponents reach
+// into the overflow and underflow range of the operations.
+static void RandomNumber(ADR at,bool zero,bool shortnum)
+{
+  UBYTE exponent;
+  int i;
+  //
+  if (zero) {
+    memset(Runner.Mem + at,0,6);
+    return;
+  }
+  if (Random() & 1) {
+    exponent = UBYTE(0x40 + int(Random() % 40) - 20);
+  } else {
+    exponent = UBYTE(0x40 + int(Random() % 120) - 60);
+  }
+  if (Random() & 1)
+    exponent |= 0x80;
+  Runner.Mem[at] = exponent;
+  do {
+    Runner.Mem[at + 1] = RandomDigits();
+  } while(Runner.Mem[at + 1] == 0);
+  for(i = 2;i < 6;i++) {
+    Runner.Mem[at + i] = (shortnum && i > 2)?(0):(RandomDigits());
+  }
+}
+///
+
+/// TestArithmetic
+// Test one of the operations with two operands. Some operands are
+// zero, some are equal up to the sign.
+static void TestArithmetic(const char *name,BCDMathPack::Routine routine,ADR entry,int i)
+{
+  Setup();
+  RandomNumber(FR0,i % 17 == 0,i % 5 == 0);
+  RandomNumber(FR1,i % 13 == 0,i % 7 == 0);
+  if (i % 11 == 0 || i % 19 == 0)
+    memcpy(Runner.Mem + FR1,Runner.Mem + FR0,6);
+  if (i % 19 == 0)
+    Runner.Mem[FR1] ^= 0x80;
+  RunMathTest(name,routine,entry);
+}
+///
+
+/// TestConversions
+// Test the conversions between integers, floating point numbers and
+// strings, and the polynomial evaluation.
+static void TestConversions(int i)
+{
+  static const char chars[] = "0123456789.E+- ";
+  int j,len;
+  //
+  Setup();
+  Runner.Mem[FR0]     = Random();
+  Runner.Mem[FR0 + 1] = Random();
+  RunMathTest("IFP",BCDMathPack::Math_IFP,MathIFP);
+  //
+  // Also numbers close to the integer range.
+  Setup();
+  RandomNumber(FR0,i % 9 == 0,false);
+  if (i & 1)
+    Runner.Mem[FR0] = UBYTE(0x3f + Random() % 4);
+  RunMathTest("FPI",BCDMathPack::Math_FPI,MathFPI);
+  //
+  Setup();
+  RandomNumber(FR0,i % 9 == 0,i % 3 == 0);
+  RunMathTest("FASC",BCDMathPack::Math_FASC,MathFASC);
+  //
+  // A random string of mostly digits, with some dots, exponents and
+  // signs mixed in.
+  Setup();
+  len = 1 + Random() % 14;
+  Runner.Mem[INBUFF]     = UBYTE(LBUFF);
+  Runner.Mem[INBUFF + 1] = UBYTE(LBUFF >> 8);
+  Runner.Mem[CIX]        = 0;
+  for(j = 0;j < len;j++) {
+    Runner.Mem[LBUFF + j] = (Random() % 3)?(UBYTE('0' + Random() % 10)):(UBYTE(chars[Random() % 15]));
+  }
+  Runner.Mem[LBUFF + len] = 0x9b;
+  RunMathTest("AFP",BCDMathPack::Math_AFP,MathAFP);
+  //
+  // A polynomial of up to ten coefficients.
+  Setup();
+  RandomNumber(FR0,i % 9 == 0,false);
+  Runner.A = UBYTE(1 + Random() % 10);
+  for(j = 0;j < Runner.A;j++) {
+    RandomNumber(ADR(Polynomial + 6 * j),j % 4 == 3,false);
+  }
+  Runner.X = UBYTE(Polynomial);
+  Runner.Y = UBYTE(Polynomial >> 8);
+  RunMathTest("PLYEVL",BCDMathPack::Math_PLYEVL,MathPLYEVL);
+}
+///
+
+/// LoadRom
+// Load the ROM image to test, or the built-in ROM if no file
+// is given. Returns false on an error.
+static bool LoadRom(const char *name)
+{
+  FILE *file;
+  bool ok;
+  //
+  if (name == NULL) {
+    memcpy(RomImage,osdist,sizeof(RomImage));
+    return true;
+  }
+  //
+  file = fopen(name,"rb");
+  if (file == NULL) {
+    printf("unable to open the ROM image %s\n",name);
+    return false;
+  }
+  ok = fread(RomImage,1,sizeof(RomImage),file) == sizeof(RomImage);
+  fclose(file);
+  if (!ok)
+    printf("%s is not an XL ROM image\n",name);
+  return ok;
+}
+///
+
+/// main
+int main(int argc,char **argv)
+{
+  UWORD lowsum,highsum;
+  int i;
+  //
+  if (!LoadRom((argc > 1)?(argv[1]):(NULL)))
+    return 20;
+  //
+  // A genuine XL ROM keeps its checksums at 0xc000 and 0xfff8.
+  lowsum  = UWORD(RomImage[0x0000] | (RomImage[0x0001] << 8));
+  highsum = UWORD(RomImage[0x3ff8] | (RomImage[0x3ff9] << 8));
+  Rom     = HLERoutines::FindRom(lowsum,highsum);
+  if (Rom == NULL) {
+    printf("The ROM with the checksums $%04x and $%04x is not in the registry.\n",lowsum,highsum);
+    return 5;
+  }
+  //
+  for(i = 0;i < 256;i++) {
+    Pages[i] = new class RamPage;
+    Space.MapPage(i << 8,Pages[i]);
+  }
+  //
+  TestMemoryClear(0x10);
+  TestMemoryClear(0xa0);
+  TestScreenClear(0x9c40,0xa0);
+  TestScreenClear(0xbc40,0xc0);
+  TestScreenClear(0x7e80,0x80);
+  TestScreenClear(0x3000,0x31);
+  for(i = 0;i < 26;i++) {
+    TestDeleteLine(0x9c40,24,UBYTE(i));
+    TestDeleteLine(0x7c40,24,UBYTE(i));
+    TestDeleteLine(0xbd60,4,UBYTE(i & 7));
+    TestInsertLine(0xa0,24,UBYTE(i));
+    TestInsertLine(0x80,24,UBYTE(i));
+    TestInsertLine(0xc0,4,UBYTE(i & 7));
+  }
+  //
+  // The BCD math pack is only used for the built-in ROM.
+  if (memcmp(RomImage,osdist,sizeof(RomImage)) == 0) {
+    for(i = 0;i < MathTests;i++) {
+      TestArithmetic("FADD",BCDMathPack::Math_FADD,MathFADD,i);
+      TestArithmetic("FSUB",BCDMathPack::Math_FSUB,MathFSUB,i);
+      TestArithmetic("FMUL",BCDMathPack::Math_FMUL,MathFMUL,i);
+      TestArithmetic("FDIV",BCDMathPack::Math_FDIV,MathFDIV,i);
+      TestConversions(i);
+    }
+  }
+  //
+  for(i = 0;i < 256;i++) {
+    delete Pages[i];
+  }
+  //
+  printf("%s ROM: %d tests, %d failed.\n",Rom->Name,Tests,Failures);
+  return (Failures)?(10):(0);
+}
+///
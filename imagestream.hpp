@@ -47,6 +47,14 @@ public:
   //
   // Writes data back into the image to the given offset.
   virtual bool Write(ULONG offset,const void *buffer,ULONG size) = 0;
+  //
+  // Write all modifications still pending back into the file
+  // before the stream is disposed. Returns a boolean success
+  // indicator, does not throw.
+  virtual bool Close(void)
+  {
+    return true;
+  }
 
 };
 ///
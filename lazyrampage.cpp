@@ -0,0 +1,8 @@
+/***********************************************************************************
+ **
+ ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
+ **
+ ** $Id: lazyrampage.cpp,v 1.1 2020/05/11 17:40:12 thor Exp $
+ **
+ ** In this module: A page of memory that is only allocated on the first write
+ **********************************************************************************/
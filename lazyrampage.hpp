@@ -0,0 +1,96 @@
+/***********************************************************************************
+ **
+ ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
+ **
+ ** $Id: lazyrampage.hpp,v 1.1 2020/05/11 17:40:12 thor Exp $
+ **
+ ** In this module: A page of memory that is only allocated on the first write
+ **********************************************************************************/
+
+#ifndef LAZYRAMPAGE_HPP
+#define LAZYRAMPAGE_HPP
+
+/// Includes
+#include "types.hpp"
+#include "page.hpp"
+#include "string.hpp"
+///
+
+/// Class LazyRamPage
+// Defines a page of RAM whose memory is provided by its owner, typically
+// a slice of a larger block that is allocated at once. The page remains
+// unused and reads as zero until it is written to for the first time.
+// Only then the slice is cleared and taken into use, and from then on
+// accesses go directly to the memory. As an unused slice is never
+// touched, the operating system does not need to provide memory for it.
+class LazyRamPage : public Page {
+  //
+  // The memory this page goes to once it is used.
+  UBYTE *Storage;
+  //
+  // The "complex" functions are only called as long as the page
+  // is unused.
+  virtual UBYTE ComplexRead(ADR)
+  {
+    return 0;
+  }
+  //
+  virtual void ComplexWrite(ADR mem,UBYTE val)
+  {
+    Use();
+    memory[mem & PAGE_MASK] = val;
+  }
+  //
+public:
+  LazyRamPage(void)
+    : Storage(NULL)
+  { }
+  //
+  ~LazyRamPage(void)
+  { }
+  //
+  // Define the memory this page goes to once used. This also
+  // resets the page to unused.
+  void SetStorage(UBYTE *mem)
+  {
+    Storage = mem;
+    memory  = NULL;
+  }
+  //
+  // Take the page into use, clear its memory.
+  void Use(void)
+  {
+    if (memory == NULL) {
+      memset(Storage,0,PAGE_LENGTH);
+      memory = Storage;
+    }
+  }
+  //
+  // Check whether the page has been written to.
+  bool isUsed(void) const
+  {
+    return memory != NULL;
+  }
+  //
+  // Patch a byte into the RAM.
+  virtual void PatchByte(ADR mem,UBYTE val)
+  {
+    ComplexWrite(mem,val);
+  }
+  //
+  // This is never IO space, even if unused.
+  virtual bool isIOSpace(ADR) const
+  {
+    return false;
+  }
+  //
+  // Blank a page to all zeros. This releases the page.
+  void Blank(void)
+  {
+    memory = NULL;
+  }
+};
+///
+
+///
+#endif
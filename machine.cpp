@@ -67,6 +67,9 @@
 #include "licence.hpp"
 #include "sighandler.hpp"
 #include "keyboardstick.hpp"
+#include "patch.hpp"
+#include "timer.hpp"
+#include "string.hpp"
 #include <stdarg.h>
 ///
 
@@ -135,6 +138,8 @@ Machine::Machine(void)
   keypadstick    = NULL;
 
   escCode        = 0;
+  memset(escSlots,0,sizeof(escSlots));
+  profileEscapes = false;
   quit           = false;
   reset          = false;
   coldstart      = false;
@@ -438,18 +443,25 @@ void Machine::Jam(UBYTE opcode)
 
 /// Machine::Escape
 // This one is privately for the CPU: Emulate an escape code by
-// going thru all patches.  
+// dispatching it to the patch that allocated it.
 // It is called by the CPU code to respond to an ESCape / JAM code 
 // to execute emulator specific instructions
 void Machine::Escape(UBYTE code)
 {
-  if (!patchProviderChain.IsEmpty()) {
-    class AdrSpace *ram     = mmu->CPURAM();
-    class PatchProvider *pp = patchProviderChain.First();
-    while(pp) {
-      if (pp->RunEmulatorTrap(ram,cpu,code))
+  struct EscapeSlot *slot = escSlots + code;
+  //
+  if (slot->Owner) {
+    if (profileEscapes) {
+      UQUAD start    = Timer::MicroTime();
+      // The PC is already behind the code.
+      slot->Location = (cpu->PC() - 2) & 0xffff;
+      slot->Calls++;
+      if (slot->Owner->RunEmulatorTrap(mmu->CPURAM(),cpu,code)) {
+	slot->Micros += Timer::MicroTime() - start;
 	return;
-      pp = pp->NextOf();
+      }
+    } else if (slot->Owner->RunEmulatorTrap(mmu->CPURAM(),cpu,code)) {
+      return;
     }
   }
   //
@@ -466,10 +478,12 @@ void Machine::Escape(UBYTE code)
 ///
 
 /// Machine::AlocateEscape
-// Allocate N escape codes, return the next available code.
-UBYTE Machine::AllocateEscape(UBYTE count)
+// Allocate N escape codes for the given patch, return the next
+// available code.
+UBYTE Machine::AllocateEscape(UBYTE count,class Patch *owner)
 {
   UBYTE next;
+  int i;
 
   if (int(count) + int(escCode) >= 0xff)
     Throw(OutOfRange,"Machine::AllocateEscape",
@@ -477,11 +491,46 @@ UBYTE Machine::AllocateEscape(UBYTE count)
 
   next     = escCode;
   escCode += count;
+  //
+  // Install the owner for dispatching, and restart the statistics
+  // as the code may have been used by another patch before.
+  for(i = next;i < escCode;i++) {
+    escSlots[i].Owner    = owner;
+    escSlots[i].Location = 0;
+    escSlots[i].Calls    = 0;
+    escSlots[i].Micros   = 0;
+  }
 
   return next;
 }
 ///
 
+/// Machine::ReleaseEscape
+// Release the escape codes of a patch that is going away.
+void Machine::ReleaseEscape(class Patch *owner)
+{
+  int i;
+
+  for(i = 0;i < 256;i++) {
+    if (escSlots[i].Owner == owner)
+      escSlots[i].Owner = NULL;
+  }
+}
+///
+
+/// Machine::ResetEscapeStatistics
+// Reset the call counters and timings of all escape codes.
+void Machine::ResetEscapeStatistics(void)
+{
+  int i;
+
+  for(i = 0;i < 256;i++) {
+    escSlots[i].Calls  = 0;
+    escSlots[i].Micros = 0;
+  }
+}
+///
+
 /// Machine::SigBreak
 // Handle a ^C event in whatever way it is appropriate
 void Machine::SigBreak(void)
@@ -86,6 +86,22 @@ class KeyboardStick;
 // Unfortunately, we cannot config this by the 
 // configchain itself.
 class Machine {
+public:
+  //
+  // An allocated escape code: The patch that runs it, and how
+  // often and how long it ran.
+  struct EscapeSlot {
+    // The patch that allocated the code, or NULL.
+    class Patch *Owner;
+    // The address of the escape code as seen last.
+    ADR          Location;
+    // Number of times the code was run.
+    ULONG        Calls;
+    // The host time spent in the patch, in microseconds.
+    UQUAD        Micros;
+  };
+  //
+private:
   //
   // Chain of all configurable modules in here.
   List<Configurable>    configChain;
@@ -100,8 +116,8 @@ class Machine {
   // Chain of all gameports. These classes are the input generators
   // for game port devices like paddles, joysticks or lightpens
   List<GamePort>        gamePortChain;
-  // Chain of all installed patches so we know what to run if we
-  // hit an escape code
+  // Chain of all installed patch providers. Escape codes are
+  // dispatched by the escSlots table below.
   List<PatchProvider>   patchProviderChain;
   // Chain of all possible input sources for the CPU IRQ line
   List<IRQSource>       irqChain;
@@ -178,6 +194,15 @@ class Machine {
   // The next free Escape code
   UBYTE                  escCode;
   //
+  // The owners of the escape codes and their statistics, indexed by
+  // the escape code. This dispatches an escape code directly to the
+  // patch that allocated it.
+  struct EscapeSlot      escSlots[256];
+  //
+  // Set if the escape codes are profiled, i.e. their calls are
+  // counted and timed. This costs two host timer reads per call.
+  bool                   profileEscapes;
+  //
   // The following is set to true when exiting the emulator.
   bool                   quit;
   bool                   reset;
@@ -456,13 +481,38 @@ public:
   }
   //
   // This one is privately for the CPU: Emulate an escape code by
-  // going thru all patches.  
+  // dispatching it to the patch that allocated it.
   // It is called by the CPU code to respond to an ESCape / JAM code 
   // to execute emulator specific instructions
   void Escape(UBYTE code);
   // 
-  // Allocate N escape codes, return the next available code.
-  UBYTE AllocateEscape(UBYTE count);
+  // Allocate N escape codes for the given patch, return the next
+  // available code.
+  UBYTE AllocateEscape(UBYTE count,class Patch *owner);
+  //
+  // Release the escape codes of a patch that is going away.
+  void ReleaseEscape(class Patch *owner);
+  //
+  // Return the number of escape codes allocated so far.
+  UBYTE EscapeCodesInUse(void) const
+  {
+    return escCode;
+  }
+  //
+  // Return the owner and the statistics of an escape code.
+  const struct EscapeSlot &EscapeSlotOf(UBYTE code) const
+  {
+    return escSlots[code];
+  }
+  //
+  // Reset the call counters and timings of all escape codes.
+  void ResetEscapeStatistics(void);
+  //
+  // Enable or disable the profiling of the escape codes.
+  void ProfileEscapes(bool enable)
+  {
+    profileEscapes = enable;
+  }
   //
   // Machine management functions
   //
@@ -14,6 +14,7 @@
 #include "cmdlineparser.hpp"
 #include "exceptions.hpp"
 #include "errorrequester.hpp"
+#include "timer.hpp"
 #include "new.hpp"
 #include "stdio.hpp"
 ///
@@ -78,6 +79,7 @@ int main(int argc,char **argv)
   class CmdLineParser *args = NULL;
   char *configname          = NULL;
   char *statename           = NULL;
+  bool timing               = false;
   int rc = 0;
 
   try {
@@ -85,6 +87,10 @@ int main(int argc,char **argv)
     bool domenu;
     char *home;
     char confname[80];
+    // Time stamps of the startup phases, for the timing report.
+    UQUAD starttime,buildtime,configtime,parsetime,coldtime;
+    //
+    starttime = Timer::MicroTime();
     // First build the machine and all its subclasses.
     mach = new class Machine;
     args = new class CmdLineParser;
@@ -92,6 +98,7 @@ int main(int argc,char **argv)
     // This constructs all subclasses and links them into the
     // main emulator object
     mach->BuildMachine(args);  
+    buildtime = Timer::MicroTime();
     //
     // Are there any global arguments?
     ParseFromFile(args,"/etc/atari++/atari++.conf");
@@ -123,9 +130,11 @@ int main(int argc,char **argv)
     args->DefineTitle("Global options");
     args->DefineFile("config","configuration file to load",configname,false,true,false);
     args->DefineFile("state","status snapshot file to load",statename,false,true,false);
+    args->DefineBool("startuptiming","print the time spent in the startup phases",timing);
     // Check whether we have a configuration file to load. If so, do now.
     if (configname && *configname)
       ParseFromFile(args,configname);
+    configtime = Timer::MicroTime();
     //
     //
     domenu = false;
@@ -184,6 +193,7 @@ int main(int argc,char **argv)
 	}
       }
     } while(retry);
+    parsetime = Timer::MicroTime();
     //
     // Now that we parsed all arguments, check whether we should really
     // run the emulator (we do not in case the user just requested help
@@ -194,6 +204,22 @@ int main(int argc,char **argv)
       // Check for a state name. Load now if available.
       if (statename && *statename)
 	mach->ReadStates(statename);
+      coldtime = Timer::MicroTime();
+      //
+      if (timing) {
+	printf("Startup timing:\n"
+	       "Building the machine         : %8lu usecs\n"
+	       "Reading the configuration    : %8lu usecs\n"
+	       "Parsing the arguments        : %8lu usecs\n"
+	       "Coldstart and state loading  : %8lu usecs\n"
+	       "Total time to first cycle    : %8lu usecs\n",
+	       (unsigned long)(buildtime  - starttime),
+	       (unsigned long)(configtime - buildtime),
+	       (unsigned long)(parsetime  - configtime),
+	       (unsigned long)(coldtime   - parsetime),
+	       (unsigned long)(coldtime   - starttime));
+	fflush(stdout);
+      }
       // Run the emulator
       mach->Atari()->EmulationLoop();
     }
@@ -21,8 +21,9 @@
 ///
 
 /// MathPackPatch::MathPackPatch
-MathPackPatch::MathPackPatch(class Machine *mach,class PatchProvider *p)
-  : Patch(mach,p,30) // requires quite a lot of slots.
+MathPackPatch::MathPackPatch(class Machine *mach,class PatchProvider *p,bool exact)
+  : Patch(mach,p,30), // requires quite a lot of slots.
+    Exact(exact)
 {
 }
 ///
@@ -819,13 +820,19 @@ void MathPackPatch::InstallPatch(class AdrSpace *adr,UBYTE code)
   InsertESC(adr,0xddab,code + 15); // FSTOP
   InsertESC(adr,0xddb6,code + 16); // FMOVE
   InsertESC(adr,0xdd40,code + 17); // PLYEVL
-  InsertESC(adr,0xddc0,code + 18); // EXP
-  InsertESC(adr,0xddcc,code + 19); // EXP10
-  InsertESC(adr,0xdecd,code + 20); // LOG
-  InsertESC(adr,0xded1,code + 21); // LOG10
-  // Undocumented call-ins follow. These are used
-  // by BASIC and Mac/65
-  InsertESC(adr,0xde95,code + 22); // FFRACT
+  //
+  // In BCD mode, the ROM computes the transcendental functions by
+  // the patched primitives. Rounding them to the result of the host
+  // functions would not give the results of the ROM.
+  if (!Exact) {
+    InsertESC(adr,0xddc0,code + 18); // EXP
+    InsertESC(adr,0xddcc,code + 19); // EXP10
+    InsertESC(adr,0xdecd,code + 20); // LOG
+    InsertESC(adr,0xded1,code + 21); // LOG10
+    // Undocumented call-ins follow. These are used
+    // by BASIC and Mac/65
+    InsertESC(adr,0xde95,code + 22); // FFRACT
+  }
   InsertESC(adr,0xda51,code + 23); // INITINBUF
   InsertESC(adr,0xdba1,code + 24); // SKIPBLANKS
   InsertESC(adr,0xda5a,code + 25); // TIMESTWO  
@@ -850,10 +857,46 @@ void MathPackPatch::InstallPatch(class AdrSpace *adr,UBYTE code)
 }
 ///
 
+/// MathPackPatch::RunBCDPatch
+// Run one of the patches in BCD. Returns false if the patch has
+// no BCD version as its host version is exact anyhow.
+bool MathPackPatch::RunBCDPatch(class AdrSpace *adr,class CPU *cpu,UBYTE code)
+{
+  ADR mem = (ADR(cpu->Y())<<8) | ADR(cpu->X());
+  bool carry;
+  //
+  // Clearing registers and the undocumented helpers other than the
+  // normalization do not compute anything, their host versions are
+  // exact.
+  if (code == 4 || code == 5 || (code > 17 && code != BCDMathPack::Math_Normalize))
+    return false;
+  //
+  carry = Native.Run(adr,BCDMathPack::Routine(code),cpu->A(),mem);
+  //
+  // The normalization is also the tail of routines that run in
+  // decimal mode, and it leaves this mode.
+  if (code == BCDMathPack::Math_Normalize)
+    cpu->P() &= ~CPU::D_Mask;
+  //
+  // The load and store routines leave Y at 0xff.
+  if (code >= BCDMathPack::Math_FLD0R && code <= BCDMathPack::Math_FST0P)
+    cpu->Y() = 0xff;
+  if (carry) {
+    cpu->P() |= CPU::C_Mask;
+  } else {
+    cpu->P() &= ~CPU::C_Mask;
+  }
+  return true;
+}
+///
+
 /// MathPackPatch::RunPatch
 // Run one of the math pack patches
 void MathPackPatch::RunPatch(class AdrSpace *adr,class CPU *cpu,UBYTE code)
 {
+  if (Exact && RunBCDPatch(adr,cpu,code))
+    return;
+  //
   switch(code) {
   case 0:
     AFP(adr,cpu);
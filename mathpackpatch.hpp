@@ -15,6 +15,7 @@
 #include "types.hpp"
 #include "patch.hpp"
 #include "mathsupport.hpp"
+#include "bcdmathpack.hpp"
 ///
 
 /// Forwards
@@ -26,6 +27,18 @@ class PatchProvider;
 /// Class MathPackPatch
 #ifdef HAVE_MATH
 class MathPackPatch : public Patch, private MathSupport {
+  //
+  // If set, compute in BCD exactly as the built-in Os does rather
+  // than in host floating point. The transcendental functions are
+  // then left to the ROM, which runs them on the patched primitives.
+  bool               Exact;
+  //
+  // The native BCD implementation of the math pack for the above.
+  class BCDMathPack  Native;
+  //
+  // Run one of the patches in BCD. Returns false if the patch has
+  // no BCD version as its host version is exact anyhow.
+  bool RunBCDPatch(class AdrSpace *adr,class CPU *cpu,UBYTE code);
   //
   // Convert ASCII to BCD in FR0. Set carry flag on error
   void AFP(class AdrSpace *adr,class CPU *cpu);
@@ -99,7 +112,7 @@ protected:
   //
 public:  
   // Constructors and destructors
-  MathPackPatch(class Machine *mach,class PatchProvider *p);
+  MathPackPatch(class Machine *mach,class PatchProvider *p,bool exact);
   virtual ~MathPackPatch(void)
   { 
   }
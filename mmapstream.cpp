@@ -0,0 +1,111 @@
+/***********************************************************************************
+ **
+ ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
+ **
+ ** $Id: mmapstream.cpp,v 1.1 2020/04/05 12:31:17 thor Exp $
+ **
+ ** In this module: Disk image source stream interface towards mmap
+ **********************************************************************************/
+
+/// Includes
+#include "mmapstream.hpp"
+#include "exceptions.hpp"
+#include "directory.hpp"
+#include "string.hpp"
+#include "unistd.hpp"
+#if USE_MMAPSTREAM
+#include <fcntl.h>
+#include <sys/mman.h>
+///
+
+/// MMapStream::MMapStream
+MMapStream::MMapStream(void)
+  : Mapping(NULL), Size(0)
+{ }
+///
+
+/// MMapStream::~MMapStream
+// Cleanup the stream and release the mapping.
+MMapStream::~MMapStream(void)
+{
+  if (Mapping)
+    munmap(Mapping,Size);
+}
+///
+
+/// MMapStream::OpenImage
+// Open a disk image from a file name and map it into
+// memory. Only images that cannot be modified are mapped.
+void MMapStream::OpenImage(const char *name)
+{
+  struct stat info;
+  void *map;
+  int handle;
+  //
+  // First check whether we are already open. If so, we
+  // cannot re-open again.
+#if CHECK_LEVEL > 0
+  if (Mapping) {
+    Throw(ObjectExists,"MMapStream::OpenImage",
+	  "the image has been opened already");
+  }
+#endif
+  //
+  if (stat(name,&info)) {
+    ThrowIo("MMapStream::OpenImage","unable to stat the image file");
+  }
+  //
+  // Empty files cannot be mapped, and nothing else than plain
+  // files should be.
+  if (!S_ISREG(info.st_mode) || info.st_size <= 0)
+    Throw(InvalidParameter,"MMapStream::OpenImage","the image file cannot be mapped");
+  //
+  // A mapping does not take a snapshot of the file: It follows
+  // modifications of the file, and truncating the file faults on
+  // the next access beyond its new end. Hence, as for ROM images,
+  // only map files that cannot be modified, i.e. have no write
+  // permission for us, our group or anyone else. The superuser may
+  // write all files. The caller keeps the stdio stream for all
+  // other images.
+  if (geteuid() == 0 || (info.st_mode & (S_IWGRP | S_IWOTH)))
+    Throw(InvalidParameter,"MMapStream::OpenImage","the image file is writable and cannot be mapped");
+  if ((info.st_mode & S_IWUSR) && info.st_uid == geteuid())
+    Throw(InvalidParameter,"MMapStream::OpenImage","the image file is writable and cannot be mapped");
+  //
+  handle = open(name,O_RDONLY);
+  if (handle < 0)
+    ThrowIo("MMapStream::OpenImage","unable to open the input stream");
+  //
+  Size = ULONG(info.st_size);
+  map  = mmap(NULL,Size,PROT_READ,MAP_PRIVATE,handle,0);
+  //
+  // The mapping remains valid after closing the file.
+  close(handle);
+  if (map == MAP_FAILED) {
+    Size = 0;
+    ThrowIo("MMapStream::OpenImage","unable to map the image file");
+  }
+  Mapping  = (UBYTE *)map;
+}
+///
+
+/// MMapStream::Read
+// Reads data from the image into the buffer from the given
+// byte offset.
+bool MMapStream::Read(ULONG offset,void *buffer,ULONG size)
+{
+#if CHECK_LEVEL > 0
+  if (Mapping == NULL)
+    Throw(ObjectDoesntExist,"MMapStream::Read","the image has not yet been opened");
+#endif
+  // Try to read past the end?
+  if (offset + size > Size || offset + size < offset)
+    return false;
+  //
+  memcpy(buffer,Mapping + offset,size);
+  return true;
+}
+///
+
+///
+#endif
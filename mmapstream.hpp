@@ -0,0 +1,77 @@
+/***********************************************************************************
+ **
+ ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
+ **
+ ** $Id: mmapstream.hpp,v 1.1 2020/04/05 12:31:17 thor Exp $
+ **
+ ** In this module: Disk image source stream interface towards mmap
+ **********************************************************************************/
+
+#ifndef MMAPSTREAM_HPP
+#define MMAPSTREAM_HPP
+
+/// Includes
+#include "types.h"
+#include "types.hpp"
+#include "imagestream.hpp"
+#if HAVE_SYS_MMAN_H && HAVE_MMAP && HAVE_MUNMAP && HAVE_FCNTL_H && HAVE_OPEN && HAVE_CLOSE
+#define USE_MMAPSTREAM 1
+///
+
+/// Class MMapStream
+// This class implements the image stream interface by mapping
+// the image file into memory. Sector reads are then simple
+// copies from the mapping. Only images that cannot be modified
+// are mapped, hence the stream is always write-protected.
+class MMapStream : public ImageStream {
+  //
+  // The start of the mapped image, or NULL if not mapped.
+  UBYTE *Mapping;
+  //
+  // The size of the image
+  ULONG  Size;
+  //
+public:
+  MMapStream(void);
+  virtual ~MMapStream(void);
+  //
+  // Open the image from a file name.
+  virtual void OpenImage(const char *filename);
+  //
+  // Format an image. A mapping cannot grow, hence formatting
+  // is left to the FileStream and this returns an error.
+  virtual bool FormatImage(const char *)
+  {
+    return false;
+  }
+  //
+  // Get the size of an image in bytes.
+  virtual ULONG ByteSize(void)
+  {
+    return Size;
+  }
+  //
+  // Get a protection status, i.e. wether we may write to the image.
+  // Returns true in case we are protected.
+  virtual bool ProtectionStatus(void)
+  {
+    return true;
+  }
+  //
+  // Reads data from the image into the buffer from the given
+  // byte offset. Returns a boolean success indicator, does not
+  // throw.
+  virtual bool Read(ULONG offset,void *buffer,ULONG size);
+  //
+  // Writes data back into the image to the given offset. This
+  // always fails as the image is protected.
+  virtual bool Write(ULONG,const void *,ULONG)
+  {
+    return false;
+  }
+};
+#endif
+///
+
+///
+#endif
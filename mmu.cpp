@@ -36,7 +36,8 @@ MMU::MMU(class Machine *machine)
     blank(new class RomPage[32]), handlers(new class RomPage),
     cpuspace(new class AdrSpace), anticspace(new class AdrSpace), 
     debugspace(new DebugAdrSpace(machine,cpuspace)),
-    xeram(NULL), axlonram(NULL)
+    xeram(NULL), axlonram(NULL),
+    generation(0), mappingstate(MapImmediately), dirtyareas(0)
 {
   // Set default mapping by defining various flags:
   // The default machine is an 800XL (hence, mine!)
@@ -47,6 +48,8 @@ MMU::MMU(class Machine *machine)
   extended_4K     = false;
   axlon           = false;
   //
+  memset(portbcache,0,sizeof(portbcache));
+  //
   // Clear the blank page out now.
   blank->Blank();
 }
@@ -55,6 +58,11 @@ MMU::MMU(class Machine *machine)
 /// MMU::~MMU Destructor
 MMU::~MMU(void)
 {
+  int i;
+  //
+  for(i = 0;i < 256;i++) {
+    delete portbcache[i];
+  }
   delete xeram;
   delete axlonram;
   delete[] blank;
@@ -121,6 +129,9 @@ void MMU::BuildMedRam(void)
   class RamPage *rp = ram->RamPages();
   ADR i;
   //
+  if (DeferMapping(MedRamArea))
+    return;
+  //
   // The 5200 does not have any memory in this area,
   // and neither extended RAM.
   if (machine->MachType() != Mach_5200) {
@@ -180,6 +191,9 @@ void MMU::BuildCartArea(void)
   bool havebasic;
   ADR i;
   //
+  if (DeferMapping(CartArea))
+    return;
+  //
   // Get the type of the cartridge that is currently inserted
   havebasic = basicrom->BasicLoaded();
   cart      = cartrom->Cart();
@@ -216,6 +230,30 @@ void MMU::BuildCartArea(void)
 }
 ///
 
+/// MMU::SwitchCartBank
+// Fast bank switch of a cartridge that is mapped already: Map the
+// consecutive pages of the bank into the window from base to end
+// only, instead of rebuilding the cart area.
+void MMU::SwitchCartBank(class Cartridge *cart,ADR base,ADR end,class RomPage *bank)
+{
+  ADR i;
+  //
+  // Carts behind this one in the chain are mapped on top of it and
+  // might cover the window. Let the full build sort this out.
+  if (cart->NextOf() || mappingstate != MapImmediately) {
+    BuildCartArea();
+    return;
+  }
+  //
+  generation++;
+  for(i = base;i < end;i += PAGE_LENGTH) {
+    cpuspace->MapPage(i,bank);
+    anticspace->MapPage(i,bank);
+    bank++;
+  }
+}
+///
+
 /// MMU::BuildOsArea
 // Build all areas except selftest that
 // could be mapped by ROM. This is 0xc000 to 0xd000
@@ -226,6 +264,9 @@ void MMU::BuildOsArea(void)
   class RomPage *rom;
   class Page    *cfpage; // page from 0xcf00 to 0xcfff that might be hidden by Axlon RAM Disk Control
   ADR i;
+  //
+  if (DeferMapping(OsArea))
+    return;
   //  
   // Get the Os ROM area.
   rom = osrom->OsPages();
@@ -345,6 +386,56 @@ void MMU::BuildOsArea(void)
 }
 ///
 
+/// MMU::EndPortBChange
+// Complete the change of the mapping by a write of the given value
+// into PORTB, either from the mapping cache or by building the
+// areas that changed.
+void MMU::EndPortBChange(UBYTE portb)
+{
+  struct PortBMapping *map = portbcache[portb];
+  UBYTE dirty              = dirtyareas;
+  ULONG gen                = generation;
+  //
+  mappingstate = MapImmediately;
+  dirtyareas   = 0;
+  if (dirty == 0)
+    return;
+  //
+  // The mapping is a function of PORTB and the flags as long as
+  // nothing else changed it in between.
+  if (map && map->Generation      == gen             &&
+      map->BasicMapped     == basic_mapped    &&
+      map->RomDisabled     == rom_disabled    &&
+      map->SelfTestMapped  == selftest_mapped &&
+      map->MathPackDisable == mathpack_disable) {
+    cpuspace->SetPageTable(map->CPUPages);
+    anticspace->SetPageTable(map->AnticPages);
+    return;
+  }
+  //
+  // Otherwise, build the areas that changed.
+  mappingstate = MapCommitting;
+  if (dirty & MedRamArea)
+    BuildMedRam();
+  if (dirty & CartArea)
+    BuildCartArea();
+  if (dirty & OsArea)
+    BuildOsArea();
+  mappingstate = MapImmediately;
+  //
+  // Keep the mapping for the next time this value is written.
+  if (map == NULL)
+    portbcache[portb] = map = new struct PortBMapping;
+  cpuspace->GetPageTable(map->CPUPages);
+  anticspace->GetPageTable(map->AnticPages);
+  map->Generation      = gen;
+  map->BasicMapped     = basic_mapped;
+  map->RomDisabled     = rom_disabled;
+  map->SelfTestMapped  = selftest_mapped;
+  map->MathPackDisable = mathpack_disable;
+}
+///
+
 /// MMU::BuildRamRomMapping
 // Build the mapping for the complete RAM mapping
 void MMU::BuildRamRomMapping(void)
@@ -33,6 +33,7 @@ class PIA;
 class Antic;
 class CartCtrl;
 class Cartridge;
+class RomPage;
 class Monitor;
 class CartROM;
 class RamExtension;
@@ -76,6 +77,55 @@ class MMU : public Chip, public Saveable, public MemController {
   bool extended_4K;     // true if additional 4K for 800's enabled.
   bool axlon;           // true if axlon RAM extension should be made available
   //
+  // The mapping cache for PORTB writes: For each value written into
+  // PORTB, the complete page tables of CPU and ANTIC as they were built
+  // before. Any change of the mapping not triggered by PORTB, e.g. by
+  // cartridge bank switching or a RAM disk control register, bumps the
+  // generation and thus invalidates all entries.
+  struct PortBMapping {
+    class Page *CPUPages[256];
+    class Page *AnticPages[256];
+    ULONG       Generation;
+    // The flags the mapping was built for.
+    bool        BasicMapped,RomDisabled,SelfTestMapped,MathPackDisable;
+  };
+  struct PortBMapping *portbcache[256];
+  ULONG                generation;
+  //
+  // The state of a PORTB change: While PIA updates the MMU flags, the
+  // mapping is deferred and the areas to rebuild are collected.
+  enum MappingState {
+    MapImmediately,  // not within a PORTB change
+    MapDeferred,     // collect the areas to rebuild
+    MapCommitting    // rebuilding the collected areas
+  }                    mappingstate;
+  //
+  // The areas to rebuild at the end of the PORTB change.
+  enum {
+    MedRamArea = 1,
+    CartArea   = 2,
+    OsArea     = 4
+  };
+  UBYTE                dirtyareas;
+  //
+  // Check whether the build of the given area is deferred to the end
+  // of a PORTB change. Returns true if so, otherwise invalidates the
+  // mapping cache if required.
+  bool DeferMapping(UBYTE area)
+  {
+    switch(mappingstate) {
+    case MapDeferred:
+      dirtyareas |= area;
+      return true;
+    case MapImmediately:
+      generation++;
+      break;
+    case MapCommitting:
+      break;
+    }
+    return false;
+  }
+  //
   // Create all necessary RAM extensions for the MMU
   bool BuildExtensions(void);
   // Remove MMU/RAM Extensions no longer required. This
@@ -90,18 +140,24 @@ public:
   // Map a page to the CPU address space
   void MapCPUPage(ADR mem,class Page *page)
   {
+    if (mappingstate != MapCommitting)
+      generation++;
     cpuspace->MapPage(mem,page);
   }
   //
   // Map a page to the ANTIC address space
   void MapANTICPage(ADR mem,class Page *page)
   {
+    if (mappingstate != MapCommitting)
+      generation++;
     anticspace->MapPage(mem,page);
   }
   //
   // Map a page to both CPU and ANTIC address space
   void MapPage(ADR mem,class Page *page)
   {
+    if (mappingstate != MapCommitting)
+      generation++;
     cpuspace->MapPage(mem,page);
     anticspace->MapPage(mem,page);
   }
@@ -127,11 +183,36 @@ public:
   // Build the mapping from 0x8000 to 0xc000
   void BuildCartArea(void);
   //
+  // Fast bank switch of a cartridge that is mapped already: Map the
+  // consecutive pages of the bank into the window from base to end
+  // only, instead of rebuilding the cart area.
+  void SwitchCartBank(class Cartridge *cart,ADR base,ADR end,class RomPage *bank);
+  //
   // Build all areas except selftest that
   // could be mapped by ROM. This is 0xc000 to 0xd000
   // and 0xd800 to 0x10000
   void BuildOsArea(void);
   //
+  // Start a change of the mapping by a PORTB write. Until the change
+  // is completed, the Select functions below only update the flags.
+  void BeginPortBChange(void)
+  {
+    mappingstate = MapDeferred;
+    dirtyareas   = 0;
+  }
+  //
+  // Complete the change of the mapping by a write of the given value
+  // into PORTB, either from the mapping cache or by building the
+  // areas that changed.
+  void EndPortBChange(UBYTE portb);
+  //
+  // Invalidate the mapping cache because the pages of an extension
+  // have been reallocated.
+  void InvalidateMappingCache(void)
+  {
+    generation++;
+  }
+  //
   // Return whether GTIA TRIG3 will return a CART_LOADED flag here.
   // Return false if no cart is loaded. Return true if so.
   // NOTE! An disabled Oss super cart will show up here as
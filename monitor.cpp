@@ -12,7 +12,9 @@
 #include "monitor.hpp"
 #include "adrspace.hpp"
 #include "cpu.hpp"
+#include "callprofiler.hpp"
 #include "mmu.hpp"
+#include "debugadrspace.hpp"
 #include "antic.hpp"
 #include "timer.hpp"
 #include "display.hpp"
@@ -22,6 +24,8 @@
 #include "curses.hpp"
 #include "list.hpp"
 #include "instruction.hpp"
+#include "binarytrace.hpp"
+#include "rampage.hpp"
 
 #include <stdarg.h>
 #include <ctype.h>
@@ -49,8 +53,9 @@ Monitor::Monitor(class Machine *mach)
   : machine(mach), cpu(mach->CPU()), MMU(mach->MMU()),
     cpuspace(MMU->CPURAM()), anticspace(MMU->AnticRAM()), currentadr(MMU->CPURAM()),
     debugspace(MMU->DebugRAM()),
-    tracefile(NULL), symboltable(NULL), curses(NULL), cmdline(NULL), 
-    abort(false), fetchtrace(false),
+    tracefile(NULL), binarytrace(NULL), symboltable(NULL), symbolindex(NULL), symbolcount(0),
+    symbolgeneration(0), curses(NULL), cmdline(NULL), 
+    abort(false), fetchtrace(false), quiet(false),
     cmdchain(NULL),
     Envi(this,"ENVI","V","environment settings"),
     Splt(this,"SPLT","/","split off display"),
@@ -76,7 +81,9 @@ Monitor::Monitor(class Machine *mach)
     Prof(this,"PROF","O","profile code"),
     // help must go last into the chain to be the first getting displayed.
     Help(this,"HELP","?","display this text")
-{ }
+{
+  memset(symbolhash,0,sizeof(symbolhash));
+}
 ///
 
 /// Monitor::~Monitor
@@ -85,6 +92,7 @@ Monitor::~Monitor(void)
   ClearSymbolTable();
   if (tracefile)
     fclose(tracefile);
+  delete binarytrace;
   delete[] cmdline;
 }
 ///
@@ -100,6 +108,60 @@ void Monitor::ClearSymbolTable(void)
     symboltable = symboltable->next;
     delete s;
   }
+  memset(symbolhash,0,sizeof(symbolhash));
+  delete[] symbolindex;
+  symbolindex = NULL;
+  symbolcount = 0;
+  symbolgeneration++;
+}
+///
+
+/// Monitor::SymbolHashOf
+// Compute the hash value of a symbol name. Names are compared
+// case-insensitive, hence the hash is as well.
+int Monitor::SymbolHashOf(const char *name)
+{
+  ULONG hash = 0;
+
+  while(*name) {
+    hash = hash * 31 + tolower(UBYTE(*name));
+    name++;
+  }
+
+  return int(hash & (SymbolHashSize - 1));
+}
+///
+
+/// Monitor::BuildSymbolIndex
+// Sort the symbols by their value for the lookup by address. Symbols
+// of the same value keep the order of the symbol table.
+void Monitor::BuildSymbolIndex(void)
+{
+  struct Symbol *s;
+  LONG *start;
+  LONG i;
+
+  delete[] symbolindex;
+  symbolindex = NULL;
+  symbolcount = 0;
+  symbolgeneration++;
+  
+  for(s = symboltable;s;s = s->next)
+    symbolcount++;
+  if (symbolcount == 0)
+    return;
+  //
+  // Symbol values are 16 bit wide, hence a counting sort does.
+  symbolindex = new struct Symbol *[symbolcount];
+  start       = new LONG[0x10001];
+  memset(start,0,sizeof(LONG) * 0x10001);
+  for(s = symboltable;s;s = s->next)
+    start[s->value + 1]++;
+  for(i = 1;i <= 0x10000;i++)
+    start[i] += start[i - 1];
+  for(s = symboltable;s;s = s->next)
+    symbolindex[start[s->value]++] = s;
+  delete[] start;
 }
 ///
 
@@ -130,13 +192,16 @@ bool Monitor::ParseSymbolTable(const char *filename)
 	    if (s.ParseLabel(linebuffer)) {
 	      struct Symbol *add;
 	      result = true;
-	      if ((add = const_cast<struct Symbol *>(Symbol::FindSymbol(symboltable,s.name,0,s.type,s.size)))) {
+	      if ((add = const_cast<struct Symbol *>(FindSymbol(s.name,0,s.type,s.size)))) {
 		// Label already exists, replace its value.
 		add->value  = s.value;
 	      } else {
-		add         = new struct Symbol(s);
-		add->next   = symboltable;
-		symboltable = add;
+		int hash      = SymbolHashOf(s.name);
+		add           = new struct Symbol(s);
+		add->next     = symboltable;
+		symboltable   = add;
+		add->hashnext = symbolhash[hash];
+		symbolhash[hash] = add;
 	      }
 	    }
 	  }
@@ -144,6 +209,7 @@ bool Monitor::ParseSymbolTable(const char *filename)
 	  Print("Error %s reading the symbol file %s\n",strerror(errno),filename);
 	}
       }
+      BuildSymbolIndex();
       fclose(symbols);
     } catch(...) {
       ClearSymbolTable();
@@ -267,75 +333,114 @@ bool Monitor::Symbol::ParseLabel(char *line)
 }
 ///
 
-/// Monitor::Symbol::FindSymbol
+/// Monitor::SymbolNameOf
+// Return the name of the label at the given address, or NULL
+// if there is none.
+const char *Monitor::SymbolNameOf(ADR address)
+{
+  const struct Symbol *symbol;
+
+  symbol = FindSymbol(address,Symbol::Label,Symbol::PreferAbsolute);
+  if (symbol)
+    return symbol->name;
+  
+  return NULL;
+}
+///
+
+/// Monitor::Symbol::ScoreFor
+// Return how well this label matches the given type and size,
+// or a negative number if it does not match at all.
+int Monitor::Symbol::ScoreFor(Type t,Size s) const
+{
+  int score = 0;
+
+  switch(t) {
+  case Equate:
+    if (type == Equate)
+      score += 10;
+    else
+      return -1;
+    break;
+  case Label:
+    if (type == Label)
+      score += 10;
+    else
+      return -1;
+    break;
+  case Any:
+    score += 5;
+    break;
+  case PreferLabel:
+    if (type == Label)
+      score += 5;
+    score += 2;
+    break;
+  case PreferEquate:
+    if (type == Equate)
+      score += 5;
+    score += 2;
+    break;
+  }
+  switch(s) {
+  case ZeroPage:
+    if (size == ZeroPage)
+      score += 10;
+    else
+      return -1;
+    break;
+  case Absolute:
+    if (size == Absolute)
+      score += 10;
+    else
+      return -1;
+    break;
+  case All:
+    score += 5;
+    break;
+  case PreferZeroPage:
+    if (size == ZeroPage)
+      score += 5;
+    score += 2;
+    break;
+  case PreferAbsolute:
+    if (size == Absolute)
+      score += 5;
+    score += 2;
+    break;
+  }
+
+  return score;
+}
+///
+
+/// Monitor::FindSymbol
 // Find a label by its address, size and type.
-const struct Monitor::Symbol *Monitor::Symbol::FindSymbol(const struct Symbol *list,UWORD address,Type t,Size s)
+const struct Monitor::Symbol *Monitor::FindSymbol(UWORD address,Symbol::Type t,Symbol::Size s) const
 {
   const struct Symbol *bestmatch = NULL;
   int score     = 0;
   int bestscore = 0;
-  
-  for(;list;list = list->next) {
-    if (list->value == address) {
-      score = 0;
-      switch(t) {
-      case Equate:
-	if (list->type == Equate)
-	  score += 10;
-	else
-	  continue;
-	break;
-      case Label:
-	if (list->type == Label)
-	  score += 10;
-	else
-	  continue;
-	break;
-      case Any:
-	score += 5;
-	break;
-      case PreferLabel:
-	if (list->type == Label)
-	  score += 5;
-	score += 2;
-	break;
-      case PreferEquate:
-	if (list->type == Equate)
-	  score += 5;
-	score += 2;
-	break;
-      }
-      switch(s) {
-      case ZeroPage:
-	if (list->size == ZeroPage)
-	  score += 10;
-	else
-	  continue;
-	break;
-      case Absolute:
-	if (list->size == Absolute)
-	  score += 10;
-	else
-	  continue;
-	break;
-      case Any:
-	score += 5;
-	break;
-      case PreferZeroPage:
-	if (list->size == ZeroPage)
-	  score += 5;
-	score += 2;
-	break;
-      case PreferAbsolute:
-	if (list->size == Absolute)
-	  score += 5;
-	score += 2;
-	break;
-      }
-      if (score >= bestscore) {
-	bestscore = score;
-	bestmatch = list;
-      }
+  LONG lo       = 0;
+  LONG hi       = symbolcount;
+
+  // Find the first symbol with the given value.
+  while(lo < hi) {
+    LONG mid = (lo + hi) >> 1;
+    if (symbolindex[mid]->value < address) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  //
+  // Symbols of the same value are in the order of the symbol
+  // table, the last one with the best score wins.
+  for(;lo < symbolcount && symbolindex[lo]->value == address;lo++) {
+    score = symbolindex[lo]->ScoreFor(t,s);
+    if (score >= 0 && score >= bestscore) {
+      bestscore = score;
+      bestmatch = symbolindex[lo];
     }
   }
   
@@ -343,19 +448,20 @@ const struct Monitor::Symbol *Monitor::Symbol::FindSymbol(const struct Symbol *l
 }
 ///
 
-/// Monitor::Symbol::FindSymbol
+/// Monitor::FindSymbol
 // Find a symbol by its name, size and type.
-const struct Monitor::Symbol *Monitor::Symbol::FindSymbol(const struct Symbol *list,const char *name,UWORD pc,Type t,Size s)
+const struct Monitor::Symbol *Monitor::FindSymbol(const char *name,UWORD pc,Symbol::Type t,Symbol::Size s) const
 {
   int bestdist = 0xffff;
   const struct Symbol *bestmatch = NULL;
+  const struct Symbol *list      = symbolhash[SymbolHashOf(name)];
   size_t l = strlen(name) + 1;
 
   if (l > Symbol::MaxLabelSize)
     l = Symbol::MaxLabelSize;
 
   while(list) {
-    if ((t == Any || list->type == t) && (s == All || list->size == s)) {
+    if ((t == Symbol::Any || list->type == t) && (s == Symbol::All || list->size == s)) {
       
       if (!strncasecmp(name,list->name,l)) {
 	int dist = int(list->value) - int(pc);
@@ -367,7 +473,7 @@ const struct Monitor::Symbol *Monitor::Symbol::FindSymbol(const struct Symbol *l
 	}
       }
     }
-    list = list->next;
+    list = list->hashnext;
   }
 
   return bestmatch;
@@ -383,16 +489,20 @@ struct Monitor::Command* &Monitor::CommandChain(void)
 ///
 
 /// Monitor::Expression Evaluation miscellaneous
-bool Monitor::EvaluateExpression(char *s,LONG &val)
+bool Monitor::EvaluateExpression(char *s,LONG &val,bool silent)
 {
   char *start = s;
+  bool  loud  = quiet;
 
+  quiet = silent;
   try {
     val = EvaluateLogical(s);
     if (*s != 0)
       throw NumericException(this,"Error: %s is an invalid expression.\n",start);
+    quiet = loud;
     return true;
   } catch (const NumericException &) {
+    quiet = loud;
     return false;
   }
 }
@@ -646,7 +756,7 @@ LONG Monitor::EvaluateNumeric(char *&s)
 	break;
     }
     *lptr  = 0;
-    symbol = Symbol::FindSymbol(symboltable,labelname,cpu->PC(),Symbol::Any,Symbol::All);
+    symbol = FindSymbol(labelname,cpu->PC(),Symbol::Any,Symbol::All);
     if (symbol) {
       s = sptr;
       return symbol->value;
@@ -669,9 +779,11 @@ Monitor::NumericException::NumericException(class Monitor *mon,const char *errfm
 {
   va_list args;
   
-  va_start(args,errfmt);
-  mon->VPrint(errfmt,args);
-  va_end(args);
+  if (!mon->quiet) {
+    va_start(args,errfmt);
+    mon->VPrint(errfmt,args);
+    va_end(args);
+  }
 }
 ///
 
@@ -1086,8 +1198,14 @@ void Monitor::PrintCPUStatus(void) const
 // Fill a buffer with the CPU flags in readable form
 void Monitor::CPUFlags(char pstring[9]) const
 {  
-  UBYTE flags = cpu->P();
+  CPUFlags(cpu->P(),pstring);
+}
+///
 
+/// Monitor::CPUFlags
+// Fill a buffer with the given flags in readable form
+void Monitor::CPUFlags(UBYTE flags,char pstring[9])
+{  
   pstring[0] = (flags & CPU::N_Mask)?('N'):('-');
   pstring[1] = (flags & CPU::V_Mask)?('V'):('-');
   pstring[2] = '.';
@@ -1551,13 +1669,92 @@ void Monitor::Dump::Apply(char e)
 /// Monitor::UnAs::UnAs
 Monitor::UnAs::UnAs(class Monitor *mon,const char *lng,const char *shr,const char *helper)
   : Command(mon,lng,shr,helper,'L'), lines(16)
-{ }
+{ 
+  int i;
+  
+  for(i = 0;i < 256;i++) {
+    cache[i].Ins = NULL;
+  }
+}
 ///
 
-/// Monitor::UnAs::DisassembleLine
-// Disassemble a single instruction into a buffer,
+/// Monitor::UnAs::DisassembleInstruction
+// Disassemble a single instruction into a buffer, taking the
+// index registers for symbol lookups from the arguments,
+// advance the disassembly position, return it. This goes
+// through the cache of disassembled lines.
+ADR Monitor::UnAs::DisassembleInstruction(class AdrSpace *adr,ADR where,UBYTE x,UBYTE y,char *line)
+{
+  struct CacheLine *cl;
+  const struct Instruction *ins;
+  UBYTE inst;
+  int i,size;
+  
+  if (where >= 0x10000) {
+    *line = 0;
+    return where;
+  }
+  //
+  inst = adr->ReadByte(where);
+  ins  = &monitor->cpu->Disassemble(inst);
+  //
+  // The index registers only enter the symbol lookup of indexed
+  // instructions.
+  switch(ins->AddressingMode) {
+  case Instruction::ZPage_X:
+  case Instruction::Indirect_X:
+  case Instruction::Absolute_X:
+  case Instruction::AbsIndirect_X:
+    y = 0;
+    break;
+  case Instruction::ZPage_Y:
+  case Instruction::Absolute_Y:
+    x = 0;
+    break;
+  default:
+    x = y = 0;
+    break;
+  }
+  //
+  cl = cache + (where & 0xff);
+  if (cl->Ins == ins && cl->PC == where && cl->Bytes[0] == inst && 
+      cl->X == x && cl->Y == y && cl->Generation == monitor->symbolgeneration) {
+    size = cl->Next - where;
+    for(i = 1;i < size;i++) {
+      if (adr->ReadByte(where + i) != cl->Bytes[i])
+	break;
+    }
+    if (i >= size) {
+      strcpy(line,cl->Line);
+      return cl->Next;
+    }
+  }
+  //
+  // Not in the cache, or outdated. Disassemble and update the cache.
+  cl->Ins        = NULL;
+  cl->Next       = FormatInstruction(adr,where,x,y,line);
+  size           = cl->Next - where;
+  if (size >= 1 && size <= 3 && strlen(line) < sizeof(cl->Line)) {
+    for(i = 0;i < size;i++) {
+      cl->Bytes[i] = adr->ReadByte(where + i);
+    }
+    cl->Ins        = ins;
+    cl->PC         = where;
+    cl->X          = x;
+    cl->Y          = y;
+    cl->Generation = monitor->symbolgeneration;
+    strcpy(cl->Line,line);
+  }
+
+  return cl->Next;
+}
+///
+
+/// Monitor::UnAs::FormatInstruction
+// Disassemble a single instruction into a buffer, taking the
+// index registers for symbol lookups from the arguments,
 // advance the disassembly position, return it.
-ADR Monitor::UnAs::DisassembleLine(class AdrSpace *adr,ADR where,char *line)
+ADR Monitor::UnAs::FormatInstruction(class AdrSpace *adr,ADR where,UBYTE x,UBYTE y,char *line)
 {
   int op;
   ADR pc = where;
@@ -1591,7 +1788,7 @@ ADR Monitor::UnAs::DisassembleLine(class AdrSpace *adr,ADR where,char *line)
   case Instruction::Immediate:
     if (where < 0x10000) {
       op     = adr->ReadByte(where++);
-      target = Monitor::Symbol::FindSymbol(monitor->symboltable,op,Symbol::Equate,Symbol::ZeroPage);
+      target = monitor->FindSymbol(op,Symbol::Equate,Symbol::ZeroPage);
       if (target) {
 	sprintf(buf,"%-4s #%.16s",name,target->name);
       } else {
@@ -1607,7 +1804,7 @@ ADR Monitor::UnAs::DisassembleLine(class AdrSpace *adr,ADR where,char *line)
   case Instruction::ZPage:
     if (where < 0x10000) {
       op     = adr->ReadByte(where++);
-      target = Monitor::Symbol::FindSymbol(monitor->symboltable,op,Symbol::PreferLabel,Symbol::ZeroPage);
+      target = monitor->FindSymbol(op,Symbol::PreferLabel,Symbol::ZeroPage);
       if (target) {
 	sprintf(buf,"%-4s  %.16s",name,target->name);
       } else {
@@ -1620,7 +1817,7 @@ ADR Monitor::UnAs::DisassembleLine(class AdrSpace *adr,ADR where,char *line)
   case Instruction::ZPage_X:
     if (where < 0x10000) {
       op  = adr->ReadByte(where++);
-      target = Monitor::Symbol::FindSymbol(monitor->symboltable,UBYTE(op + cpu->X()),Symbol::PreferLabel,Symbol::ZeroPage);
+      target = monitor->FindSymbol(UBYTE(op + x),Symbol::PreferLabel,Symbol::ZeroPage);
       if (target) {
 	sprintf(buf,"%-4s  %.16s,X",name,target->name);
       } else {
@@ -1633,7 +1830,7 @@ ADR Monitor::UnAs::DisassembleLine(class AdrSpace *adr,ADR where,char *line)
   case Instruction::ZPage_Y:
     if (where < 0x10000) {
       op  = adr->ReadByte(where++); 
-      target = Monitor::Symbol::FindSymbol(monitor->symboltable,UBYTE(op + cpu->Y()),Symbol::PreferLabel,Symbol::ZeroPage);
+      target = monitor->FindSymbol(UBYTE(op + y),Symbol::PreferLabel,Symbol::ZeroPage);
       if (target) {
 	sprintf(buf,"%-4s  %.16s,Y",name,target->name);
       } else {
@@ -1646,7 +1843,7 @@ ADR Monitor::UnAs::DisassembleLine(class AdrSpace *adr,ADR where,char *line)
   case Instruction::Indirect:
     if (where < 0x10000) {
       op  = adr->ReadWord(where);
-      target = Monitor::Symbol::FindSymbol(monitor->symboltable,op,Symbol::PreferEquate,Symbol::PreferAbsolute);
+      target = monitor->FindSymbol(op,Symbol::PreferEquate,Symbol::PreferAbsolute);
       if (target) {
 	sprintf(buf,"%-4s  (%.16s)",name,target->name);
       } else {
@@ -1660,7 +1857,7 @@ ADR Monitor::UnAs::DisassembleLine(class AdrSpace *adr,ADR where,char *line)
   case Instruction::Indirect_X:
     if (where < 0x10000) {
       op  = adr->ReadByte(where++);
-      target = Monitor::Symbol::FindSymbol(monitor->symboltable,UBYTE(op + cpu->X()),Symbol::PreferLabel,Symbol::ZeroPage);
+      target = monitor->FindSymbol(UBYTE(op + x),Symbol::PreferLabel,Symbol::ZeroPage);
       if (target) {
 	sprintf(buf,"%-4s  (%.16s,X)",name,target->name);
       } else {
@@ -1673,7 +1870,7 @@ ADR Monitor::UnAs::DisassembleLine(class AdrSpace *adr,ADR where,char *line)
   case Instruction::Indirect_Y:
     if (where < 0x10000) {
       op  = adr->ReadByte(where++);
-      target = Monitor::Symbol::FindSymbol(monitor->symboltable,op,Symbol::PreferLabel,Symbol::ZeroPage);
+      target = monitor->FindSymbol(op,Symbol::PreferLabel,Symbol::ZeroPage);
       if (target) {
 	sprintf(buf,"%-4s  (%.16s),Y",name,target->name);
       } else {
@@ -1686,7 +1883,7 @@ ADR Monitor::UnAs::DisassembleLine(class AdrSpace *adr,ADR where,char *line)
   case Instruction::Indirect_Z:
     if (where < 0x10000) {
       op  = adr->ReadByte(where++);
-      target = Monitor::Symbol::FindSymbol(monitor->symboltable,op,Symbol::PreferLabel,Symbol::ZeroPage);
+      target = monitor->FindSymbol(op,Symbol::PreferLabel,Symbol::ZeroPage);
       if (target) {
 	sprintf(buf,"%-4s  (%.16s)",name,target->name);
       } else {
@@ -1699,7 +1896,7 @@ ADR Monitor::UnAs::DisassembleLine(class AdrSpace *adr,ADR where,char *line)
   case Instruction::Absolute:
     if (where < 0xffff) {
       op  = adr->ReadWord(where);
-      target = Monitor::Symbol::FindSymbol(monitor->symboltable,op,Symbol::PreferLabel,Symbol::PreferAbsolute);
+      target = monitor->FindSymbol(op,Symbol::PreferLabel,Symbol::PreferAbsolute);
       if (target) {
 	sprintf(buf,"%-4s  %.16s",name,target->name);
       } else {
@@ -1713,7 +1910,7 @@ ADR Monitor::UnAs::DisassembleLine(class AdrSpace *adr,ADR where,char *line)
   case Instruction::Absolute_X:
     if (where < 0xffff) {
       op  = adr->ReadWord(where);
-      target = Monitor::Symbol::FindSymbol(monitor->symboltable,UWORD(op + cpu->X()),Symbol::PreferLabel,Symbol::PreferAbsolute);
+      target = monitor->FindSymbol(UWORD(op + x),Symbol::PreferLabel,Symbol::PreferAbsolute);
       if (target) {
 	sprintf(buf,"%-4s  %.16s,X",name,target->name);
       } else {
@@ -1727,7 +1924,7 @@ ADR Monitor::UnAs::DisassembleLine(class AdrSpace *adr,ADR where,char *line)
   case Instruction::Absolute_Y:
     if (where < 0xffff) {
       op  = adr->ReadWord(where);
-      target = Monitor::Symbol::FindSymbol(monitor->symboltable,UWORD(op + cpu->Y()),Symbol::PreferLabel,Symbol::PreferAbsolute);
+      target = monitor->FindSymbol(UWORD(op + y),Symbol::PreferLabel,Symbol::PreferAbsolute);
       if (target) {
 	sprintf(buf,"%-4s  %.16s,Y",name,target->name);
       } else {
@@ -1741,7 +1938,7 @@ ADR Monitor::UnAs::DisassembleLine(class AdrSpace *adr,ADR where,char *line)
   case Instruction::AbsIndirect_X:
     if (where < 0xffff) {
       op  = adr->ReadWord(where);
-      target = Monitor::Symbol::FindSymbol(monitor->symboltable,UBYTE(op + cpu->X()),Symbol::PreferLabel,Symbol::PreferAbsolute);
+      target = monitor->FindSymbol(UBYTE(op + x),Symbol::PreferLabel,Symbol::PreferAbsolute);
       if (target) {
 	sprintf(buf,"%-4s  (%.16s,X)",name,target->name);
       } else {
@@ -1756,7 +1953,7 @@ ADR Monitor::UnAs::DisassembleLine(class AdrSpace *adr,ADR where,char *line)
     // Note that this displacement is signed
     if (where < 0x10000) {
       op  = (BYTE)(adr->ReadByte(where++));
-      target = Monitor::Symbol::FindSymbol(monitor->symboltable,where+op,Symbol::PreferLabel,Symbol::PreferAbsolute);
+      target = monitor->FindSymbol(where+op,Symbol::PreferLabel,Symbol::PreferAbsolute);
       if (target) {
 	sprintf(buf,"%-4s  %.16s",name,target->name);
       } else {
@@ -1770,8 +1967,8 @@ ADR Monitor::UnAs::DisassembleLine(class AdrSpace *adr,ADR where,char *line)
     if (where < 0xffff) {
       UBYTE zp = adr->ReadByte(where++);
       op       = (BYTE)adr->ReadByte(where++);
-      pctarget = Monitor::Symbol::FindSymbol(monitor->symboltable,where+op,Symbol::PreferLabel,Symbol::PreferAbsolute);
-      target   = Monitor::Symbol::FindSymbol(monitor->symboltable,zp      ,Symbol::PreferLabel,Symbol::ZeroPage);
+      pctarget = monitor->FindSymbol(where+op,Symbol::PreferLabel,Symbol::PreferAbsolute);
+      target   = monitor->FindSymbol(zp      ,Symbol::PreferLabel,Symbol::ZeroPage);
       if (target) {
 	if (pctarget) {
 	  sprintf(buf,"%-4s  %.16s,%.16s",name,target->name,pctarget->name);
@@ -1793,7 +1990,7 @@ ADR Monitor::UnAs::DisassembleLine(class AdrSpace *adr,ADR where,char *line)
   //
   // Now disassemble the remaining line dependent on the number of arguments
   // we pulled off (one to three).
-  pctarget = Monitor::Symbol::FindSymbol(monitor->symboltable,pc,Symbol::Any,Symbol::Absolute);
+  pctarget = monitor->FindSymbol(pc,Symbol::Any,Symbol::Absolute);
   if (pctarget) {
     sprintf(pcbuf,"$%04x:%.16s",pc,pctarget->name);
   } else {
@@ -1811,6 +2008,20 @@ ADR Monitor::UnAs::DisassembleLine(class AdrSpace *adr,ADR where,char *line)
 	    adr->ReadByte(pc+2),buf);
     break;
   }
+  return where;
+}
+///
+
+/// Monitor::UnAs::DisassembleLine
+// Disassemble a single instruction into a buffer,
+// advance the disassembly position, return it.
+ADR Monitor::UnAs::DisassembleLine(class AdrSpace *adr,ADR where,char *line)
+{
+  ADR pc = where;
+  //
+  where = DisassembleInstruction(adr,pc,monitor->cpu->X(),monitor->cpu->Y(),line);
+  if (pc >= 0x10000)
+    return where;
   //
   // Check whether we are at the CPU PC position. If so, print
   // a star behind the address.
@@ -2081,7 +2292,7 @@ bool Monitor::Step::MainLoop(void)
 
   monitor->cpu->DisableStack();
   monitor->cpu->DisablePC();
-  if (monitor->tracefile == NULL)
+  if (monitor->tracefile == NULL && monitor->binarytrace == NULL)
     monitor->cpu->DisableTrace();  
   monitor->fetchtrace = false;
   monitor->Splt.UpdateSplit();
@@ -2880,6 +3091,8 @@ void Monitor::Envi::Apply(char e)
   case '?':
     Print("ENVI.A : toggle between CPU and ANTIC address space\n");
     Print("ENVI.L [filename] : set tracing output file\n");
+    Print("ENVI.B [filename] : set binary tracing output file\n");
+    Print("ENVI.D trace file [from [to]] : disassemble binary trace into file\n");
     Print("ENVI.S [filename] : load ld65 debug symbols from file\n");
     Print("ENVI.C : clear symbol table\n");
     break;
@@ -2924,44 +3137,344 @@ void Monitor::Envi::Apply(char e)
       Print("Tracing disabled.\n");
     }
     break;
+  case 'B':
+    if (monitor->binarytrace) {
+      class BinaryTrace *trace = monitor->binarytrace;
+      monitor->binarytrace = NULL;
+      if (monitor->tracefile == NULL && !monitor->fetchtrace)
+	monitor->cpu->DisableTrace();
+      try {
+	trace->Close();
+      } catch(const AtariException &) {
+	Print("I/O error : %s\n",strerror(errno));
+      }
+      delete trace;
+    }
+    token = NextToken();
+    if (token) {
+      class BinaryTrace *trace = new class BinaryTrace;
+      try {
+	trace->OpenForWrite(token,monitor->machine->Antic()->FrameLines());
+	monitor->binarytrace = trace;
+	monitor->cpu->EnableTrace();
+	Print("Binary tracing enabled, trace written to %s.\n",token);
+      } catch(const AtariException &) {
+	Print("I/O error : %s\n",strerror(errno));
+	delete trace;
+      }
+    } else {
+      Print("Binary tracing disabled.\n");
+    }
+    break;
+  case 'D':
+    token = NextToken();
+    if (token) {
+      const char *tracename = token;
+      const char *filename  = NextToken();
+      if (filename) {
+	LONG from = 0x0000,to = 0xffff;
+	bool valid = true;
+	char *arg  = NextToken();
+	if (arg) {
+	  valid = monitor->EvaluateExpression(arg,from);
+	  arg   = NextToken();
+	  if (valid && arg) {
+	    valid = monitor->EvaluateExpression(arg,to);
+	  } else {
+	    to    = from;
+	  }
+	}
+	if (valid && LastArg()) {
+	  DecodeTrace(tracename,filename,ADR(from),ADR(to));
+	}
+      } else {
+	Print("output file name argument missing.\n");
+      }
+    } else {
+      Print("trace file name argument missing.\n");
+    }
+    break;
   default:
     ExtInvalid();
   }
 }
 ///
 
+/// Monitor::Envi::DecodeTrace
+// Disassemble a binary trace into a text file in the format of
+// ENVI.L, keeping only the instructions from the given range.
+void Monitor::Envi::DecodeTrace(const char *tracename,const char *filename,ADR from,ADR to)
+{
+  class BinaryTrace trace;
+  struct BinaryTrace::Record rec;
+  class AdrSpace space;
+  class RamPage page;
+  FILE *out;
+  char buffer[80];
+  char pstring[9];
+  ULONG count = 0;
+  ADR mem;
+  int i;
+  //
+  // All pages of the address space alias to the same page, this
+  // is sufficient for the up to three bytes of an instruction.
+  for(mem = 0;mem < 0x10000;mem += PAGE_LENGTH) {
+    space.MapPage(mem,&page);
+  }
+  //
+  try {
+    if (!trace.OpenForRead(tracename)) {
+      Print("%s is not a binary trace.\n",tracename);
+      return;
+    }
+  } catch(const AtariException &) {
+    Print("I/O error : %s\n",strerror(errno));
+    return;
+  }
+  //
+  out = fopen(filename,"w");
+  if (out == NULL) {
+    Print("I/O error : %s\n",strerror(errno));
+    return;
+  }
+  try {
+    while(trace.Read(rec)) {
+      if (rec.PC < from || rec.PC > to)
+	continue;
+      for(i = 0;i < rec.Size;i++) {
+	space.WriteByte((rec.PC + i) & 0xffff,rec.Bytes[i]);
+      }
+      monitor->UnAs.DisassembleInstruction(&space,rec.PC,rec.X,rec.Y,buffer);
+      buffer[32] = '*';
+      Monitor::CPUFlags(rec.P,pstring);
+      fprintf(out,"%-32s;A:%02x X:%02x Y:%02x S:%02x P:%02x=%s XPos:%3d YPos:%3d Cycles:%3d\n",buffer,
+	      rec.A,rec.X,rec.Y,rec.S,rec.P,pstring,rec.XPos,rec.YPos,int(rec.Cycles));
+      count++;
+    }
+  } catch(const AtariException &) {
+    Print("I/O error : %s\n",strerror(errno));
+  }
+  //
+  if (fclose(out) != 0) {
+    Print("I/O error : %s\n",strerror(errno));
+  } else {
+    Print("%lu instructions written to %s.\n",(unsigned long)count,filename);
+  }
+}
+///
+
+/// Monitor::BrkP::BreakPoint::BreakPoint
+Monitor::BrkP::BreakPoint::BreakPoint(ADR from,ADR to,UBYTE t,const char *cond)
+  : address(from), last(to), type(t), enabled(true), condition(NULL), hits(0),
+    failed(false)
+{
+  if (cond) {
+    condition = new char[strlen(cond) + 1];
+    strcpy(condition,cond);
+  }
+}
+///
+
 /// Monitor::BrkP::BrkP
 Monitor::BrkP::BrkP(class Monitor *mon,const char *lng,const char *shr,const char *helper)
   : Command(mon,lng,shr,helper,'S')
 { }
 ///
 
+/// Monitor::BrkP::~BrkP
+Monitor::BrkP::~BrkP(void)
+{
+  struct BreakPoint *p;
+
+  while((p = Points.RemHead()))
+    delete p;
+}
+///
+
+/// Monitor::BrkP::Rebuild
+// Install the union of all enabled points into the CPU and the
+// debug address space.
+void Monitor::BrkP::Rebuild(void)
+{
+  class CPU *cpu              = monitor->cpu;
+  class DebugAdrSpace *debug  = monitor->MMU->DebugRAM();
+  const struct BreakPoint *p;
+  ADR adr;
+
+  cpu->ClearBreakPoints();
+  debug->ClearWatchPoints();
+  for(p = Points.First();p;p = p->NextOf()) {
+    if (p->enabled) {
+      for(adr = p->address;adr <= p->last;adr++) {
+	if (p->type & DebugAdrSpace::ExecuteAccess)
+	  cpu->SetBreakPoint(adr);
+	if (p->type & (DebugAdrSpace::ReadAccess | DebugAdrSpace::WriteAccess))
+	  debug->SetWatchPoint(adr,p->type & (DebugAdrSpace::ReadAccess | DebugAdrSpace::WriteAccess));
+      }
+    }
+  }
+  //
+  // Watch points require the slower debug address space.
+  if (debug->WatchesEnabled()) {
+    cpu->EnableWatchPoints();
+  } else {
+    cpu->DisableWatchPoints();
+  }
+}
+///
+
+/// Monitor::BrkP::Triggered
+// Check whether an access of the given type to the given address
+// triggers, i.e. an enabled point covers it and its condition, if
+// any, is true.
+bool Monitor::BrkP::Triggered(ADR adr,UBYTE type)
+{
+  struct BreakPoint *p;
+  char buffer[256];
+  LONG value;
+
+  for(p = Points.First();p;p = p->NextOf()) {
+    if (p->enabled && (p->type & type) && adr >= p->address && adr <= p->last) {
+      if (p->condition) {
+	strncpy(buffer,p->condition,sizeof(buffer) - 1);
+	buffer[sizeof(buffer) - 1] = 0;
+	// This runs within the emulation where nothing can be printed.
+	// An invalid condition breaks such that the error is seen, it
+	// is reported as soon as the monitor is entered.
+	if (monitor->EvaluateExpression(buffer,value,true)) {
+	  if (value == 0)
+	    continue;
+	} else {
+	  p->failed = true;
+	}
+      }
+      p->hits++;
+      return true;
+    }
+  }
+  return false;
+}
+///
+
+/// Monitor::BrkP::ReportFailures
+// Report the points whose condition could not be evaluated since
+// the monitor was entered last.
+void Monitor::BrkP::ReportFailures(void)
+{
+  struct BreakPoint *p;
+
+  for(p = Points.First();p;p = p->NextOf()) {
+    if (p->failed) {
+      Print("Error: the condition %s cannot be evaluated, breaking at:\n",p->condition);
+      PrintPoint(p);
+      p->failed = false;
+    }
+  }
+}
+///
+
+/// Monitor::BrkP::PrintPoint
+// Print a break or watch point.
+void Monitor::BrkP::PrintPoint(const struct BreakPoint *p)
+{
+  const char *type;
+  char range[16];
+
+  switch(p->type) {
+  case DebugAdrSpace::ExecuteAccess:
+    type = "Breakpoint";
+    break;
+  case DebugAdrSpace::WriteAccess:
+    type = "Watchpoint(write only)";
+    break;
+  case DebugAdrSpace::ReadAccess:
+    type = "Watchpoint(read only)";
+    break;
+  default:
+    type = "Watchpoint(read/write)";
+    break;
+  }
+  if (p->last > p->address) {
+    snprintf(range,sizeof(range),"$%04x-$%04x",(unsigned int)p->address,(unsigned int)p->last);
+  } else {
+    snprintf(range,sizeof(range),"$%04x",(unsigned int)p->address);
+  }
+  if (p->condition) {
+    Print("%s at %s if %s (%s, " LU " hits)\n",type,range,p->condition,
+	  (p->enabled)?("enabled"):("disabled"),p->hits);
+  } else {
+    Print("%s at %s (%s, " LU " hits)\n",type,range,
+	  (p->enabled)?("enabled"):("disabled"),p->hits);
+  }
+}
+///
+
+/// Monitor::BrkP::AddPoint
+// Parse off the optional size and condition behind the address,
+// and create a point of the given type.
+void Monitor::BrkP::AddPoint(UBYTE type)
+{
+  struct BreakPoint *p;
+  const char *cond;
+  char buffer[256];
+  LONG value;
+  int size;
+  ADR last;
+
+  if (GetAddress(here)) {
+    if (GetDefault(size,1,1,0x10000)) {
+      cond = NextToken();
+      if (LastArg()) {
+	last = here + size - 1;
+	if (last > 0xffff)
+	  last = 0xffff;
+	if (cond) {
+	  // Check the syntax of the condition now rather than on
+	  // a hit.
+	  if (strlen(cond) >= sizeof(buffer)) {
+	    Print("Condition %s is too long.\n",cond);
+	    return;
+	  }
+	  strcpy(buffer,cond);
+	  if (!monitor->EvaluateExpression(buffer,value))
+	    return;
+	}
+	for(p = Points.First();p;p = p->NextOf()) {
+	  if (p->address == here && p->last == last && p->type == type && p->condition == NULL && cond == NULL) {
+	    Print("Already %s at address : $%04x\n",
+		  (type == DebugAdrSpace::ExecuteAccess)?("breakpoint"):("watchpoint"),here);
+	    return;
+	  }
+	}
+	p = new struct BreakPoint(here,last,type,cond);
+	Points.AddTail(p);
+	Rebuild();
+	Print("Installed ");
+	PrintPoint(p);
+      }
+    }
+  }
+}
+///
+
 /// Monitor::BrkP::ToggleBreakpoint
 // Toggle the break point at the given address on/off
 void Monitor::BrkP::ToggleBreakpoint(ADR here)
 {
-  int i;
+  struct BreakPoint *p;
 
-  for(i=0;i<NumBrk;i++) {
-    if (BreakPoints[i].id >= 0 && BreakPoints[i].address == here) {
-      monitor->cpu->ClearBreakPoint(BreakPoints[i].id);
-      BreakPoints[i].id = -1;
+  for(p = Points.First();p;p = p->NextOf()) {
+    if (p->type == DebugAdrSpace::ExecuteAccess && p->address == here && p->last == here) {
+      p->Remove();
+      delete p;
+      Rebuild();
       return;
     }
   }
 
   // Here, nothing found at the address, set a breakpoint
-  for(i=0;i<NumBrk;i++) {
-    if (BreakPoints[i].id == -1) {
-      BreakPoints[i].id      = monitor->cpu->SetBreakPoint(here);
-      if (BreakPoints[i].id >= 0) {
-	monitor->cpu->EnableBreakPoint(BreakPoints[i].id);
-	BreakPoints[i].address = here;
-	BreakPoints[i].enabled = true;
-	return;
-      }
-    }
-  }
+  Points.AddTail(new struct BreakPoint(here,here,DebugAdrSpace::ExecuteAccess,NULL));
+  Rebuild();
 }
 ///
 
@@ -2969,15 +3482,15 @@ void Monitor::BrkP::ToggleBreakpoint(ADR here)
 // Set and clear breakpoints, general breakpoint logic
 void Monitor::BrkP::Apply(char e)
 {
-  int i;
-  class CPU *cpu = monitor->cpu;
-  class MMU *MMU = monitor->MMU;
+  struct BreakPoint *p,*next;
+  bool found;
   
   switch(e) {
   case '?':
-    Print("BRKP.S [addr] : set breakpoint at address\n"
-	  "BRKP.W [addr] : set write only watchpoint at address\n"
-	  "BRKP.V [addr] : set read/write watchpoint at address\n"
+    Print("BRKP.S [addr [size [cond]]] : set breakpoint at address\n"
+	  "BRKP.W [addr [size [cond]]] : set write only watchpoint at address\n"
+	  "BRKP.R [addr [size [cond]]] : set read only watchpoint at address\n"
+	  "BRKP.V [addr [size [cond]]] : set read/write watchpoint at address\n"
 	  "BRKP.C [addr] : clear breakpoint at address\n"
 	  "BRKP.D [addr] : disable breakpoint at address\n"
 	  "BRKP.E [addr] : enable breakpoint at address\n"
@@ -2985,172 +3498,69 @@ void Monitor::BrkP::Apply(char e)
 	  "BRKP.L        : list all breakpoints\n");
     return;
   case 'S':
-    if (GetAddress(here)) {
-      if (LastArg()) {
-	for(i=0;i<NumBrk;i++) {
-	  if (BreakPoints[i].id >= 0 && BreakPoints[i].address == here) {
-	    Print("Already breakpoint at address : $%04x\n",here);
-	    return;
-	  }
-	}
-	for(i=0;i<NumBrk;i++) {
-	  if (BreakPoints[i].id == -1) {
-	    BreakPoints[i].id      = cpu->SetBreakPoint(here);
-	    if (BreakPoints[i].id >= 0) {
-	      cpu->EnableBreakPoint(BreakPoints[i].id);
-	      BreakPoints[i].address = here;
-	      BreakPoints[i].enabled = true;
-	      Print("Installed breakpoint at address : $%04x\n",here);
-	      return;
-	    }
-	  }
-	}
-	Print("All breakpoint slots occupied.\n");
-      }
-    }
+    AddPoint(DebugAdrSpace::ExecuteAccess);
     break;  
   case 'W':
+    AddPoint(DebugAdrSpace::WriteAccess);
+    break;
+  case 'R':
+    AddPoint(DebugAdrSpace::ReadAccess);
+    break;
   case 'V':
-    if (GetAddress(here)) {
-      if (LastArg()) {
-	for(i=0;i<NumBrk;i++) {
-	  if (WatchPoints[i].id >= 0 && WatchPoints[i].address == here) {
-	    Print("Already watchpoint at address : $%04x\n",here);
-	    return;
-	  }
-	}
-	for(i=0;i<NumBrk;i++) {
-	  if (WatchPoints[i].id == -1) {
-	    WatchPoints[i].id = MMU->DebugRAM()->SetWatchPoint(here,e == 'V');
-	    if (WatchPoints[i].id >= 0) {
-	      cpu->EnableWatchPoints();
-	      WatchPoints[i].address = here;
-	      WatchPoints[i].enabled = true;
-	      WatchPoints[i].read    = (e == 'V');
-	      Print("Installed watchpoint at address : $%04x\n",here);
-	      return;
-	    }
-	  }
-	}
-	Print("All watchpoint slots occupied.\n");
-      }
-    }
+    AddPoint(DebugAdrSpace::ReadAccess | DebugAdrSpace::WriteAccess);
     break;
   case 'C':
-    if (GetAddress(here)) {
-      if (LastArg()) {
-	for(i=0;i<NumBrk;i++) {
-	  if (BreakPoints[i].id >= 0 && BreakPoints[i].address == here) {
-	    cpu->ClearBreakPoint(BreakPoints[i].id);
-	    BreakPoints[i].id = -1;
-	    Print("Removed breakpoint at address : $%04x\n",here);
-	    return;
-	  }
-	  if (WatchPoints[i].id >= 0 && WatchPoints[i].address == here) {
-	    if (WatchPoints[i].enabled)
-	      MMU->DebugRAM()->RemoveWatchPointByIndex(WatchPoints[i].id);
-	    WatchPoints[i].id = -1;
-	    Print("Removed watchpoint at address : $%04x\n",here);
-	    if (MMU->DebugRAM()->WatchesEnabled()) {
-	      cpu->DisableWatchPoints();
-	    }
-	    return;
-	  }
-	}
-	Print("No breakpoint or watchpoint at address : $%04x\n",here);
-      }
-    }
-    break;
   case 'D':
-    if (GetAddress(here)) {
-      if (LastArg()) {
-	for(i=0;i<NumBrk;i++) {
-	  if (BreakPoints[i].id >= 0 && BreakPoints[i].address == here) {
-	    cpu->DisableBreakPoint(BreakPoints[i].id);
-	    BreakPoints[i].enabled = false;
-	    Print("Disabled breakpoint at address : $%04x\n",here);
-	    return;
-	  }
-	}
-	for(i=0;i<NumBrk;i++) {
-	  if (WatchPoints[i].id >= 0 && WatchPoints[i].address == here) {
-	    MMU->DebugRAM()->RemoveWatchPointByIndex(WatchPoints[i].id);
-	    WatchPoints[i].enabled = false;
-	    if (MMU->DebugRAM()->WatchesEnabled()) {
-	      cpu->DisableWatchPoints();
-	    }
-	    Print("Disabled watchpoint at address : $%04x\n",here);
-	    return;
-	  }
-	}
-	Print("No breakpoint or watchpoint at address : $%04x\n",here);
-      }
-    }
-    break;
   case 'E':
     if (GetAddress(here)) {
       if (LastArg()) {
-	for(i=0;i<NumBrk;i++) {
-	  if (BreakPoints[i].id >= 0 && BreakPoints[i].address == here) {
-	    cpu->EnableBreakPoint(BreakPoints[i].id);
-	    BreakPoints[i].enabled = true;
-	    Print("Enabled breakpoint at address : $%04x\n",here);
-	    return;
-	  }
-	}	
-	for(i=0;i<NumBrk;i++) {
-	  if (WatchPoints[i].id >= 0 && WatchPoints[i].address == here) {
-	    WatchPoints[i].id = MMU->DebugRAM()->SetWatchPoint(here,WatchPoints[i].read);
-	    if (WatchPoints[i].id >= 0) {
-	      cpu->EnableWatchPoints();
-	      WatchPoints[i].address = here;
-	      WatchPoints[i].enabled = true;
-	      Print("Enabled watchpoint at address : $%04x\n",here);
-	      return;
-	    } else {
-	      WatchPoints[i].id = -1;
-	      return;
+	found = false;
+	for(p = Points.First();p;p = next) {
+	  next = p->NextOf();
+	  if (here >= p->address && here <= p->last) {
+	    found = true;
+	    switch(e) {
+	    case 'C':
+	      Print("Removed ");
+	      PrintPoint(p);
+	      p->Remove();
+	      delete p;
+	      break;
+	    case 'D':
+	      p->enabled = false;
+	      Print("Disabled ");
+	      PrintPoint(p);
+	      break;
+	    case 'E':
+	      p->enabled = true;
+	      Print("Enabled ");
+	      PrintPoint(p);
+	      break;
 	    }
 	  }
 	}
-	Print("No breakpoint or watchpoint at address : $%04x\n",here);
+	if (found) {
+	  Rebuild();
+	} else {
+	  Print("No breakpoint or watchpoint at address : $%04x\n",here);
+	}
       }
     }
     break;
   case 'A':
     if (LastArg()) {
-      for(i=0;i<NumBrk;i++) {
-	if (BreakPoints[i].id >= 0) {
-	  cpu->ClearBreakPoint(BreakPoints[i].id);
-	  BreakPoints[i].id = -1;
-	} 
-      }
-      for(i=0;i<NumBrk;i++) {
-	if (WatchPoints[i].id >= 0) {
-	  MMU->DebugRAM()->RemoveWatchPointByIndex(WatchPoints[i].id);
-	  WatchPoints[i].id = -1;
-	}
-      }
-      cpu->DisableWatchPoints();
+      while((p = Points.RemHead()))
+	delete p;
+      Rebuild();
       Print("All breakpoints removed.\n");
     }
     break;
   case 'L':
     if (LastArg()) {
-      for(i=0;i<NumBrk;i++) {
-	if (BreakPoints[i].id >= 0) {
-	  Print("Breakpoint at $%04x (%s)\n",
-		BreakPoints[i].address,
-		(BreakPoints[i].enabled)?("enabled"):("disabled"));
-	}
-      }
-      for(i=0;i<NumBrk;i++) {
-	if (WatchPoints[i].id >= 0) {
-	  Print("Watchpoint(%s) at $%04x (%s)\n",
-		(WatchPoints[i].read)?("read/write"):("write only"),
-		WatchPoints[i].address,
-		(WatchPoints[i].enabled)?("enabled"):("disabled"));
-	}
+      if (Points.First() == NULL)
+	Print("No breakpoints set.\n");
+      for(p = Points.First();p;p = p->NextOf()) {
+	PrintPoint(p);
       }
     }
     break;
@@ -3289,8 +3699,23 @@ void Monitor::Disk::Apply(char e)
     Print("Disk subcommands:\n"
 	  "DISK.L file addr      : load raw memory block from disk\n"
 	  "DISK.S file addr size : save raw memory block to disk\n"
+	  "DISK.C [unit]         : show drive status and sector cache statistics\n"
 	  );
     break;
+  case 'C':
+    if (GetDefault(size,1,1,4)) {
+      class Chip *chip;
+      char name[16];
+      //
+      snprintf(name,sizeof(name),"Drive.%d",size);
+      for(chip = monitor->machine->ChipChain().First();chip;chip = chip->NextOf()) {
+	if (!strcasecmp(name,chip->NameOf())) {
+	  chip->DisplayStatus(monitor);
+	  break;
+	}
+      }
+    }
+    break;
   case 'L':
     filename = NextToken();
     if (filename) {
@@ -3358,22 +3783,29 @@ void Monitor::Prof::Apply(char e)
   switch(e) {
   case '?':
     Print("Profiler subcommands:\n"
-	  "PROF.S : start profiling\n"
-	  "PROF.X : stop profiling\n"
-	  "PROF.L : list profile data\n"
-	  "PROF.C : list cumulative profiling data\n");
+	  "PROF.S      : start profiling\n"
+	  "PROF.X      : stop profiling\n"
+	  "PROF.L      : list profile data\n"
+	  "PROF.C      : list cumulative profiling data\n"
+	  "PROF.R      : list inclusive and exclusive cycles per subroutine\n"
+	  "PROF.G file : write the call graph in callgrind format\n"
+	  "PROF.F file : write the call graph as folded stacks for flame graphs\n"
+	  "PROF.T      : list calls and host time of the emulator traps while profiling\n");
     break;
   case 'S':
     if (monitor->cpu->ProfilingCountersOf()) {
       Print("Profiler is already running.\n");
     } else {
       monitor->cpu->StartProfiling();
+      monitor->machine->ResetEscapeStatistics();
+      monitor->machine->ProfileEscapes(true);
       Print("Profiling enabled.\n");
     }
     break;
   case 'X':
     if (monitor->cpu->ProfilingCountersOf()) {
       monitor->cpu->StopProfiling();
+      monitor->machine->ProfileEscapes(false);
       Print("Profiler stopped.\n");
     } else {
       Print("Profiler is not running.\n");
@@ -3391,13 +3823,8 @@ void Monitor::Prof::Apply(char e)
 	(monitor->cpu->ProfilingCountersOf()):
 	(monitor->cpu->CumulativeProfilingCountersOf());
       int lines;
-      int height  = 32;
       ADR pc      = 0;
       UQUAD total = 0;
-#ifdef USE_CURSES
-      WINDOW *window = (WINDOW *)monitor->curses->window;
-      getmaxyx(window,height,lines);
-#endif
       if (cntrs == NULL) {
 	Print("Profiler is currently not running. Please start the profiler first with\n"
 	      "PROF.S, run the program, then use PROF.L again to show collected data.\n");
@@ -3435,7 +3862,7 @@ void Monitor::Prof::Apply(char e)
 	lines = 0;
 	while(last) {
 	  const struct Symbol *target;
-	  target = Monitor::Symbol::FindSymbol(monitor->symboltable,last->pc,Symbol::Label,Symbol::PreferAbsolute);
+	  target = monitor->FindSymbol(last->pc,Symbol::Label,Symbol::PreferAbsolute);
 	  //
 	  // Print the label name if we have it, or the label.
 	  if (target) {
@@ -3446,37 +3873,8 @@ void Monitor::Prof::Apply(char e)
 		  (unsigned long)(last->count),
 		  100.0*last->count/double(total));
 	  }
-	  lines++;
-	  if (lines >= (height >> 1)) {
-	    const char *prompt = "*** Press RETURN to continue or Q to abort ***";
-	    int in = 0;
-#ifndef USE_CURSES
-	    char input[64];
-	    
-	    printf("%s",prompt);
-	    fflush(stdout);
-	    monitor->machine->RefreshDisplay();
-	    fgets(input,sizeof(input),stdin);
-	    in = input[0];
-#else
-	    monitor->Print("%s",prompt);
-	    do {
-	      in = getch();
-	    } while(in == ERR);
-	    monitor->Print("\n");
-#endif	   
-	    if (in == 'q' || in == 'Q')
-	      break;
-	    lines = 0;
-#ifdef USE_CURSES
-	    {
-	      int x,y;
-	      getyx(window,y,x);
-	      wmove(window,y-1,0);
-	      wdeleteln(window);
-	    }
-#endif
-	  }
+	  if (!NextLine(lines))
+	    break;
 	  last = last->next;
 	}
 	while((last = entries)) {
@@ -3492,7 +3890,174 @@ void Monitor::Prof::Apply(char e)
       }
     }
     break;
+  case 'R':
+    {
+      class CallProfiler *prof = monitor->cpu->CallProfilerOf();
+      struct CallProfiler::Function *functions = NULL;
+      LONG i,count;
+      int lines = 0;
+      UQUAD total;
+      //
+      if (prof == NULL) {
+	Print("Profiler is currently not running. Please start the profiler first with\n"
+	      "PROF.S, run the program, then use PROF.R again to show collected data.\n");
+	break;
+      }
+      try {
+	count = prof->CollectFunctions(functions);
+	total = prof->RootOf()->TotalCycles;
+	if (total == 0)
+	  total = 1;
+	Print("Subroutine                 Calls  Exclusive        DMA  Inclusive        DMA\n");
+	for(i = 0;i < count;i++) {
+	  const struct CallProfiler::Function *f = functions + i;
+	  const char *name = NULL;
+	  char label[32];
+	  //
+	  if (f->Entry > 0xffff) {
+	    name = "(toplevel)";
+	  } else if ((name = monitor->SymbolNameOf(f->Entry)) == NULL) {
+	    snprintf(label,sizeof(label),"%s_%04x",(f->Interrupt)?("int"):("sub"),(unsigned int)(f->Entry));
+	    name = label;
+	  }
+	  Print("%-22s %9lu %10.0f %10.0f %10.0f %10.0f (%.3f%%)\n",name,(unsigned long)(f->Calls),
+		double(f->SelfCycles - f->SelfStolen),double(f->SelfStolen),
+		double(f->TotalCycles - f->TotalStolen),double(f->TotalStolen),
+		100.0 * f->TotalCycles / double(total));
+	  if (!NextLine(lines))
+	    break;
+	}
+	delete[] functions;
+      } catch(...) {
+	delete[] functions;
+	throw;
+      }
+    }
+    break;
+  case 'T':
+    {
+      class Machine *mach = monitor->machine;
+      UBYTE order[256];
+      int i,j,count = 0;
+      int lines     = 0;
+      //
+      // Collect the codes that have been run, sorted by decreasing
+      // host time. The number of codes is small, so insertion sort
+      // does.
+      for(i = 0;i < mach->EscapeCodesInUse();i++) {
+	const struct Machine::EscapeSlot &slot = mach->EscapeSlotOf(UBYTE(i));
+	if (slot.Calls == 0)
+	  continue;
+	for(j = count;j > 0 && mach->EscapeSlotOf(order[j - 1]).Micros < slot.Micros;j--) {
+	  order[j] = order[j - 1];
+	}
+	order[j] = UBYTE(i);
+	count++;
+      }
+      if (count == 0) {
+	Print("No emulator traps have been run while profiling. Traps are only\n"
+	      "counted and timed between PROF.S and PROF.X.\n");
+	break;
+      }
+      Print("Code Location                   Calls    Time/us   us/call\n");
+      for(i = 0;i < count;i++) {
+	const struct Machine::EscapeSlot &slot = mach->EscapeSlotOf(order[i]);
+	const char *name = monitor->SymbolNameOf(slot.Location);
+	char label[32];
+	//
+	if (name == NULL) {
+	  snprintf(label,sizeof(label),"%04x",(unsigned int)(slot.Location));
+	  name = label;
+	}
+	Print("%02x   %-22s %10lu %10.0f %9.2f\n",(unsigned int)(order[i]),name,
+	      (unsigned long)(slot.Calls),double(slot.Micros),
+	      double(slot.Micros) / double(slot.Calls));
+	if (!NextLine(lines))
+	  break;
+      }
+    }
+    break;
+  case 'G':
+  case 'F':
+    {
+      class CallProfiler *prof = monitor->cpu->CallProfilerOf();
+      const char *filename;
+      //
+      if (prof == NULL) {
+	Print("Profiler is currently not running. Please start the profiler first with\n"
+	      "PROF.S and run the program.\n");
+	break;
+      }
+      filename = NextToken();
+      if (filename) {
+	FILE *f = fopen(filename,"w");
+	if (f) {
+	  if (e == 'G') {
+	    prof->WriteCallgrind(f,monitor);
+	  } else {
+	    prof->WriteFoldedStacks(f,monitor);
+	  }
+	  if (ferror(f)) {
+	    Print("I/O error : %s\n",strerror(errno));
+	  }
+	  fclose(f);
+	} else {
+	  Print("I/O error : %s\n",strerror(errno));
+	}
+      } else {
+	Print("file name argument missing.\n");
+      }
+    }
+    break;
+  default:
+    ExtInvalid();
+  }
+}
+///
+
+/// Monitor::Prof::NextLine
+// Count a printed line and wait for the user to confirm the next page
+// if the screen is full. Returns false if the user wants to abort.
+bool Monitor::Prof::NextLine(int &lines)
+{
+  int height = 32;
+#ifdef USE_CURSES
+  WINDOW *window = (WINDOW *)monitor->curses->window;
+  int width;
+  getmaxyx(window,height,width);
+#endif
+  lines++;
+  if (lines >= (height >> 1)) {
+    const char *prompt = "*** Press RETURN to continue or Q to abort ***";
+    int in = 0;
+#ifndef USE_CURSES
+    char input[64];
+    
+    printf("%s",prompt);
+    fflush(stdout);
+    monitor->machine->RefreshDisplay();
+    fgets(input,sizeof(input),stdin);
+    in = input[0];
+#else
+    monitor->Print("%s",prompt);
+    do {
+      in = getch();
+    } while(in == ERR);
+    monitor->Print("\n");
+#endif	   
+    if (in == 'q' || in == 'Q')
+      return false;
+    lines = 0;
+#ifdef USE_CURSES
+    {
+      int x,y;
+      getyx(window,y,x);
+      wmove(window,y-1,0);
+      wdeleteln(window);
+    }
+#endif
   }
+  return true;
 }
 ///
 
@@ -3593,6 +4158,8 @@ void Monitor::MainLoop(bool title)
 	  "F10: Step Over                        (NEXT)\n"
 	  "F11: Step                             (STEP)\n\n");
 #endif
+  // Break points might have triggered due to an invalid condition.
+  BrkP.ReportFailures();
   do {
     Splt.UpdateSplit();
     token = ReadLine("Monitor > ");
@@ -3715,9 +4282,9 @@ void Monitor::EnterMonitor(void)
 ///
 
 /// Monitor::CapturedBreakPoint
-// Enter the monitor because we detected a breakpoint. Arguments
-// are the breakpoint number and the PC
-void Monitor::CapturedBreakPoint(int,ADR pc)
+// Enter the monitor because we detected a breakpoint. Argument
+// is the PC
+void Monitor::CapturedBreakPoint(ADR pc)
 {
 #ifdef MUST_OPEN_CONSOLE
   machine->Display()->SwitchScreen(false);
@@ -3745,8 +4312,8 @@ void Monitor::CapturedBreakPoint(int,ADR pc)
 
 /// Monitor::CapturedWatchPoint
 // Enter the monitor because we detected a watchpoint. Arguments
-// are the watchpoint number and the address
-void Monitor::CapturedWatchPoint(int,ADR mem)
+// are the watched address and the PC of the accessing instruction
+void Monitor::CapturedWatchPoint(ADR mem,ADR pc)
 {
 #ifdef MUST_OPEN_CONSOLE
   machine->Display()->SwitchScreen(false);
@@ -3759,7 +4326,7 @@ void Monitor::CapturedWatchPoint(int,ADR mem)
     if (!Step.MainLoop())
       MainLoop();
   } else {
-    Print("\nWatchpoint hit at $%04x.\n",mem);
+    Print("\nWatchpoint at $%04x hit at $%04x.\n",mem,pc);
     MainLoop();
   }
   curses = NULL;
@@ -3790,6 +4357,45 @@ void Monitor::CapturedTrace(ADR)
 	    cpu->A(),cpu->X(),cpu->Y(),cpu->S(),cpu->P(),pstring,cpu->CurrentXPos(),
 	    machine->Antic()->CurrentYPos());
   }
+  //
+  // The binary trace only records the instruction, disassembly
+  // is left to ENVI.D.
+  if (binarytrace) {
+    struct BinaryTrace::Record rec;
+    int i;
+    
+    rec.PC   = cpu->PC();
+    rec.Size = UBYTE(UnAs.InstructionSize(cpuspace->ReadByte(rec.PC)));
+    for(i = 0;i < rec.Size;i++) {
+      rec.Bytes[i] = cpuspace->ReadByte((rec.PC + i) & 0xffff);
+    }
+    rec.A    = cpu->A();
+    rec.X    = cpu->X();
+    rec.Y    = cpu->Y();
+    rec.S    = cpu->S();
+    rec.P    = cpu->P();
+    rec.XPos = cpu->CurrentXPos();
+    rec.YPos = machine->Antic()->CurrentYPos();
+    try {
+      binarytrace->Write(rec);
+    } catch(const AtariException &) {
+      class BinaryTrace *trace = binarytrace;
+      int error = errno;
+      //
+      // Do not unwind the emulation from here, just stop
+      // tracing and let the user know.
+      binarytrace = NULL;
+      if (tracefile == NULL && !fetchtrace)
+	cpu->DisableTrace();
+      try {
+	trace->Close();
+      } catch(const AtariException &) {
+	// The first error is the one to report.
+      }
+      delete trace;
+      machine->PutWarning("Binary tracing disabled, I/O error : %s\n",strerror(error));
+    }
+  }
   
   if (fetchtrace) {
 #ifdef MUST_OPEN_CONSOLE
@@ -3801,7 +4407,7 @@ void Monitor::CapturedTrace(ADR)
     
     curses = &win;
     
-    if (tracefile == NULL)
+    if (tracefile == NULL && binarytrace == NULL)
       cpu->DisableTrace();
     fetchtrace = false;
     cpu->DisableStack(); 
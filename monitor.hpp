@@ -20,6 +20,10 @@
 #include <stdarg.h>
 ///
 
+/// Forwards
+struct Instruction;
+///
+
 /// Class Monitor
 // This class implements the built-in monitor for the
 // Atari++ emulator.
@@ -37,12 +41,18 @@ class Monitor {
   // The log file for the output tracing, if possible.
   FILE           *tracefile;
   //
+  // The binary trace, if enabled.
+  class BinaryTrace *binarytrace;
+  //
   // Symbol database for symbolic debugging.
   struct Symbol {
     //
     // The next symbol.
     struct Symbol *next;
     //
+    // The next symbol with the same hash value of the name.
+    struct Symbol *hashnext;
+    //
     // The type of the symbol
     enum Type {
       Equate,      // a symbolic equate
@@ -75,28 +85,36 @@ class Monitor {
     // a successful parse.
     bool ParseLabel(char *line);
     //
-    // Find a label by its address, size and type.
-    static const struct Symbol *FindSymbol(const struct Symbol *list,
-					   UWORD address,Type t,Size s);
-    //
-    // Find a label by its name. Try to find the symbol that is closest
-    // to the given PC value.
-    static const struct Symbol *FindSymbol(const struct Symbol *list,
-					   const char *name,UWORD pc,Type t,Size s);
+    // Return how well this label matches the given type and size,
+    // or a negative number if it does not match at all.
+    int ScoreFor(Type t,Size s) const;
     //
     // Construct an empty label.
     Symbol(void)
-    : next(NULL)
+    : next(NULL), hashnext(NULL)
     { }
     //
     // Copy a label from another label.
     Symbol(const Symbol &o)
-    : next(NULL), type(o.type), size(o.size), value(o.value)
+    : next(NULL), hashnext(NULL), type(o.type), size(o.size), value(o.value)
     {
       memcpy(name,o.name,sizeof(name));
     }
   }              *symboltable;
   //
+  // The index of the symbol table: All symbols sorted by their value
+  // for the lookup by address, and a hash table for the lookup by name.
+  struct Symbol **symbolindex;
+  LONG            symbolcount;
+  //
+  enum {
+    SymbolHashSize = 1024
+  };
+  struct Symbol  *symbolhash[SymbolHashSize];
+  //
+  // Incremented each time the symbol table changes.
+  ULONG           symbolgeneration;
+  //
   //
   // curses output window
   struct CursesWindow {
@@ -122,6 +140,10 @@ class Monitor {
   // the monitor.
   bool            fetchtrace;
   //
+  // If set, errors of the expression evaluator are not printed. This
+  // is the case while the emulator runs and no output is available.
+  bool            quiet;
+  //
   // Definition of the command history buffer. This is a doubly linked list of the following
   // nodes
   struct HistoryLine : public Node<HistoryLine> {
@@ -182,12 +204,28 @@ class Monitor {
   // Fill a buffer with the CPU flags in readable form
   void CPUFlags(char pstring[9]) const;
   //
+  // Ditto, for the given flags.
+  static void CPUFlags(UBYTE flags,char pstring[9]);
+  //
   // Clear the symbol table.
   void ClearSymbolTable(void);
   //
   // Read a symbol table from a file.
   bool ParseSymbolTable(const char *filename);
   //
+  // Sort the symbols by their value for the lookup by address.
+  void BuildSymbolIndex(void);
+  //
+  // Compute the hash value of a symbol name.
+  static int SymbolHashOf(const char *name);
+  //
+  // Find a label by its address, size and type.
+  const struct Symbol *FindSymbol(UWORD address,Symbol::Type t,Symbol::Size s) const;
+  //
+  // Find a label by its name. Try to find the symbol that is closest
+  // to the given PC value.
+  const struct Symbol *FindSymbol(const char *name,UWORD pc,Symbol::Type t,Symbol::Size s) const;
+  //
   // Add a command to the command chain
   struct Command* &CommandChain(void);
   //
@@ -195,7 +233,7 @@ class Monitor {
   void MainLoop(bool title = true);
   //
   // Expression evaluator methods (private)
-  bool EvaluateExpression(char *s,LONG &val);
+  bool EvaluateExpression(char *s,LONG &val,bool silent = false);
   LONG EvaluateLogical(char *&s);
   LONG EvaluateCompare(char *&s);
   LONG EvaluatePlusMinus(char *&s);
@@ -304,6 +342,9 @@ class Monitor {
   // The Environment settings command
   struct Envi : public Command {
     Envi(class Monitor *mon,const char *lng,const char *shr,const char *helper);
+    //
+    // Disassemble a binary trace into a text file.
+    void DecodeTrace(const char *tracename,const char *filename,ADR from,ADR to);
     void Apply(char e);
   } Envi;
   friend struct Envi;
@@ -434,12 +475,32 @@ class Monitor {
   private:
     int  lines;
     //
+    // The cache of disassembled instructions, one line for each
+    // address within a page. A line is only valid as long as the
+    // instruction bytes, the index registers, the instruction set
+    // and the symbol table did not change.
+    struct CacheLine {
+      const struct Instruction *Ins;  // the instruction, NULL if invalid
+      ULONG                     Generation; // of the symbol table
+      ADR                       PC,Next;
+      UBYTE                     Bytes[3];
+      UBYTE                     X,Y;  // zero if not indexed
+      char                      Line[80];
+    }    cache[256];
+    //
+    // Disassemble an instruction without consulting the cache.
+    ADR FormatInstruction(class AdrSpace *adr,ADR where,UBYTE x,UBYTE y,char *line);
+    //
   public:
     // Get the byte size of an instruction in bytes.
     int InstructionSize(UBYTE ins);
     //
     // Disassemble a single line into a buffer, return the instruction
     ADR DisassembleLine(class AdrSpace *adr,ADR where,char *line);
+    //
+    // Ditto, but do not mark the PC and break points, and take
+    // the index registers from the arguments.
+    ADR DisassembleInstruction(class AdrSpace *adr,ADR where,UBYTE x,UBYTE y,char *line);
     void Apply(char e);
   } UnAs;  
   friend struct UnAs;
@@ -458,29 +519,59 @@ class Monitor {
   // Set and clear breakpoints
   struct BrkP : public Command {  
   private:
-#ifdef HAS_MEMBER_INIT
-    static const int NumBrk = 8;
-#else
-#define              NumBrk   8
-#endif
-    struct BreakPoint {
-      ADR address;
-      int id;      // its Id, as returned from the CPU interface, -1 for free
-      bool enabled;
-      bool read;   // if true, the watchpoint reacts on read also
+    //
+    // A break or watch point, covering a range of addresses. The
+    // CPU and the debug address space only see the union of all
+    // enabled points, the details are checked here on a hit.
+    struct BreakPoint : public Node<struct BreakPoint> {
+      ADR   address;   // first address
+      ADR   last;      // last address, inclusive
+      UBYTE type;      // access types, see DebugAdrSpace::AccessType
+      bool  enabled;
+      char *condition; // an expression that must be true to break, or NULL
+      ULONG hits;      // number of times the point triggered
+      bool  failed;    // set if the condition could not be evaluated
       //
-      BreakPoint(void)
-	: address(0), id(-1), enabled(true)
-      { }
-    } BreakPoints[NumBrk],WatchPoints[NumBrk];
+      BreakPoint(ADR from,ADR to,UBYTE t,const char *cond);
+      ~BreakPoint(void)
+      {
+	delete[] condition;
+      }
+    };
+    //
+    // All break and watch points, in the order they were created.
+    List<struct BreakPoint> Points;
+    //
+    // Install the union of all enabled points into the CPU and the
+    // debug address space.
+    void Rebuild(void);
+    //
+    // Parse off the optional size and condition behind the address,
+    // and create a point of the given type.
+    void AddPoint(UBYTE type);
+    //
+    // Print a point.
+    void PrintPoint(const struct BreakPoint *p);
     //
   public:
     BrkP(class Monitor *mon,const char *lng,const char *shr,const char *helper);
+    ~BrkP(void);
     //
     void Apply(char e);
     //
     // Toggle breakpoint at the indicated address on/off.
     void ToggleBreakpoint(ADR brk);
+    //
+    // Check whether an access of the given type to the given address
+    // triggers, i.e. an enabled point covers it and its condition, if
+    // any, is true. Conditions are evaluated silently as this runs
+    // within the emulation, a condition that cannot be evaluated
+    // triggers.
+    bool Triggered(ADR adr,UBYTE type);
+    //
+    // Report the points whose condition could not be evaluated since
+    // the monitor was entered last.
+    void ReportFailures(void);
   } BrkP; 
   friend struct BrkP;
   //
@@ -561,6 +652,9 @@ class Monitor {
   // The profiling command.
   struct Prof : public Command {
     Prof(class Monitor *mon,const char *lng,const char *shr,const char *helper);
+    // Count a printed line and wait for the user to confirm the
+    // next page if required. Returns false on abort.
+    bool NextLine(int &lines);
   public:
     void Apply(char e);
   } Prof;
@@ -596,15 +690,26 @@ public:
   // Enter the monitor because we found a JAM opcode that is not
   // an ESC opcode
   void Jam(UBYTE opcode);
-  // Enter the monitor because we detected a breakpoint. Arguments
-  // are the breakpoint number and the PC
-  void CapturedBreakPoint(int i,ADR pc);
+  // Check whether a break or watch point of the given access type
+  // at the given address triggers, i.e. whether its condition holds.
+  bool TestBreakPoint(ADR adr,UBYTE type)
+  {
+    return BrkP.Triggered(adr,type);
+  }
+  // Enter the monitor because we detected a breakpoint. Argument
+  // is the PC
+  void CapturedBreakPoint(ADR pc);
   // Enter the monitor because we detected a memory watch point.
-  // Arguments are the breakpoint number and the address.
-  void CapturedWatchPoint(int i,ADR mem);
+  // Arguments are the watched address and the PC of the instruction
+  // that accessed it.
+  void CapturedWatchPoint(ADR mem,ADR pc);
   // Enter the monitor because of software tracing. Argument is the
   // current PC
   void CapturedTrace(ADR pc);
+  //
+  // Return the name of the label at the given address, or NULL if
+  // there is none.
+  const char *SymbolNameOf(ADR address);
 };
 ///
 
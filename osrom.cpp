@@ -21,9 +21,11 @@
 #include "rdevice.hpp"
 #include "mathpackpatch.hpp"
 #include "romxlchecksum.hpp"
+#include "hlepatch.hpp"
 #include "exceptions.hpp"
 #include "osdist.hpp"
 #include "mmu.hpp"
+#include "romimage.hpp"
 #include "new.hpp"
 #include "stdio.hpp"
 ///
@@ -35,6 +37,8 @@ OsROM::OsROM(class Machine *mach)
   cpu        = NULL;
   cpuram     = NULL;
   devices    = NULL;
+  hle        = NULL;
+  image      = NULL;
 
   siopatch   = true;
   ppatch     = true;
@@ -43,6 +47,10 @@ OsROM::OsROM(class Machine *mach)
   rpatch     = false;
   hAsd       = false;
   mppatch    = false;
+  mp_type    = Math_Host;
+  hlememclear    = false;
+  hlescreenclear = false;
+  hlescroll      = false;
 
   osapath    = NULL;
   osbpath    = NULL;
@@ -62,6 +70,7 @@ OsROM::OsROM(class Machine *mach)
 OsROM::~OsROM(void)
 {
   PatchProvider::DisposePatches();
+  ReleaseImage();
   
   delete[] osapath;
   delete[] osbpath;
@@ -86,6 +95,17 @@ int OsROM::LoadFromFile(const char *path,int pages)
 
   fp = fopen(path,"rb");
   if (fp) {
+    // Try to map the image first such that the pages are shared with
+    // all other processes using the same ROM. Otherwise, read it.
+    image = new class RomImage;
+    if (image->Map(fp,ULONG(pages) << 8)) {
+      int i;
+      for(i = 0;i < pages;i++)
+	rom[i].SetImage(image->PageOf(i));
+      fclose(fp);
+      return 0;
+    }
+    ReleaseImage();
     do {
       if (!page->ReadFromFile(fp))
 	break;
@@ -99,6 +119,19 @@ int OsROM::LoadFromFile(const char *path,int pages)
 }
 ///
 
+/// OsROM::ReleaseImage
+// Release the mapped ROM image, let the pages use their own storage.
+void OsROM::ReleaseImage(void)
+{
+  int i;
+  //
+  for(i = 0;i < 64;i++)
+    rom[i].SetImage(NULL);
+  delete image;
+  image = NULL;
+}
+///
+
 /// OsRom::CheckRomFile
 // Check the given OS rom, must contain the given number of pages.
 // Throws on error.
@@ -247,6 +280,9 @@ void OsROM::LoadROM(void)
   int error; 
   OsType type = RomType();
 
+  // Patches of the previous run went into the old image, hence
+  // always start from a fresh one.
+  ReleaseImage();
   switch(type) {
   case Os_RomA:
     // Ok, try to load the OsA ROM.
@@ -326,6 +362,7 @@ void OsROM::LoadROM(void)
 void OsROM::Initialize(void)
 {
   devices = NULL; // The old one is part of the patch list and thus now gone.
+  hle     = NULL; // ditto.
   DisposePatches();
   LoadROM();
 
@@ -357,8 +394,32 @@ void OsROM::Initialize(void)
       new class EDevice(machine,this,'K');
     }
 
-    if (mppatch)
-      new class MathPackPatch(machine,this);
+    if (mppatch) {
+      bool bcd = (mp_type == Math_BCD);
+      //
+      // The BCD arithmetic follows the math pack of the built-in Os.
+      // The math packs of the other ROMs differ in details.
+      if (bcd && RomType() != Os_Builtin) {
+	machine->PutWarning("The BCD math pack patch requires the built-in Os ROM.\n"
+			    "The math pack patch computes in host floating point instead.\n");
+	bcd = false;
+      }
+      new class MathPackPatch(machine,this,bcd);
+    }
+    //
+    // The high-level emulation of Os routines. This finds the
+    // entry points from the unpatched ROM, which is still unpatched
+    // at this time as patches only go in below.
+    if (hlememclear || hlescreenclear || hlescroll) {
+      UBYTE traps = 0;
+      if (hlememclear)
+	traps |= HLEPatch::MemoryClearTrap;
+      if (hlescreenclear)
+	traps |= HLEPatch::ScreenClearTrap;
+      if (hlescroll)
+	traps |= HLEPatch::ScrollTrap;
+      hle = new class HLEPatch(machine,this,traps);
+    }
     //
     // We must adjust the checksum in case:
     // a) we installed any patch and there is a rom checksum 
@@ -366,7 +427,7 @@ void OsROM::Initialize(void)
     // b) the Rom is the built-in ROM that requires the patch without
     // asking for it.
     if (RomType() == Os_Builtin || 
-	((siopatch || ppatch || hpatch || epatch || rpatch || mppatch) && 
+	((siopatch || ppatch || hpatch || epatch || rpatch || mppatch || hle) && 
 	 (RomType() == Os_RomXL || RomType() == Os_Builtin || RomType() == Os_Rom1200)))
       new class RomXLChecksum(machine,this);
     
@@ -409,6 +470,14 @@ void OsROM::ParseArgs(class ArgParser *args)
       {"BuiltIn",Os_Builtin},
       {NULL    ,0}
     };
+#if HAVE_MATH
+  static const struct ArgParser::SelectionVector mathtypevector[] = 
+    { {"Host"   ,Math_Host },
+      {"BCD"    ,Math_BCD  },
+      {NULL    ,0}
+    };
+  LONG mathtype   = mp_type;
+#endif
   LONG ostype;
   bool oldspatch  = siopatch;
   bool oldppatch  = ppatch;
@@ -417,6 +486,10 @@ void OsROM::ParseArgs(class ArgParser *args)
   bool oldrpatch  = rpatch;
   bool oldhasd    = hAsd;
   bool oldmppatch = mppatch;
+  MathType oldmptype = mp_type;
+  bool oldmemclear    = hlememclear;
+  bool oldscreenclear = hlescreenclear;
+  bool oldscroll      = hlescroll;
   
   ostype = os_type;
   args->DefineTitle("OsROM");
@@ -447,7 +520,13 @@ void OsROM::ParseArgs(class ArgParser *args)
     args->DefineBool("InstallHAsDisk","install host handler as D: device",hAsd); 
 #if HAVE_MATH
     args->DefineBool("InstallMathPatch","install fast math pack patch",mppatch);
+    args->DefineSelection("MathPatchType","arithmetic of the math pack patch",
+			  mathtypevector,mathtype);
+    mp_type = (MathType)mathtype;
 #endif
+    args->DefineBool("HLEMemoryClear","run the coldstart memory test natively",hlememclear);
+    args->DefineBool("HLEScreenClear","clear the screen natively",hlescreenclear);
+    args->DefineBool("HLEScroll","scroll the screen natively",hlescroll);
 
     // Fix up the HDevice directories a bit.
     for(i=0;i<4;i++) {
@@ -472,7 +551,11 @@ void OsROM::ParseArgs(class ArgParser *args)
       oldepatch  != epatch                 ||
       oldrpatch  != rpatch                 ||
       oldhasd    != hAsd                   ||
-      oldmppatch != mppatch) {
+      oldmppatch != mppatch                ||
+      oldmptype  != mp_type                ||
+      oldmemclear    != hlememclear        ||
+      oldscreenclear != hlescreenclear     ||
+      oldscroll      != hlescroll) {
     args->SignalBigChange(ArgParser::ColdStart);
   }
   os_type = (OsROM::OsType)ostype;
@@ -559,6 +642,9 @@ void OsROM::DisplayStatus(class Monitor *mon)
 		   "\tInstallPDevice: %s\tInstallHDevice: %s"
 		   "\tInstallEDevice: %s\tInstallRDevice: %s\n"
 		   "\tInstallHAsDHandler: %s\tMathPackPatch: %s\n"
+		   "\tMathPatchType : %s\n"
+		   "\tHLEMemoryClear: %s\tHLEScreenClear: %s\tHLEScroll: %s\n"
+		   "\tHLE entries   : %s\n"
 		   "\tOsType        : %s\n"
 		   "\tOsAPath       : %s\n"
 		   "\tOsBPath       : %s\n"
@@ -575,6 +661,11 @@ void OsROM::DisplayStatus(class Monitor *mon)
 		   (rpatch)?("on"):("off"),
 		   (hAsd)?("on"):("off"),
 		   (mppatch)?("on"):("off"),
+		   (mp_type == Math_BCD)?("BCD"):("Host"),
+		   (hlememclear)?("on"):("off"),
+		   (hlescreenclear)?("on"):("off"),
+		   (hlescroll)?("on"):("off"),
+		   (hle)?((hle->RomName())?(hle->RomName()):("unknown ROM")):("(none)"),
 		   osname,
 		   (osapath)?(osapath):("(none)"),
 		   (osbpath)?(osbpath):("(none)"),
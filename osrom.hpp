@@ -24,6 +24,8 @@ class Monitor;
 class ArgParser;
 class HDevice;
 class DeviceAdapter;
+class HLEPatch;
+class RomImage;
 ///
 
 /// Class OsROM
@@ -42,17 +44,27 @@ public:
     Os_5200               // the 5200 ROM
   };
   //
+  // Arithmetic of the math pack patch
+  enum MathType {
+    Math_Host,            // host floating point, fast but rounds differently
+    Math_BCD              // native BCD, exactly as the built-in Os
+  };
+  //
   // Links to other Os resources needed.
   class CPU            *cpu;
   class MMU            *mmu;
   class AdrSpace       *cpuram;
   class DeviceAdapter  *devices;
+  class HLEPatch       *hle;
   //
   OsType                os_type;  // the type of Os to use
   //
   // The Os ROM pages we administrate. 32 for OsA,B, 64 for Os XL
   class RomPage         rom[64];
   //
+  // The mapped ROM image file the above pages use, if any.
+  class RomImage       *image;
+  //
   // Settings for this class:
   bool                  siopatch; // install SIO/DISKINTERFpatch?
   bool                  ppatch;   // install P: replacement
@@ -61,6 +73,10 @@ public:
   bool                  rpatch;   // install R: replacement
   bool                  hAsd;     // install H: as D: handler
   bool                  mppatch;  // install math pack patch?
+  MathType              mp_type;  // arithmetic of the math pack patch
+  bool                  hlememclear; // native memory test on coldstart?
+  bool                  hlescreenclear; // native screen clear?
+  bool                  hlescroll; // native screen scrolling?
   //
   // names of the ROM image
   char                 *osapath;
@@ -74,6 +90,8 @@ public:
   //
   // private: Load the Os ROM.
   void LoadROM(void);
+  // Release the mapped ROM image, let the pages use their own storage.
+  void ReleaseImage(void);
   // Load one or several pages from a file into the Os ROM
   int LoadFromFile(const char *path,int pages);
   // Special service for the built-in ROM: Patch the ROM contents
@@ -33,7 +33,7 @@
 HQSound::HQSound(class Machine *mach)
   : Sound(mach), DspName(new char[9]), SoundStream(-1),
     FragSize(8), NumFrags(16),
-    BufferedSamples(0), ForceStereo(false), UpdateBuffer(false), UpdateSamples(0)
+    ForceStereo(false), UpdateBuffer(false), UpdateSamples(0)
 {
   strcpy(DspName,"/dev/dsp");
 }
@@ -53,24 +53,14 @@ HQSound::~HQSound(void)
 }
 ///
 
-/// HQSound::GenerateSamples
-// Generate the given number (not in bytes, but in number) of audio samples
-// and place them into the tail of the ready buffer list.
-void HQSound::GenerateSamples(ULONG numsamples)
-{	
-  // Let the parent class do the job
-  BufferedSamples += Sound::GenerateSamples(numsamples,FragSamples);
-}
-///
-
 /// HQSound::FeedDevice
-// Feed data into the dsp device by taking buffered bytes from the queue
-// and removing the sample buffers, putting them back into the free list.
-// This returns false on a buffer underrun
+// Feed data into the dsp device by taking buffered samples from the
+// ring buffer. This returns false on a buffer underrun
 bool HQSound::FeedDevice(class Timer *delay)
 {
 #ifdef USE_SOUND
-  struct AudioBufferBase *ab;
+  const UBYTE *samples;
+  ULONG count;
   bool ready;
   
   if (delay) {
@@ -82,31 +72,25 @@ bool HQSound::FeedDevice(class Timer *delay)
     ready = Timer::CheckIO(SoundStream);
   }
   if (ready) {
-    // The device is ready to take more samples. Hence, pull them from the ready queue
-    ab = ReadyBuffers.RemHead();
-    if (ab) {
-      // Yes, we have a valid buffer here. Hence, play it.
-      errno = 0;
-      if (write(SoundStream,ab->ReadPtr,ab->ReadyBytes()) == -1) {
+    // The device is ready to take more samples. Hence, pull them from the ring buffer.
+    samples = Ring.NextSamples(count);
+    if (count) {
+      ssize_t written;
+      // Yes, we have samples here. Hence, play them.
+      errno   = 0;
+      written = write(SoundStream,samples,count << Ring.SampleShiftOf());
+      if (written == -1) {
 	if (errno != EAGAIN) {      
-	  // Put it back into the free list immediately to be able to release the buffer
-	  // after the throw.
-	  FreeBuffers.AddTail(ab);
 	  // Abort if there has been an error. Abort if so.
 	  ThrowIo("HQSound::FeedDevice","Writing samples to the audio stream failed.");
 	  EnableSound = false;
-	} else {
-	  // Otherwise, ignore the write and put the sample buffer back
-	  // where it came from. EAGAIN indicates that we cannot currently
-	  // write into the device without blocking. select() should have ensured
-	  // this, but it doesn't.
-	  ReadyBuffers.AddHead(ab);
 	}
+	// Otherwise, ignore the write and keep the samples in the buffer.
+	// EAGAIN indicates that we cannot currently write into the device
+	// without blocking. select() should have ensured this, but it doesn't.
       } else {
-	// This buffer is used up. Cound the number of collected samples down, then release
-	// the buffer.
-	BufferedSamples -= ab->ReadySamples();
-	FreeBuffers.AddTail(ab);
+	// Remove the samples the device took from the buffer.
+	Ring.ConsumeSamples(ULONG(written) >> Ring.SampleShiftOf());
       }
       return true;
     }
@@ -150,7 +134,6 @@ void HQSound::WarmStart(void)
   //
   // Dispose the old buffers now.
   CleanBuffer();
-  BufferedSamples    = 0;
 }
 ///
 
@@ -299,12 +282,16 @@ bool HQSound::InitializeDsp(void)
     ThrowIo("HQSound::InitializeDsp","Cannot figure out the active buffer size");
   };
   //
-  // Setup the effective buffering frequency.
-  EffectiveFreq   = SamplingFreq;
+  // Setup the latency control: Keep the buffer half filled.
+  ResetRateControl((ULONG(NumFrags) * FragSamples) >> 1);
   CycleCarry      = 0;
   UpdateBuffer    = false;
   UpdateSamples   = 0;
   //
+  // Allocate the ring buffer such that it can hold twice the samples
+  // the device buffers.
+  AllocateBuffer(ULONG(NumFrags) * FragSamples * 2);
+  //
   return true;
 #else
   return false;
@@ -358,26 +345,25 @@ void HQSound::UpdateSound(class Timer *delay)
     // Ok, re-feed the device. In case of underrun, generate some samples manually.
     do {
       while (!FeedDevice(delay)) {
-	// Generate one fragment of data.
+	// Generate one fragment of data. The latency control will
+	// pick up the low fill level and generate samples faster.
 	GenerateSamples(FragSamples);
-	// Note that we underrun. Adjust the effective sampling frequency accordingly.
-	AdjustUnderrun();
+	UpdateBuffer = true;
       }
       // If there is nothing to delay, bail out.
       if (delay == NULL) break;
       // Otherwise, delay until the delay time is over.
     } while(!delay->EventIsOver());
     //
-    // Now check for the number of bytes in the buffer. This should not
-    // grow endless. If it is too large, signal an overrun and adjust the
-    // frequency accordingly.
-    if (BufferedSamples > ULONG(NumFrags-2) * FragSamples) {
-      AdjustOverrun();
-    }
-    // If there is only one fragment in the buffer, signal underrun as well
-    if (delay && BufferedSamples < (FragSamples << 1)) {
-      GenerateSamples(FragSamples);
-      AdjustUnderrun();
+    // Now adjust the rate at which samples are generated to the
+    // number of samples in the buffer.
+    if (delay) {
+      ControlRate();
+      // If there is only one fragment in the buffer, refill it immediately.
+      if (Ring.ReadySamples() < (FragSamples << 1)) {
+	GenerateSamples(FragSamples);
+	UpdateBuffer = true;
+      }
     }
   } else {
     // Sound has been disabled. Just do the wait if we have to wait.
@@ -392,43 +378,6 @@ void HQSound::UpdateSound(class Timer *delay)
 }
 ///
 
-/// HQSound::AdjustOverrun
-// Signal a buffer overrun
-void HQSound::AdjustOverrun(void)
-{
-  LONG newfreq;
-  // The buffer is running too full. This means we are
-  // generating samples too fast. Reduce the sampling frequency.
-  // We must do this very carefully as overruns accumulate data
-  newfreq = (EffectiveFreq * 8191) >> 13;
-  if (newfreq >= EffectiveFreq)
-    newfreq--;
-  EffectiveFreq = newfreq;
-  // Drop buffer bytes we should have generated so far.
-  UpdateSamples = 0;
-  //printf("Overrun! Freq now=%ld\n",EffectiveFreq);
-}
-///
-
-/// HQSound::AdjustUnderrun
-// Signal a buffer underrun
-void HQSound::AdjustUnderrun(void)
-{
-  LONG newfreq;
-  // The buffer is running empty. We are generating
-  // too few samples. Enlarge the effective frequency to keep track.
-  newfreq = (EffectiveFreq << 12) / 4095;
-  if (newfreq <= EffectiveFreq)
-    newfreq++;
-  if (newfreq <= (SamplingFreq << 1))
-    EffectiveFreq = newfreq;
-  // We underrrun, or are near to underrun. We'd better update the
-  // the buffer and flush all buffered bytes to prevent the worst.
-  UpdateBuffer = true;
-  //printf("Underrun! Freq now=%ld\n",EffectiveFreq);
-}
-///
-
 /// HQSound::DisplayStatus
 // Display the status of the sound over the monitor
 void HQSound::DisplayStatus(class Monitor *mon)
@@ -455,7 +404,7 @@ void HQSound::DisplayStatus(class Monitor *mon)
 		   SamplingFreq,
 		   FragSize,
 		   NumFrags,
-		   BufferedSamples,
+		   LONG(Ring.ReadySamples()),
 		   EffectiveFreq,
 		   Stereo?("on"):("off"),
 		   Interleaved?("on"):("off"),
@@ -42,10 +42,6 @@ class HQSound : public Sound {
   //
   // Sound configuration
   //
-  // Effective output frequency. We reduce or increase this
-  // depending on whether the buffer over- or underruns.
-  LONG             EffectiveFreq;
-  //
   // frequency carry-over from last computation loop
   LONG             CycleCarry;
   // 
@@ -60,9 +56,6 @@ class HQSound : public Sound {
   // buffering and so on.
   LONG             NumFrags;
   //
-  // Total number of bytes in the output buffer
-  ULONG            BufferedSamples;
-  //
   // Enforce output in stereo, works around bugs in ALSA
   bool             ForceStereo;
   //
@@ -74,21 +67,10 @@ class HQSound : public Sound {
   // delayed the generation to reduce the overhead.
   ULONG            UpdateSamples;
   //
-  // Generate the given number (not in bytes, but in number) of audio samples
-  // and place them into the tail of the ready buffer list.
-  void GenerateSamples(ULONG numsamples);
-  //
-  // Feed data into the dsp device by taking buffered bytes from the queue
-  // and removing the sample buffers, putting them back into the free list.
-  // This returns false on a buffer underrun
+  // Feed data into the dsp device by taking buffered samples from the
+  // ring buffer. This returns false on a buffer underrun
   bool FeedDevice(class Timer *delay);
   //
-  // Signal a buffer overrun
-  void AdjustOverrun(void);
-  //
-  // Signal a buffer underrun
-  void AdjustUnderrun(void);
-  //
   // Private setup of the dsp: Initialize and
   // configure the dsp for the user specified
   // parameters. Returns false in case the dsp cannot be setup.
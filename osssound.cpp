@@ -228,11 +228,8 @@ bool OssSound::InitializeDsp(void)
   // Compute the buffer size and allocate it.
   BufferSize      = SamplingFreq / Divisor;
   //
-  // Allocate a new playing buffer with these settings.
-  delete PlayingBuffer;
-  PlayingBuffer = NULL;
-  PlayingBuffer = AudioBufferBase::NewBuffer(SignedSamples,Stereo,SixteenBit,LittleEndian,Interleaved);
-  PlayingBuffer->Realloc(BufferSize);
+  // Allocate a new ring buffer with these settings.
+  AllocateBuffer(BufferSize);
   //
   //
   return true;
@@ -263,31 +260,31 @@ void OssSound::UpdateSound(class Timer *delay)
       }
       // If the dsp is ready to take more data, feed it.
       if (dspready) {
-	int disp;
-	UBYTE offset = 0;
-	// Compute/get the console speaker.
-	if (EnableConsoleSpeaker && ConsoleSpeakerStat) {
-	  offset = ConsoleVolume;
-	}
-	// Ask pokey to compute more samples into the playing buffer.
-	PlayingBuffer->WritePtr = PlayingBuffer->Buffer;
-	LeftPokey->ComputeSamples(PlayingBuffer,BufferSize,SamplingFreq,offset);
-	// Check whether we have an interleaved buffer. If so, then we must 
-	// run the second pokey.
-	if ((disp = PlayingBuffer->ChannelOffset())) {
-	  PlayingBuffer->WritePtr  = PlayingBuffer->Buffer + disp;
-	  RightPokey->ComputeSamples(PlayingBuffer,BufferSize,SamplingFreq,offset);
-	  PlayingBuffer->WritePtr -= disp;
-	}
+	const UBYTE *samples;
+	ULONG count;
+	ssize_t written;
+	// Ask pokey to compute more samples into the ring buffer.
+	GenerateSamples(BufferSize);
 	//
 	// Write into the audio output device.
-	errno = 0;
-	if (write(SoundStream,PlayingBuffer->ReadPtr,PlayingBuffer->ReadyBytes()) == -1) {
-	  if (errno != EAGAIN) {
-	    // Abort if there has been an error. Abort if so.
-	    ThrowIo("OssSound::UpdateSound","Writing samples to the audio stream failed.");
-	    EnableSound = false;
+	for(;;) {
+	  samples = Ring.NextSamples(count);
+	  if (count == 0)
+	    break;
+	  errno   = 0;
+	  written = write(SoundStream,samples,count << Ring.SampleShiftOf());
+	  if (written == -1) {
+	    if (errno != EAGAIN) {
+	      // Abort if there has been an error. Abort if so.
+	      ThrowIo("OssSound::UpdateSound","Writing samples to the audio stream failed.");
+	      EnableSound = false;
+	    }
+	    // Drop what the device cannot take right now. The samples
+	    // would be late anyhow.
+	    Ring.Reset();
+	    break;
 	  }
+	  Ring.ConsumeSamples(ULONG(written) >> Ring.SampleShiftOf());
 	}
       }
       // Even if we could push more data, abort here if we have no timer
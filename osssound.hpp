@@ -16,7 +16,6 @@
 #include "chip.hpp"
 #include "timer.hpp"
 #include "sound.hpp"
-#include "audiobuffer.hpp"
 #if HAVE_FCNTL_H && HAVE_SYS_IOCTL_H && HAVE_SYS_SOUNDCARD_H && HAS_EAGAIN_DEFINE
 #define USE_SOUND
 #endif
@@ -34,7 +34,7 @@ void Patch::InsertESC(class AdrSpace *adr,ADR mem,UBYTE code)
 void Patch::InstallPatchList(class Machine *mach,class AdrSpace *adr)
 {   
   if (NumPatches) {
-    MinCode = mach->AllocateEscape(NumPatches);
+    MinCode = mach->AllocateEscape(NumPatches,this);
     MaxCode = UBYTE(MinCode + NumPatches - 1);
   } else {
     MinCode = MaxCode = 0xff;
@@ -44,9 +44,8 @@ void Patch::InstallPatchList(class Machine *mach,class AdrSpace *adr)
 ///
 
 /// Patch::RunEmulatorTrap
-// This is for the CPU emulator: Find a patch by an ESC code and
-// dispatch it. Call this for the first patch in a list of
-// patches. Returns true in case the patch could have been dispatched.
+// This is for the CPU emulator: Dispatch an ESC code to this patch.
+// Returns true in case the patch could have been dispatched.
 bool Patch::RunEmulatorTrap(class AdrSpace *adr,class CPU *cpu,UBYTE code)
 {
   if (NumPatches && code >= MinCode && code <= MaxCode) {
@@ -26,6 +26,9 @@ class CPU;
 // to simplify the life of the emulator. To be precise, this rather
 // describes a range of ESC codes, not just a single.
 class Patch : public Node<class Patch> {
+  //
+  // The machine the escape codes are allocated from.
+  class Machine *Machine;
   //
   // The ESCcape code range for the patch. This identifies the patch uniquely
   UBYTE        MinCode,MaxCode,NumPatches;
@@ -37,8 +40,8 @@ protected:
   // from them. You need to provide the machine to allocate the patch
   // from.
   // A free slot for the ESC code is allocated automagically.
-  Patch(class Machine *,class PatchProvider *plist,UBYTE numpatches)
-    : NumPatches(numpatches)
+  Patch(class Machine *mach,class PatchProvider *plist,UBYTE numpatches)
+    : Machine(mach), MinCode(0xff), MaxCode(0xff), NumPatches(numpatches)
   {
     // Must add patches in this order since the XL checksum patch
     // cleans up the checksum here.
@@ -62,14 +65,15 @@ public:
   {
     // Patches add themselves, so they should remove themsevles
     Remove();
+    // Ditto for their escape codes.
+    Machine->ReleaseEscape(this);
   }
   // This is for the maintainer of the patch list: Install all patches
   // in a row. Call it from the first patch at hand.
   void InstallPatchList(class Machine *mach,class AdrSpace *adr);
   //
-  // This is for the CPU emulator: Find a patch by an ESC code and
-  // dispatch it. Call this for the first patch in a list of
-  // patches. Returns true in case the patch could have been dispatched.
+  // This is for the CPU emulator: Dispatch an ESC code to this patch.
+  // Returns true in case the patch could have been dispatched.
   bool RunEmulatorTrap(class AdrSpace *adr,class CPU *cpu,UBYTE code);
   //
   // Reset this patch. This method can be overloaded if required.
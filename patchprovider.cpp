@@ -52,24 +52,6 @@ void PatchProvider::DisposePatches(void)
 }
 ///
 
-/// PatchProvider::RunEmulatorTrap
-// This is why we are here: Run all patches we and other providers
-// we are linked to know of. This must be called with the head of
-// the patch provider list.
-bool PatchProvider::RunEmulatorTrap(class AdrSpace *adr,class CPU *cpu,UBYTE code)
-{
-  class Patch *p = patchList.First();
-
-  while(p) {
-    if (p->RunEmulatorTrap(adr,cpu,code))
-      return true;
-    p = p->NextOf();
-  }
-
-  return false;
-} 
-///
-
 /// PatchProvider::Reset
 // Reset all patches. This is called on a warmstart or coldstart.
 void PatchProvider::Reset(void)
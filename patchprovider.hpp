@@ -56,11 +56,6 @@ protected:
   void Reset(void);
   //
 public:
-  // This is why we are here: Run all patches we and other providers
-  // we are linked to know of. This must be called with the head of
-  // the patch provider list.
-  bool RunEmulatorTrap(class AdrSpace *adr,class CPU *cpu,UBYTE code);
-  // 
   // Install all patches on the list
   void InstallPatchList(class AdrSpace *adr);
   //
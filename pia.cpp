@@ -62,6 +62,7 @@ void PIA::ChangeMMUMapping(UBYTE portbits,UBYTE changedbits)
 {
   class RamExtension *ext;
   bool mapos,mapselftest;
+  UBYTE cachekey;
   //
   switch(machine->MachType()) {
   case Mach_Atari800:
@@ -71,6 +72,12 @@ void PIA::ChangeMMUMapping(UBYTE portbits,UBYTE changedbits)
   case Mach_AtariXE:
   case Mach_AtariXL:    
   case Mach_Atari1200:
+    // The RAM extensions may alter the bits below, hence remember
+    // the value as written.
+    cachekey = portbits;
+    // The MMU only collects the changes here and applies them at
+    // once below, from its cache if this value was seen before.
+    mmu->BeginPortBChange();
     // Check for RAM extensions and forward the changes to them until
     // we find one that feels responsible. The XE extended RAM is one
     // kind of them and handled here.
@@ -117,6 +124,7 @@ void PIA::ChangeMMUMapping(UBYTE portbits,UBYTE changedbits)
     if (changedbits & 0x81) {
       mmu->SelectXLSelftest(mapselftest);
     }
+    mmu->EndPortBChange(cachekey);
     break;
   default:
     // This should not happen
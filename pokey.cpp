@@ -28,7 +28,6 @@
 #include "cpu.hpp"
 #include "snapshot.hpp"
 #include "time.hpp"
-#include "audiobuffer.hpp"
 #include "stdlib.hpp"
 #include "stdio.hpp"
 #include "new.hpp"
@@ -39,6 +38,7 @@
 #ifndef HAS_MEMBER_INIT
 const int Pokey::Base64kHz = 28;     // Divisor from 1.79Mhz to 64 KHz
 const int Pokey::Base15kHz = 114;    // Divisor from 1.79Mhz to 15 Khz
+const int Pokey::SerInBurstDelay = 114;
 #endif
 ///
 
@@ -151,6 +151,7 @@ Pokey::Pokey(class Machine *mach,int unit)
   SerBitOut_Delay  = Base15kHz;
   SerInRate        = 0;
   SerInManual      = false;
+  SerInBurst       = false;
   //
   // Initialize pointers to be on the safe side.
   sound            = NULL;
@@ -167,28 +168,23 @@ Pokey::Pokey(class Machine *mach,int unit)
 // the first tap.
 void Pokey::InitPolyCounter(UBYTE *rand,UBYTE *audio,int size,int tap)
 {
-  int shift[17]; // the shift register. Maximum possible size is 17.
-  int length = (1L << size) - 1; // Size of the output in entries. This should better be correct.
-  int i,j,n;
-
+  // The shift register, kept with its first bit in the most significant
+  // bit such that the random output is just the topmost eight bits. The
+  // register is shifted towards the LSB.
+  ULONG shift  = (1UL << size) - 1; // Pokey reset sets them all to zero.
+  int   length = (1L << size) - 1;  // Size of the output in entries. This should better be correct.
+  int   i;
+  ULONG n;
   //
-  // Pokey reset sets them all to zero.
-  for(i = 0;i < size;i++)
-    shift[i] = 1;
-  
   for(i = 0;i < length;i++) {
     // Compute the random output by picking the first size bits from the shift register.
-    for(j = 0,n = 0;j < 8;j++)
-      n |= shift[j] << (7-j);
-    *rand++  = n;
-    *audio++ = shift[0]?15:0; // normalized to maximum audio volume: 15 or 0.
-
+    *rand++  = UBYTE(shift >> (size - 8));
+    *audio++ = (shift >> (size - 1))?15:0; // normalized to maximum audio volume: 15 or 0.
+    //
     // Compute the new input to the register from the two taps. 
     // The first tab is always the register size.
-    n = shift[tap-1]^shift[size-1];
-    for(j = size - 1;j > 0;j--)
-      shift[j] = shift[j-1];
-    shift[0] = n;
+    n        = ((shift >> (size - tap)) ^ shift) & 1;
+    shift    = (shift >> 1) | (n << (size - 1));
   }
 }
 ///
@@ -215,6 +211,7 @@ void Pokey::WarmStart(void)
   SerInBytes         = 0x00; // reset serial port
   SerInRate          = 0;
   SerInManual        = false;
+  SerInBurst         = false;
   //
   //
   // Initialize poly counter registers
@@ -572,8 +569,8 @@ void Pokey::UpdateSound(UBYTE mask)
 
 /// Pokey::ComputeSamples
 // Private for the sound generator: Generate a given number
-// of new samples
-void Pokey::ComputeSamples(struct AudioBufferBase *to,int size,int dspsamplerate,UBYTE delta)
+// of new signed eight bit samples
+void Pokey::ComputeSamples(UBYTE *to,int size,int dspsamplerate,UBYTE delta)
 {
   // Mask in AudioCtrl wether filter is on
   static const UBYTE FilterMask[4] = {0x04,0x02,0x00,0x00};
@@ -625,7 +622,7 @@ void Pokey::ComputeSamples(struct AudioBufferBase *to,int size,int dspsamplerate
   if ((SkCtrl & 0x03) == 0) {
     // Sound completely disabled.
     while (size) {
-      to->PutSample(0);
+      *to++ = 0;
       size--;
     }
   } else 
@@ -809,7 +806,7 @@ void Pokey::ComputeSamples(struct AudioBufferBase *to,int size,int dspsamplerate
 	val = OutputMapping[out];
       }
       // Output the sample over the channel.
-      to->PutSample(UBYTE(val));
+      *to++ = UBYTE(val);
       size--;
       // Decrement the number of generated samples now
       Output = 0;
@@ -1371,7 +1368,7 @@ UBYTE Pokey::SerInRead(void)
 	    // UpdateSound gets called implicitly by this thru
 	    // SignalSerialBytes
 	  } else {
-	    SerIn_Counter  = SerIn_Delay;	  
+	    SerIn_Counter  = (SerInBurst)?(SerInBurstDelay):(SerIn_Delay);
 	    // Update the sound as we received the next byte
 	    /*
 	    ** If we do, then the sound doesn't sound right, so
@@ -1726,7 +1723,7 @@ UBYTE Pokey::AllPotRead(void)
 // n 15Khz steps steps. Note that we might signal
 // zero bytes here in case we just want pokey to ask
 // back later...
-void Pokey::SignalSerialBytes(UBYTE *data,int num,UWORD delay,UWORD baudrate)
+void Pokey::SignalSerialBytes(UBYTE *data,int num,UWORD delay,UWORD baudrate,bool burst)
 {
   if (SerIn_Counter > 0 || SerInBytes) {
     // Serial problem of pokey: Serial device miscommunication,
@@ -1738,7 +1735,8 @@ void Pokey::SignalSerialBytes(UBYTE *data,int num,UWORD delay,UWORD baudrate)
   SerInBuffer    = data;
   SerInBytes     = num;
   SerInRate      = baudrate;
-  SerIn_Counter  = delay * Base15kHz + SerIn_Delay;
+  SerInBurst     = burst;
+  SerIn_Counter  = delay * Base15kHz + ((burst)?(SerInBurstDelay):(SerIn_Delay));
   //
   //
   // Update channels 3&4 that need to sync to this input
@@ -1982,6 +1980,7 @@ void Pokey::State(class SnapShot *sn)
   SerOut_Counter     = 0;
   SerXmtDone_Counter = 0;
   SerInBytes         = 0;
+  SerInBurst         = false;
   SerOut_Register    = 0xffff;
   SerOut_Buffer      = 0xff;
   SerBitOut_Counter  = 0;
@@ -40,7 +40,6 @@ class IRQSource;
 class SIO;
 class Keyboard;
 class Sound;
-struct AudioBufferBase;
 ///
 
 /// Class Pokey
@@ -59,6 +58,11 @@ class Pokey : public Chip, public Page, public Saveable, private VBIAction, priv
   static const int Base64kHz     INIT(28);     // Divisor from 1.79Mhz to 64 KHz
   static const int Base15kHz     INIT(114);    // Divisor from 1.79Mhz to 15 Khz
   //
+  // The gap between two serial input bytes in burst mode. The Os
+  // SIO interrupt handler reads SerIn within this time, the next
+  // byte only arrives after the previous one was taken.
+  static const int SerInBurstDelay INIT(114);
+  //
   // Sizes of the poly counters
 #ifdef HAS_MEMBER_INIT
   static const int Poly4Size = (1<<4) -1; // The size of the 4 bit poly counter
@@ -229,6 +233,7 @@ class Pokey : public Chip, public Page, public Saveable, private VBIAction, priv
   int    SerInBytes;
   int    SerInRate;
   bool   SerInManual;      // set if the serial input was parsed off manually.
+  bool   SerInBurst;       // set if the bytes are delivered without the serial bit timing.
   //
   // The SAP record from last recording. Whenever Pokey changes its stage,
   // the SAP record is written to disk.
@@ -323,11 +328,11 @@ public:
   void SignalKeyboardEvent(void);
   //
   // Private for the sound generator: Generate a given number
-  // of new samples for a given sampling rate, given the audio buffer
-  // to collect them and an offset to emulate the GTIA console speaker.
+  // of new signed eight bit samples for a given sampling rate into the
+  // target, given an offset to emulate the GTIA console speaker.
   // NOTE: The former interface specified the number of bytes, we changed
   // this to the number of samples.
-  void ComputeSamples(struct AudioBufferBase *target,int size,int samplerate,UBYTE offset = 0);
+  void ComputeSamples(UBYTE *target,int size,int samplerate,UBYTE offset = 0);
   //
   // Private for the sound subsystem: Get the base horizontal blanking frequency
   // This rather much depends on the base frequency of the system, and hence on
@@ -342,7 +347,9 @@ public:
   // n 15Khz steps steps or after the default delay,
   // and with a baud rate with the indicated timer constant
   // measured in the period length in 1.79Mhz clocks.
-  void SignalSerialBytes(UBYTE *buffer,int num,UWORD delay = 0,UWORD cycles = 47);
+  // If burst is set, the bytes arrive as fast as the Os
+  // can pick them up rather than at the serial bit rate.
+  void SignalSerialBytes(UBYTE *buffer,int num,UWORD delay = 0,UWORD cycles = 47,bool burst = false);
   //
   // Signal that a command frame has been signaled and that we therefore
   // abort incoming IO traffic. This is a hack to enforce resynchronization
@@ -0,0 +1,96 @@
+/***********************************************************************************
+ **
+ ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
+ **
+ ** $Id: romimage.cpp,v 1.1 2020/05/12 19:21:05 thor Exp $
+ **
+ ** In this module: A ROM image mapped from a file
+ **********************************************************************************/
+
+/// Includes
+#include "romimage.hpp"
+#include "unistd.hpp"
+#if USE_ROMIMAGE_MMAP
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+///
+
+/// RomImage::RomImage
+RomImage::RomImage(void)
+  : Mapping(NULL), Size(0), Offset(0)
+{ }
+///
+
+/// RomImage::~RomImage
+RomImage::~RomImage(void)
+{
+#if USE_ROMIMAGE_MMAP
+  if (Mapping)
+    munmap(Mapping,Size);
+#endif
+}
+///
+
+/// RomImage::Map
+// Map the given number of bytes from the current file position on,
+// and advance the file position behind the image. Returns false if
+// the file cannot be mapped, the caller has to read the data then.
+bool RomImage::Map(FILE *fp,ULONG size)
+{
+#if USE_ROMIMAGE_MMAP
+  struct stat info;
+  long pagesize,pos;
+  ULONG base;
+  void *map;
+  int handle;
+  //
+  if (Mapping || size == 0)
+    return false;
+  //
+  handle = fileno(fp);
+  pos    = ftell(fp);
+  if (handle < 0 || pos < 0 || fstat(handle,&info))
+    return false;
+  //
+  // Only plain files can be mapped, and the image must be complete as
+  // accessing a mapping beyond the end of the file faults.
+  if (!S_ISREG(info.st_mode) || ULONG(info.st_size) < ULONG(pos) + size)
+    return false;
+  //
+  // A private mapping does not take a snapshot of the file: Pages not
+  // yet copied still follow modifications of the file, and truncating
+  // it faults on the next access. Hence, only map files that cannot be
+  // modified by us, i.e. have no write permission for us, our group
+  // or anyone else. The superuser may write all files. The caller
+  // reads a copy of all other files.
+  if (geteuid() == 0 || (info.st_mode & (S_IWGRP | S_IWOTH)))
+    return false;
+  if ((info.st_mode & S_IWUSR) && info.st_uid == geteuid())
+    return false;
+  //
+  pagesize = sysconf(_SC_PAGESIZE);
+  if (pagesize <= 0)
+    pagesize = 4096;
+  base     = ULONG(pos) & ~ULONG(pagesize - 1);
+  //
+  // The mapping is writable such that patches can go into it, but
+  // private such that they only touch a copy of the page.
+  map = mmap(NULL,ULONG(pos) - base + size,PROT_READ | PROT_WRITE,MAP_PRIVATE,handle,base);
+  if (map == MAP_FAILED)
+    return false;
+  //
+  if (fseek(fp,pos + size,SEEK_SET)) {
+    munmap(map,ULONG(pos) - base + size);
+    return false;
+  }
+  //
+  Mapping = (UBYTE *)map;
+  Offset  = ULONG(pos) - base;
+  Size    = Offset + size;
+  return true;
+#else
+  return false;
+#endif
+}
+///
@@ -0,0 +1,60 @@
+/***********************************************************************************
+ **
+ ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
+ **
+ ** $Id: romimage.hpp,v 1.1 2020/05/12 19:21:05 thor Exp $
+ **
+ ** In this module: A ROM image mapped from a file
+ **********************************************************************************/
+
+#ifndef ROMIMAGE_HPP
+#define ROMIMAGE_HPP
+
+/// Includes
+#include "types.h"
+#include "types.hpp"
+#include "stdio.hpp"
+#if HAVE_SYS_MMAN_H && HAVE_MMAP && HAVE_MUNMAP && HAVE_FILENO && HAVE_SYS_STAT_H
+#define USE_ROMIMAGE_MMAP 1
+#endif
+///
+
+/// Class RomImage
+// This class maps the contents of a ROM image file privately into
+// memory such that the RomPages can use it directly instead of keeping
+// a copy. All emulator processes using the same ROM hence share the
+// same physical memory. As the mapping is private, patching a byte
+// only copies the host page containing it. Files that could be modified
+// while the emulator runs are not mapped but read.
+class RomImage {
+  //
+  // The start of the mapping, or NULL if not mapped.
+  UBYTE *Mapping;
+  //
+  // The size of the mapping in bytes.
+  ULONG  Size;
+  //
+  // The offset of the image within the mapping. The mapping starts
+  // at a host page boundary, the image does not need to.
+  ULONG  Offset;
+  //
+public:
+  RomImage(void);
+  ~RomImage(void);
+  //
+  // Map the given number of bytes from the current file position on,
+  // and advance the file position behind the image. Returns false if
+  // the file cannot be mapped or is writable, the caller has to read
+  // the data then.
+  bool Map(FILE *fp,ULONG size);
+  //
+  // Return the image data of the given 256 byte page.
+  UBYTE *PageOf(int page) const
+  {
+    return Mapping + Offset + (ULONG(page) << 8);
+  }
+};
+///
+
+///
+#endif
@@ -23,9 +23,13 @@ protected:
   //
   // The ROM image goes here. We *must not* use the
   // "memory" pointer of the page as this would allow
-  // write accesses to the rom.
+  // write accesses to the rom. This either points to the
+  // storage of the page, or into a mapped ROM image.
   UBYTE *romimage;
   //
+  // The storage of the page itself.
+  UBYTE *ownimage;
+  //
   virtual UBYTE ComplexRead(ADR mem)
   {
     return romimage[mem & PAGE_MASK];
@@ -41,11 +45,13 @@ public:
   // The constructor also constructs the memory here.
   RomPage(void)
     : romimage(new UBYTE[256])
-  { }
+  { 
+    ownimage = romimage;
+  }
   //
   ~RomPage(void)
   {
-    delete[] romimage;
+    delete[] ownimage;
   }
   //
   //
@@ -65,9 +71,18 @@ public:
   // Blank a rompage to all zeros
   void Blank(void)
   {
+    romimage = ownimage;
     memset(romimage,0,256);
   }  
   //
+  // Use the given 256 bytes of a mapped ROM image as contents of
+  // this page, or the storage of the page itself if NULL. The image
+  // must remain valid as long as the page uses it.
+  void SetImage(UBYTE *image)
+  {
+    romimage = (image)?(image):(ownimage);
+  }
+  //
   // Patch a byte into a ROM. 
   virtual void PatchByte(ADR mem,UBYTE val)
   {
@@ -26,9 +26,9 @@ RomXLChecksum::RomXLChecksum(class Machine *mach,class PatchProvider *p)
 /// RomXLChecksum::CheckSum
 // Run a word checksum over a range of the Os ROM, lo inclusive,
 // hi exclusive.
-UWORD RomXLChecksum::CheckSum(ADR lo,ADR hi)
+UWORD RomXLChecksum::CheckSum(class Machine *mach,ADR lo,ADR hi)
 {
-  class RomPage *rom = Machine->OsROM()->OsPages();
+  class RomPage *rom = mach->OsROM()->OsPages();
   UWORD sum = 0;
 
   // Offset the low and hi such that we get the right address within the
@@ -51,28 +51,37 @@ UWORD RomXLChecksum::CheckSum(ADR lo,ADR hi)
 }
 ///
 
+/// RomXLChecksum::ComputeChecksums
+// Compute the two checksums the selftest expects at 0xc000 and
+// 0xfff8 of the currently loaded XL Os ROM.
+void RomXLChecksum::ComputeChecksums(class Machine *mach,UWORD &lowsum,UWORD &highsum)
+{
+  lowsum  = CheckSum(mach,0xc002,0xd000);
+  if (mach->OsROM()->RomType() != OsROM::Os_Rom1200) {
+    // Due to an Os bug, the 1200XL does not sum this
+    // part of the ROM
+    lowsum += CheckSum(mach,0x5000,0x5800);
+  }
+  lowsum  += CheckSum(mach,0xd800,0xe000);
+  //
+  highsum  = CheckSum(mach,0xe000,0xfff8);
+  highsum += CheckSum(mach,0xfffa,0x10000);
+}
+///
+
 /// RomXLChecksum::InstallPatch
 // This entry is called whenever a new ROM is loaded. It is required
 // to install the patch into the image.
 void RomXLChecksum::InstallPatch(class AdrSpace *adr,UBYTE)
 {
-  UWORD sum;
+  UWORD lowsum,highsum;
   //
   // Fix up the ROM checksums.
   //
-  sum  = CheckSum(0xc002,0xd000);
-  if (Machine->OsROM()->RomType() != OsROM::Os_Rom1200) {
-    // Due to an Os bug, the 1200XL does not sum this
-    // part of the ROM
-    sum += CheckSum(0x5000,0x5800);
-  }
-  sum += CheckSum(0xd800,0xe000);
-  adr->PatchByte(0xc000,UBYTE(sum & 0xff));
-  adr->PatchByte(0xc001,UBYTE(sum >> 8));
-  //
-  sum  = CheckSum(0xe000,0xfff8);
-  sum += CheckSum(0xfffa,0x10000);
-  adr->PatchByte(0xfff8,UBYTE(sum & 0xff));
-  adr->PatchByte(0xfff9,UBYTE(sum >> 8));
+  ComputeChecksums(Machine,lowsum,highsum);
+  adr->PatchByte(0xc000,UBYTE(lowsum & 0xff));
+  adr->PatchByte(0xc001,UBYTE(lowsum >> 8));
+  adr->PatchByte(0xfff8,UBYTE(highsum & 0xff));
+  adr->PatchByte(0xfff9,UBYTE(highsum >> 8));
 }
 ///
@@ -39,7 +39,7 @@ class RomXLChecksum : public Patch {
   //
   // Run a word checksum over a range of the Os ROM, lo inclusive,
   // hi exclusive.
-  UWORD CheckSum(ADR lo,ADR hi);
+  static UWORD CheckSum(class Machine *mach,ADR lo,ADR hi);
   //
 public:
   RomXLChecksum(class Machine *mach,class PatchProvider *p);
@@ -47,6 +47,9 @@ public:
   { 
   }
   //
+  // Compute the two checksums the selftest expects at 0xc000 and
+  // 0xfff8 of the currently loaded XL Os ROM.
+  static void ComputeChecksums(class Machine *mach,UWORD &lowsum,UWORD &highsum);
 };
 ///
 
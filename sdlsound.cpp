@@ -28,9 +28,9 @@
 // Build up the SDL sound now.
 SDLSound::SDLSound(class Machine *mach)
   : Sound(mach), SDLClient(mach,SDL_INIT_AUDIO),
-    SoundInit(false), Paused(true), MayRunPokey(false), UpdateBuffer(false), ForceStereo(false),
+    SoundInit(false), Paused(true), Underrun(false), UpdateBuffer(false), ForceStereo(false),
     FragSize(9), NumFrags(6),
-    CycleCarry(0), ConsoleVolume(32), BufferedSamples(0), UpdateSamples(0)
+    CycleCarry(0), ConsoleVolume(32), UpdateSamples(0)
 {
 #if defined _WIN32
   // Windows DirectSound/WaveOut doesn't seem to be able
@@ -54,15 +54,6 @@ SDLSound::~SDLSound(void)
 }
 ///
 
-/// SDLSound::GenerateSamples
-// Generate the given number (not in bytes, but in number) of audio samples
-// and place them into the tail of the ready buffer list.
-void SDLSound::GenerateSamples(ULONG numsamples)
-{	
-  BufferedSamples += Sound::GenerateSamples(numsamples,FragSamples);
-}
-///
-
 /// SDLSound::CloseSound
 // Shut down the sound system by quitting the
 // corresponding SDL system.
@@ -76,7 +67,7 @@ void SDLSound::CloseSound(void)
     // Ok, the sound is running.
     CloseSDL();
   }  
-  // Dispose the audio buffer nodes now.
+  // Dispose the buffered samples now.
   Sound::CleanBuffer();
 }
 ///
@@ -177,13 +168,18 @@ void SDLSound::OpenSound(void)
   // Get the size of a fragment in samples.
   FragSamples     = as.samples;
   BufferSize      = FragSamples * NumFrags;
-  EffectiveFreq   = as.freq;
-  BufferedSamples = 0;
   CycleCarry      = 0;
   UpdateBuffer    = false;
   UpdateSamples   = 0;
   Paused          = true;
+  Underrun        = false;
   //
+  // Allocate the ring buffer the callback takes the samples from. The
+  // audio is still paused, so the callback is not yet running.
+  AllocateBuffer((BufferSize + (FragSamples << 2)) << 1);
+  //
+  // Keep a full SDL buffer size of samples in the ring buffer.
+  ResetRateControl(BufferSize);
 }
 ///
 
@@ -197,26 +193,19 @@ void SDLSound::UpdateSound(class Timer *delay)
     // Signal that we must update the sound now since the pokey parameters changed.
     UpdateBuffer = true;
     if (delay) {    
-      // Here we are in the VBI state. Check now at the end of the VBI
-      // how many bytes are left.
-      SDL_LockAudio();
-      // Check how many bytes we got buffered. If too many, cut the frequency down.
-      if (BufferedSamples > (BufferSize + (FragSamples<<1))) {
-	AdjustOverrun();
-      }
-      SDL_UnlockAudio();
-      MayRunPokey = true; // as no one is working with it, go ahead!
+      // Here we are in the VBI state. The callback only reads from the
+      // ring buffer, hence no locking is required here.
       delay->WaitForEvent();    
-      MayRunPokey = false;
-      SDL_LockAudio();
-      // Check whether the buffered bytes are getting too short.
-      if (BufferedSamples < FragSamples<<2) {
-	// Better enlarge the frequency to avoid the trouble...
-	AdjustUnderrun();
+      // Adjust the rate at which samples are generated to the number
+      // of samples left in the buffer.
+      ControlRate();
+      // Check whether the buffered bytes are getting too short, or
+      // whether the callback ran out of samples.
+      if (Underrun || Ring.ReadySamples() < FragSamples<<2) {
+	Underrun = false;
 	// Refill the buffer immediately to avoid a near buffer stall
 	GenerateSamples(FragSamples);
-      }    
-      SDL_UnlockAudio();
+      }
     }
   } else if (delay) {
     // No sound enabled, just wait.
@@ -243,17 +232,15 @@ void SDLSound::HBI(void)
       UpdateBuffer = true;
     }
     if (UpdateBuffer) {
-      // Compute this number of samples, and put it into the buffer. This must not
-      // interact with the audio sample request.
-      SDL_LockAudio();
+      // Compute this number of samples, and put it into the buffer. The
+      // callback only removes samples from the ring, so no locking is required.
       GenerateSamples(UpdateSamples);
-      SDL_UnlockAudio();
       UpdateBuffer = false;
       UpdateSamples  = 0;
     }
     //
     // Start the audio playback now if we haven't done so before.
-    if (Paused && BufferedSamples > BufferSize) {
+    if (Paused && Ring.ReadySamples() > BufferSize) {
       SDL_PauseAudio(0);
       Paused = false;
     }
@@ -269,41 +256,6 @@ void SDLSound::HBI(void)
 }
 ///
 
-/// SDLSound::AdjustOverrun
-// Signal a buffer overrun
-void SDLSound::AdjustOverrun(void)
-{
-  LONG newfreq;
-  // The buffer is running too full. This means we are
-  // generating samples too fast. Reduce the sampling frequency.
-  // We must do this very carefully as overruns accumulate data
-  newfreq = (EffectiveFreq * 8191) >> 13;
-  if (newfreq >= EffectiveFreq)
-    newfreq--;
-  EffectiveFreq = newfreq;
-  // Drop all samples we delayed generation for.
-  UpdateSamples = 0;
-}
-///
-
-/// SDLSound::AdjustUnderrun
-// Signal a buffer underrun
-void SDLSound::AdjustUnderrun(void)
-{
-  LONG newfreq;
-  // The buffer is running empty. We are generating
-  // too few samples. Enlarge the effective frequency to keep track.
-  newfreq = (EffectiveFreq << 13) / 8191;
-  if (newfreq <= EffectiveFreq)
-    newfreq++;
-  if (newfreq <= (SamplingFreq << 1))
-    EffectiveFreq = newfreq;
-  // Enforce that we write a new buffer immediately in case
-  // we are short on samples.
-  UpdateBuffer  = true;
-}
-///
-
 /// SDLSound::CallBackEntry
 // The SDL Callback hook that computes more samples here. This is just the 
 // wrapper that loads the "this" poiner and calls the real hook function.
@@ -315,57 +267,25 @@ void SDLSound::CallBackEntry(void *data,Uint8 *stream,int len)
 ///
 
 /// SDLSound::CallBack
-// The real callback hook called to compute more samples.
-// This uses pokey to generate the samples required by SDL.
+// The real callback hook called to fetch more samples.
+// This only takes the samples pokey placed into the ring buffer,
+// it never runs pokey itself and never locks.
 void SDLSound::CallBack(UBYTE *stream, int bytes)
 {
   // Do not perform any computation in case the sound is no longer active.
   if (SoundInit) {
-    // Check whether we have an active sample. If so, use it first to satisfy the request.
-    while(bytes) {
-      if (PlayingBuffer == NULL) {
-	// No playing buffer. Pull a new one from the list of ready buffers.
-	PlayingBuffer = ReadyBuffers.RemHead();
-	if (PlayingBuffer == NULL) {
-	  // Ok, check whether we may launch pokey directly here. This might
-	  // be valid if the main thread is waiting in the VBI anyhow.
-	  if (MayRunPokey) {
-	    GenerateSamples(FragSamples);
-	    continue;
-	  } else {
-	    // Unfortunately, we cannot directly call pokey
-	    // here since we don't know the state of it and whether something
-	    // else is currently playing with it.
-	    AdjustUnderrun();
-	    return;
-	  }
-	}
-      }
-      if (PlayingBuffer) {
-	int cpy;
-	// We do have a buffer now. Ok, copy as many bytes as required into the output buffer.
-	cpy = PlayingBuffer->ReadyBytes();
-	if (cpy > bytes)
-	  cpy = bytes;
-	memcpy(stream,PlayingBuffer->ReadPtr,cpy);
-	// Adjust the playing buffer pointers now.
-	PlayingBuffer->ReadPtr += cpy;
-	stream                 += cpy;
-	bytes                  -= cpy;
-	BufferedSamples        -= cpy >> PlayingBuffer->SampleShift;
-	//
-	// Check whether anything remains. If not, put the buffer
-	// back into the free list.
-	if (PlayingBuffer->IsEmpty()) {
-	  // We're done with it. Dispose it.
-	  FreeBuffers.AddTail(PlayingBuffer);
-	  PlayingBuffer = NULL;
-	}
-      }
-    }    
-    if (BufferedSamples < FragSamples) {
-      // Better enlarge the frequency to avoid the trouble...
-      AdjustUnderrun();
+    ULONG samples = ULONG(bytes) >> Ring.SampleShiftOf();
+    ULONG copied  = Ring.ReadSamples(stream,samples);
+    //
+    if (copied < samples) {
+      // Ran dry. Play silence for the rest. We cannot run pokey here
+      // since we don't know its state, so let the emulation thread
+      // refill the buffer.
+      Ring.FillSilence(stream + (copied << Ring.SampleShiftOf()),samples - copied);
+      Underrun = true;
+    } else if (Ring.ReadySamples() < FragSamples) {
+      // Running low, let the emulation thread refill the buffer.
+      Underrun = true;
     }
   }
 }
@@ -407,12 +327,19 @@ void SDLSound::WarmStart(void)
   ULONG minsamples   = (NumFrags - 2)<<FragSize;
   ConsoleSpeakerStat = false;  
   //
-  // Dispose the old audio buffer nodes now.
-  CleanBuffer();
-  BufferedSamples    = 0;
+  // Dispose the old samples now. This requires that the callback
+  // is not running.
+  if (SoundInit) {
+    SDL_LockAudio();
+    CleanBuffer();
+    SDL_UnlockAudio();
+  } else {
+    CleanBuffer();
+  }
+  Underrun           = false;
   //
   // Reset generation frequency
-  EffectiveFreq   = SamplingFreq;
+  ResetRateControl(TargetSamples);
   // Fill the audio buffer here.
   GenerateSamples(minsamples);
 }
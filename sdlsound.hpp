@@ -27,7 +27,7 @@ class SDLSound : public Sound, public SDLClient {
   //
   bool             SoundInit;   // set if the sound system is running.
   bool             Paused;      // set if audio output is still paused
-  bool             MayRunPokey; // set if the side thread may run pokey sound processing
+  volatile bool    Underrun;    // set by the callback if it ran out of samples
   bool             UpdateBuffer;// set if the buffer must be recalculated and cannot be delayed
   bool             ForceStereo; // enforce stereo output even if mono is sufficient.
   //
@@ -52,12 +52,6 @@ class SDLSound : public Sound, public SDLClient {
   ULONG            FragSamples;   // samples in a fragment
   //
   LONG             ConsoleVolume; // volume of the console speaker
-  //  
-  // The effective frequency for buffer refill
-  LONG             EffectiveFreq;
-  //
-  // Total number of samples in the output buffer.
-  ULONG            BufferedSamples;
   //
   // Total number of buffers we delayed for update
   ULONG            UpdateSamples;
@@ -66,23 +60,13 @@ class SDLSound : public Sound, public SDLClient {
   // wrapper that loads the "this" poiner and calls the real hook function.
   static void CallBackEntry(void *data,Uint8 *stream,int len);
   //
-  // The real callback hook called to compute more samples.
+  // The real callback hook called to fetch more samples.
   void CallBack(UBYTE *stream,int size);
   //
-  // Generate the given number (not in bytes, but in number) of audio samples
-  // and place them into the tail of the ready buffer list.
-  void GenerateSamples(ULONG numsamples);
-  //
   // Open resp. close the SDL frontend for this class. This gets done for
   // enabled audio.
   void OpenSound(void);
   void CloseSound(void);
-  //  
-  // Signal a buffer overrun
-  void AdjustOverrun(void);
-  //
-  // Signal a buffer underrun
-  void AdjustUnderrun(void);
   //
 public:
   // Open the SDL Sound class
@@ -101,6 +101,16 @@ public:
   // device.
   virtual UBYTE ReadStatus(const UBYTE *CommandFrame,UWORD &delay,UWORD &speed) = 0;
   //
+  // Check whether the data frame of the indicated read command may be
+  // delivered in a burst, bypassing the serial timing and the delays
+  // of the device. This is only safe for commands whose timing is not
+  // observed by the Atari software.
+  virtual bool AcceleratesTransfer(const UBYTE *)
+  {
+    // The default is to keep the serial timing.
+    return false;
+  }
+  //
   // Rather exotic concurrent read/write commands. These methods are used for
   // the 850 interface box to send/receive bytes when bypassing the SIO. In these
   // modes, clocking comes from the external 850 interface, and SIO remains unactive.
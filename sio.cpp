@@ -33,7 +33,9 @@ SIO::SIO(class Machine *mach)
   Read_Done_Delay    = 50;
   Read_Deliver_Delay = 2;
   Format_Done_Delay  = 400;
+  UltraSpeed_Delay   = 8;
   MotorEnabled       = false;
+  Accelerated        = false;
   HaveWarned         = false;
   ActiveDevice       = NULL;
 }
@@ -135,6 +137,7 @@ void SIO::WarmStart(void)
   SIOState          = NoState;
   MotorEnabled      = false;
   HaveWarned        = false;
+  Accelerated       = false;
   ActiveDevice      = NULL;
 }
 ///
@@ -168,6 +171,9 @@ void SIO::WriteByte(UBYTE byte)
 	    CmdType = ActiveDevice->CheckCommandFrame(CommandFrame,DataFrameLength,
 						      pokey->SerialTransmitSpeed());
 	    if (CmdType != Off) {	      
+	      // Check whether the device is willing to bypass the serial
+	      // timing for this command.
+	      Accelerated  = (CmdType == ReadCommand)?(ActiveDevice->AcceleratesTransfer(CommandFrame)):false;
 	      // Check whether we have enough data buffer here; if not,
 	      // enlarge it. Note that we need one additional byte
 	      // for the checksum	    
@@ -423,6 +429,10 @@ void SIO::RequestInput(void)
 	delay       = UWORD(Read_Done_Delay);
       }
       result        = ActiveDevice->ReadBuffer(CommandFrame,DataFrame,bytes,delay,InputSpeed);
+      // The drive mechanics are not emulated for accelerated transfers,
+      // only give the Os the time to get ready for the completion code.
+      if (Accelerated)
+	delay       = UWORD(UltraSpeed_Delay);
       // Check whether we already got any bytes in return.
       if (bytes) {
 	// Yes, we did. Integrate them into our data frame buffer, 
@@ -529,8 +539,9 @@ void SIO::RequestInput(void)
       DataFrameIdx   = bytes;
       ExpectedBytes -= bytes;
     }
-    // Transmit now the bytes in this buffer.
-    pokey->SignalSerialBytes(DataFrame,DataFrameIdx,delay,InputSpeed);
+    // Transmit now the bytes in this buffer. Accelerated transfers
+    // deliver them as fast as the Os picks them up.
+    pokey->SignalSerialBytes(DataFrame,DataFrameIdx,delay,InputSpeed,Accelerated);
     // Now we have zero data available in the buffer, need to
     // refill on the next go.
     DataFrameIdx = 0;
@@ -624,6 +635,7 @@ void SIO::SetCommandLine(bool onoff)
     }
     CommandFrameIdx = 0;
     DataFrameIdx    = 0;
+    Accelerated     = false;
     // Expect a SIO command frame here.
     ExpectedBytes   = 5;
     SIOState        = CmdState;
@@ -1049,6 +1061,8 @@ void SIO::DisplayStatus(class Monitor *mon)
 		   "\tSIO Read Done Delay    : " LD "\n"
 		   "\tSIO Write Done Delay   : " LD "\n"
 		   "\tSIO Format Done Delay  : " LD "\n"
+		   "\tSIO Ultra Speed Delay  : " LD "\n"
+		   "\tSIO Accelerated Frame  : %s\n"
 		   "\tSIO Command Frame Idx  : %d\n"
 		   "\tSIO Data Frame Idx     : %d\n"
 		   "\tCommand Frame Contents : %02x %02x %02x %02x\n",
@@ -1057,6 +1071,8 @@ void SIO::DisplayStatus(class Monitor *mon)
 		   Read_Done_Delay, 
 		   Write_Done_Delay,
 		   Format_Done_Delay,
+		   UltraSpeed_Delay,
+		   (Accelerated)?("yes"):("no"),
 		   CommandFrameIdx,
 		   DataFrameIdx, 
 		   CommandFrame[0],CommandFrame[1],
@@ -1081,5 +1097,7 @@ void SIO::ParseArgs(class ArgParser *args)
 		   0,240,Write_Done_Delay);
   args->DefineLong("FormatDoneDelay","format done delay in HBlanks",
 		   0,1024,Format_Done_Delay);
+  args->DefineLong("UltraSpeedDelay","accelerated read done delay in HBlanks",
+		   0,240,UltraSpeed_Delay);
 }
 ///
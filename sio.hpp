@@ -102,6 +102,10 @@ private:
   // Flag whether the tape motor is running (or enabled to be running).
   bool                MotorEnabled;
   //
+  // Set if the active device delivers the data frame of the current
+  // command in a burst.
+  bool                Accelerated;
+  //
   // The following is true in case we have been warned already.
   bool                HaveWarned;
   //
@@ -115,6 +119,7 @@ private:
   LONG                Read_Done_Delay;  // typical time to complete a read command
   LONG                Format_Done_Delay;// typical time to complete a format command
   LONG                Read_Deliver_Delay; // delay from the ok of the read to the delivery of the data
+  LONG                UltraSpeed_Delay; // typical time to complete an accelerated read command
   //
   //
   // Miscellaneous internal methods
@@ -91,6 +91,16 @@ public:
   // This is the only additional method here, required to load/save entire blocks
   virtual void DefineChunk(const char *argname,const char *help,UBYTE *mem,size_t size) = 0;
   //
+  // Check whether the state is saved (true) or restored (false). Chunks
+  // that are unused need then not to be saved, but must be defined
+  // when restoring the state.
+  virtual bool isSaving(void) const = 0;
+  //
+  // Check whether the snapshot only collects the items to restore
+  // before the file is parsed. No state must be changed then, as
+  // parsing the file may still fail.
+  virtual bool isCollecting(void) const = 0;
+  //
 };
 ///
 
@@ -182,6 +182,19 @@ public:
   // This is the only additional method here, required to load/save entire blocks
   virtual void DefineChunk(const char *argname,const char *help,UBYTE *mem,size_t size);
   //
+  // This snapshot restores the state.
+  virtual bool isSaving(void) const
+  {
+    return false;
+  }
+  //
+  // Check whether the items are collected, i.e. the file has not
+  // been parsed yet.
+  virtual bool isCollecting(void) const
+  {
+    return Collecting;
+  }
+  //
 };
 ///
 
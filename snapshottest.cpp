@@ -0,0 +1,365 @@
+/***********************************************************************************
+ **
+ ** Atari++ emulator (c) 2002 THOR-Software, Thomas Richter
+ **
+ ** $Id: snapshottest.cpp,v 1.1 2020/05/16 10:12:31 thor Exp $
+ **
+ ** In this module: Test of the snapshots of the 130XE extended RAM
+ **********************************************************************************/
+
+/// Includes
+#include "types.h"
+#include "types.hpp"
+#include "machine.hpp"
+#include "mmu.hpp"
+#include "adrspace.hpp"
+#include "cmdlineparser.hpp"
+#include "exceptions.hpp"
+#include "stdio.hpp"
+#include "string.hpp"
+#include "unistd.hpp"
+///
+
+/// Description
+// This program builds an XE machine with extended RAM, fills some
+// pages of the banks, and restores them from a snapshot with the
+// bitmap of the used pages, from a snapshot in the old format that
+// contains all pages and no bitmap, and from a damaged snapshot that
+// must not modify the memory. It is built by "make snapshottest" and
+// run by "make test". It returns zero if all tests pass.
+///
+
+/// Defines
+// The snapshot files used by the test.
+#define NEW_STATE     "snapshottest-new.state"
+#define OLD_STATE     "snapshottest-old.state"
+#define DAMAGED_STATE "snapshottest-damaged.state"
+// The number of bank bits, and the number of pages of all banks.
+#define BANK_BITS     4
+#define BANK_PAGES    ((1 << BANK_BITS) << 6)
+///
+
+/// TestExceptionPrinter
+// Print exceptions to stderr.
+class TestExceptionPrinter : public ExceptionPrinter {
+public:
+  virtual void PrintException(const char *fmt,...) PRINTF_STYLE;
+};
+//
+void TestExceptionPrinter::PrintException(const char *fmt,...)
+{
+  va_list args;
+  //
+  va_start(args,fmt);
+  vfprintf(stderr,fmt,args);
+  fprintf(stderr,"\n");
+  va_end(args);
+}
+///
+
+/// Statics
+static class Machine  *Mach;
+static class AdrSpace *Ram;
+static int             Failures;
+///
+
+/// SelectBank
+// Map the given bank into 0x4000..0x7fff by PIA port B. The Compy
+// scheme uses bits 2,3,6 and 7, bit 4 enables the CPU access.
+static void SelectBank(int bank)
+{
+  static const UBYTE bits[BANK_BITS] = {2,3,6,7};
+  UBYTE portb = 0xef;
+  int i;
+  //
+  for(i = 0;i < BANK_BITS;i++) {
+    if (bank & (1 << i)) {
+      portb |= UBYTE(1 << bits[i]);
+    } else {
+      portb &= UBYTE(~(1 << bits[i]));
+    }
+  }
+  // Select the data direction register, make all bits outputs,
+  // then select the data register again.
+  Ram->WriteByte(0xd303,0x00);
+  Ram->WriteByte(0xd301,0xff);
+  Ram->WriteByte(0xd303,0x04);
+  Ram->WriteByte(0xd301,portb);
+}
+///
+
+/// Pattern
+// The test pattern at the given address of the given bank.
+static UBYTE Pattern(int bank,ADR adr)
+{
+  return UBYTE((bank * 37 + adr * 11 + (adr >> 8)) | 1);
+}
+///
+
+/// Fill
+// Fill the test pages: A complete page in bank 5, a single byte in
+// bank 9 and the last page of the last bank.
+static void Fill(void)
+{
+  ADR adr;
+  //
+  SelectBank(5);
+  for(adr = 0x4000;adr < 0x4100;adr++) {
+    Ram->WriteByte(adr,Pattern(5,adr));
+  }
+  SelectBank(9);
+  Ram->WriteByte(0x5234,Pattern(9,0x5234));
+  SelectBank((1 << BANK_BITS) - 1);
+  for(adr = 0x7f00;adr < 0x8000;adr++) {
+    Ram->WriteByte(adr,Pattern((1 << BANK_BITS) - 1,adr));
+  }
+}
+///
+
+/// Scribble
+// Modify the memory of the banks, including a page that is not used
+// by the test pattern.
+static void Scribble(void)
+{
+  SelectBank(3);
+  Ram->WriteByte(0x6000,0x55);
+  SelectBank(5);
+  Ram->WriteByte(0x4010,0xaa);
+}
+///
+
+/// Check
+// Check that the test pages are present and all other memory of the
+// banks touched is zero. Returns the number of bytes that differ.
+static int Check(const char *name)
+{
+  static const int banks[] = {0,3,5,9,(1 << BANK_BITS) - 1,-1};
+  int i,diffs = 0;
+  ADR adr;
+  //
+  for(i = 0;banks[i] >= 0;i++) {
+    SelectBank(banks[i]);
+    for(adr = 0x4000;adr < 0x8000;adr++) {
+      UBYTE expect = 0;
+      UBYTE value  = Ram->ReadByte(adr);
+      //
+      if ((banks[i] == 5 && adr < 0x4100) ||
+	  (banks[i] == 9 && adr == 0x5234) ||
+	  (banks[i] == (1 << BANK_BITS) - 1 && adr >= 0x7f00))
+	expect = Pattern(banks[i],adr);
+      if (value != expect) {
+	if (diffs < 8)
+	  printf("%s: bank %d at $%04x is $%02x, expected $%02x\n",name,banks[i],adr,value,expect);
+	diffs++;
+      }
+    }
+  }
+  if (diffs)
+    Failures++;
+  printf("%s: %s\n",name,(diffs)?("failed"):("passed"));
+  return diffs;
+}
+///
+
+/// WriteOldFormat
+// Convert a snapshot into the format without the bitmap of the used
+// pages, in which all pages are present. Returns false on an error.
+static bool WriteOldFormat(const char *from,const char *to)
+{
+  FILE *in,*out;
+  char line[512],name[32];
+  bool present[BANK_PAGES];
+  bool skip = false;
+  int i,j,page;
+  //
+  in  = fopen(from,"r");
+  if (in == NULL)
+    return false;
+  out = fopen(to,"w");
+  if (out == NULL) {
+    fclose(in);
+    return false;
+  }
+  memset(present,0,sizeof(present));
+  while(fgets(line,sizeof(line),in)) {
+    if (line[0] == '#' || line[0] == '+')
+      skip = false;
+    if (!strncmp(line,"+XERAM::UsedPages",17)) {
+      skip = true;
+    } else if (sscanf(line,"+XERAM::Page%d",&page) == 1 && page >= 0 && page < BANK_PAGES) {
+      present[page] = true;
+    }
+    if (!skip)
+      fputs(line,out);
+  }
+  //
+  // Add the unused pages as blank pages.
+  fprintf(out,"#\n");
+  for(i = 0;i < BANK_PAGES;i++) {
+    if (!present[i]) {
+      snprintf(name,sizeof(name),"Page%d",i);
+      fprintf(out,"+XERAM::%s = \n",name);
+      for(j = 0;j < 256;j++) {
+	fprintf(out,"00");
+	if (j % 40 == 39)
+	  fprintf(out,"\n");
+      }
+      fprintf(out,"\n");
+    }
+  }
+  fclose(in);
+  return fclose(out) == 0;
+}
+///
+
+/// WriteDamaged
+// Write a copy of the snapshot whose last page chunk is cut short.
+// Returns false on an error.
+static bool WriteDamaged(const char *from,const char *to)
+{
+  FILE *in,*out;
+  char line[512];
+  long size = 0,last = 0;
+  //
+  in  = fopen(from,"r");
+  if (in == NULL)
+    return false;
+  // Find the start of the last page chunk.
+  while(fgets(line,sizeof(line),in)) {
+    if (!strncmp(line,"+XERAM::Page",12))
+      last = size;
+    size += long(strlen(line));
+  }
+  rewind(in);
+  out = fopen(to,"w");
+  if (out == NULL) {
+    fclose(in);
+    return false;
+  }
+  size = 0;
+  while(fgets(line,sizeof(line),in)) {
+    fputs(line,out);
+    size += long(strlen(line));
+    if (size > last)
+      break;
+  }
+  // Only a few bytes of the chunk.
+  fprintf(out,"0102\n");
+  fclose(in);
+  return fclose(out) == 0;
+}
+///
+
+/// RunTests
+// Run the tests on the machine.
+static void RunTests(void)
+{
+  bool thrown;
+  //
+  Mach->ColdStart();
+  Fill();
+  if (Check("filled memory"))
+    return;
+  //
+  Mach->WriteStates(NEW_STATE);
+  if (!WriteOldFormat(NEW_STATE,OLD_STATE) || !WriteDamaged(NEW_STATE,DAMAGED_STATE)) {
+    printf("unable to write the test snapshots\n");
+    Failures++;
+    return;
+  }
+  //
+  // A coldstart releases all pages of the banks.
+  Mach->ColdStart();
+  Mach->ReadStates(NEW_STATE);
+  Check("snapshot with the bitmap of the used pages");
+  //
+  Mach->ColdStart();
+  Mach->ReadStates(OLD_STATE);
+  Check("snapshot with all pages");
+  //
+  // Pages used by the machine but not in the snapshot must be
+  // released.
+  Scribble();
+  Mach->ReadStates(NEW_STATE);
+  Check("snapshot on top of used pages");
+  Scribble();
+  Mach->ReadStates(OLD_STATE);
+  Check("snapshot with all pages on top of used pages");
+  //
+  // A damaged snapshot must fail and leave the memory alone.
+  thrown = false;
+  try {
+    Mach->ReadStates(DAMAGED_STATE);
+  } catch(const AtariException &) {
+    thrown = true;
+  }
+  if (!thrown) {
+    printf("damaged snapshot: not detected\n");
+    Failures++;
+  }
+  Check("memory after a damaged snapshot");
+}
+///
+
+/// main
+int main(void)
+{
+  // The arguments must be modifiable.
+  static char arguments[][16] = {
+    "snapshottest",
+    "-machine","XE",
+    "-xebankbits","4",
+    "-xebankscheme","Compy",
+    "-frontend","None",
+    "-sound","Wav",
+    "-EnablePlayback","false",
+    "-ostype","BuiltIn",
+    "-basictype","disabled"
+  };
+  const int argc = int(sizeof(arguments) / sizeof(arguments[0]));
+  char *argv[argc + 1];
+  class CmdLineParser *args = NULL;
+  bool retry;
+  int i,rc = 0;
+  //
+  for(i = 0;i < argc;i++) {
+    argv[i] = arguments[i];
+  }
+  argv[argc] = NULL;
+  //
+  try {
+    Mach = new class Machine;
+    args = new class CmdLineParser;
+    Mach->BuildMachine(args);
+    if (!args->PreParseArgs(argc,argv,"command line")) {
+      printf("the arguments of the test are invalid\n");
+      rc = 20;
+    } else {
+      do {
+	retry = false;
+	try {
+	  Mach->ParseArgs(args);
+	} catch(const class AsyncEvent &) {
+	  // Parse again after the machine has been rebuilt.
+	  retry = true;
+	}
+      } while(retry);
+      Ram = Mach->MMU()->CPURAM();
+      RunTests();
+      rc  = (Failures)?(10):(0);
+    }
+  } catch(const AtariException &ex) {
+    class TestExceptionPrinter printer;
+    ex.PrintException(printer);
+    rc = 20;
+  }
+  //
+  unlink(NEW_STATE);
+  unlink(OLD_STATE);
+  unlink(DAMAGED_STATE);
+  delete args;
+  delete Mach;
+  //
+  return rc;
+}
+///
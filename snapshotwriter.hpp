@@ -85,6 +85,18 @@ public:
   // This is the only additional method here, required to load/save entire blocks
   virtual void DefineChunk(const char *argname,const char *help,UBYTE *mem,size_t size);
   //
+  // This snapshot saves the state.
+  virtual bool isSaving(void) const
+  {
+    return true;
+  }
+  //
+  // Items are written immediately.
+  virtual bool isCollecting(void) const
+  {
+    return false;
+  }
+  //
 };
 ///
 
@@ -26,8 +26,9 @@ Sound::Sound(class Machine *mach)
     PokeyFreq(15700), // defaults to the even NTSC frequency base
     SignedSamples(false), Stereo(false), SixteenBit(false),
     LittleEndian(false), Interleaved(false), SamplingFreq(44100),
-    ConsoleSpeakerStat(false), PlayingBuffer(NULL),
-    EnableSound(true), EnableConsoleSpeaker(true), ConsoleVolume(32)
+    ConsoleSpeakerStat(false),
+    EnableSound(true), EnableConsoleSpeaker(true), ConsoleVolume(32),
+    EffectiveFreq(44100), TargetSamples(0), FillLevel(0), RateIntegral(0)
 {
 }
 ///
@@ -35,65 +36,50 @@ Sound::Sound(class Machine *mach)
 /// Sound::~Sound
 Sound::~Sound(void) 
 {
-  CleanBuffer();
+}
+///
+
+/// Sound::AllocateBuffer
+// Allocate the ring buffer such that it holds at least the given
+// number of samples in the sample format configured above.
+void Sound::AllocateBuffer(ULONG samples)
+{
+  Ring.Allocate(samples,SignedSamples,Stereo,SixteenBit,LittleEndian,Interleaved);
 }
 ///
 
 /// Sound::GenerateSamples
 // Generate the given number (not in bytes, but in number) of audio samples
-// and place them into the tail of the ready buffer list.
-// Make buffers at least fragsize samples large.
-ULONG Sound::GenerateSamples(ULONG numsamples,ULONG fragsize)
+// and place them into the ring buffer. Returns the number of generated
+// samples, which is smaller than requested if the ring buffer is full.
+ULONG Sound::GenerateSamples(ULONG numsamples)
 {
-  struct AudioBufferBase *ab;
-  UBYTE offset,*writeptr;
-  int disp;
-  ULONG generate = numsamples;
+  ULONG generate = Ring.FreeSamples();
+  UBYTE offset   = 0;
+  //
+  // Do not generate more than fits into the buffer. The output device
+  // is then late, and the samples would get lost anyhow.
+  if (generate > numsamples)
+    generate = numsamples;
+  numsamples = generate;
   //
-  // Check whether we still have a buffer pending that could take the samples. 
-  // The candidate is the tail of the ready buffer list.
+  // Compute the offset for the console speaker.
+  if (EnableConsoleSpeaker && ConsoleSpeakerStat) {
+    offset = UBYTE(ConsoleVolume);
+  }
   while(generate) {
-    ULONG todo = 0;
-    if ((ab = ReadyBuffers.Last())) 
-      todo = ab->FreeSamples();
-    if (todo > generate)
-      todo = generate;
-    if (todo == 0) {
-      ULONG newsize = generate;
-      // No, we cannot extend this buffer. Get a new one and make it at
-      // least as large as a fragment.
-      if (newsize < fragsize) {
-	newsize = fragsize;
-      }
-      // Remove the next available audio buffer from the free-list, or rebuild one.
-      ab = FreeBuffers.RemHead();
-      if (ab == NULL) {
-	ab = AudioBufferBase::NewBuffer(SignedSamples,Stereo,SixteenBit,LittleEndian,Interleaved);
-      }   
-      //
-      // Queue this into the tail of the audio device output queue immediately as not to
-      // loose it if someone throws.  
-      ReadyBuffers.AddTail(ab);
-      ab->Realloc(newsize);
-      todo = generate;
-    }
-    // Compute the offset for the console speaker.
-    offset = 0;
-    if (EnableConsoleSpeaker && ConsoleSpeakerStat) {
-      offset = UBYTE(ConsoleVolume);
-    }
-    // One way or another, we have now a sample buffer. 
-    // Now ask pokey to compute more samples. This also adds the console speaker offset
-    // right away.
-    writeptr = ab->WritePtr;
-    LeftPokey->ComputeSamples(ab,todo,SamplingFreq,offset);
-    // If we are generating interleaved samples, we must have a second pokey for that
-    // and now fill in the other half of the samples.
-    if ((disp = ab->ChannelOffset())) {
-      ab->WritePtr  = writeptr + disp;
-      RightPokey->ComputeSamples(ab,todo,SamplingFreq,offset);
-      ab->WritePtr -= disp;
+    ULONG todo = generate;
+    if (todo > ScratchSamples)
+      todo = ScratchSamples;
+    // Ask pokey to compute more samples. This also adds the console speaker offset
+    // right away. If we are generating interleaved samples, we must have a second
+    // pokey for that and fill in the other channel.
+    LeftPokey->ComputeSamples(LeftSamples,todo,SamplingFreq,offset);
+    if (Interleaved) {
+      RightPokey->ComputeSamples(RightSamples,todo,SamplingFreq,offset);
     }
+    // Convert them into the output format and append them to the ring.
+    Ring.PutSamples(LeftSamples,RightSamples,todo);
     generate -= todo;
   }
   //
@@ -106,14 +92,56 @@ ULONG Sound::GenerateSamples(ULONG numsamples,ULONG fragsize)
 // Cleanup the buffer for the next go
 void Sound::CleanBuffer(void)
 {  
-  struct AudioBufferBase *ab;
-  // Dispose the audio buffer nodes now.
-  while((ab = ReadyBuffers.RemHead()))
-    delete ab;
-  while((ab = FreeBuffers.RemHead()))
-    delete ab;  
-  delete PlayingBuffer;
-  PlayingBuffer = NULL;
+  Ring.Reset();
+}
+///
+
+/// Sound::ResetRateControl
+// Reset the latency control such that it keeps the given number of
+// samples in the ring buffer.
+void Sound::ResetRateControl(ULONG target)
+{
+  TargetSamples = target;
+  FillLevel     = LONG(target) << 4;
+  RateIntegral  = 0;
+  EffectiveFreq = SamplingFreq;
+}
+///
+
+/// Sound::ControlRate
+// Run the latency control on the current fill level of the ring
+// buffer and update the effective frequency. This should be run
+// once per frame by the emulation thread.
+void Sound::ControlRate(void)
+{
+  LONG limit = SamplingFreq >> 6; // never deviate more than 1.5% from the nominal rate
+  LONG error,correction;
+  //
+  // The output device takes samples in fragments, hence the fill level
+  // jumps by a fragment at a time. Filter this out first, over about
+  // sixteen frames.
+  FillLevel    += LONG(Ring.ReadySamples()) - (FillLevel >> 4);
+  error         = TargetSamples - (FillLevel >> 4);
+  //
+  // The integral part removes the steady drift between the emulation
+  // and the audio clock. Limit it to avoid wind-up while the emulation
+  // is late.
+  RateIntegral += error;
+  if (RateIntegral > (limit << 10))
+    RateIntegral = limit << 10;
+  if (RateIntegral < -(limit << 10))
+    RateIntegral = -(limit << 10);
+  //
+  // The proportional part pulls the fill level back to the set point
+  // within a couple of seconds. Note that a missing sample per second
+  // requires a rate correction of one Hz.
+  correction    = (error >> 2) + (RateIntegral >> 10);
+  if (correction > limit)
+    correction = limit;
+  if (correction < -limit)
+    correction = -limit;
+  //
+  EffectiveFreq = SamplingFreq + correction;
 }
 ///
 
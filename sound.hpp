@@ -18,12 +18,12 @@
 #include "vbiaction.hpp"
 #include "hbiaction.hpp"
 #include "pokey.hpp"
+#include "audiobuffer.hpp"
 ///
 
 /// Forwards
 class Machine;
 class Monitor;
-struct AudioBufferBase;
 ///
 
 /// Class Sound
@@ -47,11 +47,18 @@ protected:
   LONG                    SamplingFreq;
   // State of the console speaker (on or off)
   bool                    ConsoleSpeakerStat;
-  // The audio data ring-buffer. The first buffer contains free
-  // buffer slots, the second busy (to be played) ones.
-  List<AudioBufferBase>   FreeBuffers;
-  List<AudioBufferBase>   ReadyBuffers;
-  struct AudioBufferBase *PlayingBuffer;
+  // The audio data ring-buffer. Pokey output is converted into the
+  // format of the output device and appended here, the output device
+  // plays it back from the other end.
+  class AudioBuffer       Ring;
+  //
+  // Pokey renders its samples into the following before they are
+  // converted into the ring buffer.
+  enum {
+    ScratchSamples = 256
+  };
+  UBYTE                   LeftSamples[ScratchSamples];
+  UBYTE                   RightSamples[ScratchSamples];
   //  
   //  
   // Generic sound preferences.
@@ -59,15 +66,42 @@ protected:
   bool                    EnableConsoleSpeaker;  
   LONG                    ConsoleVolume; // volume of the console speaker
   //
+  // Latency control. The fill level of the ring buffer is kept at a
+  // set point by a PI controller that adjusts the rate at which pokey
+  // generates samples, i.e. the ratio between emulated time and audio
+  // time. This is the rate in samples per emulated second.
+  LONG                    EffectiveFreq;
+  //
+  // The set point of the controller in samples, the fill level of the
+  // ring buffer, low-pass filtered and scaled by 16, and the integral
+  // of the control error.
+  LONG                    TargetSamples;
+  LONG                    FillLevel;
+  LONG                    RateIntegral;
+  //
+  // Allocate the ring buffer such that it holds at least the given
+  // number of samples in the sample format configured above.
+  void AllocateBuffer(ULONG samples);
+  //
   // Generate the given number (not in bytes, but in number) of audio samples
-  // and place them into the tail of the ready buffer list.
-  // Make buffers at least fragsize samples large. Returns the number of
-  // generated samples (frames in the language of ALSA).
-  ULONG GenerateSamples(ULONG numsamples,ULONG fragsize);
+  // and place them into the ring buffer. Returns the number of generated
+  // samples (frames in the language of ALSA), which is smaller than
+  // requested if the ring buffer is full.
+  ULONG GenerateSamples(ULONG numsamples);
   //
-  // Cleanup the buffer for the next go
+  // Cleanup the buffer for the next go. The output device must not
+  // play from the buffer while this is called.
   void CleanBuffer(void);
   //
+  // Reset the latency control such that it keeps the given number of
+  // samples in the ring buffer.
+  void ResetRateControl(ULONG target);
+  //
+  // Run the latency control on the current fill level of the ring
+  // buffer and update the effective frequency. This should be run
+  // once per frame by the emulation thread.
+  void ControlRate(void);
+  //
   // On VBI, provided we aren't late, update the sound.
   // This implements the interface of the VBIAction class.
   // This is the one and only class in the VBI chain that finally
@@ -93,6 +127,20 @@ public:
   // Turn the console speaker on or off
   virtual void ConsoleSpeaker(bool onoff) = 0;
   //
+  // Check whether the sound is rendered offline. If so, the emulation
+  // is not timed by the sound output but runs as fast as possible.
+  virtual bool isOffline(void) const
+  {
+    return false;
+  }
+  //
+  // Check whether the display may skip its refresh while the sound
+  // is rendered offline.
+  virtual bool isVideoSkipped(void) const
+  {
+    return false;
+  }
+  //
   // the following are imported by the Chip class:
   virtual void ColdStart(void) = 0;
   virtual void WarmStart(void) = 0;
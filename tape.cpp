@@ -19,12 +19,20 @@
 #include "wavdecoder.hpp"
 ///
 
+/// Defines
+// The gap in milliseconds standard records are shortened to in
+// turbo mode. This is the short IRG the Os writes, the cassette
+// handler always listens this quickly after starting the motor.
+#define TURBO_IRG 160
+///
+
 /// Tape::Tape
 // Construct a tape drive.
 Tape::Tape(class Machine *mach,const char *name)
   : SerialDevice(mach,name,0x60), VBIAction(mach),
     Pokey(NULL), SIO(NULL), TapeImg(NULL), File(NULL),
-    Playing(false), Recording(false), RecordAsWav(false), ReadNextRecord(false), RecordSize(0),
+    Playing(false), Recording(false), RecordAsWav(false), CacheWav(false), TurboTape(false), TurboFallback(false),
+    ReadNextRecord(false), RecordSize(0),
     NTSC(false), isAuto(true), IRGCounter(0), MotorOffCounter(0), EOFGap(3000), TicksPerFrame(0), 
     ImageToLoad(NULL), ImageName(NULL), SIODirect(false)
 {
@@ -144,6 +152,25 @@ UBYTE Tape::AcknowledgeCommandFrame(const UBYTE *,UWORD &,UWORD &)
 }
 ///
 
+/// Tape::isStandardRecord
+// Check whether the record in the buffer is a standard record
+// as written by the Os, i.e. one that can be loaded fast.
+bool Tape::isStandardRecord(void) const
+{
+  // The Os writes records of 128 data bytes behind two sync
+  // bytes and a control byte for a full, partial or EOF
+  // record, followed by the checksum.
+  if (RecordSize != 128 + 3 + 1 || SIO == NULL)
+    return false;
+  if (Buffer[0] != 0x55 || Buffer[1] != 0x55)
+    return false;
+  if (Buffer[2] != 0xfc && Buffer[2] != 0xfa && Buffer[2] != 0xfe)
+    return false;
+  //
+  return SIO->ChkSum(Buffer,128 + 3) == Buffer[128 + 3];
+}
+///
+
 /// Tape::FillRecordBuffer
 // Fill the record buffer with the next record for reading from tape.
 void Tape::FillRecordBuffer(void)
@@ -154,6 +181,18 @@ void Tape::FillRecordBuffer(void)
   //
   // Got any data or EOF? On EOF, just stop delivering anything...
   if (RecordSize > 0) {
+    // In turbo mode, the leader and the long gaps of standard records
+    // are shortened as the Os does not depend on them. The first record
+    // in another format indicates a custom loader that might, so keep
+    // the timing from then on.
+    if (TurboTape && TurboFallback == false) {
+      if (isStandardRecord()) {
+	if (irg > TURBO_IRG)
+	  irg = TURBO_IRG;
+      } else {
+	TurboFallback = true;
+      }
+    }
     // Compute the size in frames until the data starts.
     // irg / 1000 is the time in seconds.
     // 15700 / ticksperframe is the frame rate in Hz.
@@ -400,6 +439,141 @@ void Tape::InsertTape()
 }
 ///
 
+/// Tape::HashOf
+// Compute a hash of the contents of the given file,
+// and its size. This is a 64 bit FNV-1a hash.
+UQUAD Tape::HashOf(FILE *file,ULONG &size)
+{
+  UBYTE buffer[4096];
+  UQUAD hash = (UQUAD(0xcbf29ce4UL) << 32) | 0x84222325UL;
+  size_t len,i;
+
+  size = 0;
+  rewind(file);
+  while((len = fread(buffer,1,sizeof(buffer),file)) > 0) {
+    for(i = 0;i < len;i++) {
+      hash ^= buffer[i];
+      hash *= (UQUAD(0x00000100UL) << 32) | 0x000001b3UL;
+    }
+    size += len;
+  }
+  if (ferror(file))
+    ThrowIo("Tape::HashOf","unable to read the tape image");
+  rewind(file);
+
+  return hash;
+}
+///
+
+/// Tape::OpenDecodedImage
+// Replace the WAV image just opened by the CAS file
+// decoded from it, and create this file if it does
+// not yet exist. The decoded file is named as the WAV file
+// with ".cache.cas" appended such that it never replaces a
+// tape image of the user, and remembers the hash of the WAV
+// file it was decoded from. Errors on the decoded file are
+// ignored, the WAV file is decoded while playing then.
+void Tape::OpenDecodedImage(void)
+{
+  char *name;
+  FILE *source,*decoded;
+  class CASFile *cas = NULL;
+  UBYTE buffer[3+256+1];
+  UWORD size,irg,baud = 0;
+  ULONG length;
+  UQUAD hash;
+  //
+  // Hash the WAV file through a separate handle such that the
+  // decoder is not disturbed.
+  source = fopen(ImageName,"rb");
+  if (source == NULL)
+    return;
+  try {
+    hash = HashOf(source,length);
+  } catch(...) {
+    fclose(source);
+    return;
+  }
+  fclose(source);
+  //
+  name = new char[strlen(ImageName) + 11];
+  strcpy(name,ImageName);
+  strcat(name,".cache.cas");
+  //
+  // First check whether a decoded file exists and belongs to
+  // this WAV file.
+  decoded = fopen(name,"rb");
+  if (decoded) {
+    bool valid;
+    cas   = new class CASFile(decoded);
+    valid = cas->HasSourceHash(hash,length);
+    if (valid) {
+      delete TapeImg;
+      fclose(File);
+      delete[] name;
+      TapeImg = cas;
+      File    = decoded;
+      TapeImg->OpenForReading();
+      return;
+    }
+    delete cas;
+    fclose(decoded);
+    cas = NULL;
+  }
+  //
+  // Otherwise, decode the complete WAV file now. If the directory
+  // is not writable, just decode the WAV file while playing.
+  decoded = fopen(name,"w+b");
+  if (decoded == NULL) {
+    delete[] name;
+    return;
+  }
+  try {
+    cas = new class CASFile(decoded);
+    cas->OpenForWriting();
+    while((size = TapeImg->ReadChunk(buffer,sizeof(buffer),irg)) > 0) {
+      // Keep the baud rate detected for the record whenever it
+      // changes.
+      if (TapeImg->BaudRateOf() != baud) {
+	baud = TapeImg->BaudRateOf();
+	cas->WriteBaudRate(baud);
+      }
+      cas->WriteChunk(buffer,size,irg);
+    }
+    // The hash comes last and marks the file as complete.
+    cas->WriteSourceHash(hash,length);
+    if (fflush(decoded) != 0)
+      ThrowIo("Tape::OpenDecodedImage","unable to write the decoded tape image");
+  } catch(...) {
+    // Decoding failed. Remove the incomplete file and
+    // decode the WAV file again while playing such that
+    // the errors are reported where they happen.
+    delete cas;
+    fclose(decoded);
+    remove(name);
+    delete[] name;
+    delete TapeImg;
+    TapeImg = NULL;
+    fclose(File);
+    File    = fopen(ImageName,"rb");
+    if (File == NULL)
+      ThrowIo("Tape::OpenDecodedImage","unable to reopen the tape file");
+    TapeImg = TapeImage::CreateImageForFile(machine,File);
+    TapeImg->OpenForReading();
+    return;
+  }
+  //
+  // Continue with the decoded file.
+  delete[] name;
+  delete TapeImg;
+  fclose(File);
+  rewind(decoded);
+  TapeImg = cas;
+  File    = decoded;
+  TapeImg->OpenForReading();
+}
+///
+
 /// Tape::EjectTape
 // Eject the tape.
 void Tape::EjectTape()
@@ -435,13 +609,16 @@ void Tape::OpenImage(void)
     } else {
       File = fopen(ImageName,"rb");
       // For the time, ignore errors here.
-      IRGCounter = 0;
-      RecordSize = 0;
+      IRGCounter    = 0;
+      RecordSize    = 0;
+      TurboFallback = false;
       //
       // Create the new tape reader if we have input.
       if (File) {
 	TapeImg        = TapeImage::CreateImageForFile(machine,File);
 	TapeImg->OpenForReading();
+	if (CacheWav && TapeImg->isAudio())
+	  OpenDecodedImage();
 	ReadNextRecord = true;
 	//IRGCounter     = (NTSC)?(864):(720);
 	IRGCounter     = (NTSC)?(6):(5);
@@ -486,6 +663,8 @@ void Tape::ParseArgs(class ArgParser *args)
   args->DefineBool("Record","press the record button on the tape recorder",Recording);
   args->DefineBool("Eject","unload the tape from the recorder",eject);
   args->DefineBool("RecordAsWav","write tape output as WAV file",RecordAsWav);
+  args->DefineBool("CacheWav","keep WAV images decoded as CAS file next to them",CacheWav);
+  args->DefineBool("TurboTape","shorten the gaps between standard tape records",TurboTape);
 
   switch(val) {
   case 0:
@@ -554,12 +733,14 @@ void Tape::DisplayStatus(class Monitor *mon)
 		   "\tIRG Counter      : %ld\n"
 		   "\tMotor is         : %s\n"
 		   "\tPlay is          : %s\n"
-		   "\tRecord is        : %s\n",
+		   "\tRecord is        : %s\n"
+		   "\tTurbo loading    : %s\n",
 		   ImageName?ImageName:"",
 		   long(IRGCounter),
 		   motorstatus,
 		   Playing?("pressed"):("released"),
-		   Recording?("pressed"):("released")
+		   Recording?("pressed"):("released"),
+		   TurboTape?(TurboFallback?("on, custom loader found"):("on")):("off")
 		   );
 }
 ///
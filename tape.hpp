@@ -52,6 +52,17 @@ class Tape : public SerialDevice, private VBIAction {
   // Write the output as WAV file?
   bool             RecordAsWav;
   //
+  // Keep WAV images decoded as CAS files next to them.
+  bool             CacheWav;
+  //
+  // Collapse the gaps between standard records to load faster?
+  bool             TurboTape;
+  //
+  // Set as soon as a record not in the Os format has been found
+  // on the tape. Such tapes use custom loaders, so the timing
+  // remains accurate from then on.
+  bool             TurboFallback;
+  //
   // Ready to read the next record?
   bool             ReadNextRecord;
   //
@@ -107,6 +118,19 @@ class Tape : public SerialDevice, private VBIAction {
   // on the settings.
   void OpenImage(void);
   //
+  // Compute a hash of the contents of the given file,
+  // and its size.
+  static UQUAD HashOf(FILE *file,ULONG &size);
+  //
+  // Replace the WAV image just opened by the CAS file
+  // decoded from it, and create this file if it does
+  // not yet exist.
+  void OpenDecodedImage(void);
+  //
+  // Check whether the record in the buffer is a standard record
+  // as written by the Os, i.e. one that can be loaded fast.
+  bool isStandardRecord(void) const;
+  //
   // Fill the record buffer with the next record for reading from tape.
   void FillRecordBuffer(void);
   //
@@ -61,6 +61,20 @@ public:
   virtual void OpenForReading(void)
   { };
   //
+  // Check whether this is an audio recording whose records
+  // have to be decoded from the signal first.
+  virtual bool isAudio(void) const
+  {
+    return false;
+  }
+  //
+  // Return the baud rate of the record read last. This is the
+  // standard rate unless the image knows better.
+  virtual UWORD BaudRateOf(void) const
+  {
+    return 600;
+  }
+  //
   // Byte-wise access to the contents, ignoring the IRGs
   // and the baud rate. This is the "cooked" access for
   // disk emulation.
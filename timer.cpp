@@ -309,3 +309,15 @@ long Timer::GetMicroDelay(void)
   return (now.tv_sec * 1000 + now.tv_usec / 1000);
 }
 ///
+
+/// Timer::MicroTime
+// Return a time stamp in microseconds for measuring short
+// intervals. Only differences of time stamps are meaningful.
+UQUAD Timer::MicroTime(void)
+{
+  struct Timeval now;
+  //
+  now.GetTimeOfDay();
+  return UQUAD(now.tv_sec) * UsecsPerSec + UQUAD(now.tv_usec);
+}
+///
@@ -12,6 +12,7 @@
 
 /// Includes
 #include "types.h"
+#include "types.hpp"
 #include "time.hpp"
 ///
 
@@ -157,6 +158,10 @@ public:
   // This is a pretty rough approximation as it is only 1/1000th of
   // the possible resolution... *sigh*
   long GetMicroDelay(void);
+  //
+  // Return a time stamp in microseconds for measuring short
+  // intervals. Only differences of time stamps are meaningful.
+  static UQUAD MicroTime(void);
 };
 ///
 
@@ -19,15 +19,20 @@
 #include <math.h>
 ///
 
+/// Defines
+// The mark and space frequencies of the tape in Hz.
+#define MARK_FREQUENCY  5327.0
+#define SPACE_FREQUENCY 3995.0
+// The damping of the analysis filters.
+#define FILTER_STABILIZE (7.0 / 8.0)
+///
+
 /// WavDecoder::GoertzelFFT::SetupFilter
 // Setup a filter for the given frequency
 void WavDecoder::GoertzelFFT::SetupFilter(double freq)
 {
   m_dCos       = 2.0 * cos(2.0 * M_PI / freq);
   m_dSin       = 2.0 * sin(2.0 * M_PI / freq);
-  m_dStabilize = 7.0 / 8.0;
-  m_dLeak      = 1.0 / (1 + m_dStabilize - m_dCos * m_dStabilize); // computed
-  m_d2MinusCos = 2.0 - m_dCos;
 }
 ///
 
@@ -38,26 +43,6 @@ WavDecoder::GoertzelFFT::GoertzelFFT(double samplingfreq)
 }
 ///
 
-/// WavDecoder::GoertzelFFT::Filter
-// Drive a value through the filter, record the output, which is
-// the squared of the filter response.
-double WavDecoder::GoertzelFFT::Filter(double v)
-{
-  double s_n;
-  double y,h;
-  
-  // Drive the filter
-  s_n       = m_dCos * m_dSN_1 - m_dSN_2 + v;
-  y         = v * m_dLeak;
-  h         = s_n * s_n + m_dSN_1 * m_dSN_1 - m_dCos * s_n * m_dSN_1
-    - y * m_d2MinusCos * (s_n + m_dSN_1) + y * y * m_d2MinusCos;
-  m_dSN_2   = m_dSN_1;
-  m_dSN_1   = m_dStabilize * s_n;
-  
-  return h;
-}
-///
-
 /// WavDecoder::GoertzelFFT::StartOscillator
 // Restart the oscillator with initial conditions of y=0, and y' sufficient
 // to create a +1 amplitude. This is for the synthesis.
@@ -99,56 +84,10 @@ double WavDecoder::GoertzelFFT::NextSample(void)
 
 /// WavDecoder::FilterPair::FilterPair
 WavDecoder::FilterPair::FilterPair(double samplingfreq,double shift)
-  : m_Mark(samplingfreq), m_Space(samplingfreq), m_bOut(false),
-    m_dHysteresis(1.5), m_dRatio(1.0),
-    m_dMarkAmplitude(0.0), m_dSpaceAmplitude(0.0),
-    m_dMarkNormalize(1.0), m_dSpaceNormalize(1.0),
-    m_dFreq(samplingfreq)
-{
-  m_Mark.SetFrequency(5327.0 * shift);
-  m_Space.SetFrequency(3995.0 * shift);
-}
-///
-
-/// WavDecoder::FilterPair::Filter
-// Drive a value through the filter, record the output, which is
-// the squared of the filter response.
-bool WavDecoder::FilterPair::Filter(double v)
-{
-  double m,s;
-  
-  m = m_Mark.Filter(v);
-  s = m_Space.Filter(v);
-  
-  if (m_bOut) {
-    // Switch potentially back to space
-    if (s * m_dSpaceNormalize > m * m_dHysteresis * m_dMarkNormalize)
-      m_bOut = false;
-  } else {
-    if (m * m_dMarkNormalize  > s * m_dHysteresis * m_dSpaceNormalize)
-      m_bOut = true;
-  }
-  
-  if (m_bOut) {
-    m_dRatio          = (31.0 * m_dRatio          + m) / 32.0;
-    m_dMarkAmplitude  = (31.0 * m_dMarkAmplitude  + m) / 32.0;
-  } else {
-    m_dRatio          = (31.0 * m_dRatio          + s) / 32.0;
-    m_dSpaceAmplitude = (31.0 * m_dSpaceAmplitude + s) / 32.0;
-  }
-  
-  return m_bOut;
-}
-///
-
-/// WavDecoder::FilterPair::NormalizeFilterGains
-// Normalize the filter gains.
-void WavDecoder::FilterPair::NormalizeFilterGains(void)
+  : m_Mark(samplingfreq), m_Space(samplingfreq), m_dFreq(samplingfreq)
 {
-  if (m_dMarkAmplitude > 0.0)
-    m_dMarkNormalize  = 1.0 / sqrt(m_dMarkAmplitude);
-  if (m_dSpaceAmplitude > 0.0)
-    m_dSpaceNormalize = 1.0 / sqrt(m_dSpaceAmplitude);
+  m_Mark.SetFrequency(MARK_FREQUENCY * shift);
+  m_Space.SetFrequency(SPACE_FREQUENCY * shift);
 }
 ///
 
@@ -220,45 +159,102 @@ void WavDecoder::FilterPair::WriteByte(class WavFile *out,UBYTE byte,UWORD baudr
 
 /// WavDecoder::FilterCascade::FilterCascade
 WavDecoder::FilterCascade::FilterCascade(double samplingfreq)
-  : m_pActiveFilter(NULL), m_dRatio(0.0),
+  : m_iActive(0), m_dPairHysteresis(1.5), m_dRatio(0.0),
     m_iOptimal(0), m_dHysteresis(1.2)
 {
   int i;
   double lshift = 1.0;
   double hshift = 1.0;
   
-  for(i = 0;i < m_iNFilters * 2 + 1;i++) {
-    m_ppFilter[i] = NULL;
-  }
-  
 #if DEBUG_LEVEL > 0
   memset(ones,0,sizeof(ones));
 #endif
   
-  try {
-    m_ppFilter[0] = new class FilterPair(samplingfreq,1.0);
-    m_Switch[0].m_iNext = 1; // lower frequency
-    m_Switch[0].m_iPrev = 2; // higher frequency
-    for(i = 1;i <= m_iNFilters;i++) {
-      lshift /= 1.03;
-      hshift *= 1.03;
-      m_ppFilter[2 * i - 1] = new class FilterPair(samplingfreq,lshift);
-      m_Switch  [2 * i - 1].m_iNext = ((i + 1) <= m_iNFilters)?(2 * i + 1):(-1); // lower frequency
-      m_Switch  [2 * i - 1].m_iPrev = ((i - 1) > 1)           ?(2 * i - 3):(0);  // higher frequency
-      m_ppFilter[2 * i - 0] = new class FilterPair(samplingfreq,hshift);
-      m_Switch  [2 * i - 0].m_iNext = ((i - 1) > 1)           ?(2 * i - 2):(0);  // lower frequency
-      m_Switch  [2 * i - 0].m_iPrev = ((i + 1) <= m_iNFilters)?(2 * i + 2):(-1); // higher frequency
-    }
-  } catch(...) {
-    for(i = 0;i < m_iNFilters * 2 + 1;i++) {
-      delete m_ppFilter[i];
-      m_ppFilter[i] = NULL;
-    }
-    throw;
+  for(i = 0;i < m_iNPairs;i++) {
+    m_iSlot[i] = i;
+    m_iPair[i] = i;
+  }
+  
+  SetupPair(0,samplingfreq,1.0);
+  m_Switch[0].m_iNext = 1; // lower frequency
+  m_Switch[0].m_iPrev = 2; // higher frequency
+  for(i = 1;i <= m_iNFilters;i++) {
+    lshift /= 1.03;
+    hshift *= 1.03;
+    SetupPair(2 * i - 1,samplingfreq,lshift);
+    m_Switch  [2 * i - 1].m_iNext = ((i + 1) <= m_iNFilters)?(2 * i + 1):(-1); // lower frequency
+    m_Switch  [2 * i - 1].m_iPrev = ((i - 1) > 1)           ?(2 * i - 3):(0);  // higher frequency
+    SetupPair(2 * i - 0,samplingfreq,hshift);
+    m_Switch  [2 * i - 0].m_iNext = ((i - 1) > 1)           ?(2 * i - 2):(0);  // lower frequency
+    m_Switch  [2 * i - 0].m_iPrev = ((i + 1) <= m_iNFilters)?(2 * i + 2):(-1); // higher frequency
   }
 }
 ///
 
+/// WavDecoder::FilterCascade::SetupFilter
+// Setup the mark or space filter in the given slot for the given
+// frequency, and reset its state.
+void WavDecoder::FilterCascade::SetupFilter(int f,int slot,double samplingfreq,double freq)
+{
+  double period = samplingfreq / freq;
+  double cosine = 2.0 * cos(2.0 * M_PI / period);
+  
+  m_dCos[f][slot]       = cosine;
+  m_dLeak[f][slot]      = 1.0 / (1 + FILTER_STABILIZE - cosine * FILTER_STABILIZE); // computed
+  m_d2MinusCos[f][slot] = 2.0 - cosine;
+  m_dSN_2[f][slot]      = 0.0;
+  m_dSN_1[f][slot]      = 0.0;
+  m_dAmplitude[f][slot] = 0.0;
+  m_dNormalize[f][slot] = 1.0;
+}
+///
+
+/// WavDecoder::FilterCascade::SetupPair
+// Setup the given filter pair and activate it. Shift is the
+// frequency bias. This also resets the state of the pair.
+void WavDecoder::FilterCascade::SetupPair(int i,double samplingfreq,double shift)
+{
+  int slot;
+  
+  if (!IsActive(i)) {
+    // Move the pair behind the active pairs.
+    SwapSlots(m_iSlot[i],m_iActive);
+    m_iActive++;
+  }
+  slot = m_iSlot[i];
+  SetupFilter(Mark ,slot,samplingfreq,MARK_FREQUENCY  * shift);
+  SetupFilter(Space,slot,samplingfreq,SPACE_FREQUENCY * shift);
+  m_bOut[slot]     = false;
+  m_dQuality[slot] = 1.0;
+}
+///
+
+/// WavDecoder::FilterCascade::SwapSlots
+// Exchange the contents of two slots of the filter bank.
+void WavDecoder::FilterCascade::SwapSlots(int a,int b)
+{
+  int f;
+  
+  if (a == b)
+    return;
+  
+  for(f = Mark;f <= Space;f++) {
+    Swap(m_dCos[f][a]      ,m_dCos[f][b]);
+    Swap(m_d2MinusCos[f][a],m_d2MinusCos[f][b]);
+    Swap(m_dLeak[f][a]     ,m_dLeak[f][b]);
+    Swap(m_dSN_2[f][a]     ,m_dSN_2[f][b]);
+    Swap(m_dSN_1[f][a]     ,m_dSN_1[f][b]);
+    Swap(m_dAmplitude[f][a],m_dAmplitude[f][b]);
+    Swap(m_dNormalize[f][a],m_dNormalize[f][b]);
+  }
+  Swap(m_bOut[a]    ,m_bOut[b]);
+  Swap(m_dQuality[a],m_dQuality[b]);
+  Swap(m_iPair[a]   ,m_iPair[b]);
+  m_iSlot[m_iPair[a]] = a;
+  m_iSlot[m_iPair[b]] = b;
+}
+///
+
 /// WavDecoder::FilterCascade::ResetFilters
 // Reset all filters and filter states
 void WavDecoder::FilterCascade::ResetFilters(double samplingfreq)
@@ -271,29 +267,71 @@ void WavDecoder::FilterCascade::ResetFilters(double samplingfreq)
   memset(ones,0,sizeof(ones));
 #endif
   
-  if (m_ppFilter[0] == NULL)
-    m_ppFilter[0] = new class FilterPair(samplingfreq,1.0);
+  if (!IsActive(0))
+    SetupPair(0,samplingfreq,1.0);
   
   for(i = 1;i <= m_iNFilters;i++) {
     lshift /= 1.03;
     hshift *= 1.03;
-    if (m_ppFilter[2 * i - 1] == NULL)
-      m_ppFilter[2 * i - 1] = new class FilterPair(samplingfreq,lshift);
-    if (m_ppFilter[2 * i - 0] == NULL)
-      m_ppFilter[2 * i - 0] = new class FilterPair(samplingfreq,hshift);
+    if (!IsActive(2 * i - 1))
+      SetupPair(2 * i - 1,samplingfreq,lshift);
+    if (!IsActive(2 * i - 0))
+      SetupPair(2 * i - 0,samplingfreq,hshift);
   }
 }
 ///
 
-/// WavDecoder::FilterCascade::~WavDecoder
-WavDecoder::FilterCascade::~FilterCascade(void)
+/// WavDecoder::FilterCascade::FilterBank
+// Drive a value through all active filters of the bank and update
+// the output decisions of the active pairs.
+void WavDecoder::FilterCascade::FilterBank(double v)
 {
-  int i;
+  double response[2][m_iNPairs];
+  int active = m_iActive;
+  int f,i;
+  //
+  // Drive the filters. There are no dependencies between the
+  // filters, hence this loop vectorizes.
+  for(f = Mark;f <= Space;f++) {
+    const double *cs = m_dCos[f];
+    const double *lk = m_dLeak[f];
+    const double *mc = m_d2MinusCos[f];
+    double *sn_1     = m_dSN_1[f];
+    double *sn_2     = m_dSN_2[f];
+    double *h        = response[f];
+    for(i = 0;i < active;i++) {
+      double s_n,y;
+      //
+      s_n     = cs[i] * sn_1[i] - sn_2[i] + v;
+      y       = v * lk[i];
+      h[i]    = s_n * s_n + sn_1[i] * sn_1[i] - cs[i] * s_n * sn_1[i]
+	- y * mc[i] * (s_n + sn_1[i]) + y * y * mc[i];
+      sn_2[i] = sn_1[i];
+      sn_1[i] = FILTER_STABILIZE * s_n;
+    }
+  }
+  //
+  // Update the outputs of the pairs and monitor their quality.
+  for(i = 0;i < active;i++) {
+    double m = response[Mark][i];
+    double s = response[Space][i];
+    // Switch potentially back to space, or to mark.
+    bool tospace = s * m_dNormalize[Space][i] > m * m_dPairHysteresis * m_dNormalize[Mark][i];
+    bool tomark  = m * m_dNormalize[Mark][i]  > s * m_dPairHysteresis * m_dNormalize[Space][i];
+    bool out     = (m_bOut[i])?(!tospace):(tomark);
+    //
+    m_bOut[i]              = out;
+    m_dQuality[i]          = (31.0 * m_dQuality[i] + ((out)?(m):(s))) / 32.0;
+    m_dAmplitude[Mark][i]  = (out)?((31.0 * m_dAmplitude[Mark][i]  + m) / 32.0):(m_dAmplitude[Mark][i]);
+    m_dAmplitude[Space][i] = (out)?(m_dAmplitude[Space][i]):((31.0 * m_dAmplitude[Space][i] + s) / 32.0);
+  }
   
-  for(i = 0;i < m_iNFilters * 2 + 1;i++) {
-    delete m_ppFilter[i];
-    m_ppFilter[i] = NULL;
+#if DEBUG_LEVEL > 0
+  for(i = 0;i < active;i++) {
+    if (m_bOut[i])
+      ones[m_iPair[i]]++;
   }
+#endif
 }
 ///
 
@@ -302,36 +340,22 @@ WavDecoder::FilterCascade::~FilterCascade(void)
 // the squared of the filter response.
 bool WavDecoder::FilterCascade::Filter(double v,bool adjustfilters)
 {
-  int i;
-  
-  for(i = 0;i < m_iNFilters * 2 + 1;i++) {
-    if (m_ppFilter[i])
-      m_ppFilter[i]->Filter(v);
-  }
+  FilterBank(v);
   
-#if DEBUG
-  for(i = 0;i < m_iNFilters * 2 + 1;i++) {
-    if (m_ppFilter[i]) {
-      if (m_ppFilter[i]->OutputOf())
-	ones[i]++;
-    }
-  }
-#endif
-  
-  if (m_ppFilter[m_iOptimal]) {
+  if (IsActive(m_iOptimal)) {
     if (adjustfilters) {
-      if (m_Switch[m_iOptimal].m_iNext >= 0 && m_ppFilter[m_Switch[m_iOptimal].m_iNext] &&
-	  m_ppFilter[m_Switch[m_iOptimal].m_iNext]->QualityOf() > m_ppFilter[m_iOptimal]->QualityOf() * m_dHysteresis) {
+      if (m_Switch[m_iOptimal].m_iNext >= 0 && IsActive(m_Switch[m_iOptimal].m_iNext) &&
+	  QualityOf(m_Switch[m_iOptimal].m_iNext) > QualityOf(m_iOptimal) * m_dHysteresis) {
 	m_iOptimal = m_Switch[m_iOptimal].m_iNext;
       }
-      if (m_Switch[m_iOptimal].m_iPrev >= 0 && m_ppFilter[m_Switch[m_iOptimal].m_iPrev] &&
-	  m_ppFilter[m_Switch[m_iOptimal].m_iPrev]->QualityOf() > m_ppFilter[m_iOptimal]->QualityOf() * m_dHysteresis) {
+      if (m_Switch[m_iOptimal].m_iPrev >= 0 && IsActive(m_Switch[m_iOptimal].m_iPrev) &&
+	  QualityOf(m_Switch[m_iOptimal].m_iPrev) > QualityOf(m_iOptimal) * m_dHysteresis) {
 	m_iOptimal = m_Switch[m_iOptimal].m_iPrev;
       }
-      m_dRatio = m_ppFilter[m_iOptimal]->QualityOf();
+      m_dRatio = QualityOf(m_iOptimal);
     }
     
-    return m_ppFilter[m_iOptimal]->OutputOf();
+    return OutputOf(m_iOptimal);
   } else {
     // Always return mark, i.e. no start bit.
     return true;
@@ -345,56 +369,42 @@ bool WavDecoder::FilterCascade::Filter(double v,bool adjustfilters)
 // have the expected result - if possible.
 bool WavDecoder::FilterCascade::Filter(double v,bool adjustfilters,bool expected)
 {
-  int i;
+  FilterBank(v);
   
-  for(i = 0;i < m_iNFilters * 2 + 1;i++) {
-    if (m_ppFilter[i])
-      m_ppFilter[i]->Filter(v);
-  }
-  
-#if DEBUG_LEVEL > 0
-  for(i = 0;i < m_iNFilters * 2 + 1;i++) {
-    if (m_ppFilter[i]) {
-      if (m_ppFilter[i]->OutputOf())
-	ones[i]++;
-    }
-  }
-#endif 
-  
-  if (m_ppFilter[m_iOptimal]) {
+  if (IsActive(m_iOptimal)) {
     if (adjustfilters) {
-      if (m_Switch[m_iOptimal].m_iNext >= 0 && m_ppFilter[m_Switch[m_iOptimal].m_iNext] &&
-	  m_ppFilter[m_Switch[m_iOptimal].m_iNext]->OutputOf() == expected &&
-	  m_ppFilter[m_Switch[m_iOptimal].m_iNext]->QualityOf() > m_ppFilter[m_iOptimal]->QualityOf() * m_dHysteresis) {
+      if (m_Switch[m_iOptimal].m_iNext >= 0 && IsActive(m_Switch[m_iOptimal].m_iNext) &&
+	  OutputOf(m_Switch[m_iOptimal].m_iNext) == expected &&
+	  QualityOf(m_Switch[m_iOptimal].m_iNext) > QualityOf(m_iOptimal) * m_dHysteresis) {
 	m_iOptimal = m_Switch[m_iOptimal].m_iNext;
       }
-      if (m_Switch[m_iOptimal].m_iPrev >= 0 && m_ppFilter[m_Switch[m_iOptimal].m_iPrev] &&
-	  m_ppFilter[m_Switch[m_iOptimal].m_iPrev]->OutputOf() == expected &&
-	  m_ppFilter[m_Switch[m_iOptimal].m_iPrev]->QualityOf() > m_ppFilter[m_iOptimal]->QualityOf() * m_dHysteresis) {
+      if (m_Switch[m_iOptimal].m_iPrev >= 0 && IsActive(m_Switch[m_iOptimal].m_iPrev) &&
+	  OutputOf(m_Switch[m_iOptimal].m_iPrev) == expected &&
+	  QualityOf(m_Switch[m_iOptimal].m_iPrev) > QualityOf(m_iOptimal) * m_dHysteresis) {
 	m_iOptimal = m_Switch[m_iOptimal].m_iPrev;
       }
-      m_dRatio = m_ppFilter[m_iOptimal]->QualityOf();
+      m_dRatio = QualityOf(m_iOptimal);
     }
     
-    if (m_ppFilter[m_iOptimal]->OutputOf() == expected) {
+    if (OutputOf(m_iOptimal) == expected) {
       return expected;
-    } else if (m_Switch[m_iOptimal].m_iNext >= 0 && m_ppFilter[m_Switch[m_iOptimal].m_iNext] &&
-	       m_ppFilter[m_Switch[m_iOptimal].m_iNext]->OutputOf() == expected) {
+    } else if (m_Switch[m_iOptimal].m_iNext >= 0 && IsActive(m_Switch[m_iOptimal].m_iNext) &&
+	       OutputOf(m_Switch[m_iOptimal].m_iNext) == expected) {
       if (adjustfilters) {
 	m_iOptimal = m_Switch[m_iOptimal].m_iNext;
-	m_dRatio   = m_ppFilter[m_iOptimal]->QualityOf();
+	m_dRatio   = QualityOf(m_iOptimal);
       }
       return expected;
-    } else if (m_Switch[m_iOptimal].m_iPrev >= 0 && m_ppFilter[m_Switch[m_iOptimal].m_iPrev] &&
-	       m_ppFilter[m_Switch[m_iOptimal].m_iPrev]->OutputOf() == expected) {
+    } else if (m_Switch[m_iOptimal].m_iPrev >= 0 && IsActive(m_Switch[m_iOptimal].m_iPrev) &&
+	       OutputOf(m_Switch[m_iOptimal].m_iPrev) == expected) {
       if (adjustfilters) {
 	m_iOptimal = m_Switch[m_iOptimal].m_iPrev;	
-	m_dRatio   = m_ppFilter[m_iOptimal]->QualityOf();
+	m_dRatio   = QualityOf(m_iOptimal);
       }
       return expected;
     }
     
-    return m_ppFilter[m_iOptimal]->OutputOf();
+    return OutputOf(m_iOptimal);
   } else {
       // Always return mark, i.e. the idle line.
     return true;
@@ -406,7 +416,7 @@ bool WavDecoder::FilterCascade::Filter(double v,bool adjustfilters,bool expected
 // Return the best quality ratio we could find.
 double WavDecoder::FilterCascade::QualityOf(void) const
 {
-  if (m_ppFilter[m_iOptimal] == NULL)
+  if (!IsActive(m_iOptimal))
     return 0.0; // dead channel
   
   return m_dRatio;
@@ -420,25 +430,26 @@ bool WavDecoder::FilterCascade::RemoveIncorrectFiltersFor(bool bitvalue)
 {
   int i;
   
-  for(i = 0;i < m_iNFilters * 2 + 1;i++) {
-    if (m_ppFilter[i]) {
-      if (m_ppFilter[i]->OutputOf() != bitvalue) {
-	delete m_ppFilter[i];
-	m_ppFilter[i] = NULL;
+  for(i = 0;i < m_iNPairs;i++) {
+    if (IsActive(i)) {
+      if (OutputOf(i) != bitvalue) {
+	// Move the pair behind the active pairs.
+	m_iActive--;
+	SwapSlots(m_iSlot[i],m_iActive);
       }
     }
   }
   
-  if (m_ppFilter[m_iOptimal] == NULL) {
-    if (m_Switch[m_iOptimal].m_iNext >= 0 && m_ppFilter[m_Switch[m_iOptimal].m_iNext]) {
+  if (!IsActive(m_iOptimal)) {
+    if (m_Switch[m_iOptimal].m_iNext >= 0 && IsActive(m_Switch[m_iOptimal].m_iNext)) {
       m_iOptimal = m_Switch[m_iOptimal].m_iNext;
-    } else if (m_Switch[m_iOptimal].m_iPrev >= 0 && m_ppFilter[m_Switch[m_iOptimal].m_iPrev]) {
+    } else if (m_Switch[m_iOptimal].m_iPrev >= 0 && IsActive(m_Switch[m_iOptimal].m_iPrev)) {
       m_iOptimal = m_Switch[m_iOptimal].m_iPrev;
     } else {
       return false;
     }
   }
-  if (m_ppFilter[m_iOptimal] == NULL) {
+  if (!IsActive(m_iOptimal)) {
     return false;
   }
   return true;
@@ -453,21 +464,21 @@ bool WavDecoder::FilterCascade::FindOptimalFilterFor(bool bitvalue)
   int i;
   double bestratio = 0.0;
   
-  for(i = 0;i < m_iNFilters * 2 + 1;i++) {
-    if (m_ppFilter[i]) {
-      if (m_ppFilter[i]->OutputOf() == bitvalue) {
-	if (m_ppFilter[i]->QualityOf() > bestratio) {
-	  bestratio  = m_ppFilter[m_iOptimal]->QualityOf();
+  for(i = 0;i < m_iNPairs;i++) {
+    if (IsActive(i)) {
+      if (OutputOf(i) == bitvalue) {
+	if (QualityOf(i) > bestratio) {
+	  bestratio  = QualityOf(m_iOptimal);
 	  m_iOptimal = i;
 	}
       }
     }
   }
   
-  if (m_ppFilter[m_iOptimal] == NULL)
+  if (!IsActive(m_iOptimal))
     return false;
       
-  m_dRatio = m_ppFilter[m_iOptimal]->QualityOf();
+  m_dRatio = QualityOf(m_iOptimal);
   return true;
 }
 ///
@@ -478,17 +489,18 @@ void WavDecoder::FilterCascade::NormalizeFilterGains(void)
 {
   int i;
   
-  for(i = 0;i < m_iNFilters * 2 + 1;i++) {
-    if (m_ppFilter[i]) {
-      m_ppFilter[i]->NormalizeFilterGains();
-    }
+  for(i = 0;i < m_iActive;i++) {
+    if (m_dAmplitude[Mark][i] > 0.0)
+      m_dNormalize[Mark][i]  = 1.0 / sqrt(m_dAmplitude[Mark][i]);
+    if (m_dAmplitude[Space][i] > 0.0)
+      m_dNormalize[Space][i] = 1.0 / sqrt(m_dAmplitude[Space][i]);
   }
 }
 ///
 
 /// WavDecoder::ChannelFilter::ChannelFilter
-WavDecoder::ChannelFilter::ChannelFilter(double samplingfreq)
-  : m_Left(samplingfreq), m_Right(samplingfreq), m_dHysteresis(2.0),
+WavDecoder::ChannelFilter::ChannelFilter(double samplingfreq,bool stereo)
+  : m_Left(samplingfreq), m_Right(samplingfreq), m_bStereo(stereo), m_dHysteresis(2.0),
     m_iActiveInput(0), m_dRatio(1.0)
 {
 }
@@ -502,6 +514,11 @@ bool WavDecoder::ChannelFilter::Filter(double left,double right,bool adjustfilte
   bool left_out,right_out;
   
   left_out  = m_Left.Filter(left,adjustfilters);
+  //
+  // For a mono recording, the right channel would always decode
+  // exactly as the left one, and would never be selected.
+  if (!m_bStereo)
+    return left_out;
   right_out = m_Right.Filter(right,adjustfilters);
   
   if (adjustfilters) {
@@ -533,6 +550,8 @@ bool WavDecoder::ChannelFilter::Filter(double left,double right,bool adjustfilte
   bool left_out,right_out;
   
   left_out  = m_Left.Filter(left,adjustfilters,expected);
+  if (!m_bStereo)
+    return left_out;
   right_out = m_Right.Filter(right,adjustfilters,expected);
   
   if (adjustfilters) {
@@ -576,7 +595,7 @@ void WavDecoder::ChannelFilter::FindOptimalFilterFor(bool bitvalue)
   if (m_Left.FindOptimalFilterFor(bitvalue))
     worked = true;
   
-  if (m_Right.FindOptimalFilterFor(bitvalue))
+  if (m_bStereo && m_Right.FindOptimalFilterFor(bitvalue))
     worked = true;
   
   if (!worked)
@@ -594,7 +613,7 @@ void WavDecoder::ChannelFilter::RemoveIncorrectFiltersFor(bool bitvalue)
   
   if (m_Left.RemoveIncorrectFiltersFor(bitvalue))
     worked = true;
-  if (m_Right.RemoveIncorrectFiltersFor(bitvalue))
+  if (m_bStereo && m_Right.RemoveIncorrectFiltersFor(bitvalue))
     worked = true;
   
   if (!worked)
@@ -608,7 +627,8 @@ void WavDecoder::ChannelFilter::RemoveIncorrectFiltersFor(bool bitvalue)
 void WavDecoder::ChannelFilter::NormalizeFilterGains(void)
 {
   m_Left.NormalizeFilterGains();
-  m_Right.NormalizeFilterGains();
+  if (m_bStereo)
+    m_Right.NormalizeFilterGains();
 }
 ///
 
@@ -618,7 +638,8 @@ void WavDecoder::ChannelFilter::NormalizeFilterGains(void)
 void WavDecoder::ChannelFilter::ResetFilters(double samplingfreq)
 {
   m_Left.ResetFilters(samplingfreq);
-  m_Right.ResetFilters(samplingfreq);
+  if (m_bStereo)
+    m_Right.ResetFilters(samplingfreq);
 }
 ///
 
@@ -986,7 +1007,7 @@ void WavDecoder::SerialDecoder::ResetFilters(void)
 WavDecoder::WavDecoder(class Machine *mach,FILE *in)
   : VBIAction(mach), m_pMachine(mach), m_pDecoder(NULL), m_pFilter(NULL), m_pFile(in), m_pWav(NULL),
     m_ucChecksum(0), m_ucRecordType(0), m_pSynthesis(NULL), m_dLag(0.0), m_bPositive(true),
-    m_dIRG(0.0), m_dSyncDuration(0.0), m_DecoderState(TapeEOF), m_pucBufPtr(NULL), m_bBadEOF(false)
+    m_dIRG(0.0), m_dSyncDuration(0.0), m_dBaud(600.0), m_DecoderState(TapeEOF), m_pucBufPtr(NULL), m_bBadEOF(false)
 {
 }
 ///
@@ -1029,7 +1050,7 @@ void WavDecoder::OpenForReading(void)
   m_pWav->ParseHeader();
 
   // Create the frequency analysing filter.
-  m_pFilter = new ChannelFilter(m_pWav->FrequencyOf());
+  m_pFilter = new ChannelFilter(m_pWav->FrequencyOf(),m_pWav->NumChannelsOf() > 1);
 
   //
   // The decoder is not yet there. So create it now.
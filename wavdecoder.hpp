@@ -33,29 +33,20 @@ class Machine;
 // is not supported currently.
 class WavDecoder : public TapeImage, private VBIAction {
   //
-  // A simple fast filter using the Goertzel-Algorithm.
+  // A simple oscillator using the Goertzel-Algorithm. This is used
+  // for synthesis.
   class GoertzelFFT {
     //
     // The cosine of the frequency, defines the response frequency.
     double m_dCos;
     double m_dSin;
     //
-    // 2.0 - cos
-    double m_d2MinusCos;
-    //
-    // The DC leakage compensation of the groetzel filter.
-    double m_dLeak;
-    //
     // The frequency for which the filter was setup.
     double m_dFreq;
     //
     // The sampling frequency of the wav file.
     double m_dSamplingFreq;
     //
-    // Stabilization constant.
-    double m_dStabilize;
-    //
-    //
     // Filter delay lines.
     double m_dSN_2;
     double m_dSN_1;
@@ -82,10 +73,6 @@ class WavDecoder : public TapeImage, private VBIAction {
       SetupFilter(m_dSamplingFreq / freq);
     }
     //
-    // Drive a value through the filter, record the output, which is
-    // the squared of the filter response.
-    double Filter(double v);
-    //
     // Restart the oscillator with initial conditions of y=0, and y' sufficient
     // to create a +1 amplitude. This is for the synthesis.
     void StartOscillator(bool positive);
@@ -94,30 +81,14 @@ class WavDecoder : public TapeImage, private VBIAction {
     double NextSample(void);
   };
   //
-  // This class implements a pair of FFT filters (mark,space) and monitors their
-  // quality and measures the ratio of mark/space.
+  // This class implements a pair of oscillators (mark,space) for
+  // synthesizing the two-tone signal.
   class FilterPair {
     //
     // One for mark, one for space.
     class GoertzelFFT m_Mark;
     class GoertzelFFT m_Space;
     //
-    // The current output bit.
-    bool              m_bOut;
-    //
-    // The hysteresis for the output decision.
-    double            m_dHysteresis;
-    //
-    double            m_dRatio;
-    //
-    // Average amplitudes of mark and space
-    double            m_dMarkAmplitude;
-    double            m_dSpaceAmplitude;
-    //
-    // Correction for source amplitude divergence.
-    double            m_dMarkNormalize;
-    double            m_dSpaceNormalize;
-    //
     // Sampling frequency
     double            m_dFreq;
     //
@@ -126,26 +97,6 @@ class WavDecoder : public TapeImage, private VBIAction {
     // shift is the frequency bias. For the exact frequencies, specify here 1.0.
     FilterPair(double samplingfreq,double shift);
     //
-    // Drive a value through the filter, record the output, which is
-    // the squared of the filter response.
-    bool Filter(double v);
-    //
-    // Return the quality of the filter as the ratio of recognized
-    // signals.
-    double QualityOf(void) const
-    {
-      return m_dRatio;
-    }
-    //
-    // Return the last output bit again.
-    bool OutputOf(void) const
-    {
-      return m_bOut;
-    }
-    //
-    // Normalize the filter gains.
-    void NormalizeFilterGains(void);
-    //
     // Generate a mark or space output, true for mark, false for space.
     // The second argument is the number of seconds. The synthesizer
     // tries to stop at a negative to positive transition of the wave and
@@ -164,15 +115,61 @@ class WavDecoder : public TapeImage, private VBIAction {
   // monitoring the input.
   class FilterCascade {
     //
-    // Number of filters in each frequency direction.
+    // Number of filters in each frequency direction, and the
+    // total number of filter pairs.
+    enum {
+      m_iNFilters = 12,
+      m_iNPairs   = 2 * m_iNFilters + 1
+    };
+    //
+    // Indices into the arrays of the Goertzel filters.
     enum {
-      m_iNFilters = 12
+      Mark  = 0,
+      Space = 1
     };
     //
-    class FilterPair *m_ppFilter[2 * m_iNFilters + 1];
+    // The filter bank. Each pair consists of a Goertzel filter for
+    // mark and one for space. The filters are kept in plain arrays
+    // indexed by a slot such that a sample runs through the complete
+    // bank in a single loop the compiler can vectorize. The active pairs
+    // occupy the first slots, pairs that decoded a bit incorrectly are
+    // moved behind them and are no longer run.
+    //
+    // The cosine of the frequency, defines the response frequency.
+    double m_dCos[2][m_iNPairs];
     //
-    // The currently active filter
-    class FilterPair *m_pActiveFilter;
+    // 2.0 - cos
+    double m_d2MinusCos[2][m_iNPairs];
+    //
+    // The DC leakage compensation of the groetzel filter.
+    double m_dLeak[2][m_iNPairs];
+    //
+    // Filter delay lines.
+    double m_dSN_2[2][m_iNPairs];
+    double m_dSN_1[2][m_iNPairs];
+    //
+    // The current output bit of each pair.
+    bool   m_bOut[m_iNPairs];
+    //
+    // The quality of each pair as the average response of the
+    // recognized signal.
+    double m_dQuality[m_iNPairs];
+    //
+    // Average amplitudes of mark and space
+    double m_dAmplitude[2][m_iNPairs];
+    //
+    // Correction for source amplitude divergence.
+    double m_dNormalize[2][m_iNPairs];
+    //
+    // The slot of each filter pair, and the filter pair in each slot.
+    int    m_iSlot[m_iNPairs];
+    int    m_iPair[m_iNPairs];
+    //
+    // The number of active pairs, these are in the first slots.
+    int    m_iActive;
+    //
+    // The hysteresis for the output decision of a pair.
+    double m_dPairHysteresis;
     //
     // The best quality ratio we could find.
     double m_dRatio;
@@ -188,21 +185,61 @@ class WavDecoder : public TapeImage, private VBIAction {
     struct FilterSwitch {
       int m_iNext;
       int m_iPrev;
-    }      m_Switch[2 * m_iNFilters + 1];
+    }      m_Switch[m_iNPairs];
     //
     //
 #if DEBUG_LEVEL > 0
-    int ones[2 * m_iNFilters + 1];
+    int ones[m_iNPairs];
 #endif
     //
+    // Setup the mark or space filter in the given slot for the given
+    // frequency, and reset its state.
+    void SetupFilter(int f,int slot,double samplingfreq,double freq);
+    //
+    // Setup the given filter pair and activate it. Shift is the
+    // frequency bias. This also resets the state of the pair.
+    void SetupPair(int i,double samplingfreq,double shift);
+    //
+    // Exchange the contents of two slots of the filter bank.
+    void SwapSlots(int a,int b);
+    //
+    // Exchange two values.
+    template<typename T>
+    static void Swap(T &a,T &b)
+    {
+      T t = a;
+      a   = b;
+      b   = t;
+    }
+    //
+    // Drive a value through all active filters of the bank and update
+    // the output decisions of the active pairs.
+    void FilterBank(double v);
+    //
+    // Check whether the given filter pair is still active.
+    bool IsActive(int i) const
+    {
+      return m_iSlot[i] < m_iActive;
+    }
+    //
+    // Return the output bit of the given filter pair.
+    bool OutputOf(int i) const
+    {
+      return m_bOut[m_iSlot[i]];
+    }
+    //
+    // Return the quality of the given filter pair.
+    double QualityOf(int i) const
+    {
+      return m_dQuality[m_iSlot[i]];
+    }
+    //
   public:
     FilterCascade(double samplingfreq);
     //
     // Reset all filters and filter states
     void ResetFilters(double samplingfreq);
     //
-    ~FilterCascade(void);
-    //
     // Drive a value through the filter, record the output, which is
     // the squared of the filter response.
     bool Filter(double v,bool adjustfilters);
@@ -234,6 +271,10 @@ class WavDecoder : public TapeImage, private VBIAction {
     class FilterCascade m_Left;
     class FilterCascade m_Right;
     //
+    // Set if the input has two distinct channels. Otherwise, the right
+    // channel is a copy of the left and need not be filtered.
+    bool   m_bStereo;
+    //
     double m_dHysteresis;
     //
     // The currently active input
@@ -243,7 +284,7 @@ class WavDecoder : public TapeImage, private VBIAction {
     double m_dRatio;
     //
   public:
-    ChannelFilter(double samplingfreq);
+    ChannelFilter(double samplingfreq,bool stereo);
     //
     // Perform a filtering on the stereo pair (left,right)
     // And adapt the filter given what is best.
@@ -437,6 +478,18 @@ public:
   // Open a wav file for reading.
   virtual void OpenForReading(void);
   //
+  // The records of a wav file have to be decoded from the signal.
+  virtual bool isAudio(void) const
+  {
+    return true;
+  }
+  //
+  // Return the baud rate detected for the record read last.
+  virtual UWORD BaudRateOf(void) const
+  {
+    return UWORD(m_dBaud + 0.5);
+  }
+  //
   // After the work is done, complete the file. This is only
   // required for writing.
   virtual void Close(void);
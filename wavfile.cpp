@@ -65,6 +65,15 @@ void WavFile::ParseHeader(void)
       if (m_usBitsPerChannel != 8 && m_usBitsPerChannel != 16)
 	Throw(NotImplemented,"WavFile::ParseHeader",
 	      "Unsupported number of bits per channel in WAV file, must be 8 or 16");
+      //
+      // 8 bit samples are unsigned, 16 bit samples are signed.
+      if (m_usBitsPerChannel == 8) {
+	m_sNormalizeOffset = 128;
+	m_dNormalizeScale  = 1.0 / 128.0;
+      } else {
+	m_sNormalizeOffset = 0;
+	m_dNormalizeScale  = 1.0 / 32768.0;
+      }
       
       if (blockalign != (m_usNumChannels * m_usBitsPerChannel) >> 3)
 	Throw(InvalidParameter,"WavFile::ParseHeader",
@@ -100,34 +109,64 @@ void WavFile::ParseHeader(void)
 }
 ///
 
-/// WavFile::Advance
-// Go to the next sample, return true if there is one.
-bool WavFile::Advance(void)
+/// WavFile::FillBuffer
+// Refill the read-ahead buffer from the file. This reads as many
+// complete sample frames as are left in the data chunk, but at most
+// the size of the buffer, and decodes them into left and right samples.
+void WavFile::FillBuffer(void)
 {
-  if (m_ulSampleCount > 0) {
-    try {
-      if (m_usBitsPerChannel == 8) {
-	m_sLeftSample = Get();
-      } else {
-	m_sLeftSample = GetWord();
+  ULONG framesize = (m_usNumChannels * m_usBitsPerChannel) >> 3;
+  ULONG frames    = m_ulSampleCount;
+  const UBYTE *in;
+  ULONG i;
+
+  if (m_pucReadAhead == NULL) {
+    m_pucReadAhead = new UBYTE[ReadAheadFrames * framesize];
+    m_psLeft       = new WORD[ReadAheadFrames];
+    m_psRight      = new WORD[ReadAheadFrames];
+  }
+
+  if (frames > ReadAheadFrames)
+    frames = ReadAheadFrames;
+  //
+  // A truncated file still delivers all samples up to the point
+  // where it ends.
+  frames = fread(m_pucReadAhead,framesize,frames,m_pSource);
+  if (frames == 0) {
+    m_ulSampleCount = 0;
+    if (ferror(m_pSource))
+      ThrowIo("WavFile::FillBuffer",
+	      "Unexpected error while reading from the WAV file");
+    throw AtariException(0,"unexpected EOF","WavFile::FillBuffer",
+			 "Unexpected EOF while reading from the the WAV file");
+  }
+  //
+  in = m_pucReadAhead;
+  if (m_usBitsPerChannel == 8) {
+    if (m_usNumChannels == 1) {
+      for(i = 0;i < frames;i++,in++) {
+	m_psLeft[i] = m_psRight[i] = in[0];
       }
-      if (m_usNumChannels == 1) {
-	m_sRightSample = m_sLeftSample;
-      } else {
-	if (m_usBitsPerChannel == 8) {
-	  m_sRightSample = Get();
-	} else {
-	m_sRightSample = GetWord();
-	}
+    } else {
+      for(i = 0;i < frames;i++,in += 2) {
+	m_psLeft[i]  = in[0];
+	m_psRight[i] = in[1];
+      }
+    }
+  } else {
+    if (m_usNumChannels == 1) {
+      for(i = 0;i < frames;i++,in += 2) {
+	m_psLeft[i] = m_psRight[i] = WORD(in[0] | (in[1] << 8));
+      }
+    } else {
+      for(i = 0;i < frames;i++,in += 4) {
+	m_psLeft[i]  = WORD(in[0] | (in[1] << 8));
+	m_psRight[i] = WORD(in[2] | (in[3] << 8));
       }
-      m_ulSampleCount--;
-      return true;
-    } catch(AtariException &ae) {
-      m_ulSampleCount = 0;
-      throw ae;
     }
   }
-  return false;
+  m_ulBufferPos  = 0;
+  m_ulBufferFill = frames;
 }
 ///
 
@@ -20,6 +20,11 @@
 /// WavFile
 // A simple helper structure to read and analyze a wav file.
 class WavFile {
+  //
+  // Number of sample frames read ahead from the file at once.
+  enum {
+    ReadAheadFrames = 4096
+  };
   //
   // The file to be parsed.
   FILE *m_pSource;
@@ -43,6 +48,25 @@ class WavFile {
   WORD  m_sLeftSample;
   WORD  m_sRightSample;
   //
+  // Offset and scale that normalize a sample into -1..1.
+  WORD   m_sNormalizeOffset;
+  double m_dNormalizeScale;
+  //
+  // The read-ahead buffer for reading. This keeps the raw file
+  // data, followed by the left and the right samples decoded
+  // from it.
+  UBYTE *m_pucReadAhead;
+  WORD  *m_psLeft;
+  WORD  *m_psRight;
+  //
+  // The position of the next sample in the read-ahead buffer,
+  // and the number of samples in there.
+  ULONG  m_ulBufferPos;
+  ULONG  m_ulBufferFill;
+  //
+  // Refill the read-ahead buffer from the file.
+  void FillBuffer(void);
+  //
   // Read a single character.
   UBYTE Get(void) const
   {
@@ -142,9 +166,18 @@ class WavFile {
 public:
   WavFile(FILE *source)
   : m_pSource(source), m_ulTotalSize(0), m_usNumChannels(0), m_ulFrequency(0),
-    m_ulSampleCount(0)
+    m_ulSampleCount(0), m_sNormalizeOffset(0), m_dNormalizeScale(0.0),
+    m_pucReadAhead(NULL), m_psLeft(NULL), m_psRight(NULL),
+    m_ulBufferPos(0), m_ulBufferFill(0)
   { }
   //
+  ~WavFile(void)
+  {
+    delete[] m_pucReadAhead;
+    delete[] m_psLeft;
+    delete[] m_psRight;
+  }
+  //
   // Parse the header, fill in all the details.
   void ParseHeader(void);
   //
@@ -191,7 +224,19 @@ public:
   //
   // Advance to the next sample value for reading if possible.
   // Return true if there are more samples to follow, false otherwise.
-  bool Advance(void);
+  bool Advance(void)
+  {
+    if (m_ulSampleCount > 0) {
+      if (m_ulBufferPos >= m_ulBufferFill)
+	FillBuffer();
+      m_sLeftSample  = m_psLeft[m_ulBufferPos];
+      m_sRightSample = m_psRight[m_ulBufferPos];
+      m_ulBufferPos++;
+      m_ulSampleCount--;
+      return true;
+    }
+    return false;
+  }
   //
   // Return the sample frequency
   ULONG FrequencyOf(void) const
@@ -199,17 +244,16 @@ public:
     return m_ulFrequency;
   }
   //
+  // Return the number of channels in the file.
+  UWORD NumChannelsOf(void) const
+  {
+    return m_usNumChannels;
+  }
+  //
   // Normalize a sample.
-  double Normalize(WORD sample)
-  {
-    switch(m_usBitsPerChannel) {
-    case 8:
-      return (sample - 128) / 128.0;
-    case 16:
-      return sample / 32768.0;
-    default:
-      return 0.0;
-    }
+  double Normalize(WORD sample) const
+  {
+    return (sample - m_sNormalizeOffset) * m_dNormalizeScale;
   }
   //
   // Return the number of samples still in the chunk.
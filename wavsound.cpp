@@ -18,7 +18,6 @@
 #include "pokey.hpp"
 #include "exceptions.hpp"
 #include "wavsound.hpp"
-#include "audiobuffer.hpp"
 #include "unistd.hpp"
 #if HAVE_FCNTL_H && HAVE_SYS_IOCTL_H && HAVE_SYS_SOUNDCARD_H
 #define USE_PLAYBACK
@@ -37,7 +36,7 @@ WavSound::WavSound(class Machine *mach)
     Playback(true), EnableAfterReset(true), ForceStereo(false),
     WavStereo(false), WavSixteen(false),
     Recording(false), HaveMutingValue(true),
-    OutputCounter(0)
+    OutputCounter(0), RenderSeconds(0), RenderedLines(0), RenderVideo(true)
 {
 #ifndef USE_PLAYBACK
   Playback = false;
@@ -73,6 +72,7 @@ void WavSound::ColdStart(void)
   // Check whether the user requested output. If so, try to configure the
   // output file.
   CloseWavFile(false); // dispose it
+  RenderedLines = 0;
   //
   // Now run for the warmstart.
   WarmStart();
@@ -299,6 +299,9 @@ bool WavSound::OpenOssStream(void)
     break;
   }
   //
+  // Allocate the ring buffer for the playback.
+  AllocateBuffer(ULONG(NumFrags << 1) * FragSamples);
+  //
   // Set the DSP sample rate to the user preferred value.
   // This is optional as LONG as we can read the rate back.
   //
@@ -368,8 +371,6 @@ void WavSound::InitializeBuffer(void)
   // Compute how many samples we compute per 15.7 Khz. This is given by the ratio of
   // our sampling frequency to the fixed cycle frequency. Round this up to one byte
   // to compute the buffer size.
-  delete PlayingBuffer;
-  PlayingBuffer   = NULL;
   bufsize         = (SamplingFreq + PokeyFreq - 1) / PokeyFreq;
   if (bufsize < 1) bufsize = 1; // That should not happen, though.
   // Build a new playing buffer to fit the needs of the wav output stream.
@@ -384,8 +385,7 @@ void WavSound::InitializeBuffer(void)
   if (RightPokey && WavStereo) {
     interleaved = true;
   }
-  PlayingBuffer   = AudioBufferBase::NewBuffer(WavSixteen,stereo,WavSixteen,true,interleaved);
-  PlayingBuffer->Realloc(bufsize);
+  WavBuffer.Allocate(bufsize,WavSixteen,stereo,WavSixteen,true,interleaved);
   Residual        = 0;
   OutputCounter   = 0;
   MutingValue     = 128;
@@ -474,55 +474,45 @@ void WavSound::CloseWavFile(bool finewrite)
 // argument given.
 void WavSound::UpdateSound(class Timer *delay)
 {
+  // If rendering offline, the emulation is not timed at all.
+  if (RenderSeconds > 0)
+    return;
   // Check whether we want the sound at all. In case we don't, we
   // do not need all this.
 #ifdef USE_PLAYBACK
   if (delay) {
     if (OssStream >= 0) {
-      LONG fragcnt;
-      struct AudioBufferBase *sn;
+      ULONG ready,limit;
       // We ignore all update events since we cannot update "out of line"
       // since this would mess up the recording. But we may re-play
-      // the buffers we have.
+      // the samples we have.
       while (delay->WaitForIO(OssStream)) {
-	// Now remove buffers from the queue and replay them into the
+	const UBYTE *samples;
+	ULONG count;
+	ssize_t written;
+	// Now remove samples from the buffer and replay them into the
 	// device. Actually, the OSS devices should do this themselves,
 	// but it seems that this doesn't work correctly!
-	sn = ReadyBuffers.First();
-	if (sn) {
-	  // This audio node exists. Play it back node.
-	  write(OssStream,sn->ReadPtr,sn->ReadyBytes());
-	  // Hmm. All this could result in errors, but as the main
-	  // intention is the recording of sound, I don't care.
-	  // If this is not the last node, remove it, otherwise replay it.
-	  // This may, of course, cause a "hickup", but we cannot
-	  // regenerate audio as we need to record the audio samples
-	  // at "emulation time" whereas we play them at real-time.
-	  // Hence, some "lag" should be expected we need to
-	  // work against. We do so by "hickup", i.e. by pushing
-	  // obsolete data into the buffer again. This is not nice,
-	  // but better than a "plop" and a complete buffer underrun
-	  // we would have to deal otherwise. This way, the dsp queue
-	  // keeps at least busy.
-	  if (sn->NextOf()) {
-	    sn->Remove();
-	    FreeBuffers.AddTail(sn);
-	  }
+	samples = Ring.NextSamples(count);
+	if (count == 0) {
+	  // We cannot regenerate audio as we need to record the audio
+	  // samples at "emulation time" whereas we play them at real-time.
+	  // Hence, just wait for the emulation to catch up.
+	  delay->WaitForEvent();
+	  break;
 	}
+	written = write(OssStream,samples,count << Ring.SampleShiftOf());
+	// Hmm. All this could result in errors, but as the main
+	// intention is the recording of sound, I don't care.
+	if (written > 0)
+	  Ring.ConsumeSamples(ULONG(written) >> Ring.SampleShiftOf());
       }
       //
-      // dispose the sound nodes queued so far up to the amount we buffer.
-      sn = ReadyBuffers.Last(), fragcnt = NumFrags;
-      while(sn && fragcnt) {
-	sn = sn->PrevOf();
-	fragcnt--;
-      }
-      while(sn) {
-	struct AudioBufferBase *prev = sn->PrevOf();
-	sn->Remove();
-	FreeBuffers.AddTail(sn);
-	sn = prev;
-      }
+      // dispose the samples queued so far up to the amount we buffer.
+      ready = Ring.ReadySamples();
+      limit = ULONG(NumFrags) * FragSamples;
+      if (ready > limit)
+	Ring.ConsumeSamples(ready - limit);
     } else {
       delay->WaitForEvent();
     }
@@ -560,44 +550,42 @@ void WavSound::HBI(void)
       Residual  -= PokeyFreq;
     }
     // Now check whether we have to generate samples at all. If not, then there's nothing to do.
-    if (PlayingBuffer && buffersamples) {
-      int offset;
-      // Need to generate samples from pokey. We do this manually here. The PlayingBuffer
+    if (WavBuffer.SizeOf() && buffersamples) {
+      int i;
+      // Need to generate samples from pokey. We do this manually here. The WavBuffer
       // is expected to be constructed here already.
 #if CHECK_LEVEL > 0
-      if (PlayingBuffer->Size < ULONG(buffersamples >> PlayingBuffer->SampleShift))
+      if (WavBuffer.SizeOf() < ULONG(buffersamples) || buffersamples > ScratchSamples)
 	Throw(OutOfRange,"WavSound::TriggerSoundScanLine","wav intermediate buffer allocated too small");
 #endif
       //
-      // First ask the main pokey to do the computing: Reset the buffer pointer
-      // to its beginning.
-      PlayingBuffer->WritePtr = PlayingBuffer->ReadPtr = PlayingBuffer->Buffer;
-      LeftPokey->ComputeSamples(PlayingBuffer,buffersamples,SamplingFreq,0);
-      // Check whether the buffer wants a second pokey output.
-      if ((offset = PlayingBuffer->ChannelOffset())) {
-	// Start at the write-offset of the second channel.
-	PlayingBuffer->WritePtr  = PlayingBuffer->Buffer + offset;
-	RightPokey->ComputeSamples(PlayingBuffer,buffersamples,SamplingFreq,0);
-	PlayingBuffer->WritePtr -= offset;
+      // First ask the main pokey to do the computing, then the second pokey
+      // if there is one. Its samples are only used for interleaved output.
+      LeftPokey->ComputeSamples(LeftSamples,buffersamples,SamplingFreq,0);
+      if (RightPokey) {
+	RightPokey->ComputeSamples(RightSamples,buffersamples,SamplingFreq,0);
+      } else {
+	memcpy(RightSamples,LeftSamples,buffersamples);
       }
       //
       // All of this is unnecessary if we don't want to record anyhow.
       if (EnableSound) {
 	// Check whether we need to check for the muting value.
 	if (HaveMutingValue == false) {      
-	  // Ok, check the first sample. This is the muting value. Since we must have
-	  // litte endian here, we really look at the right thing even if 16bit is enabled.
-	  MutingValue            = PlayingBuffer->GetSample();
-	  // We could reset the read-pointer here, but what for?
+	  // Ok, check the first sample. This is the muting value.
+	  MutingValue            = LeftSamples[0];
 	  HaveMutingValue        = true;
 	}
 	if (Recording == false) {
 	  // Check whether we should enable recording. This happens only if
 	  // there is a sample in the audio buffer that has not the muting
 	  // value.
-	  if (PlayingBuffer->CheckForMuting(MutingValue)) {
-	    // Ok, found a value different than the muting value
-	    Recording = true;
+	  for(i = 0;i < buffersamples;i++) {
+	    if (LeftSamples[i] != MutingValue || RightSamples[i] != MutingValue) {
+	      // Ok, found a value different than the muting value
+	      Recording = true;
+	      break;
+	    }
 	  }
 	}
       }
@@ -605,12 +593,17 @@ void WavSound::HBI(void)
       // Include the console speaker now. It does not trigger off muting.
       // This is intentional
       if (ConsoleSpeakerStat && EnableConsoleSpeaker) {
-	PlayingBuffer->AddOffset(UBYTE(ConsoleVolume));
+	for(i = 0;i < buffersamples;i++) {
+	  LeftSamples[i]  += UBYTE(ConsoleVolume);
+	  RightSamples[i] += UBYTE(ConsoleVolume);
+	}
       }      
       //
       // We could have turned on recording right now. Hence, do so please.
       if (Recording) { 
-	ULONG readybytes;
+	const UBYTE *samples;
+	ULONG count;
+	size_t readybytes;
 	//
 	if (SoundStream == NULL) {
 	  if (!OpenWavFile()) {
@@ -622,68 +615,63 @@ void WavSound::HBI(void)
 	// Count the number of generated samples
 	OutputCounter += buffersamples;
 	//
-	// Reset the buffer to its beginning again.
-	PlayingBuffer->ReadPtr = PlayingBuffer->Buffer;
-	// Now finally write it to the output file.
-	readybytes = PlayingBuffer->ReadyBytes();
-	if (fwrite(PlayingBuffer->ReadPtr,sizeof(UBYTE),readybytes,SoundStream) != (size_t)readybytes) {
-	  int error = errno;
-	  // Failed. Close the file immediately.
-	  CloseWavFile(false);
-	  // Outch. Recording failed. Should we throw an error?
-	  machine->PutWarning("Generation of .wav file %s failed due to %s, "
-			      "recording aborted.\n",FileName,strerror(error));
-	  EnableSound = false;
+	// Convert the samples into the .wav format. The buffer is drained
+	// completely each time, so this always fits.
+	WavBuffer.PutSamples(LeftSamples,RightSamples,buffersamples);
+	// Now finally write it to the output file. This might take two
+	// rounds if the samples wrap around the end of the buffer.
+	for(;;) {
+	  samples    = WavBuffer.NextSamples(count);
+	  if (count == 0)
+	    break;
+	  readybytes = count << WavBuffer.SampleShiftOf();
+	  if (fwrite(samples,sizeof(UBYTE),readybytes,SoundStream) != readybytes) {
+	    int error = errno;
+	    // Failed. Close the file immediately.
+	    CloseWavFile(false);
+	    // Outch. Recording failed. Should we throw an error?
+	    machine->PutWarning("Generation of .wav file %s failed due to %s, "
+				"recording aborted.\n",FileName,strerror(error));
+	    EnableSound = false;
+	    WavBuffer.Reset();
+	    break;
+	  }
+	  WavBuffer.ConsumeSamples(count);
 	}
       }
 #ifdef USE_PLAYBACK
       // Write the data to the oss device for playback.
       if (Playback && OssStream >= 0) {
-	struct AudioBufferBase *abb;
-	// Reset the input pointer.
-	PlayingBuffer->ReadPtr = PlayingBuffer->Buffer;
-	// Loop until all input samples have been converted to the
-	// output.
-	while(PlayingBuffer->IsEmpty() == false) {
-	  int entries = FragSamples;
-	  //
-	  // Check how many bytes we shall allocate: At least one fragment.
-	  if (entries < buffersamples)
-	    entries = buffersamples;
-	  //
-	  // Find or create a new sound node of the required size.
-	  abb = ReadyBuffers.Last();
-	  if (abb == NULL || abb->FreeSamples() < ULONG(buffersamples)) {
-	    // Need to find a new one.
-	    abb = FreeBuffers.RemHead();
-	    if (abb == NULL) {
-	      // Need to get a new one.
-	      abb = AudioBufferBase::NewBuffer(SignedSamples,Stereo,SixteenBit,LittleEndian,Interleaved);
-	    }
-	    // Add it to the output buffer to ensure that it isn't lost if we have to throw.
-	    ReadyBuffers.AddTail(abb);
-	    abb->Realloc(entries);
-	  }
-	  //
-	  // Convert now from the input to the output buffer.
-	  abb->CopyBuffer(PlayingBuffer);
-	}
+	const UBYTE *samples;
+	ULONG count;
+	ssize_t written;
+	// Convert the samples into the format of the playback device.
+	// If the device is late, the samples get lost.
+	Ring.PutSamples(LeftSamples,RightSamples,buffersamples);
 	//
 	// Check whether we can feed the Oss sound driver here.
 	if (Timer::CheckIO(OssStream)) {
-	  abb = ReadyBuffers.First();
-	  // Remove the first node, and push it into the queue.
-	  if (abb) {
-	    write(OssStream,abb->ReadPtr,abb->ReadyBytes());
-	    // Move this buffer over to the free buffers again.
-	    abb->Remove();
-	    FreeBuffers.AddTail(abb);
+	  samples = Ring.NextSamples(count);
+	  if (count >= ULONG(FragSamples)) {
+	    written = write(OssStream,samples,count << Ring.SampleShiftOf());
+	    if (written > 0)
+	      Ring.ConsumeSamples(ULONG(written) >> Ring.SampleShiftOf());
 	  }
 	}
       }
 #endif
     }
   }
+  //
+  // When rendering offline, count the emulated time and quit the
+  // emulator once the requested duration has been generated.
+  if (RenderSeconds > 0 && machine->Quit() == false) {
+    if (++RenderedLines >= ULONG(RenderSeconds) * ULONG(PokeyFreq)) {
+      CloseWavFile(true);
+      EnableSound     = false;
+      machine->Quit() = true;
+    }
+  }
 }
 ///
 
@@ -749,12 +737,16 @@ void WavSound::ParseArgs(class ArgParser *args)
 		   2,16,FragSize);
   args->DefineLong("NumFrags","specify the number of fragments",
 		   1,512,NumFrags);  
+  args->DefineLong("RenderSeconds","render this many seconds offline, then quit (0 = realtime)",
+		   0,86400,RenderSeconds);
+  args->DefineBool("RenderVideo","refresh the display while rendering offline",RenderVideo);
 
   // Re-read the base frequency
   PokeyFreq  = LeftPokey->BaseFrequency();
   //
 #ifdef USE_PLAYBACK
-  if (penable) {
+  // Playback cannot follow offline rendering.
+  if (penable && RenderSeconds == 0) {
     Playback = true;
     if (!OpenOssStream()) {
       // opening or configuring /dev/dsp failed. Do not try again!
@@ -63,6 +63,11 @@ class WavSound : public Sound {
   bool             WavStereo;     // generate WAV in stereo (both samples identically)
   bool             WavSixteen;    // generate WAV output in 16 bit, must be LE for WAV.
   //
+  // The buffer that converts the pokey samples into the
+  // format of the .wav file. The ring buffer of the sound
+  // class is only used for playback.
+  class AudioBuffer WavBuffer;
+  //
   // Will get set by the first change in the sound output
   // except for the console speaker events.
   bool             Recording;
@@ -73,6 +78,14 @@ class WavSound : public Sound {
   // complete the .wav file header.
   LONG             OutputCounter;
   //
+  // Offline rendering: If non-zero, render this many seconds of emulated
+  // time as fast as possible, then quit the emulator. The scan lines
+  // emulated since the last coldstart are counted here. Unless the
+  // display is enabled, it is not refreshed while rendering.
+  LONG             RenderSeconds;
+  ULONG            RenderedLines;
+  bool             RenderVideo;
+  //
   // Residual from the last division for the computation of the number of
   // samples. This is kept here to fit the overall frequency perfectly
   // on the LONG run. Hence, some kind of "Bresenham" algorithm here.
@@ -140,6 +153,18 @@ public:
   // Turn the console speaker on or off:
   virtual void ConsoleSpeaker(bool);
   //
+  // Check whether the sound is rendered offline.
+  virtual bool isOffline(void) const
+  {
+    return RenderSeconds > 0;
+  }
+  //
+  // Check whether the display may skip its refresh while rendering offline.
+  virtual bool isVideoSkipped(void) const
+  {
+    return RenderSeconds > 0 && !RenderVideo;
+  }
+  //
   // the following are imported by the Chip class:
   virtual void ColdStart(void);
   virtual void WarmStart(void);
@@ -44,6 +44,9 @@
 /* Define to 1 if the __null keyword is available */
 /* #define HAS__NULL_TYPE 1 */
 
+/* Define to 1 if you have the `access' function. */
+/* #define HAVE_ACCESS 1 */
+
 /* Define to 1 if you have the <alsa/asoundlib.h> header file. */
 /* #define HAVE_ALSA_ASOUNDLIB_H 1 */
 
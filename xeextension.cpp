@@ -17,13 +17,18 @@
 #include "snapshot.hpp"
 #include "mmu.hpp"
 #include "stdio.hpp"
+#include "string.hpp"
 #include "new.hpp"
 ///
 
 /// XEExtension::BankBits
-// The array that defines the bits of PIA port B that give
-// the bank #.
-const UBYTE XEExtension::BankBits[8] = { 2,3,6,7,1,5,0,4 };
+// The arrays that define the bits of PIA port B that give
+// the bank #, one for each banking scheme.
+const UBYTE XEExtension::BankBits[3][8] = { 
+  { 2,3,6,7,1,5,0,4 }, // Compy
+  { 2,3,5,6,7,1,0,4 }, // Rambo
+  { 1,2,3,5,6,7,0,4 }  // Linear
+};
 // Default values that are passed on to PIA in case we capture
 // one of the bits is one.
 ///
@@ -33,11 +38,12 @@ const UBYTE XEExtension::BankBits[8] = { 2,3,6,7,1,5,0,4 };
 // the members and have to set the name of the game.
 XEExtension::XEExtension(class Machine *mach)
   : RamExtension(mach,"130XERamBanks"),
-    RAM(new RamPage[256]),
+    Storage(NULL), RAM(NULL),
     CPUBank(0), AnticBank(0),
     CPUAccess(false), AnticAccess(false),
-    PIABankBits(2)
+    Scheme(Compy), PIABankBits(0)
 {
+  AllocateBanks(2);
 }
 ///
 
@@ -46,6 +52,30 @@ XEExtension::XEExtension(class Machine *mach)
 XEExtension::~XEExtension(void)
 {
   delete[] RAM;
+  delete[] Storage;
+}
+///
+
+/// XEExtension::AllocateBanks
+// Allocate the banks for the given number of bank bits. The memory
+// is allocated at once, but not touched here such that a large
+// expansion does not cost more than the pages used.
+void XEExtension::AllocateBanks(LONG bits)
+{
+  int i,pages = (1 << bits) << 6;
+  //
+  delete[] RAM;
+  RAM         = NULL;
+  delete[] Storage;
+  Storage     = NULL;
+  PIABankBits = 0;
+  //
+  Storage     = new UBYTE[pages << PAGE_SHIFT];
+  RAM         = new class LazyRamPage[pages];
+  for(i = 0;i < pages;i++) {
+    RAM[i].SetStorage(Storage + (i << PAGE_SHIFT));
+  }
+  PIABankBits = bits;
 }
 ///
 
@@ -65,7 +95,7 @@ bool XEExtension::MapExtension(class AdrSpace *adr,bool forantic)
     // Ok, we have to map the extra bytes for ANTIC. Hence, check
     // whether antic has access to the pages in first place.
     if (AnticAccess) {
-      class RamPage *ram;
+      class LazyRamPage *ram;
       ADR i;
       // Yes, it does. Get the bank offset, then map banks into
       // 0x4000 and up. These are 16K, making 64 pages or a left-
@@ -81,7 +111,7 @@ bool XEExtension::MapExtension(class AdrSpace *adr,bool forantic)
     // CPU Access. Check whether the CPU should access the additional
     // pages. Otherwise, as above.
     if (CPUAccess) {
-      class RamPage *ram;
+      class LazyRamPage *ram;
       ADR i;
       ram = RAM + (CPUBank << 6);
       for(i = 0x4000;i<0x8000; i += PAGE_LENGTH) {
@@ -101,6 +131,7 @@ bool XEExtension::MapExtension(class AdrSpace *adr,bool forantic)
 // reconfigure this RAM area.
 bool XEExtension::PIAWrite(UBYTE &data)
 {
+  const UBYTE *bits = BankBits[Scheme];
   bool cpu,antic;
   int bank,i;
 
@@ -110,7 +141,7 @@ bool XEExtension::PIAWrite(UBYTE &data)
   // Get the addressed bank by now.
   bank  = 0;
   for(i=0;i<PIABankBits;i++) {
-    int mask = 1<<BankBits[i]; // The mask to the bit we currently test.
+    int mask = 1<<bits[i]; // The mask to the bit we currently test.
     if (data & mask) {
       // Bit is set, address the page here.
       bank  |= (1<<i);
@@ -129,11 +160,12 @@ bool XEExtension::PIAWrite(UBYTE &data)
       antic = cpu;
     }
     //
-    if (mask & 0x80) {
+    if (mask & 0x82) {
       // Steal the bit by forwarding the default to PIA, namely
-      // a set bit. This cludge only works if CPU banking is enabled
+      // a set bit. This cludge only works if CPU banking is enabled.
+      // This disables the selftest resp. the basic.
       if (cpu)
-	data |= 0x80;
+	data |= mask;
     }
   }
 
@@ -159,7 +191,8 @@ void XEExtension::ColdStart(void)
   int i,pages;
 
   pages = (1<<PIABankBits)<<6;
-  // Clear memory pages to really emulate a coldstart
+  // Clear memory pages to really emulate a coldstart. This
+  // releases all pages.
   for(i=0;i<pages;i++) {
     RAM[i].Blank();
   }
@@ -184,28 +217,38 @@ void XEExtension::WarmStart(void)
 // title. 
 void XEExtension::ParseArgs(class ArgParser *args)
 {
-  LONG bits = PIABankBits;
+  static const struct ArgParser::SelectionVector schemevector[] = 
+    { {"Compy"  ,Compy  },
+      {"Rambo"  ,Rambo  },
+      {"Linear" ,Linear },
+      {NULL     ,0}
+    };
+  LONG bits   = PIABankBits;
+  LONG scheme = Scheme;
   
   args->DefineLong("XEBankBits","number of utilized PIA Port B bits for bank switching",0,8,bits);
+  args->DefineSelection("XEBankScheme","PIA Port B bits used for bank switching",schemevector,scheme);
   //
   // Check whether the number of bits changed. If so, then we need to
   // reallocate the bank memory.
   if (bits != PIABankBits) {
-    int i,banks = 1<<bits;
-    PIABankBits = bits;
-    //
-    // Rebuild the RAM now. This also looses its contents.
-    delete[] RAM;
-    RAM = NULL;
-    RAM = new RamPage[banks<<6];
-    //  
-    // Reset all pages.
-    for(i=0;i < banks;i++) {
-      RAM[i].Blank();
-    } 
+    // Rebuild the RAM now. This also looses its contents and
+    // releases all pages.
+    AllocateBanks(bits);
+    MMU->InvalidateMappingCache();
     // This requires a cold-start since we invalidate memory.
     args->SignalBigChange(ArgParser::ColdStart);
   }
+  //
+  // A new scheme decodes the same PORTB value to a different bank,
+  // hence the active bank and the memory maps cached per PORTB
+  // value are stale. The PORTB value is also modified for the
+  // bits taken from PIA, so restart the machine to rebuild all.
+  if (scheme != Scheme) {
+    Scheme = scheme;
+    MMU->InvalidateMappingCache();
+    args->SignalBigChange(ArgParser::ColdStart);
+  }
 }
 ///
 
@@ -214,8 +257,9 @@ void XEExtension::ParseArgs(class ArgParser *args)
 // This is part of the saveable interface.
 void XEExtension::State(class SnapShot *snap)
 {
-  int i,pages;
+  int i,j,pages;
   char id[32],helptxt[80];
+  UBYTE *used;
 
   snap->DefineTitle("XEBanking");
   snap->DefineBool("GrantCPUAccess"  ,"grant the CPU access to the extended pages",CPUAccess);
@@ -226,14 +270,49 @@ void XEExtension::State(class SnapShot *snap)
   AnticBank = CPUBank;
   MMU->BuildMedRam();
   //
-  // Now save the RAM contents.
+  // Now save the RAM contents. Only pages that have been written
+  // to are saved, all others are zero.
   snap->DefineTitle("XERAM");
   pages = (1<<PIABankBits)<<6;
+  used  = new UBYTE[pages >> 3];
+  memset(used,0,pages >> 3);
+  if (snap->isSaving()) {
+    for(i = 0;i<pages;i++) {
+      if (RAM[i].isUsed())
+	used[i >> 3] |= UBYTE(1 << (i & 7));
+    }
+  }
+  snap->DefineChunk("UsedPages","bitmap of the used extra RAM pages",used,pages >> 3);
   for(i = 0;i<pages;i++) {
     snprintf(id,31,"Page%d",i);
     snprintf(helptxt,79,"130 XE extra RAM page %d contents",i);
-    snap->DefineChunk(id,helptxt,RAM[i].Memory(),256);
+    if (snap->isSaving()) {
+      if (RAM[i].isUsed())
+	snap->DefineChunk(id,helptxt,RAM[i].Memory(),256);
+    } else if (snap->isCollecting()) {
+      // All pages must be known before parsing, the pages
+      // remain untouched until the file has been read.
+      memset(Scratch,0,sizeof(Scratch));
+      snap->DefineChunk(id,helptxt,Scratch,256);
+    } else if (used[i >> 3] & (1 << (i & 7))) {
+      RAM[i].Use();
+      snap->DefineChunk(id,helptxt,RAM[i].Memory(),256);
+    } else {
+      // Either the page is unused, or this is a snapshot without
+      // the bitmap that contains all pages. Take those into use
+      // that are not blank.
+      RAM[i].Blank();
+      snap->DefineChunk(id,helptxt,Scratch,256);
+      for(j = 0;j < PAGE_LENGTH;j++) {
+	if (Scratch[j]) {
+	  RAM[i].Use();
+	  memcpy(RAM[i].Memory(),Scratch,sizeof(Scratch));
+	  break;
+	}
+      }
+    }
   }
+  delete[] used;
 }
 ///
 
@@ -242,25 +321,35 @@ void XEExtension::State(class SnapShot *snap)
 // This is called as part of the MMU status.
 void XEExtension::DisplayStatus(class Monitor *monitor)
 {
-  int bankmask,i;
+  int bankmask,i,pages,used;
 
   // Compute the mask of all bits within PIA port B
   // that are responsible for bankswitching.
   bankmask = 0x00;
   for(i=0;i<PIABankBits;i++) {
-    bankmask |= 1<<BankBits[i];
+    bankmask |= 1<<BankBits[Scheme][i];
+  }
+  // Count the pages in use.
+  pages = (1<<PIABankBits)<<6;
+  for(i=0,used=0;i<pages;i++) {
+    if (RAM[i].isUsed())
+      used++;
   }
 
   monitor->PrintStatus("\tXE banks CPU access     : %s\n"
 		       "\tXE banks ANTIC access   : %s\n"
 		       "\tXE number of banks bits : " LD "\n"
 		       "\tXE PIA Port B bank mask : 0x%02x\n"
-		       "\tXE active bank          : %d\n",
+		       "\tXE active bank          : %d\n"
+		       "\tXE banking scheme       : %s\n"
+		       "\tXE used pages           : %d of %d\n",
 		       (CPUAccess)?("on"):("off"),
 		       (AnticAccess)?("on"):("off"),
 		       PIABankBits,
 		       bankmask,
-		       CPUBank);
+		       CPUBank,
+		       (Scheme == Compy)?("Compy"):((Scheme == Rambo)?("Rambo"):("Linear")),
+		       used,pages);
 }
 ///
 
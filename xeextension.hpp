@@ -14,18 +14,38 @@
 /// Includes
 #include "types.hpp"
 #include "ramextension.hpp"
-#include "rampage.hpp"
+#include "lazyrampage.hpp"
 ///
 
 /// Class XEExtension
 // This class implements the 130XE 64K extra mem
-// and its bank-switching mechanism.
+// and its bank-switching mechanism, and the larger
+// PIA port B controlled expansions derived from it,
+// up to 4MB.
 // It is built by the MMU whenever the machine type
 // is 130XE (clearly).
 class XEExtension : public RamExtension {
+public:
+  //
+  // The banking schemes, i.e. the orders in which the bits of
+  // port B select the bank.
+  enum BankScheme {
+    Compy,   // bits 2,3,6,7,... with separate ANTIC access, as the 130XE
+    Rambo,   // bits 2,3,5,6,... ANTIC follows the CPU.
+    Linear   // bits 1,2,3,5,6,7,... for the 576K and 1088K expansions
+  };
+  //
+private:
+  //
+  // The memory of all banks, allocated at once. Only the pages
+  // that have been written to are in use.
+  UBYTE             *Storage;
   //
-  // The Extra RAM is here: 256 pages a 256 bytes.
-  class RamPage *RAM;
+  // The Extra RAM is here: 64 pages a 256 bytes per bank.
+  class LazyRamPage *RAM;
+  //
+  // Scratch memory for restoring unused pages from a snapshot.
+  UBYTE              Scratch[PAGE_LENGTH];
   //
   // The page the CPU resp. ANTIC has access to.
   UBYTE CPUBank,AnticBank;
@@ -33,15 +53,21 @@ class XEExtension : public RamExtension {
   // Whether CPU or ANTIC have access to these pages.
   bool CPUAccess,AnticAccess;
   //
-  // The array that defines the bits of PIA port B that give
-  // the bank #.
-  static const UBYTE BankBits[8];
+  // The arrays that define the bits of PIA port B that give
+  // the bank #, one for each scheme.
+  static const UBYTE BankBits[3][8];
+  //
+  // The selected banking scheme.
+  LONG Scheme;
   //
   // The number of bits of PIA we spend for addressing the banks.
   // The more bits we allocate here, the more other features
   // will break.
   LONG PIABankBits;
   //
+  // Allocate the banks for the given number of bank bits.
+  void AllocateBanks(LONG bits);
+  //
 public:
   XEExtension(class Machine *mach);
   ~XEExtension(void);
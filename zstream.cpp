@@ -11,6 +11,10 @@
 #include "filestream.hpp"
 #include "exceptions.hpp"
 #include "zstream.hpp"
+#include "stdio.hpp"
+#include "string.hpp"
+#include "directory.hpp"
+#include "unistd.hpp"
 #include "new.hpp"
 #if HAVE_ZLIB_H && HAVE_GZOPEN
 #include <zlib.h>
@@ -18,23 +22,37 @@
 
 /// ZStream::ZStream
 ZStream::ZStream(void)
-  : InFile(NULL), Size(0)
+  : FileName(NULL), Contents(NULL), Size(0), Capacity(0),
+    IsProtected(true), IsModified(false), IsGrowing(false)
 { }
 ///
 
 /// ZStream::~ZStream
-// Cleanup the file stream now, close the file.
+// Cleanup the file stream now, recompress the contents
+// if it has been altered.
 ZStream::~ZStream(void)
 {
-  struct Buffer *buf;
-  // Dispose all buffers now.
-  while((buf = Contents.RemHead())) {
-    delete buf;
-  }
+  // This is only the fallback if the stream has not been
+  // closed. Errors cannot be reported from here, the image
+  // remains as it was in this case.
+  if (IsModified)
+    WriteBack();
   //
-  if (InFile) {
-    gzclose(InFile);
-  }
+  delete[] Contents;
+  delete[] FileName;
+}
+///
+
+/// ZStream::Close
+// Recompress the contents into the image file if it has been
+// altered. Returns a success indicator, does not throw. The
+// modifications are kept if this fails.
+bool ZStream::Close(void)
+{
+  if (IsModified)
+    return WriteBack();
+  //
+  return true;
 }
 ///
 
@@ -43,53 +61,108 @@ ZStream::~ZStream(void)
 // the protection status and other nifties.
 void ZStream::OpenImage(const char *name)
 {
-  struct Buffer *buf;
-  ULONG  offset;
+  struct stat info;
+  gzFile infile;
   //
   // First check whether we are already open. If so, we
   // cannot re-open again.
 #if CHECK_LEVEL > 0
-  if (InFile) {
-    Throw(ObjectExists,"FileStream::OpenImage",
+  if (Contents) {
+    Throw(ObjectExists,"ZStream::OpenImage",
 	  "the image has been opened already");
   }
 #endif
   //
-  InFile        = gzopen(name,"rb");
-  if (InFile == NULL)
+  // The compressed image can only be written back if the
+  // file itself is writable by us.
+  if (stat(name,&info)) {
+    ThrowIo("ZStream::OpenImage","unable to stat the image file");
+  }
+#if HAVE_ACCESS
+  IsProtected = (access(name,W_OK) == 0)?false:true;
+#else
+  IsProtected = (info.st_mode & S_IWUSR)?false:true;
+#endif
+  //
+  FileName = new char[strlen(name) + 1];
+  strcpy(FileName,name);
+  //
+  infile   = gzopen(name,"rb");
+  if (infile == NULL)
     ThrowIo("ZStream::OpenImage","unable to open the input stream");
   //
-  // Now read all buffers into this stream here.
-  offset = 0;
-  do {
-    UBYTE *dt;
-    ULONG remains;
-    //
-    buf = new struct Buffer;
-    Contents.AddTail(buf);
-    buf->Offset = offset;
-    //
-    // Fill this buffer by the ZLib
-    dt = buf->Data,remains = 256;
+  // Now decompress the complete image into the buffer, growing
+  // it as required.
+  try {
+    Size     = 0;
+    Capacity = 65536;
+    Contents = new UBYTE[Capacity];
     do {
       int rd;
       //
+      if (Size >= Capacity) {
+	UBYTE *grown = new UBYTE[Capacity << 1];
+	memcpy(grown,Contents,Size);
+	delete[] Contents;
+	Contents  = grown;
+	Capacity <<= 1;
+      }
+      //
       // Now read data from the zlib into this buffer.
-      rd = gzread(InFile,dt,remains);
+      rd = gzread(infile,Contents + Size,Capacity - Size);
       // Abort on EOF: If that happens, we're done with reading the image
-      if (rd == 0) {
-	Size = offset;
-	return;
-      }
+      if (rd == 0)
+	break;
       if (rd < 0)
 	ThrowIo("ZStream::OpenImage","failed to read from the Z image file");
       //
-      // Increment data over the position.
-      dt      += rd;
-      remains -= rd;
-      offset  += rd;
-    } while(remains);
-  } while(true);
+      Size += rd;
+    } while(true);
+  } catch(...) {
+    gzclose(infile);
+    throw;
+  }
+  //
+  gzclose(infile);
+}
+///
+
+/// ZStream::FormatImage
+// Start a new, empty image that is compressed into the
+// given file as soon as the stream is closed. The image
+// grows as data is written into it.
+bool ZStream::FormatImage(const char *name)
+{
+  struct stat info;
+  //
+#if CHECK_LEVEL > 0
+  if (Contents) {
+    Throw(ObjectExists,"ZStream::FormatImage",
+	  "the image has been opened already");
+  }
+#endif
+  //
+  // If the file exists, it must be writable.
+  if (stat(name,&info) == 0) {
+#if HAVE_ACCESS
+    if (access(name,W_OK))
+      return false;
+#else
+    if ((info.st_mode & S_IWUSR) == 0)
+      return false;
+#endif
+  }
+  //
+  FileName = new char[strlen(name) + 1];
+  strcpy(FileName,name);
+  //
+  Size        = 0;
+  Capacity    = 65536;
+  Contents    = new UBYTE[Capacity];
+  IsProtected = false;
+  IsGrowing   = true;
+  IsModified  = true;
+  return true;
 }
 ///
 
@@ -98,59 +171,120 @@ void ZStream::OpenImage(const char *name)
 // byte offset.
 bool ZStream::Read(ULONG offset,void *buffer,ULONG size)
 {
-  UBYTE *out;
-  struct Buffer *buf;
-  //
 #if CHECK_LEVEL > 0
-  if (InFile == NULL)
+  if (Contents == NULL)
     Throw(ObjectDoesntExist,"ZStream::Read","the image has not yet been opened");
 #endif
   // Try to read past the end?
-  if (offset + size > Size)
+  if (offset + size > Size || offset + size < offset)
     return false;
   //
-  // Ok, things seem sane here. Find the buffer that is responsible for the
-  // given offset. Since atari disk images are relatively small, we can simply seek backward
-  // until we find it.
-  buf = Contents.Last();
-  while(buf && buf->Offset > offset) {
-    buf = buf->PrevOf();
-  }
-  // If we are here, we either reached the end of the list (how that? Didn't we check
-  // the offset?) or found a buffer, whose last byte is beyond what we need.
-  out = (UBYTE *)buffer;
-  while(size) {
-    ULONG bufof;
-    ULONG remain;
-    //
+  memcpy(buffer,Contents + offset,size);
+  return true;
+}
+///
+
+/// ZStream::Write
+// Write data back into the image at the given offset.
+// This only alters the decompressed contents, the
+// image is recompressed when the stream is closed.
+bool ZStream::Write(ULONG offset,const void *buffer,ULONG size)
+{
 #if CHECK_LEVEL > 0
-    if (buf == NULL)
-      Throw(PhaseError,"ZStream::Read","found premature EOF in the Z output stream");
+  if (Contents == NULL)
+    Throw(ObjectDoesntExist,"ZStream::Write","the image has not yet been opened");
 #endif
-    // Compute the offset within the buffer.
-    bufof  = offset - buf->Offset;
-    remain = 256 - bufof; // remaining bytes in the buffer.
-    if (remain > size)
-      remain = size;
-    memcpy(out,buf->Data + bufof,remain);
-    //
-    // Advance to the next buffer and decrement the size
-    out    += remain;
-    size   -= remain;
-    offset += remain;
-    buf     = buf->NextOf();
+  // Check wether we may write first.
+  if (IsProtected)
+    return false;
+  // Try to write past the end? This is only possible
+  // while formatting.
+  if (offset + size < offset)
+    return false;
+  if (offset + size > Size) {
+    if (!IsGrowing)
+      return false;
+    if (offset + size > Capacity) {
+      ULONG newcap = Capacity;
+      UBYTE *grown;
+      while(newcap < offset + size) {
+	newcap <<= 1;
+	if (newcap == 0)
+	  return false;
+      }
+      grown = new UBYTE[newcap];
+      memcpy(grown,Contents,Size);
+      delete[] Contents;
+      Contents = grown;
+      Capacity = newcap;
+    }
+    if (offset > Size)
+      memset(Contents + Size,0,offset - Size);
+    Size = offset + size;
   }
+  //
+  memcpy(Contents + offset,buffer,size);
+  IsModified = true;
   return true;
 }
 ///
 
-/// ZStream::Write
-// Write data back into the image at the given offset.
-// We cannot write to a compressed stream, hence return an
-// error condition here.
-bool ZStream::Write(ULONG,const void *,ULONG)
+/// ZStream::WriteBack
+// Compress the contents back into the image file. Returns a
+// success indicator, does not throw. The image is first
+// written to a temporary file that replaces the original only
+// if compression succeeded completely.
+bool ZStream::WriteBack(void)
 {
-  return false;
+  gzFile outfile;
+  char *tmpname;
+  ULONG offset;
+  bool ok = true;
+  //
+  if (FileName == NULL || Contents == NULL)
+    return false;
+  //
+  tmpname = new char[strlen(FileName) + 2];
+  strcpy(tmpname,FileName);
+  strcat(tmpname,"~");
+  //
+  outfile = gzopen(tmpname,"wb9");
+  if (outfile == NULL) {
+    delete[] tmpname;
+    return false;
+  }
+  //
+  offset = 0;
+  while(offset < Size) {
+    ULONG chunk = Size - offset;
+    if (chunk > 65536)
+      chunk = 65536;
+    if (gzwrite(outfile,Contents + offset,chunk) != int(chunk)) {
+      ok = false;
+      break;
+    }
+    offset += chunk;
+  }
+  if (gzclose(outfile) != Z_OK)
+    ok = false;
+  //
+#if HAVE_CHMOD
+  // Keep the access rights of the original file, the
+  // temporary file is created with the default rights.
+  if (ok) {
+    struct stat info;
+    if (stat(FileName,&info) == 0 && chmod(tmpname,info.st_mode & 07777))
+      ok = false;
+  }
+#endif
+  if (ok && rename(tmpname,FileName) == 0) {
+    IsModified = false;
+  } else {
+    remove(tmpname);
+    ok = false;
+  }
+  delete[] tmpname;
+  return ok;
 }
 ///
 
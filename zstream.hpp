@@ -14,7 +14,6 @@
 #include "types.h"
 #include "types.hpp"
 #include "imagestream.hpp"
-#include "list.hpp"
 #include "new.hpp"
 #if HAVE_ZLIB_H && HAVE_GZOPEN
 #include <zlib.h>
@@ -25,31 +24,36 @@
 // IO streams.
 class ZStream : public ImageStream {
   //
-  // The file we manage as input file.
-  gzFile     InFile;
+  // The name of the file we manage. This is required to write the
+  // image back on closing.
+  char      *FileName;
+  //
+  // The decompressed contents. This is a single contiguous buffer
+  // that is grown while decompressing, such that sector access is
+  // a simple memcpy.
+  UBYTE     *Contents;
   //
   // The size of the image, decompressed
   ULONG      Size;
   //
-  // The decompressed contents: This is organized as buffers of 
-  // 256 bytes each (more or less one for each sector pair)
-  struct Buffer : public Node<struct Buffer> {
-    // Offset within the buffer of this node.
-    ULONG  Offset;
-    // Data contents for this buffer.
-    UBYTE *Data;
-    //
-    Buffer(void)
-      : Offset(0), Data(new UBYTE[256])
-    { }
-    ~Buffer(void)
-    {
-      delete[] Data;
-    }
-  };
-  // Now, the contents is a list of buffers of the above
-  // type.
-  List<Buffer> Contents;
+  // The number of bytes allocated in the buffer above. This is at
+  // least the size.
+  ULONG      Capacity;
+  //
+  // The protection status of the file.
+  bool       IsProtected;
+  //
+  // Set if the contents has been altered and must be recompressed
+  // on closing.
+  bool       IsModified;
+  //
+  // Set if the image is being formatted. Writes past the end of
+  // the image then extend it.
+  bool       IsGrowing;
+  //
+  // Compress the contents back into the image file. Returns a
+  // success indicator, does not throw.
+  bool WriteBack(void);
   //
 public:
   ZStream(void);
@@ -58,12 +62,10 @@ public:
   // Open the image from a file name.
   virtual void OpenImage(const char *filename);
   //
-  // Format an image. Since we cannot write, we do 
-  // return an error.
-  virtual bool FormatImage(const char *)
-  {
-    return false;
-  }
+  // Format an image, i.e. start with an empty image that is
+  // compressed into the given file on closing. Returns false
+  // if the file cannot be written.
+  virtual bool FormatImage(const char *filename);
   //
   // Get the size of an image in bytes.
   virtual ULONG ByteSize(void)
@@ -72,12 +74,11 @@ public:
   }
   //
   // Get a protection status, i.e. wether we may write to the image.
-  // Returns true in case we are protected. Since we cannot write back
-  // to the compressed image without recompression, we currently 
-  // return true here: always protected
+  // Returns true in case we are protected. Writes are kept in memory
+  // and recompressed into the file as soon as the stream is closed.
   virtual bool ProtectionStatus(void)
   {
-    return true;
+    return IsProtected;
   }
   //
   // Reads data from the image into the buffer from the given
@@ -87,6 +88,10 @@ public:
   //
   // Writes data back into the image to the given offset.
   virtual bool Write(ULONG offset,const void *buffer,ULONG size);
+  //
+  // Recompress the contents into the image file if it has been
+  // altered. Returns a success indicator, does not throw.
+  virtual bool Close(void);
 };
 #endif
 ///